@@ -1,4 +1,6 @@
 #include "src/app.h"
+#include "src/cli.h"
+#include "src/throttle.h"
 #include "src/utils.h"
 
 #include <shellapi.h>
@@ -10,18 +12,32 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/, LPSTR /*l
     int argc = 0;
     LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
 
+    // Headless runs (stdin and manifest batches, plans, manifest compiles, shard workers, the UI
+    // benchmark) open no window and run beside the GUI and each other; only the GUI is single-instance
+    const CommandLine cmd = ParseCommandLine(argc, argv);
+    const bool headless = (!cmd.args.empty() && cmd.args[0] == L"-") || cmd.manifest || cmd.plan ||
+                          cmd.compileManifest || cmd.shardWorker || cmd.uiBench;
+
     // Mutex to prevent multiple instances
-    g_hMutex = CreateMutexW(nullptr, TRUE, PROCESS_MUTEX_GUID);
-    if (!g_hMutex) {
-        LocalFree(argv);
-        return 1;
+    if (!headless) {
+        g_hMutex = CreateMutexW(nullptr, TRUE, PROCESS_MUTEX_GUID);
+        if (!g_hMutex) {
+            LocalFree(argv);
+            return 1;
+        }
     }
-    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+    if (!headless && GetLastError() == ERROR_ALREADY_EXISTS) {
         DWORD waitRes = WaitForSingleObject(g_hMutex, 1000);
         if (waitRes == WAIT_TIMEOUT || waitRes == WAIT_FAILED) {
             if (waitRes == WAIT_TIMEOUT) {
                 HWND existingApp = FindWindowW(L"NameExchangerClass", L"FilenameExchanger");
-                if (existingApp) {
+                // Throttle switches alone retune the batch running in the existing instance; beside a
+                // swap, watch or pair rule of their own they are that batch's settings, not an update
+                const bool batchRequested = !cmd.args.empty() || !cmd.watch.empty() || !cmd.pairRules.empty();
+                ThrottleUpdate update;
+                if (existingApp && !batchRequested && ParseThrottleSwitches(cmd, update) && update.fields) {
+                    SendThrottleUpdate(existingApp, update);
+                } else if (existingApp) {
                     ShowWindow(existingApp, SW_RESTORE);
                     SetForegroundWindow(existingApp);
                 }
@@ -40,7 +56,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/, LPSTR /*l
             ReleaseMutex(g_hMutex);
             CloseHandle(g_hMutex);
         }
-        return 0;
+        return app.exitCode;
     }
     LocalFree(argv);
 
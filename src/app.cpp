@@ -1,10 +1,25 @@
 #include "app.h"
 
+#include "checkpoint.h"
+#include "cli.h"
+#include "collision_index.h"
 #include "d3d_helpers.h"
+#include "exchange.h"
 #include "font_data.h"
 #include "i18n.h"
+#include "manifest.h"
+#include "metadata_swap.h"
+#include "name_fold.h"
+#include "pair_rule.h"
+#include "plan.h"
+#include "path_lock.h"
+#include "shard_executor.h"
+#include "stream_mode.h"
 #include "tray.h"
+#include "ui_harness.h"
 #include "utils.h"
+#include "verify.h"
+#include "watch_service.h"
 
 #include "imgui.h"
 #include "imgui_internal.h"
@@ -16,13 +31,12 @@
 #include <shlobj.h>
 #include <windows.h>
 #include <algorithm>
-#include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <dwmapi.h>
 #include <filesystem>
 #include <string>
-
-// External function from the Rust library
-extern "C" int exchange(const char* path1, const char* path2, bool preserve_ext);
+#include <vector>
 
 // Forward declaration for ImGui Win32 handler
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -32,26 +46,46 @@ static App g_app;
 App& GetApp() { return g_app; }
 
 namespace {
-ImVec4 ToImVec4(COLORREF color, float alpha = 1.0f) {
-    return ImVec4(GetRValue(color) / 255.0f, GetGValue(color) / 255.0f, GetBValue(color) / 255.0f, alpha);
-}
+// Extra client height (at 96 DPI) taken by the swap queue panel
+constexpr float kQueuePanelHeight = 256.0f;
 
-float Luminance(const ImVec4& color) { return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z; }
+// Posted by the watch thread after it appended a batch to the swap queue
+constexpr UINT WM_APP_WATCH_BATCH = WM_APP + 1;
 
-ImVec4 ShiftLuminanceToRange(const ImVec4& color, float minLum, float maxLum) {
-    const float lum = Luminance(color);
-    float delta = 0.0f;
-    if (lum < minLum) {
-        delta = minLum - lum;
-    } else if (lum > maxLum) {
-        delta = maxLum - lum;
-    }
+// RegisterHotKey id of pinned pair 0; pair i uses kPinHotkeyBase + i
+constexpr int kPinHotkeyBase = 0x100;
+
+// Posted by the settings observer when a theme-related registry key was written
+constexpr UINT WM_APP_SETTINGS_CHANGED = WM_APP + 2;
+
+// SetTimer id of the pending theme refresh
+constexpr UINT_PTR kThemeTimerId = 1;
+
+// Rows in the completion list under a path input
+constexpr size_t kMaxPathSuggestions = 8;
+constexpr ImGuiInputTextFlags kPathInputFlags =
+    ImGuiInputTextFlags_CallbackCompletion | ImGuiInputTextFlags_CallbackHistory;
+
+// Path status is looked at again this often even when nothing changed, so that the disk is followed
+constexpr auto kPathStatusRecheck = std::chrono::milliseconds(1000);
+
+// Failed queue rows and path status problems
+const ImVec4 kErrorTextColor(0.86f, 0.20f, 0.18f, 1.0f);
 
-    ImVec4 out = color;
-    out.x = std::clamp(out.x + delta, 0.0f, 1.0f);
-    out.y = std::clamp(out.y + delta, 0.0f, 1.0f);
-    out.z = std::clamp(out.z + delta, 0.0f, 1.0f);
-    return out;
+// Tab takes the selected completion, the arrow keys move the selection
+int PathInputCallback(ImGuiInputTextCallbackData* data) {
+    auto* state = static_cast<PathCompletionState*>(data->UserData);
+    const int count = static_cast<int>(state->suggestions.size());
+    if (count == 0) {
+        return 0;
+    }
+    if (data->EventFlag == ImGuiInputTextFlags_CallbackHistory) {
+        state->selected = (state->selected + (data->EventKey == ImGuiKey_UpArrow ? count - 1 : 1)) % count;
+    } else if (data->EventFlag == ImGuiInputTextFlags_CallbackCompletion) {
+        data->DeleteChars(0, data->BufTextLen);
+        data->InsertChars(0, state->suggestions[state->selected].path.c_str());
+    }
+    return 0;
 }
 
 bool IsWindowsAppsDarkMode() {
@@ -66,13 +100,25 @@ bool IsWindowsAppsDarkMode() {
     return value == 0;
 }
 
-ImVec4 GetWindowsAccentColor() {
+COLORREF GetWindowsAccentColor() {
     DWORD argb = 0;
     BOOL opaqueBlend = FALSE;
     if (SUCCEEDED(DwmGetColorizationColor(&argb, &opaqueBlend))) {
-        return ImVec4(((argb >> 16) & 0xFF) / 255.0f, ((argb >> 8) & 0xFF) / 255.0f, (argb & 0xFF) / 255.0f, 1.0f);
+        return RGB((argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF);
     }
-    return ToImVec4(GetSysColor(COLOR_HIGHLIGHT));
+    return GetSysColor(COLOR_HIGHLIGHT);
+}
+
+ThemeInputs ReadThemeInputs() {
+    ThemeInputs inputs;
+    inputs.darkMode = IsWindowsAppsDarkMode();
+    inputs.window = GetSysColor(COLOR_WINDOW);
+    inputs.windowText = GetSysColor(COLOR_WINDOWTEXT);
+    inputs.shadow = GetSysColor(COLOR_3DSHADOW);
+    inputs.buttonFace = GetSysColor(COLOR_BTNFACE);
+    inputs.scrollbar = GetSysColor(COLOR_SCROLLBAR);
+    inputs.accent = GetWindowsAccentColor();
+    return inputs;
 }
 
 bool WriteWideTextToStderr(const std::wstring& text) {
@@ -116,17 +162,6 @@ void PrintCommandLineUsageToConsole(const std::wstring& message) {
     }
 }
 
-bool ParsePreserveFlag(const wchar_t* rawFlag) {
-    std::string flag = Utf16ToUtf8(rawFlag ? rawFlag : L"");
-    std::transform(flag.begin(), flag.end(), flag.begin(),
-                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-
-    if (flag == "f" || flag == "false" || flag == "n" || flag == "0") {
-        return false;
-    }
-    return true;
-}
-
 void ShowCommandLineUsageOnError(int returnId) {
     if (returnId == 0) {
         return;
@@ -139,10 +174,10 @@ void ShowCommandLineUsageOnError(int returnId) {
 }
 
 // Rename the executable's extension reliably via a two-step rename through an intermediate
-// extension, avoiding NTFS case-insensitive same-file issues where rename(".exe", ".EXE") may
+// name, avoiding NTFS case-insensitive same-file issues where rename(".exe", ".EXE") may
 // be a no-op. On failure ec is set and the file is rolled back to its original name.
 void RenameExeToExtension(const std::filesystem::path& exePath, const std::wstring& targetExt, std::error_code& ec) {
-    const std::filesystem::path tmpPath = exePath.parent_path() / (exePath.stem().wstring() + L"._exch_tmp_");
+    const std::filesystem::path tmpPath = exePath.parent_path() / UniqueTempName(exePath.stem().wstring());
     ec.clear();
     std::filesystem::rename(exePath, tmpPath, ec);
     if (ec) return;
@@ -183,6 +218,25 @@ void App::UpdateDpiScale() {
 }
 
 void App::ApplySystemTheme() {
+    themeInputs = ReadThemeInputs();
+    ApplyThemePalette(DeriveThemePalette(themeInputs));
+}
+
+void App::RefreshSystemTheme() {
+    if (const std::optional<ThemePalette> palette = RefreshThemePalette(themeInputs, themePalette, ReadThemeInputs())) {
+        ApplyThemePalette(*palette);
+    }
+}
+
+void App::QueueThemeRefresh() {
+    const auto now = ChangeCoalescer::Clock::now();
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(themeChanges.Notify(now) - now).count();
+    SetTimer(hwnd, kThemeTimerId, static_cast<UINT>((std::max)(wait, decltype(wait){1})), nullptr);
+}
+
+void App::ApplyThemePalette(const ThemePalette& palette) {
+    themePalette = palette;
+
     ImGuiStyle& style = ImGui::GetStyle();
     style.WindowBorderSize = 0.0f;
     style.WindowRounding = 0.0f;
@@ -190,85 +244,183 @@ void App::ApplySystemTheme() {
     style.FrameBorderSize = 0.0f;
     style.Colors[ImGuiCol_ChildBg] = ImVec4(0, 0, 0, 0);
 
-    const bool darkMode = IsWindowsAppsDarkMode();
-
-    ImVec4 windowBg = ToImVec4(GetSysColor(COLOR_WINDOW));
-    ImVec4 text = ToImVec4(GetSysColor(COLOR_WINDOWTEXT));
-    ImVec4 border = ToImVec4(GetSysColor(COLOR_3DSHADOW));
-    ImVec4 frameBg = ToImVec4(GetSysColor(COLOR_BTNFACE));
-    ImVec4 scrollbarBg = ToImVec4(GetSysColor(COLOR_SCROLLBAR));
-    ImVec4 accent = GetWindowsAccentColor();
-
-    if (darkMode) {
-        windowBg = ShiftLuminanceToRange(windowBg, 0.08f, 0.18f);
-        text = ShiftLuminanceToRange(text, 0.82f, 0.96f);
-        border = ShiftLuminanceToRange(border, 0.28f, 0.42f);
-        frameBg = ShiftLuminanceToRange(frameBg, 0.14f, 0.24f);
-        scrollbarBg = ShiftLuminanceToRange(scrollbarBg, 0.12f, 0.22f);
-        accent = ShiftLuminanceToRange(accent, 0.08f, 0.12f);
-    } else {
-        windowBg = ShiftLuminanceToRange(windowBg, 0.90f, 0.98f);
-        text = ShiftLuminanceToRange(text, 0.05f, 0.20f);
-        border = ShiftLuminanceToRange(border, 0.50f, 0.70f);
-        frameBg = ShiftLuminanceToRange(frameBg, 0.94f, 1.00f);
-        scrollbarBg = ShiftLuminanceToRange(scrollbarBg, 0.90f, 0.98f);
-        accent = ShiftLuminanceToRange(accent, 0.35f, 0.62f);
-    }
-
-    style.Colors[ImGuiCol_WindowBg] = windowBg;
-    style.Colors[ImGuiCol_Text] = text;
-    style.Colors[ImGuiCol_Border] = border;
-    style.Colors[ImGuiCol_FrameBg] = frameBg;
-    style.Colors[ImGuiCol_FrameBgHovered] =
-        ShiftLuminanceToRange(frameBg, darkMode ? 0.20f : 0.88f, darkMode ? 0.32f : 0.94f);
-    style.Colors[ImGuiCol_FrameBgActive] =
-        ShiftLuminanceToRange(frameBg, darkMode ? 0.24f : 0.82f, darkMode ? 0.38f : 0.90f);
-    style.Colors[ImGuiCol_Button] = ShiftLuminanceToRange(frameBg, darkMode ? 0.18f : 0.90f, darkMode ? 0.28f : 0.96f);
-    style.Colors[ImGuiCol_ButtonHovered] =
-        ShiftLuminanceToRange(frameBg, darkMode ? 0.24f : 0.82f, darkMode ? 0.36f : 0.92f);
-    style.Colors[ImGuiCol_ButtonActive] =
-        ShiftLuminanceToRange(frameBg, darkMode ? 0.30f : 0.75f, darkMode ? 0.44f : 0.86f);
-    style.Colors[ImGuiCol_ScrollbarBg] = scrollbarBg;
-    style.Colors[ImGuiCol_ScrollbarGrab] =
-        ShiftLuminanceToRange(accent, darkMode ? 0.36f : 0.45f, darkMode ? 0.55f : 0.65f);
-    style.Colors[ImGuiCol_ScrollbarGrabHovered] =
-        ShiftLuminanceToRange(accent, darkMode ? 0.46f : 0.55f, darkMode ? 0.62f : 0.75f);
-    style.Colors[ImGuiCol_ScrollbarGrabActive] =
-        ShiftLuminanceToRange(accent, darkMode ? 0.56f : 0.65f, darkMode ? 0.72f : 0.85f);
-
-    clearColor = windowBg;
-    topBarBgColor = accent;
-    topBarTextColor =
-        (Luminance(topBarBgColor) > 0.50f) ? ImVec4(0.0f, 0.0f, 0.0f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
-    topBarButtonHoveredColor = ImVec4(topBarTextColor.x, topBarTextColor.y, topBarTextColor.z, 0.14f);
-    topBarButtonActiveColor = ImVec4(topBarTextColor.x, topBarTextColor.y, topBarTextColor.z, 0.24f);
-    tooltipBgColor = ShiftLuminanceToRange(windowBg, darkMode ? 0.16f : 0.94f, darkMode ? 0.24f : 1.0f);
-    tooltipTextColor = text;
+    style.Colors[ImGuiCol_WindowBg] = palette.windowBg;
+    style.Colors[ImGuiCol_Text] = palette.text;
+    style.Colors[ImGuiCol_Border] = palette.border;
+    style.Colors[ImGuiCol_FrameBg] = palette.frameBg;
+    style.Colors[ImGuiCol_FrameBgHovered] = palette.frameBgHovered;
+    style.Colors[ImGuiCol_FrameBgActive] = palette.frameBgActive;
+    style.Colors[ImGuiCol_Button] = palette.button;
+    style.Colors[ImGuiCol_ButtonHovered] = palette.buttonHovered;
+    style.Colors[ImGuiCol_ButtonActive] = palette.buttonActive;
+    style.Colors[ImGuiCol_ScrollbarBg] = palette.scrollbarBg;
+    style.Colors[ImGuiCol_ScrollbarGrab] = palette.scrollbarGrab;
+    style.Colors[ImGuiCol_ScrollbarGrabHovered] = palette.scrollbarGrabHovered;
+    style.Colors[ImGuiCol_ScrollbarGrabActive] = palette.scrollbarGrabActive;
+
+    clearColor = palette.windowBg;
+    topBarBgColor = palette.topBarBg;
+    topBarTextColor = palette.topBarText;
+    topBarButtonHoveredColor = palette.topBarButtonHovered;
+    topBarButtonActiveColor = palette.topBarButtonActive;
+    tooltipBgColor = palette.tooltipBg;
+    tooltipTextColor = palette.text;
 }
 
 bool App::Init(HINSTANCE hInstance, int argc, wchar_t** argv) {
-    // Command line mode: 2/3 args → exchange and exit
-    if (argc == 3) {
-        std::string p1 = Utf16ToUtf8(argv[1]);
-        std::string p2 = Utf16ToUtf8(argv[2]);
-        const int returnId = exchange(p1.c_str(), p2.c_str(), true);
-        ShowCommandLineUsageOnError(returnId);
+    const CommandLine cmd = ParseCommandLine(argc, argv);
+    pipelineDepth = cmd.pipelineDepth;
+    LatencyProfile latency;
+    uint32_t metadata = 0;
+    ThrottleUpdate throttleArgs;
+    if (pipelineDepth == 0 || (cmd.simulateLatency && !ParseLatencyProfile(*cmd.simulateLatency, latency)) ||
+        (cmd.swapMetadata && !ParseMetadataClasses(*cmd.swapMetadata, metadata)) ||
+        !ParseThrottleSwitches(cmd, throttleArgs) || (cmd.nameRules && !ParseNameRules(*cmd.nameRules, nameRules)) ||
+        (cmd.plan && !cmd.manifest && (cmd.args.empty() || cmd.args[0] != L"-")) ||
+        (cmd.compileManifest && !cmd.manifest) ||
+        (cmd.checkpoint && (!cmd.manifest || cmd.plan || cmd.compileManifest)) || (cmd.resume && !cmd.checkpoint) ||
+        (cmd.workers && (*cmd.workers == 0 || !cmd.manifest || cmd.plan || cmd.checkpoint || cmd.compileManifest)) ||
+        (cmd.shardWorker && !cmd.manifest)) {
+        const auto& L = GetCurrentLocale();
+        PrintCommandLineUsageToConsole(std::wstring(L.cmdInvalidArgument) + L"\n\n" + L.cmdUsage);
+        exitCode = 1;
+        return false;
+    }
+    if (cmd.simulateLatency) {
+        vfs = std::make_unique<SimulatedVfs>(latency);
+    } else {
+        vfs = std::make_unique<NativeVfs>(cmd.verify, metadata);
+    }
+    throttle.Apply(MergeThrottleUpdate(ThrottleSettings{}, throttleArgs));
+    batchVfs = std::make_unique<ThrottledVfs>(*vfs, throttle);
+    profiler.enabled = showProfilerOverlay = cmd.profileFrames;
+
+    // Headless UI benchmark: no window, null renderer
+    if (cmd.uiBench) {
+        RunUiBenchmark(*this, cmd.args.empty() ? std::wstring() : cmd.args[0]);
+        return false;  // Signal to exit
+    }
+
+    // Streaming mode: "-" [preserve] → swap pairs read from stdin until EOF, or only plan them with --plan.
+    // "--manifest <file> [preserve]" does the same with the pairs of a mapped manifest.
+    if ((!cmd.args.empty() && cmd.args[0] == L"-") || cmd.manifest) {
+        Manifest manifest;
+        if (cmd.manifest && !manifest.Open(*cmd.manifest)) {
+            const auto& L = GetCurrentLocale();
+            PrintCommandLineUsageToConsole(std::wstring(L.cmdManifestInvalid) + *cmd.manifest);
+            exitCode = 1;
+            return false;
+        }
+        if (cmd.compileManifest) {
+            if (!WriteBinaryManifest(*cmd.compileManifest, manifest)) {
+                const auto& L = GetCurrentLocale();
+                PrintCommandLineUsageToConsole(std::wstring(L.cmdManifestWriteFailed) + *cmd.compileManifest);
+                exitCode = 1;
+            }
+            return false;  // Signal to exit
+        }
+        const Manifest* source = cmd.manifest ? &manifest : nullptr;
+        const size_t flagIndex = source ? 0 : 1;
+        const bool preserve = cmd.args.size() > flagIndex ? ParsePreserveFlag(cmd.args[flagIndex].c_str()) : true;
+        if (cmd.plan) {
+            // A simulated share costs one round trip per stat or rename and is never probed
+            PlanCostModel simulated;
+            simulated.statUs = simulated.renameUs = latency.rttMs * 1000.0;
+            simulated.measured = true;
+            PlanOptions options;
+            options.verify = cmd.verify;
+            options.metadata = metadata;
+            options.depth = pipelineDepth;
+            options.opsPerSecond = throttle.Settings().opsPerSecond;
+            options.fixedModel = cmd.simulateLatency ? &simulated : nullptr;
+            options.nameRules = nameRules;
+            PrintCommandLineUsageToConsole(RunPlanMode(preserve, options, source, &exitCode));
+            return false;  // Signal to exit
+        }
+        if (cmd.shardWorker) {
+            exitCode = RunShardWorker(*batchVfs, manifest, preserve, pipelineDepth, *cmd.shardWorker);
+            return false;  // Signal to exit
+        }
+        if (cmd.workers) {
+            // Workers run this same command line, which carries the manifest and every swap option
+            LocalProcessTransport transport(GetCommandLineW());
+            PrintCommandLineUsageToConsole(RunShardCoordinator(*batchVfs, manifest, preserve, pipelineDepth, nameRules,
+                                                               transport, *cmd.workers, &exitCode));
+            return false;  // Signal to exit
+        }
+        // --checkpoint: the same manifest and [preserve] always hash alike, so --resume finds its checkpoint
+        Checkpoint checkpoint;
+        if (cmd.checkpoint) {
+            const Checkpoint::OpenResult opened =
+                checkpoint.Open(*cmd.checkpoint, HashManifest(manifest, preserve), manifest.Size(), cmd.resume);
+            if (opened != Checkpoint::OpenResult::Ok) {
+                const auto& L = GetCurrentLocale();
+                const wchar_t* reason = opened == Checkpoint::OpenResult::Unfinished ? L.cmdCheckpointUnfinished
+                                                                                      : L.cmdCheckpointInvalid;
+                PrintCommandLineUsageToConsole(std::wstring(reason) + *cmd.checkpoint);
+                exitCode = 1;
+                return false;
+            }
+        }
+        Checkpoint* journal = cmd.checkpoint ? &checkpoint : nullptr;
+        exitCode = RunStreamMode(*batchVfs, preserve, pipelineDepth, nameRules, source, journal);
+        checkpoint.Finish();
+        if (throttle.Settings().adaptive) {
+            const auto& L = GetCurrentLocale();
+            const TuningStats tuning = throttle.Tuning();
+            wchar_t summary[256];
+            swprintf_s(summary, L.tuningSummary, tuning.limit, tuning.p99Ms, tuning.baselineMs,
+                       static_cast<unsigned long long>(tuning.raises), static_cast<unsigned long long>(tuning.cuts),
+                       static_cast<unsigned long long>(tuning.windows));
+            PrintCommandLineUsageToConsole(summary);
+        }
         return false;  // Signal to exit
-    } else if (argc == 4) {
-        std::string p1 = Utf16ToUtf8(argv[1]);
-        std::string p2 = Utf16ToUtf8(argv[2]);
-        const bool preserve = ParsePreserveFlag(argv[3]);
-        const int returnId = exchange(p1.c_str(), p2.c_str(), preserve);
+    }
+
+    // Command line mode: 2/3 positional args → exchange and exit
+    if (cmd.args.size() == 2 || cmd.args.size() == 3) {
+        std::string p1 = Utf16ToUtf8(cmd.args[0]);
+        std::string p2 = Utf16ToUtf8(cmd.args[1]);
+        const bool preserve = cmd.args.size() == 3 ? ParsePreserveFlag(cmd.args[2].c_str()) : true;
+        const int returnId = RunExchange(p1, p2, preserve);
         ShowCommandLineUsageOnError(returnId);
         return false;  // Signal to exit
     }
 
+    // Watch rules are validated before any window exists so that a typo fails like other CLI errors
+    std::vector<WatchRule> watchRules;
+    for (const auto& [dir, pattern] : cmd.watch) {
+        WatchRule rule;
+        if (!ParseWatchRule(dir, pattern, rule)) {
+            const auto& L = GetCurrentLocale();
+            PrintCommandLineUsageToConsole(std::wstring(L.cmdWatchInvalid) + dir + L" " + pattern + L"\n\n" +
+                                           L.cmdUsage);
+            exitCode = 1;
+            return false;
+        }
+        watchRules.push_back(std::move(rule));
+    }
+
+    // Rule-generated pairs are collected up front as well and wait in the swap queue for a run
+    SwapBatch rulePairs;
+    for (const auto& [root, pattern, replacement] : cmd.pairRules) {
+        PairRule rule;
+        if (!PairRule::Compile(root, pattern, replacement, rule) || !ScanPairRule(rule, rulePairs)) {
+            const auto& L = GetCurrentLocale();
+            PrintCommandLineUsageToConsole(std::wstring(L.cmdPairRuleInvalid) + root + L" " + pattern + L" " +
+                                           replacement + L"\n\n" + L.cmdUsage);
+            exitCode = 1;
+            return false;
+        }
+    }
+
     // Check if the executable has .EXE extension and we are not admin
     std::wstring szPath(32768, L'\0');
     DWORD len = GetModuleFileNameW(nullptr, szPath.data(), static_cast<DWORD>(szPath.size()));
     szPath.resize(len);
     std::filesystem::path p(szPath);
-    if (p.extension() == L".EXE" && !IsRunAsAdmin()) {
+    runningAsAdmin = IsRunAsAdmin();
+    if (p.extension() == L".EXE" && !runningAsAdmin) {
         RunAsAdmin(true);
     }
 
@@ -330,6 +482,7 @@ bool App::Init(HINSTANCE hInstance, int argc, wchar_t** argv) {
     ShowWindow(hwnd, SW_SHOWDEFAULT);
     UpdateWindow(hwnd);
     SetForegroundWindow(hwnd);
+    isForeground = GetForegroundWindow() == hwnd;
 
     if (isTopmost) {
         SetWindowPos(hwnd, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE);
@@ -337,6 +490,7 @@ bool App::Init(HINSTANCE hInstance, int argc, wchar_t** argv) {
 
     // Setup tray icon
     SetupTrayIcon(hwnd);
+    ApplyPinnedPairs(LoadPinnedPairs(), false);
 
     // Enable drag and drop
     DragAcceptFiles(hwnd, TRUE);
@@ -352,26 +506,28 @@ bool App::Init(HINSTANCE hInstance, int argc, wchar_t** argv) {
     io.IniFilename = nullptr;  // Disable ini file
 
     ApplySystemTheme();
+    settingsObserver.Start(hwnd, WM_APP_SETTINGS_CHANGED);
+    pathCompleter = std::make_unique<PathCompleter>();
+    pathValidator = std::make_unique<PathValidator>();
 
     ImGui_ImplWin32_Init(hwnd);
     ImGui_ImplDX11_Init(d3d.device, d3d.deviceContext);
 
-    // Load fonts
-    fontLabel = LoadMsyhFont(io, 16.0f * dpiScale);
-
-    // Input font (15pt)
-    fontInput = LoadMsyhFont(io, 15.0f * dpiScale);
-
-    // Start button font (24pt)
-    fontStartBtn = LoadMsyhFont(io, 24.0f * dpiScale);
-
-    // Icon font (15pt for title bar buttons)
-    {
-        ImFontConfig cfg;
-        cfg.FontDataOwnedByAtlas = false;
-        fontIcon = io.Fonts->AddFontFromMemoryTTF(const_cast<unsigned char*>(kIconFontData),
-                                                  static_cast<int>(kIconFontDataSize), 15.0f * dpiScale, &cfg);
+    RebuildFonts();
+
+    if (!watchRules.empty()) {
+        std::wstring failedDir;
+        const auto sink = [this](SwapBatch batch) {
+            swapQueue.AddBatch(std::move(batch), true);
+            PostMessageW(hwnd, WM_APP_WATCH_BATCH, 0, 0);
+        };
+        if (!watchService.Start(watchRules, sink, failedDir)) {
+            const auto& L = GetCurrentLocale();
+            MessageBoxW(hwnd, (std::wstring(L.cmdWatchInvalid) + failedDir).c_str(), L.errorTitle,
+                        MB_OK | MB_ICONERROR);
+        }
     }
+    swapQueue.AddBatch(std::move(rulePairs));
 
     return true;
 }
@@ -411,6 +567,7 @@ int App::Run() {
         }
 
         // Start ImGui frame
+        profiler.BeginFrame();
         ImGui_ImplDX11_NewFrame();
         ImGui_ImplWin32_NewFrame();
         ImGui::NewFrame();
@@ -419,6 +576,7 @@ int App::Run() {
 
         // Rendering
         ImGui::Render();
+        profiler.EndFrame();
         const float clearColorData[4] = {clearColor.x, clearColor.y, clearColor.z, clearColor.w};
         d3d.deviceContext->OMSetRenderTargets(1, &d3d.renderTargetView, nullptr);
         d3d.deviceContext->ClearRenderTargetView(d3d.renderTargetView, clearColorData);
@@ -432,6 +590,11 @@ int App::Run() {
 }
 
 void App::Shutdown() {
+    settingsObserver.Stop();
+    pathCompleter.reset();
+    pathValidator.reset();
+    watchService.Stop();
+    swapQueue.Stop();
     RemoveTrayIcon();
     ImGui_ImplDX11_Shutdown();
     ImGui_ImplWin32_Shutdown();
@@ -450,8 +613,16 @@ void App::RenderUI() {
     const auto& L = GetCurrentLocale();
     const float s = dpiScale;
 
+    // Grow the window when the queue gets its first entry, shrink it once the queue is emptied
+    const bool wantQueuePanel = !swapQueue.Empty();
+    if (wantQueuePanel != queuePanelShown) {
+        queuePanelShown = wantQueuePanel;
+        SetWindowPos(hwnd, nullptr, 0, 0, static_cast<int>(364 * s), static_cast<int>(WindowHeight()),
+                     SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+    }
+
     float winW = 364 * s;
-    float winH = 240 * s;
+    float winH = WindowHeight();
     float barH = 32 * s;
     float btnSize = 29 * s;
     float btnY = (barH - btnSize) / 2.0f;
@@ -460,7 +631,7 @@ void App::RenderUI() {
     float each_width = 6 * s + btnSize;
 
     // Clear input focus when window loses foreground
-    if (GetForegroundWindow() != hwnd) {
+    if (!isForeground) {
         ImGui::ClearActiveID();
     }
 
@@ -472,6 +643,7 @@ void App::RenderUI() {
                      ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoSavedSettings);
 
     // === Top Bar ===
+    profiler.BeginSection(UiSection::TopBar);
     ImGui::SetCursorPos(ImVec2(0, 0));
 
     ImGui::PushStyleColor(ImGuiCol_ChildBg, topBarBgColor);
@@ -520,7 +692,7 @@ void App::RenderUI() {
 
     // Admin button
     ImGui::SetCursorPos(ImVec2(winW - each_width * 4, btnY));
-    bool isAdmin = IsRunAsAdmin();
+    const bool isAdmin = runningAsAdmin;
     if (ImGui::Button(isAdmin ? "E" : "D", ImVec2(btnSize, btnSize))) {
         std::wstring szPath(32768, L'\0');
         DWORD len = GetModuleFileNameW(nullptr, szPath.data(), static_cast<DWORD>(szPath.size()));
@@ -610,13 +782,31 @@ void App::RenderUI() {
     }
 
     ImGui::EndChild();
+    profiler.EndSection(UiSection::TopBar);
 
     // === Main Content ===
+    profiler.BeginSection(UiSection::Inputs);
+    UpdatePathStatus();
+
+    // Status of a path, right-aligned on its label's line
+    const auto renderPathStatus = [&](int field, float y) {
+        const char* text = pathStatus.text[field];
+        if (!text) return;
+        ImGui::SetCursorPos(ImVec2(winW - contentX - ImGui::CalcTextSize(text).x, y));
+        if (pathStatus.error[field]) {
+            ImGui::PushStyleColor(ImGuiCol_Text, kErrorTextColor);
+            ImGui::TextUnformatted(text);
+            ImGui::PopStyleColor();
+        } else {
+            ImGui::TextDisabled("%s", text);
+        }
+    };
 
     // Label 1
     if (fontLabel) ImGui::PushFont(fontLabel);
     ImGui::SetCursorPos(ImVec2(contentX, 42 * s));
     ImGui::Text("%s", L.file1Label);
+    renderPathStatus(0, 42 * s);
     if (fontLabel) ImGui::PopFont();
 
     // Input 1
@@ -624,23 +814,31 @@ void App::RenderUI() {
     ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 1.0f);
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(4 * s, (28 * s - ImGui::GetFontSize()) / 2.0f));
     ImGui::SetCursorPos(ImVec2(contentX, 62 * s));
+    const ImVec2 path1Below(ImGui::GetCursorScreenPos().x, ImGui::GetCursorScreenPos().y + 28.0f * s);
 
-    const float path1TextW = ImGui::CalcTextSize(path1.c_str()).x;
+    const float path1TextW = path1Width.Measure(path1);
     const float path1InnerW = (std::max)(inputWidth, path1TextW + 24.0f * s);
     const float path1ChildH = 28.0f * s + ImGui::GetStyle().ScrollbarSize;
 
     ImGui::BeginChild("##path1_scroll", ImVec2(inputWidth, path1ChildH), false, ImGuiWindowFlags_HorizontalScrollbar);
     ImGui::SetNextItemWidth(path1InnerW);
-    ImGui::InputText("##path1", &path1);
+    if (path1Completion.refocus) {
+        ImGui::SetKeyboardFocusHere();
+        path1Completion.refocus = false;
+    }
+    ImGui::InputText("##path1", &path1, kPathInputFlags, PathInputCallback, &path1Completion);
+    const bool path1Active = ImGui::IsItemActive();
     ImGui::EndChild();
 
     ImGui::PopStyleVar(2);
+    RenderPathCompletion("##path1_completion", path1, path1Completion, path1Active, path1Below, inputWidth);
     if (fontInput) ImGui::PopFont();
 
     // Label 2
     if (fontLabel) ImGui::PushFont(fontLabel);
     ImGui::SetCursorPos(ImVec2(contentX, 100 * s));
     ImGui::Text("%s", L.file2Label);
+    renderPathStatus(1, 100 * s);
     if (fontLabel) ImGui::PopFont();
 
     // Input 2
@@ -648,22 +846,32 @@ void App::RenderUI() {
     ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 1.0f);
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(4 * s, (28 * s - ImGui::GetFontSize()) / 2.0f));
     ImGui::SetCursorPos(ImVec2(contentX, 120 * s));
+    const ImVec2 path2Below(ImGui::GetCursorScreenPos().x, ImGui::GetCursorScreenPos().y + 28.0f * s);
 
-    const float path2TextW = ImGui::CalcTextSize(path2.c_str()).x;
+    const float path2TextW = path2Width.Measure(path2);
     const float path2InnerW = (std::max)(inputWidth, path2TextW + 24.0f * s);
     const float path2ChildH = 28.0f * s + ImGui::GetStyle().ScrollbarSize;
 
     ImGui::BeginChild("##path2_scroll", ImVec2(inputWidth, path2ChildH), false, ImGuiWindowFlags_HorizontalScrollbar);
     ImGui::SetNextItemWidth(path2InnerW);
-    ImGui::InputText("##path2", &path2);
+    if (path2Completion.refocus) {
+        ImGui::SetKeyboardFocusHere();
+        path2Completion.refocus = false;
+    }
+    ImGui::InputText("##path2", &path2, kPathInputFlags, PathInputCallback, &path2Completion);
+    const bool path2Active = ImGui::IsItemActive();
     ImGui::EndChild();
 
     ImGui::PopStyleVar(2);
+    RenderPathCompletion("##path2_completion", path2, path2Completion, path2Active, path2Below, inputWidth);
     if (fontInput) ImGui::PopFont();
 
+    profiler.EndSection(UiSection::Inputs);
+
     const float optionY = 160.0f * s;
     const float startBtnY = 190.0f * s;
 
+    profiler.BeginSection(UiSection::Options);
     if (fontLabel) ImGui::PushFont(fontLabel);
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(4.0f * s, 1.0f * s));
     ImGui::SetCursorPos(ImVec2(contentX, optionY));
@@ -676,14 +884,30 @@ void App::RenderUI() {
     }
     ImGui::PopStyleVar();
     if (fontLabel) ImGui::PopFont();
+    profiler.EndSection(UiSection::Options);
 
     // Exchange button
-    if (fontStartBtn) ImGui::PushFont(fontStartBtn);
+    profiler.BeginSection(UiSection::StartButton);
     float btnW = 124 * s;
     float btnH2 = 44 * s;
+
+    // Pin-pair button, left of the start button
+    if (fontLabel) ImGui::PushFont(fontLabel);
+    ImGui::SetCursorPos(ImVec2(contentX, startBtnY + 10.0f * s));
+    ImGui::BeginDisabled(path1.empty() || path2.empty() || pinnedPairs.size() >= kMaxPinnedPairs);
+    if (ImGui::Button(L.pairPinButton, ImVec2((winW - btnW) / 2.0f - 8.0f * s - contentX, 24.0f * s))) {
+        std::vector<PinnedPair> pairs;
+        for (const auto& pinned : pinnedPairs) pairs.push_back(pinned->Pair());
+        pairs.push_back(PinnedPair{Utf8ToUtf16(path1), Utf8ToUtf16(path2), preserveExt});
+        ApplyPinnedPairs(pairs, true);
+    }
+    ImGui::EndDisabled();
+    if (fontLabel) ImGui::PopFont();
+
+    if (fontStartBtn) ImGui::PushFont(fontStartBtn);
     ImGui::SetCursorPos(ImVec2((winW - btnW) / 2.0f, startBtnY));
     if (ImGui::Button(L.startButton, ImVec2(btnW, btnH2))) {
-        int returnId = exchange(path1.c_str(), path2.c_str(), preserveExt);
+        int returnId = RunExchange(path1, path2, preserveExt);
         if (returnId == 0) {
             path1.clear();
             path2.clear();
@@ -695,10 +919,408 @@ void App::RenderUI() {
     }
     if (fontStartBtn) ImGui::PopFont();
 
+    // Add-to-queue button, right of the start button
+    if (fontLabel) ImGui::PushFont(fontLabel);
+    const float queueBtnX = (winW + btnW) / 2.0f + 8.0f * s;
+    ImGui::SetCursorPos(ImVec2(queueBtnX, startBtnY + 10.0f * s));
+    ImGui::BeginDisabled(path1.empty() || path2.empty());
+    if (ImGui::Button(L.queueAddButton, ImVec2(winW - contentX - queueBtnX, 24.0f * s))) {
+        swapQueue.Add(path1, path2, preserveExt);
+        path1.clear();
+        path2.clear();
+    }
+    ImGui::EndDisabled();
+    if (fontLabel) ImGui::PopFont();
+    profiler.EndSection(UiSection::StartButton);
+
+    if (queuePanelShown) {
+        profiler.BeginSection(UiSection::Queue);
+        RenderQueuePanel(240.0f * s);
+        profiler.EndSection(UiSection::Queue);
+    }
+
+    if (showProfilerOverlay) {
+        RenderProfilerOverlay();
+    }
+
     ImGui::End();
     ImGui::PopStyleVar();  // WindowPadding
 }
 
+void App::ApplyPinnedPairs(const std::vector<PinnedPair>& pairs, bool save) {
+    for (size_t i = 0; i < pinnedPairs.size(); ++i) {
+        UnregisterHotKey(hwnd, kPinHotkeyBase + static_cast<int>(i));
+    }
+    pinnedPairs.clear();
+    for (size_t i = 0; i < pairs.size() && i < kMaxPinnedPairs; ++i) {
+        pinnedPairs.push_back(std::make_unique<PinnedSwap>(pairs[i]));
+        // Another program may own the combination; the tray entry still works then
+        RegisterHotKey(hwnd, kPinHotkeyBase + static_cast<int>(i), MOD_CONTROL | MOD_ALT | MOD_NOREPEAT,
+                       '1' + static_cast<UINT>(i));
+    }
+    if (save) {
+        SavePinnedPairs(pairs);
+    }
+}
+
+void App::TogglePinnedPair(size_t index) {
+    if (index >= pinnedPairs.size()) {
+        return;
+    }
+    const int returnId = pinnedPairs[index]->Toggle();
+    if (returnId != 0) {
+        const auto& L = GetCurrentLocale();
+        std::wstring winfo = Utf8ToUtf16(GetOutputInfo(returnId));
+        if (returnId == kResultHalfSwapped) {
+            for (int i = 0; i < 2; ++i) winfo += L"\n" + pinnedPairs[index]->StrandedPaths()[i];
+        }
+        MessageBoxW(hwnd, winfo.c_str(), L.errorTitle, MB_OK | MB_ICONERROR);
+    }
+}
+
+void App::ShowTrayContextMenu() {
+    std::vector<std::wstring> labels;
+    for (size_t i = 0; i < pinnedPairs.size(); ++i) {
+        const PinnedPair& pair = pinnedPairs[i]->Pair();
+        std::wstring label = std::to_wstring(i + 1) + L". " + std::filesystem::path(pair.path1).filename().wstring() +
+                             L" \u21C4 " + std::filesystem::path(pair.path2).filename().wstring();
+        if (const double us = pinnedPairs[i]->MedianToggleUs(); us > 0.0) {
+            wchar_t latency[32];
+            swprintf_s(latency, L"  (%.2f ms)", us / 1000.0);
+            label += latency;
+        }
+        label += L"\tCtrl+Alt+" + std::to_wstring(i + 1);
+        labels.push_back(std::move(label));
+    }
+
+    const UINT cmd = ShowTrayMenu(hwnd, labels);
+    if (cmd == kTrayCmdExit) {
+        PostQuitMessage(0);
+    } else if (cmd >= kTrayCmdToggle && cmd < kTrayCmdToggle + kMaxPinnedPairs) {
+        TogglePinnedPair(cmd - kTrayCmdToggle);
+    } else if (cmd >= kTrayCmdUnpin && cmd < kTrayCmdUnpin + kMaxPinnedPairs) {
+        std::vector<PinnedPair> pairs;
+        for (const auto& pinned : pinnedPairs) pairs.push_back(pinned->Pair());
+        if (cmd - kTrayCmdUnpin < pairs.size()) {
+            pairs.erase(pairs.begin() + (cmd - kTrayCmdUnpin));
+            ApplyPinnedPairs(pairs, true);
+        }
+    }
+}
+
+void App::RunSwapQueue(bool autoRunOnly) {
+    swapQueue.Run([this](const std::string& p1, const std::string& p2, bool preserve) {
+        return batchVfs->Exchange(p1, p2, preserve);
+    }, pipelineDepth, [rules = nameRules](const PathStore& paths, const std::vector<SwapEntry>& batch) {
+        // A name the volume rejects is reported first; the swap would fail on it either way
+        std::vector<int> codes = FindInvalidNames(paths, batch, rules);
+        const std::vector<int> collisions = FindNameCollisions(paths, batch);
+        for (size_t i = 0; i < codes.size(); ++i) {
+            if (codes[i] == kResultSuccess) codes[i] = collisions[i];
+        }
+        return codes;
+    }, autoRunOnly);
+}
+
+float App::WindowHeight() const { return (queuePanelShown ? 240.0f + kQueuePanelHeight : 240.0f) * dpiScale; }
+
+void App::UpdatePathStatus() {
+    if (!pathValidator) {
+        return;
+    }
+    PathStatusState& status = pathStatus;
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t generation = pathValidator->Generation();
+    if (path1 == status.path1 && path2 == status.path2 && preserveExt == status.preserveExt &&
+        generation == status.generation && now - status.checked < kPathStatusRecheck) {
+        return;
+    }
+    status.path1 = path1;
+    status.path2 = path2;
+    status.preserveExt = preserveExt;
+    status.generation = generation;
+    status.checked = now;
+
+    const auto& L = GetCurrentLocale();
+    const std::string* paths[2] = {&path1, &path2};
+    const PathProbe items[2] = {pathValidator->Query(0, path1), pathValidator->Query(1, path2)};
+    for (int i = 0; i < 2; ++i) {
+        const PathProbe& item = items[i];
+        const PathProbe& other = items[1 - i];
+        status.text[i] = nullptr;
+        status.error[i] = true;
+        switch (item.state) {
+            case PathProbe::State::Unknown:
+                break;
+            case PathProbe::State::Missing:
+                status.text[i] = L.pathStatusMissing;
+                break;
+            case PathProbe::State::Invalid:
+                status.text[i] = L.pathStatusInvalid;
+                break;
+            case PathProbe::State::File:
+            case PathProbe::State::Directory: {
+                const bool directory = item.state == PathProbe::State::Directory;
+                if (item.SameItem(other)) {
+                    status.text[i] = L.pathStatusSameItem;
+                    break;
+                }
+                if (other.Exists()) {
+                    // The new name is taken unless by one of the two items themselves (a case-only swap)
+                    const std::wstring self = Utf8ToUtf16(*paths[i]);
+                    const std::wstring peer = Utf8ToUtf16(*paths[1 - i]);
+                    const std::wstring target = SwappedLocation(self, peer, directory, preserveExt);
+                    const PathProbe taken = pathValidator->Query(2 + i, Utf16ToUtf8(target));
+                    const std::wstring folded = FoldName(target);
+                    if (taken.Exists() && !taken.SameItem(item) && !taken.SameItem(other) &&
+                        folded != FoldName(self) && folded != FoldName(peer)) {
+                        status.text[i] = L.pathStatusCollision;
+                        break;
+                    }
+                }
+                status.text[i] = directory ? L.pathStatusDirectory : L.pathStatusFile;
+                status.error[i] = false;
+                break;
+            }
+        }
+    }
+}
+
+void App::RenderPathCompletion(const char* id, std::string& path, PathCompletionState& state, bool active, ImVec2 pos,
+                               float width) {
+    if (!pathCompleter || (!active && !state.hovered)) {
+        state.hovered = false;
+        return;
+    }
+    // Looked up again only when the text changed, or while the folder is still being listed
+    if (path != state.query || !state.ready) {
+        state.ready = pathCompleter->Complete(path, kMaxPathSuggestions, state.suggestions);
+        state.query = path;
+        state.selected = 0;
+    }
+    if (state.suggestions.empty() || (state.suggestions.size() == 1 && state.suggestions[0].path == path)) {
+        state.hovered = false;
+        return;
+    }
+
+    ImGui::SetNextWindowPos(pos);
+    ImGui::SetNextWindowSizeConstraints(ImVec2(width, 0.0f), ImVec2(width, FLT_MAX));
+    ImGui::Begin(id, nullptr,
+                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings |
+                     ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav |
+                     ImGuiWindowFlags_AlwaysAutoResize);
+    // Clicking the main window would otherwise raise it over the list
+    ImGui::BringWindowToDisplayFront(ImGui::GetCurrentWindow());
+    for (size_t i = 0; i < state.suggestions.size(); ++i) {
+        const PathSuggestion& suggestion = state.suggestions[i];
+        ImGui::PushID(static_cast<int>(i));
+        const std::string label = suggestion.directory ? suggestion.name + "\\" : suggestion.name;
+        if (ImGui::Selectable(label.c_str(), static_cast<int>(i) == state.selected)) {
+            path = suggestion.path;
+            state.refocus = true;
+        }
+        ImGui::PopID();
+    }
+    state.hovered = ImGui::IsWindowHovered();
+    ImGui::End();
+}
+
+void App::RenderThrottlePopup() {
+    const auto& L = GetCurrentLocale();
+    if (!ImGui::BeginPopup("##throttle")) {
+        return;
+    }
+    ThrottleSettings settings = throttle.Settings();
+    bool changed = false;
+
+    float rate = static_cast<float>(settings.opsPerSecond);
+    ImGui::SetNextItemWidth(120 * dpiScale);
+    if (ImGui::DragFloat(L.throttleRateLabel, &rate, 1.0f, 0.0f, 10000.0f, rate > 0.0f ? "%.0f" : L.throttleUnlimited,
+                         ImGuiSliderFlags_AlwaysClamp)) {
+        settings.opsPerSecond = rate;
+        changed = true;
+    }
+    int inFlight = static_cast<int>(settings.maxInFlight);
+    ImGui::SetNextItemWidth(120 * dpiScale);
+    if (ImGui::DragInt(L.throttleInFlightLabel, &inFlight, 0.1f, 0, 256, inFlight > 0 ? "%d" : L.throttleUnlimited,
+                       ImGuiSliderFlags_AlwaysClamp)) {
+        settings.maxInFlight = static_cast<uint32_t>(inFlight);
+        changed = true;
+    }
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox(L.throttleAutoLabel, &settings.adaptive);
+    if (settings.adaptive) {
+        // The number above is the ceiling the tuner stays under
+        const TuningStats tuning = throttle.Tuning();
+        ImGui::TextDisabled(L.throttleTuningStatus, tuning.limit, tuning.p99Ms, tuning.baselineMs,
+                            static_cast<unsigned long long>(tuning.raises),
+                            static_cast<unsigned long long>(tuning.cuts));
+    }
+    changed |= ImGui::Checkbox(L.throttleBackgroundLabel, &settings.background);
+
+    if (changed) {
+        throttle.Apply(settings);
+    }
+    ImGui::EndPopup();
+}
+
+void App::RenderQueuePanel(float top) {
+    const auto& L = GetCurrentLocale();
+    const float s = dpiScale;
+    const float contentX = 11 * s;
+    const float panelW = 364 * s - contentX * 2;
+    const float spacing = ImGui::GetStyle().ItemSpacing.x;
+
+    if (fontInput) ImGui::PushFont(fontInput);
+    ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 1.0f);
+
+    // Toolbar: state filter, text filter, run, clear
+    const float comboW = 80 * s;
+    const float runW = 48 * s;
+    const float clearW = 96 * s;
+    ImGui::SetCursorPos(ImVec2(contentX, top + 4 * s));
+    const char* filterNames[] = {L.stateAll, L.statePending, L.stateRunning, L.stateDone, L.stateFailed};
+    int filterIndex = static_cast<int>(queueView.filter);
+    ImGui::SetNextItemWidth(comboW);
+    if (ImGui::Combo("##queue_filter", &filterIndex, filterNames, IM_ARRAYSIZE(filterNames))) {
+        queueView.filter = static_cast<QueueFilter>(filterIndex);
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(panelW - comboW - runW - clearW - spacing * 3);
+    ImGui::InputTextWithHint("##queue_text", L.queueFilterHint, &queueView.filterText);
+    ImGui::SameLine();
+    ImGui::BeginDisabled(swapQueue.IsRunning() || swapQueue.Count(SwapState::Pending) == 0);
+    if (ImGui::Button(L.queueRunButton, ImVec2(runW, 0))) {
+        RunSwapQueue();
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(swapQueue.IsRunning() || swapQueue.Finished() == 0);
+    if (ImGui::Button(L.queueClearButton, ImVec2(clearW, 0))) {
+        swapQueue.ClearFinished();
+    }
+    ImGui::EndDisabled();
+
+    // Per-state counts
+    ImGui::SetCursorPos(ImVec2(contentX, top + 34 * s));
+    ImGui::Text("%s %zu   %s %zu   %s %zu   %s %zu", L.statePending, swapQueue.Count(SwapState::Pending),
+                L.stateRunning, swapQueue.Count(SwapState::Running), L.stateDone, swapQueue.Count(SwapState::Done),
+                L.stateFailed, swapQueue.Count(SwapState::Failed));
+
+    // Throttle limits, live while a run is going
+    const float limitsW = ImGui::CalcTextSize(L.queueLimitsButton).x + ImGui::GetStyle().FramePadding.x * 2;
+    ImGui::SetCursorPos(ImVec2(contentX + panelW - limitsW, top + 32 * s));
+    if (ImGui::SmallButton(L.queueLimitsButton)) {
+        ImGui::OpenPopup("##throttle");
+    }
+    RenderThrottlePopup();
+
+    // Only the visible rows are laid out; the filtered/sorted order lives in queueView
+    ImGui::SetCursorPos(ImVec2(contentX, top + 56 * s));
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable;
+    if (ImGui::BeginTable("##queue", 4, flags, ImVec2(panelW, (kQueuePanelHeight - 62.0f) * s))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("#", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_WidthFixed, 44 * s,
+                                static_cast<ImGuiID>(QueueSortKey::Order));
+        ImGui::TableSetupColumn(L.file1Label, ImGuiTableColumnFlags_WidthStretch, 0.0f,
+                                static_cast<ImGuiID>(QueueSortKey::Path1));
+        ImGui::TableSetupColumn(L.file2Label, ImGuiTableColumnFlags_WidthStretch, 0.0f,
+                                static_cast<ImGuiID>(QueueSortKey::Path2));
+        ImGui::TableSetupColumn(L.queueStatusColumn, ImGuiTableColumnFlags_WidthFixed, 88 * s,
+                                static_cast<ImGuiID>(QueueSortKey::Status));
+        ImGui::TableHeadersRow();
+
+        if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && specs->SpecsDirty) {
+            if (specs->SpecsCount > 0) {
+                queueView.sortKey = static_cast<QueueSortKey>(specs->Specs[0].ColumnUserID);
+                queueView.descending = specs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+            }
+            specs->SpecsDirty = false;
+        }
+
+        std::string rowPath;  // Visible rows rebuild their paths into one buffer
+        swapQueue.Read([&](const PathStore& paths, const std::vector<SwapEntry>& entries) {
+            queueView.Update(paths, entries, swapQueue.Revision(), swapQueue.LayoutRevision());
+            const auto& rows = queueView.Rows();
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(rows.size()));
+            while (clipper.Step()) {
+                for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; ++r) {
+                    const uint32_t index = rows[static_cast<size_t>(r)];
+                    const SwapEntry& entry = entries[index];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%u", index + 1);
+                    ImGui::TableNextColumn();
+                    const std::string_view path1 = paths.Path(entry.path1, rowPath);
+                    ImGui::TextUnformatted(path1.data(), path1.data() + path1.size());
+                    ImGui::TableNextColumn();
+                    const std::string_view path2 = paths.Path(entry.path2, rowPath);
+                    ImGui::TextUnformatted(path2.data(), path2.data() + path2.size());
+                    ImGui::TableNextColumn();
+                    switch (entry.state) {
+                        case SwapState::Pending:
+                            ImGui::TextDisabled("%s", L.statePending);
+                            break;
+                        case SwapState::Running:
+                            ImGui::TextUnformatted(L.stateRunning);
+                            break;
+                        case SwapState::Done:
+                            ImGui::TextUnformatted(L.stateDone);
+                            break;
+                        case SwapState::Failed:
+                            ImGui::PushStyleColor(ImGuiCol_Text, kErrorTextColor);
+                            ImGui::TextUnformatted(GetOutputInfo(entry.code));
+                            ImGui::PopStyleColor();
+                            break;
+                    }
+                }
+            }
+        });
+        ImGui::EndTable();
+    }
+
+    ImGui::PopStyleVar();
+    if (fontInput) ImGui::PopFont();
+}
+
+void App::RenderProfilerOverlay() {
+    char line[96];
+    ImDrawList* drawList = ImGui::GetForegroundDrawList();
+    const float lineH = ImGui::GetTextLineHeight();
+    ImVec2 pos(4.0f * dpiScale, 34.0f * dpiScale);
+    const ImU32 color = ImGui::GetColorU32(ImGuiCol_Text, 0.75f);
+
+    const auto& frame = profiler.Frame();
+    snprintf(line, sizeof(line), "frame %.1f us (avg %.1f, max %.1f)", frame.lastUs, frame.avgUs, frame.maxUs);
+    drawList->AddText(pos, color, line);
+    for (int i = 0; i < static_cast<int>(UiSection::Count); ++i) {
+        const auto section = static_cast<UiSection>(i);
+        const auto& stats = profiler.Section(section);
+        pos.y += lineH;
+        snprintf(line, sizeof(line), "  %-8s %.1f us (avg %.1f)", FrameProfiler::Name(section), stats.lastUs,
+                 stats.avgUs);
+        drawList->AddText(pos, color, line);
+    }
+}
+
+float TextWidthCache::Measure(const std::string& str) {
+    const ImFont* currentFont = ImGui::GetFont();
+    const float currentSize = ImGui::GetFontSize();
+    if (currentFont != font || currentSize != fontSize || str != text) {
+        text = str;
+        font = currentFont;
+        fontSize = currentSize;
+        width = ImGui::CalcTextSize(str.c_str()).x;
+    }
+    return width;
+}
+
+int App::RunExchange(const std::string& p1, const std::string& p2, bool preserve) const {
+    return vfs->Exchange(p1, p2, preserve);
+}
+
 void App::CreateSendToShortcut(bool remove) {
     const auto& L = GetCurrentLocale();
 
@@ -756,13 +1378,35 @@ LRESULT App::HandleMessage(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             PostQuitMessage(0);
             return 0;
 
-        case WM_THEMECHANGED:
+        case WM_ACTIVATE:
+            isForeground = LOWORD(wParam) != WA_INACTIVE;
+            break;
+
         case WM_SETTINGCHANGE:
+            // Only the color-set broadcast concerns the theme; the registry keys cover the rest
+            if (!lParam || wcscmp(reinterpret_cast<const wchar_t*>(lParam), L"ImmersiveColorSet") != 0) {
+                return 0;
+            }
+            [[fallthrough]];
+        case WM_THEMECHANGED:
+        case WM_SYSCOLORCHANGE:
+        case WM_DWMCOLORIZATIONCOLORCHANGED:
+        case WM_APP_SETTINGS_CHANGED:
             if (ImGui::GetCurrentContext()) {
-                ApplySystemTheme();
+                QueueThemeRefresh();
             }
             return 0;
 
+        case WM_TIMER:
+            if (wParam == kThemeTimerId) {
+                if (themeChanges.Poll(ChangeCoalescer::Clock::now())) {
+                    KillTimer(hwnd, kThemeTimerId);
+                    RefreshSystemTheme();
+                }
+                return 0;
+            }
+            break;
+
         case WM_DPICHANGED: {
             UpdateDpiScale();
             RECT* pRect = reinterpret_cast<RECT*>(lParam);
@@ -770,18 +1414,7 @@ LRESULT App::HandleMessage(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                          SWP_NOZORDER | SWP_NOACTIVATE);
 
             // Rebuild fonts with new DPI
-            ImGuiIO& io = ImGui::GetIO();
-            io.Fonts->Clear();
-
-            fontLabel = LoadMsyhFont(io, 16.0f * dpiScale);
-            fontInput = LoadMsyhFont(io, 15.0f * dpiScale);
-            fontStartBtn = LoadMsyhFont(io, 24.0f * dpiScale);
-
-            ImFontConfig cfg;
-            cfg.FontDataOwnedByAtlas = false;
-            fontIcon = io.Fonts->AddFontFromMemoryTTF(const_cast<unsigned char*>(kIconFontData),
-                                                      static_cast<int>(kIconFontDataSize), 15.0f * dpiScale, &cfg);
-
+            RebuildFonts();
             ImGui_ImplDX11_InvalidateDeviceObjects();
             return 0;
         }
@@ -790,39 +1423,41 @@ LRESULT App::HandleMessage(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             HDROP hDrop = reinterpret_cast<HDROP>(wParam);
             UINT count = DragQueryFileW(hDrop, 0xFFFFFFFF, nullptr, 0);
 
-            if (count == 1) {
-                UINT len = DragQueryFileW(hDrop, 0, nullptr, 0);
+            std::vector<std::string> files;
+            for (UINT i = 0; i < count; ++i) {
+                UINT len = DragQueryFileW(hDrop, i, nullptr, 0);
                 std::wstring file(len + 1, L'\0');
-                DragQueryFileW(hDrop, 0, file.data(), len + 1);
+                DragQueryFileW(hDrop, i, file.data(), len + 1);
                 file.resize(len);
-                std::string u8file = Utf16ToUtf8(file);
-
-                if (path1.empty()) {
-                    path1 = u8file;
-                } else if (path2.empty()) {
-                    path2 = u8file;
-                } else {
-                    path1 = u8file;
-                    path2.clear();
-                }
-            } else if (count >= 2) {
-                UINT len1 = DragQueryFileW(hDrop, 0, nullptr, 0);
-                std::wstring file1(len1 + 1, L'\0');
-                DragQueryFileW(hDrop, 0, file1.data(), len1 + 1);
-                file1.resize(len1);
-
-                UINT len2 = DragQueryFileW(hDrop, 1, nullptr, 0);
-                std::wstring file2(len2 + 1, L'\0');
-                DragQueryFileW(hDrop, 1, file2.data(), len2 + 1);
-                file2.resize(len2);
-
-                path1 = Utf16ToUtf8(file1);
-                path2 = Utf16ToUtf8(file2);
+                files.push_back(Utf16ToUtf8(file));
             }
             DragFinish(hDrop);
+            AcceptDroppedPaths(files);
+            return 0;
+        }
+
+        case WM_APP_WATCH_BATCH:
+            // Only what the watch rules queued; pairs added by hand wait for Start
+            RunSwapQueue(true);
             return 0;
+
+        case WM_COPYDATA: {
+            // "--max-rate" and friends passed to a second instance
+            ThrottleUpdate update;
+            const auto* data = reinterpret_cast<const COPYDATASTRUCT*>(lParam);
+            if (!data || !ReadThrottleUpdate(*data, update)) {
+                return FALSE;
+            }
+            throttle.Apply(MergeThrottleUpdate(throttle.Settings(), update));
+            return TRUE;
         }
 
+        case WM_HOTKEY:
+            if (wParam >= kPinHotkeyBase && wParam < kPinHotkeyBase + kMaxPinnedPairs) {
+                TogglePinnedPair(wParam - kPinHotkeyBase);
+            }
+            return 0;
+
         case WM_USER + 1: {
             switch (lParam) {
                 case WM_LBUTTONUP:
@@ -833,7 +1468,7 @@ LRESULT App::HandleMessage(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                     }
                     break;
                 case WM_RBUTTONUP:
-                    PostQuitMessage(0);
+                    ShowTrayContextMenu();
                     break;
             }
             return 0;
@@ -842,6 +1477,50 @@ LRESULT App::HandleMessage(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     return DefWindowProcW(hWnd, msg, wParam, lParam);
 }
 
+void App::AcceptDroppedPaths(const std::vector<std::string>& files) {
+    if (files.size() > 2) {
+        // Consecutive items form pairs; an odd one out goes into the first input
+        for (size_t i = 0; i + 1 < files.size(); i += 2) {
+            swapQueue.Add(files[i], files[i + 1], preserveExt);
+        }
+        if (files.size() % 2 != 0) {
+            path1 = files.back();
+            path2.clear();
+        }
+    } else if (files.size() == 1) {
+        if (path1.empty()) {
+            path1 = files[0];
+        } else if (path2.empty()) {
+            path2 = files[0];
+        } else {
+            path1 = files[0];
+            path2.clear();
+        }
+    } else if (files.size() >= 2) {
+        path1 = files[0];
+        path2 = files[1];
+    }
+}
+
+void App::RebuildFonts() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts->Clear();
+
+    fontLabel = LoadMsyhFont(io, 16.0f * dpiScale);
+
+    // Input font (15pt)
+    fontInput = LoadMsyhFont(io, 15.0f * dpiScale);
+
+    // Start button font (24pt)
+    fontStartBtn = LoadMsyhFont(io, 24.0f * dpiScale);
+
+    // Icon font (15pt for title bar buttons)
+    ImFontConfig cfg;
+    cfg.FontDataOwnedByAtlas = false;
+    fontIcon = io.Fonts->AddFontFromMemoryTTF(const_cast<unsigned char*>(kIconFontData),
+                                              static_cast<int>(kIconFontDataSize), 15.0f * dpiScale, &cfg);
+}
+
 auto App::LoadMsyhFont(ImGuiIO& io, float size) -> ImFont* {
     const char* fps[] = {"c:\\Windows\\Fonts\\msyh.ttc", "c:\\Windows\\Fonts\\msyh.ttf"};
     for (const char* fp : fps) {
@@ -1,22 +1,105 @@
 #pragma once
 
+#include "change_coalescer.h"
 #include "d3d_helpers.h"
+#include "frame_profiler.h"
 #include "imgui.h"
+#include "name_rules.h"
+#include "path_completion.h"
+#include "path_validator.h"
+#include "pinned_pairs.h"
+#include "queue_view.h"
+#include "settings_observer.h"
+#include "swap_queue.h"
+#include "theme_palette.h"
+#include "throttle.h"
+#include "vfs.h"
+#include "watch_service.h"
+#include <chrono>
+#include <memory>
 #include <string>
+#include <vector>
 #include <windows.h>
 
 // Forward declare ImFont
 struct ImFont;
 
+// Width of a string in the current font; re-measured only when the text, font or font size changes
+struct TextWidthCache {
+    std::string text;
+    const ImFont* font = nullptr;
+    float fontSize = 0.0f;
+    float width = 0.0f;
+
+    float Measure(const std::string& str);
+};
+
+// Completion list under one path input
+struct PathCompletionState {
+    std::string query;   // Text the suggestions were looked up for
+    bool ready = false;  // The folder listing was cached at the time; otherwise look again next frame
+    std::vector<PathSuggestion> suggestions;
+    int selected = 0;       // Taken by Tab; moved with the arrow keys
+    bool hovered = false;   // The list was under the mouse last frame: a click on it is not a focus loss
+    bool refocus = false;   // A suggestion was clicked; give the input its focus back
+};
+
+// What the path inputs point at, shown right of their labels. Looked up again only when an input
+// or the swap mode changed, a stat finished, or the last look is older than kPathStatusRecheck.
+struct PathStatusState {
+    std::string path1;
+    std::string path2;
+    bool preserveExt = true;
+    uint64_t generation = 0;
+    std::chrono::steady_clock::time_point checked;
+    const char* text[2] = {};  // nullptr while nothing is known
+    bool error[2] = {};
+};
+
 // Application state and UI
 struct App {
     std::string path1 = "";
     std::string path2 = "";
     bool preserveExt = true;
+    std::unique_ptr<Vfs> vfs;   // Real file system (verified with --verify), or --simulate-latency's stand-in
+    size_t pipelineDepth = 1;   // --pipeline-depth: queued swaps kept in flight at once
+    NameRules nameRules = NameRules::Windows;  // --name-rules: new names a queued swap may give
+    SwapThrottle throttle;      // Limits for batch runs, adjustable from the queue panel or WM_COPYDATA
+    std::unique_ptr<Vfs> batchVfs;  // vfs behind throttle, used by the swap queue and "-" mode
 
     bool isTopmost = true;
     bool showWindow = true;
     bool done = false;
+    int exitCode = 0;  // Returned by the process when Init ends it early ("-", --manifest, --plan, errors)
+
+    // Cached system state, updated by events instead of re-queried every frame
+    bool runningAsAdmin = false;  // Fixed for the lifetime of the process token
+    bool isForeground = false;    // Tracked through WM_ACTIVATE
+    TextWidthCache path1Width;
+    TextWidthCache path2Width;
+
+    // Completion of the path inputs from cached folder listings (window mode only)
+    std::unique_ptr<PathCompleter> pathCompleter;
+    PathCompletionState path1Completion;
+    PathCompletionState path2Completion;
+
+    // Live status of the path inputs (window mode and --ui-bench)
+    std::unique_ptr<PathValidator> pathValidator;
+    PathStatusState pathStatus;
+
+    FrameProfiler profiler;
+    bool showProfilerOverlay = false;  // --profile-frames
+
+    // Pending-swap queue, shown below the main form while it has entries
+    SwapQueue swapQueue;
+    QueueView queueView;
+    bool queuePanelShown = false;
+
+    // --watch rules; settled pairs are appended to swapQueue and run immediately
+    WatchService watchService;
+
+    // Pinned pairs, toggled with Ctrl+Alt+<n> or from the tray menu
+    std::vector<std::unique_ptr<PinnedSwap>> pinnedPairs;
 
     HWND hwnd = nullptr;
     D3DState d3d = {};
@@ -39,6 +122,13 @@ struct App {
     ImVec4 tooltipBgColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
     ImVec4 tooltipTextColor = ImVec4(0.0f, 0.0f, 0.0f, 1.0f);
 
+    // Theme change tracking: registry notifications and theme messages are coalesced, and the
+    // style is only rebuilt when the inputs and then the derived palette actually differ
+    SettingsObserver settingsObserver;
+    ChangeCoalescer themeChanges{kThemeRefreshQuiet, kThemeRefreshMaxDelay};
+    ThemeInputs themeInputs;
+    ThemePalette themePalette = {};
+
     // Initialize the application (create window, D3D, ImGui, tray)
     bool Init(HINSTANCE hInstance, int argc, wchar_t** argv);
 
@@ -51,6 +141,41 @@ struct App {
     // Render one frame of the UI
     void RenderUI();
 
+    // Draw the --profile-frames timings on top of the UI
+    void RenderProfilerOverlay();
+
+    // Show the completions of path below its input (at pos, width wide) while it is being edited
+    void RenderPathCompletion(const char* id, std::string& path, PathCompletionState& state, bool active, ImVec2 pos,
+                              float width);
+
+    // Refresh pathStatus from pathValidator if anything it depends on changed
+    void UpdatePathStatus();
+
+    // Render the swap queue panel starting at the given y offset
+    void RenderQueuePanel(float top);
+
+    // Client height in pixels, including the queue panel when it is shown
+    float WindowHeight() const;
+
+    // Replace the pinned pairs, re-register their hotkeys and optionally persist them
+    void ApplyPinnedPairs(const std::vector<PinnedPair>& pairs, bool save);
+
+    // Toggle pinned pair i, reporting failures like the start button does
+    void TogglePinnedPair(size_t index);
+
+    // Show the tray context menu and carry out the chosen command
+    void ShowTrayContextMenu();
+
+    // Start the swap queue worker on batchVfs (no-op while it is already running); with autoRunOnly
+    // it runs only the pairs queued by watch rules
+    void RunSwapQueue(bool autoRunOnly = false);
+
+    // Edit the batch throttle in a popup anchored to the queue toolbar
+    void RenderThrottlePopup();
+
+    // Swap two paths on vfs; returns an exchange() code
+    int RunExchange(const std::string& p1, const std::string& p2, bool preserve) const;
+
     // Create or remove the "Send To" shortcut
     void CreateSendToShortcut(bool remove);
 
@@ -60,11 +185,26 @@ struct App {
     // Get DPI scale factor for the window
     void UpdateDpiScale();
 
-    // Apply colors from current Windows theme settings
+    // Apply colors from current Windows theme settings unconditionally
     void ApplySystemTheme();
 
+    // Re-read the theme settings and re-apply the style only if the palette changed
+    void RefreshSystemTheme();
+
+    // Note a possible theme change; RefreshSystemTheme runs once the burst has settled
+    void QueueThemeRefresh();
+
+    // Set the ImGui style and App colors from palette
+    void ApplyThemePalette(const ThemePalette& palette);
+
     // Load MSYH font with the given size
     ImFont* LoadMsyhFont(ImGuiIO& io, float size);
+
+    // (Re)load all UI fonts for the current dpiScale
+    void RebuildFonts();
+
+    // Fill the path inputs from 1 or 2 dropped items; larger drops are queued as consecutive pairs
+    void AcceptDroppedPaths(const std::vector<std::string>& files);
 };
 
 // Global app instance (needed for WndProc callback)
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+
+// Folds a burst of change notifications into one action. Each Notify pushes the deadline out to
+// `quiet` after the latest event, but never past `maxDelay` after the first one, so a steady storm
+// still gets acted on. Poll reports true once per burst when its deadline has passed.
+class ChangeCoalescer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ChangeCoalescer(Clock::duration quiet, Clock::duration maxDelay) : quiet_(quiet), maxDelay_(maxDelay) {}
+
+    // Record an event; returns the time the burst will be due
+    Clock::time_point Notify(Clock::time_point now) {
+        if (!pending_) {
+            pending_ = true;
+            first_ = now;
+        }
+        const Clock::time_point latest = first_ + maxDelay_;
+        deadline_ = (now + quiet_ < latest) ? now + quiet_ : latest;
+        return deadline_;
+    }
+
+    // True (and the burst is cleared) if a burst is pending and due
+    bool Poll(Clock::time_point now) {
+        if (!pending_ || now < deadline_) return false;
+        pending_ = false;
+        return true;
+    }
+
+    bool Pending() const { return pending_; }
+    Clock::time_point Deadline() const { return deadline_; }
+
+private:
+    Clock::duration quiet_;
+    Clock::duration maxDelay_;
+    bool pending_ = false;
+    Clock::time_point first_;
+    Clock::time_point deadline_;
+};
@@ -0,0 +1,273 @@
+#include "checkpoint.h"
+
+#include "content_hash.h"
+#include "exchange.h"
+#include "manifest.h"
+#include "parallel.h"
+#include "utils.h"
+#include "verify.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+// Pairs hashed per work item; fixed so the hash does not depend on the thread count
+constexpr size_t kHashChunk = 64 * 1024;
+constexpr uint64_t kBitmapOffset = sizeof(CheckpointHeader) + uint64_t{kCheckpointSlots} * sizeof(CheckpointSlot);
+
+uint64_t BitmapWords(uint64_t pairCount) { return (pairCount + 63) / 64; }
+
+struct Identity {
+    bool valid = false;
+    bool directory = false;
+    bool stable = false;  // File IDs survive renames on this volume (NTFS, ReFS)
+    ULONGLONG volumeSerial = 0;
+    FILE_ID_128 fileId = {};
+};
+
+Identity CaptureIdentity(const std::wstring& path) {
+    Identity id;
+    HANDLE h = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        return id;
+    }
+    FILE_BASIC_INFO basic = {};
+    FILE_ID_INFO idInfo = {};
+    if (GetFileInformationByHandleEx(h, FileBasicInfo, &basic, sizeof(basic)) &&
+        GetFileInformationByHandleEx(h, FileIdInfo, &idInfo, sizeof(idInfo))) {
+        DWORD fsFlags = 0;
+        id.valid = true;
+        id.directory = (basic.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        id.volumeSerial = idInfo.VolumeSerialNumber;
+        id.fileId = idInfo.FileId;
+        id.stable = GetVolumeInformationByHandleW(h, nullptr, 0, nullptr, nullptr, &fsFlags, nullptr, 0) &&
+                    (fsFlags & FILE_SUPPORTS_OPEN_BY_FILE_ID) != 0;
+    }
+    CloseHandle(h);
+    return id;
+}
+
+bool Matches(const Identity& id, const CheckpointSlot& slot) {
+    return id.valid && id.volumeSerial == slot.volumeSerial &&
+           std::memcmp(&id.fileId, slot.fileId, sizeof(slot.fileId)) == 0;
+}
+}  // namespace
+
+uint64_t HashManifest(const Manifest& manifest, bool preserveExt) {
+    const size_t chunks = (manifest.Size() + kHashChunk - 1) / kHashChunk;
+    std::vector<uint64_t> hashes(chunks);
+    ParallelFor(chunks, [&](size_t c) {
+        uint64_t h = c;
+        const size_t end = (std::min)(manifest.Size(), (c + 1) * kHashChunk);
+        for (size_t i = c * kHashChunk; i < end; ++i) {
+            const std::string_view path1 = manifest.Path1(i);
+            const std::string_view path2 = manifest.Path2(i);
+            const bool preserve = manifest.PreserveExt(i).value_or(preserveExt);
+            h = CombineHashes(h, HashBytes(path1.data(), path1.size(), preserve ? 1 : 0));
+            h = CombineHashes(h, HashBytes(path2.data(), path2.size()));
+        }
+        hashes[c] = h;
+    });
+    uint64_t h = manifest.Size();
+    for (uint64_t chunk : hashes) {
+        h = CombineHashes(h, chunk);
+    }
+    return h;
+}
+
+Checkpoint::OpenResult Checkpoint::Open(const std::wstring& path, uint64_t manifestHash, uint64_t pairCount,
+                                        bool resume) {
+    Close();
+    const uint64_t size = kBitmapOffset + 2 * BitmapWords(pairCount) * sizeof(uint64_t);
+
+    // No sharing: two runs must not drive the same checkpoint
+    file_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+                        nullptr);
+    LARGE_INTEGER existing = {};
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &existing)) {
+        Close();
+        return OpenResult::Invalid;
+    }
+
+    const bool fresh = existing.QuadPart == 0;
+    if (!fresh) {
+        CheckpointHeader header = {};
+        DWORD got = 0;
+        const bool valid = ReadFile(file_, &header, sizeof(header), &got, nullptr) && got == sizeof(header) &&
+                           std::memcmp(header.magic, kCheckpointMagic, sizeof(header.magic)) == 0 &&
+                           header.version == kCheckpointVersion && header.slotCount == kCheckpointSlots;
+        const bool sameBatch = valid && header.manifestHash == manifestHash && header.pairCount == pairCount &&
+                               static_cast<uint64_t>(existing.QuadPart) == size;
+        if (!sameBatch || !resume) {
+            Close();
+            return valid && !resume ? OpenResult::Unfinished : OpenResult::Invalid;
+        }
+    } else {
+        LARGE_INTEGER end = {};
+        end.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file_, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) {
+            Close();
+            DeleteFileW(path.c_str());
+            return OpenResult::Invalid;
+        }
+    }
+
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    view_ = mapping_ ? static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+    if (!view_) {
+        Close();
+        if (fresh) DeleteFileW(path.c_str());
+        return OpenResult::Invalid;
+    }
+    path_ = path;
+    slots_ = reinterpret_cast<CheckpointSlot*>(view_ + sizeof(CheckpointHeader));
+    bitmap_ = reinterpret_cast<uint64_t*>(view_ + kBitmapOffset);
+    doubt_ = bitmap_ + BitmapWords(pairCount);
+    pairCount_ = pairCount;
+
+    if (fresh) {
+        // The new tail of the file reads as zeros: no slots in use, no pair done or in doubt
+        CheckpointHeader header = {};
+        std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+        header.version = kCheckpointVersion;
+        header.slotCount = kCheckpointSlots;
+        header.manifestHash = manifestHash;
+        header.pairCount = pairCount;
+        std::memcpy(view_, &header, sizeof(header));
+        Flush();
+    }
+
+    uint64_t completed = 0;
+    for (uint64_t w = 0; w < BitmapWords(pairCount); ++w) {
+        completed += std::popcount(bitmap_[w]);
+    }
+    completed_.store(completed, std::memory_order_relaxed);
+    CollectFreeSlots();
+    return OpenResult::Ok;
+}
+
+void Checkpoint::Close() {
+    if (view_) UnmapViewOfFile(view_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+    view_ = nullptr;
+    slots_ = nullptr;
+    bitmap_ = nullptr;
+    doubt_ = nullptr;
+    pairCount_ = 0;
+    completed_.store(0, std::memory_order_relaxed);
+    sinceFlush_.store(0, std::memory_order_relaxed);
+    freeSlots_.clear();
+}
+
+std::vector<std::pair<uint64_t, int>> Checkpoint::Recover(const Manifest& manifest) {
+    for (uint32_t s = 0; s < kCheckpointSlots; ++s) {
+        CheckpointSlot& slot = slots_[s];
+        const uint64_t i = slot.pair - 1;
+        if (slot.pair == 0) continue;
+        if (i >= pairCount_ || i >= manifest.Size() || InDoubt(i) || Done(i)) {
+            // The run died after settling or marking the pair but before freeing its slot
+            if (i < pairCount_ && InDoubt(i)) MarkDone(i);
+            slot.pair = 0;
+            continue;
+        }
+        const std::wstring w1 = Utf8ToUtf16(std::string(manifest.Path1(i)));
+        const std::wstring w2 = Utf8ToUtf16(std::string(manifest.Path2(i)));
+        const bool preserve = (slot.flags & kSlotPreserveExt) != 0;
+        const bool atSource = Matches(CaptureIdentity(w1), slot);
+        const bool swapped =
+            Matches(CaptureIdentity(SwappedLocation(w1, w2, (slot.flags & kSlotDirectory) != 0, preserve)), slot);
+        if ((slot.flags & kSlotStableId) && atSource != swapped) {
+            if (swapped) MarkDone(i);
+        } else {
+            // Flagged before it is marked, so a run killed in between still reports it next time
+            doubt_[i / 64] |= uint64_t{1} << (i % 64);
+            MarkDone(i);
+        }
+        slot.pair = 0;
+    }
+    Flush();
+    CollectFreeSlots();
+
+    std::vector<std::pair<uint64_t, int>> inDoubt;
+    for (uint64_t w = 0; w < BitmapWords(pairCount_); ++w) {
+        for (uint64_t bits = doubt_[w]; bits != 0; bits &= bits - 1) {
+            inDoubt.emplace_back(w * 64 + std::countr_zero(bits), kResultResumeInDoubt);
+        }
+    }
+    return inDoubt;
+}
+
+void Checkpoint::CollectFreeSlots() {
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    freeSlots_.clear();
+    for (uint32_t s = kCheckpointSlots; s-- > 0;) {
+        if (slots_[s].pair == 0) freeSlots_.push_back(s);
+    }
+}
+
+size_t Checkpoint::Begin(uint64_t i, const std::string& path1, bool preserveExt) {
+    size_t s = 0;
+    {
+        std::unique_lock<std::mutex> lock(slotMutex_);
+        slotFreed_.wait(lock, [this] { return !freeSlots_.empty(); });
+        s = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    const Identity id = CaptureIdentity(Utf8ToUtf16(path1));
+    CheckpointSlot& slot = slots_[s];
+    slot.volumeSerial = id.volumeSerial;
+    std::memcpy(slot.fileId, &id.fileId, sizeof(slot.fileId));
+    slot.flags = (id.directory ? kSlotDirectory : 0) | (id.valid && id.stable ? kSlotStableId : 0) |
+                 (preserveExt ? kSlotPreserveExt : 0);
+    // The pair goes in last: a slot is only ever seen with its identity complete
+    std::atomic_ref<uint64_t>(slot.pair).store(i + 1, std::memory_order_release);
+    return s;
+}
+
+void Checkpoint::End(size_t slot, uint64_t i, bool succeeded) {
+    // Marked before the slot is freed, so there is no moment where a finished swap is unrecorded
+    if (succeeded) MarkDone(i);
+    std::atomic_ref<uint64_t>(slots_[slot].pair).store(0, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(slotMutex_);
+        freeSlots_.push_back(static_cast<uint32_t>(slot));
+    }
+    slotFreed_.notify_one();
+}
+
+void Checkpoint::MarkDone(uint64_t i) {
+    const uint64_t bit = uint64_t{1} << (i % 64);
+    if (std::atomic_ref<uint64_t>(bitmap_[i / 64]).fetch_or(bit, std::memory_order_relaxed) & bit) return;
+    completed_.fetch_add(1, std::memory_order_relaxed);
+    if (sinceFlush_.fetch_add(1, std::memory_order_relaxed) + 1 >= kCheckpointFlushGroup) {
+        // One worker writes the group back while the others carry on swapping
+        std::unique_lock<std::mutex> lock(flushMutex_, std::try_to_lock);
+        if (lock.owns_lock()) {
+            sinceFlush_.store(0, std::memory_order_relaxed);
+            Flush();
+        }
+    }
+}
+
+void Checkpoint::Flush() {
+    FlushViewOfFile(view_, 0);
+    FlushFileBuffers(file_);
+}
+
+bool Checkpoint::Finish() {
+    if (!view_) return false;
+    Flush();
+    if (Completed() < pairCount_) return false;
+    // In-doubt pairs count as done but still need reporting, by every later resume
+    for (uint64_t w = 0; w < BitmapWords(pairCount_); ++w) {
+        if (doubt_[w] != 0) return false;
+    }
+    const std::wstring path = path_;
+    Close();
+    return DeleteFileW(path.c_str()) != FALSE;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <windows.h>
+
+class Manifest;
+
+// Checkpoint file ("--checkpoint <file>"), memory-mapped while a manifest runs:
+//
+//   header   CheckpointHeader at offset 0
+//   slots    slotCount x CheckpointSlot: the pairs being swapped right now
+//   bitmap   one bit per pair, set once the pair swapped successfully; 64-bit words
+//   doubt    one bit per pair, set for a pair a resume could not settle; laid out as the bitmap
+//
+// Writes land in the mapping, which belongs to the system cache, so a killed process loses
+// nothing. The file itself is flushed to disk every kCheckpointFlushGroup completions and at
+// the end; after a power loss the pairs of the last unflushed group may run again.
+struct CheckpointHeader {
+    char magic[8];          // kCheckpointMagic
+    uint32_t version;       // kCheckpointVersion
+    uint32_t slotCount;     // kCheckpointSlots
+    uint64_t manifestHash;  // HashManifest of the batch this checkpoint belongs to
+    uint64_t pairCount;
+    uint64_t reserved[2];
+};
+
+// A pair that was in flight: the identity of the item at path1 just before its swap began
+struct CheckpointSlot {
+    uint64_t pair;  // Pair index + 1; 0 while the slot is free
+    uint64_t volumeSerial;
+    uint8_t fileId[16];
+    uint32_t flags;  // kSlot* bits
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CheckpointHeader) == 48, "checkpoint header layout is fixed");
+static_assert(sizeof(CheckpointSlot) == 40, "checkpoint slot layout is fixed");
+
+constexpr char kCheckpointMagic[8] = {'N', 'X', 'C', 'K', 'P', 'T', '\0', '\x1a'};
+constexpr uint32_t kCheckpointVersion = 2;
+constexpr uint32_t kCheckpointSlots = 256;  // --pipeline-depth is at most 256
+constexpr uint32_t kCheckpointFlushGroup = 1024;
+
+constexpr uint32_t kSlotDirectory = 1;    // The item is a directory (it keeps its extension)
+constexpr uint32_t kSlotStableId = 2;     // The volume keeps file IDs across renames
+constexpr uint32_t kSlotPreserveExt = 4;  // The pair swaps base names only
+
+// Identity of a manifest's batch: every path and the extension handling each pair runs with
+uint64_t HashManifest(const Manifest& manifest, bool preserveExt);
+
+class Checkpoint {
+public:
+    enum class OpenResult {
+        Ok,
+        Invalid,     // Not a checkpoint, cannot be created, or (with resume) for another batch
+        Unfinished,  // Exists, but resume was not requested
+    };
+
+    Checkpoint() = default;
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+    ~Checkpoint() { Close(); }
+
+    // Map the checkpoint of a batch of pairCount pairs, creating it if it does not exist. An existing
+    // checkpoint is only used with resume, and only if it belongs to the same batch.
+    OpenResult Open(const std::wstring& path, uint64_t manifestHash, uint64_t pairCount, bool resume);
+    void Close();
+
+    // Whether pair i already swapped in an earlier run; one bit test
+    bool Done(uint64_t i) const {
+        return (std::atomic_ref<uint64_t>(bitmap_[i / 64]).load(std::memory_order_relaxed) >> (i % 64)) & 1;
+    }
+    uint64_t Completed() const { return completed_.load(std::memory_order_relaxed); }
+    uint64_t Size() const { return pairCount_; }
+
+    // Settle the pairs an earlier run left in flight by looking where their first item is now:
+    // still at path1 means the swap never happened and the pair runs again, at its swapped
+    // location means it finished and counts as done. Anything else (the run died between the
+    // renames, or the volume has no stable file IDs) is marked done so it is never swapped
+    // again, and returned with kResultResumeInDoubt, by this and every later resume, for the
+    // caller to report. In-doubt pairs are kept in their own bitmap, so every slot is free
+    // afterwards. Call before the first Begin.
+    std::vector<std::pair<uint64_t, int>> Recover(const Manifest& manifest);
+
+    // Record that pair i is about to swap; returns the slot to pass to End. Waits for End to free a
+    // slot if all of them are taken, so no swap ever runs unrecorded.
+    size_t Begin(uint64_t i, const std::string& path1, bool preserveExt);
+    // Free the slot; a successful pair is marked done
+    void End(size_t slot, uint64_t i, bool succeeded);
+
+    // Flush everything to disk. Once every pair is done and none is in doubt the checkpoint has
+    // served its purpose and is deleted; returns whether it was. A checkpoint holding in-doubt
+    // pairs is kept so they are reported until the user deletes it.
+    bool Finish();
+
+private:
+    void MarkDone(uint64_t i);
+    bool InDoubt(uint64_t i) const { return (doubt_[i / 64] >> (i % 64)) & 1; }
+    void Flush();
+    void CollectFreeSlots();
+
+    std::wstring path_;
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    char* view_ = nullptr;
+    CheckpointSlot* slots_ = nullptr;
+    uint64_t* bitmap_ = nullptr;
+    uint64_t* doubt_ = nullptr;
+    uint64_t pairCount_ = 0;
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint32_t> sinceFlush_{0};
+
+    std::mutex slotMutex_;
+    std::condition_variable slotFreed_;
+    std::vector<uint32_t> freeSlots_;
+    std::mutex flushMutex_;
+};
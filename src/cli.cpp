@@ -0,0 +1,78 @@
+#include "cli.h"
+
+#include "utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cwchar>
+
+CommandLine ParseCommandLine(int argc, wchar_t** argv) {
+    CommandLine cmd;
+    for (int i = 1; i < argc; ++i) {
+        const std::wstring arg = argv[i] ? argv[i] : L"";
+        if (arg == L"--verify") {
+            cmd.verify = true;
+        } else if (arg == L"--profile-frames") {
+            cmd.profileFrames = true;
+        } else if (arg == L"--ui-bench") {
+            cmd.uiBench = true;
+        } else if (arg == L"--plan") {
+            cmd.plan = true;
+        } else if (arg == L"--resume") {
+            cmd.resume = true;
+        } else if (arg == L"--pipeline-depth") {
+            const std::wstring value = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+            wchar_t* end = nullptr;
+            const unsigned long depth = wcstoul(value.c_str(), &end, 10);
+            cmd.pipelineDepth = (!value.empty() && *end == L'\0' && depth <= 256) ? depth : 0;
+        } else if (arg == L"--simulate-latency") {
+            cmd.simulateLatency = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--swap-metadata") {
+            cmd.swapMetadata = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--manifest") {
+            cmd.manifest = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--compile-manifest") {
+            cmd.compileManifest = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--checkpoint") {
+            cmd.checkpoint = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--workers") {
+            const std::wstring value = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+            wchar_t* end = nullptr;
+            const unsigned long workers = wcstoul(value.c_str(), &end, 10);
+            cmd.workers = (!value.empty() && *end == L'\0' && workers <= 64) ? workers : 0;
+        } else if (arg == L"--shard-worker") {
+            cmd.shardWorker = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--max-rate") {
+            cmd.maxRate = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--max-in-flight") {
+            cmd.maxInFlight = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--io-priority") {
+            cmd.ioPriority = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--name-rules") {
+            cmd.nameRules = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+        } else if (arg == L"--watch") {
+            std::wstring dir = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+            std::wstring pattern = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+            cmd.watch.emplace_back(std::move(dir), std::move(pattern));
+        } else if (arg == L"--pair-rule") {
+            std::array<std::wstring, 3>& rule = cmd.pairRules.emplace_back();
+            for (std::wstring& value : rule) {
+                value = i + 1 < argc && argv[i + 1] ? argv[++i] : L"";
+            }
+        } else {
+            cmd.args.push_back(arg);
+        }
+    }
+    return cmd;
+}
+
+bool ParsePreserveFlag(const wchar_t* rawFlag) {
+    std::string flag = Utf16ToUtf8(rawFlag ? rawFlag : L"");
+    std::transform(flag.begin(), flag.end(), flag.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+
+    if (flag == "f" || flag == "false" || flag == "n" || flag == "0") {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Parsed process command line. Switches start with "--" and may appear anywhere;
+// everything else is kept in order as a positional argument.
+struct CommandLine {
+    std::vector<std::wstring> args;  // Positional arguments, argv[0] excluded
+    bool verify = false;             // --verify: fingerprint both items around the swap
+    bool profileFrames = false;      // --profile-frames: show per-section UI frame timings
+    bool uiBench = false;            // --ui-bench [script]: headless UI benchmark, then exit
+    bool plan = false;               // --plan: with "-", print the execution plan instead of swapping
+    bool resume = false;             // --resume: continue the batch recorded in --checkpoint
+    size_t pipelineDepth = 1;        // --pipeline-depth <n>: swaps kept in flight at once (0 if malformed)
+    // --simulate-latency <rtt[:jitter[:errors]]>: swap on a simulated share instead of the disk
+    std::optional<std::wstring> simulateLatency;
+    // --swap-metadata <times,attrs,streams|all>: keep the selected metadata with the names
+    std::optional<std::wstring> swapMetadata;
+    // --manifest <file>: run (or --plan) the pairs of a text or binary manifest like "-" mode
+    std::optional<std::wstring> manifest;
+    // --compile-manifest <out>: with --manifest, write it as a binary manifest and exit
+    std::optional<std::wstring> compileManifest;
+    // --checkpoint <file>: with --manifest, record completed pairs so that --resume can continue
+    std::optional<std::wstring> checkpoint;
+    // --workers <n>: with --manifest, run its shards on n worker processes (0 if malformed)
+    std::optional<size_t> workers;
+    // --shard-worker <pipe>: run as one of those workers, taking shards over the named pipe
+    std::optional<std::wstring> shardWorker;
+    // --max-rate <ops/s>, --max-in-flight <n>, --io-priority <background|normal>: batch throttling
+    std::optional<std::wstring> maxRate;
+    std::optional<std::wstring> maxInFlight;
+    std::optional<std::wstring> ioPriority;
+    // --name-rules <windows|posix|smb|none>: names the target volume accepts, checked before swapping
+    std::optional<std::wstring> nameRules;
+    // --watch <dir> <pattern>, repeatable; a switch missing its values yields empty strings
+    std::vector<std::pair<std::wstring, std::wstring>> watch;
+    // --pair-rule <root> <pattern> <replacement>, repeatable; missing values yield empty strings
+    std::vector<std::array<std::wstring, 3>> pairRules;
+};
+
+// Split argv into switches and positional arguments
+CommandLine ParseCommandLine(int argc, wchar_t** argv);
+
+// Interpret the optional [preserve] argument; anything but an explicit "false" keeps extensions
+bool ParsePreserveFlag(const wchar_t* rawFlag);
@@ -0,0 +1,177 @@
+#include "collision_index.h"
+
+#include "exchange.h"
+#include "name_fold.h"
+#include "parallel.h"
+#include "path_lock.h"
+#include "swap_queue.h"
+#include "utils.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+// Pairs per ParallelFor work item; one atomic hand-out per pair would dominate the folding
+constexpr size_t kIndexChunk = 1024;
+
+// One item of a pair: where it lives and what it will be called, plus the folded keys
+struct Side {
+    std::filesystem::path dir;
+    std::wstring target;     // New file name, unfolded
+    std::wstring sourceKey;  // Folded dir + '\' + folded current name
+    std::wstring targetKey;  // Folded dir + '\' + folded new name
+};
+
+bool IsDirectory(const std::filesystem::path& path) {
+    const DWORD attributes = GetFileAttributesW(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// The name exchange() gives `self` when swapping with `other` (see SwappedLocation in verify.cpp).
+// Directories keep no extension; the attribute is only looked up when it could matter, and not at
+// all without probeDisk (the item is then taken to be a file).
+std::wstring TargetName(const std::filesystem::path& self, const std::filesystem::path& other, bool preserveExt,
+                        bool probeDisk = true) {
+    if (preserveExt && self.extension() != other.extension() && !(probeDisk && IsDirectory(self))) {
+        return other.stem().wstring() + self.extension().wstring();
+    }
+    return other.filename().wstring();
+}
+
+Side MakeSide(const std::filesystem::path& self, const std::filesystem::path& other, bool preserveExt,
+              bool probeDisk) {
+    Side side;
+    side.dir = self.parent_path();
+    side.target = TargetName(self, other, preserveExt, probeDisk);
+    const std::wstring dirKey = FoldName(side.dir.wstring()) + L'\\';
+    side.sourceKey = dirKey + FoldName(self.filename().wstring());
+    side.targetKey = dirKey + FoldName(side.target);
+    return side;
+}
+}  // namespace
+
+std::vector<int> FindNameCollisions(const PathStore& paths, const std::vector<SwapEntry>& batch, bool probeDisk) {
+    std::vector<int> codes(batch.size(), kResultSuccess);
+    std::vector<Side> sides(batch.size() * 2);
+    std::vector<char> valid(batch.size(), 0);
+
+    // Fold every name on all cores; the ASCII fast path makes this cheap per name
+    const size_t chunks = (batch.size() + kIndexChunk - 1) / kIndexChunk;
+    ParallelFor(chunks, [&](size_t chunk) {
+        const size_t end = (std::min)(batch.size(), (chunk + 1) * kIndexChunk);
+        PathReader reader1(paths);
+        PathReader reader2(paths);
+        for (size_t i = chunk * kIndexChunk; i < end; ++i) {
+            const SwapEntry& entry = batch[i];
+            const std::string_view path1 = reader1.Read(entry.path1);
+            const std::string_view path2 = reader2.Read(entry.path2);
+            if (path1.empty() || path2.empty()) continue;  // exchange() reports these
+            const std::filesystem::path p1 = std::filesystem::path(Utf8ToUtf16(path1)).lexically_normal();
+            const std::filesystem::path p2 = std::filesystem::path(Utf8ToUtf16(path2)).lexically_normal();
+            sides[i * 2] = MakeSide(p1, p2, entry.preserveExt, probeDisk);
+            sides[i * 2 + 1] = MakeSide(p2, p1, entry.preserveExt, probeDisk);
+            valid[i] = 1;
+        }
+    });
+
+    // Every name the batch mentions, and whether an item currently holds it
+    std::unordered_map<std::wstring_view, bool> held;
+    held.reserve(sides.size() * 2);
+    for (const Side& side : sides) {
+        if (!side.sourceKey.empty()) held.emplace(side.sourceKey, true);
+    }
+
+    // New names the batch knows nothing about must be free on disk; stat those in parallel
+    std::vector<char> onDisk(sides.size(), 0);
+    std::vector<size_t> unknown;
+    for (size_t s = 0; probeDisk && s < sides.size(); ++s) {
+        if (valid[s / 2] && !held.count(sides[s].targetKey)) unknown.push_back(s);
+    }
+    ParallelFor(unknown.size(), [&](size_t u) {
+        const Side& side = sides[unknown[u]];
+        onDisk[unknown[u]] = GetFileAttributesW((side.dir / side.target).c_str()) != INVALID_FILE_ATTRIBUTES;
+    });
+
+    // Replay the batch in order: a pair frees its two names, then takes two new ones
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!valid[i]) continue;
+        const Side& a = sides[i * 2];
+        const Side& b = sides[i * 2 + 1];
+        if (a.sourceKey == b.sourceKey) continue;  // Same item twice: exchange() reports kResultSameFile
+
+        held[a.sourceKey] = false;
+        held[b.sourceKey] = false;
+        bool collides = a.targetKey == b.targetKey;
+        for (size_t s : {i * 2, i * 2 + 1}) {
+            const std::wstring& key = sides[s].targetKey;
+            if (collides || key == a.sourceKey || key == b.sourceKey) continue;
+            auto it = held.find(key);
+            collides = it != held.end() ? it->second : onDisk[s] != 0;
+        }
+
+        if (collides) {
+            codes[i] = kResultNameCollision;
+            held[a.sourceKey] = true;
+            held[b.sourceKey] = true;
+        } else {
+            held[a.targetKey] = true;
+            held[b.targetKey] = true;
+        }
+    }
+    return codes;
+}
+
+bool IsCaseOnlySwap(const std::wstring& path1, const std::wstring& path2, bool preserveExt) {
+    const std::filesystem::path p1(path1);
+    const std::filesystem::path p2(path2);
+    // Called before every native swap: rule the pair out on its names, which is nearly always
+    // possible, before the disk is asked whether an item is a directory (which keeps no extension)
+    const auto couldKeepName = [preserveExt](const std::filesystem::path& self, const std::filesystem::path& other) {
+        const std::wstring name = FoldName(self.filename().wstring());
+        return FoldName(TargetName(self, other, preserveExt, false)) == name ||
+               FoldName(other.filename().wstring()) == name;
+    };
+    if (!couldKeepName(p1, p2) || !couldKeepName(p2, p1)) {
+        return false;
+    }
+    const std::wstring target1 = TargetName(p1, p2, preserveExt);
+    const std::wstring target2 = TargetName(p2, p1, preserveExt);
+    const std::wstring name1 = p1.filename().wstring();
+    const std::wstring name2 = p2.filename().wstring();
+    if (target1 == name1 && target2 == name2) {
+        return false;  // Nothing changes; exchange() handles the no-op
+    }
+    return FoldName(target1) == FoldName(name1) && FoldName(target2) == FoldName(name2);
+}
+
+int ExchangeCaseOnly(const std::wstring& path1, const std::wstring& path2, bool preserveExt) {
+    const std::filesystem::path self[2] = {path1, path2};
+    if (FoldName(self[0].lexically_normal().wstring()) == FoldName(self[1].lexically_normal().wstring())) {
+        return kResultSameFile;
+    }
+
+    // Both items move aside first, so neither final name is held by the other item
+    std::filesystem::path from[4];
+    std::filesystem::path to[4];
+    for (int i = 0; i < 2; ++i) {
+        const std::filesystem::path parked = self[i].parent_path() / UniqueTempName(self[i].stem().wstring());
+        from[i] = self[i];
+        to[i] = parked;
+        from[i + 2] = parked;
+        to[i + 2] = self[i].parent_path() / TargetName(self[i], self[1 - i], preserveExt);
+    }
+
+    for (int step = 0; step < 4; ++step) {
+        if (!MoveFileExW(from[step].c_str(), to[step].c_str(), 0)) {
+            const int result = ResultFromWin32Error(GetLastError());
+            while (step-- > 0) {
+                MoveFileExW(to[step].c_str(), from[step].c_str(), 0);
+            }
+            return result;
+        }
+    }
+    return kResultSuccess;
+}
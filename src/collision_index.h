@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class PathStore;
+struct SwapEntry;
+
+// Check a batch of pairs for names that would collide on a case-insensitive volume once swapped,
+// comparing FoldName keys. The pairs are replayed in order against the set of names the batch
+// knows about, so a chain where one pair frees a name that a later pair takes is fine, but
+//   - two pairs that would give their items the same name,
+//   - a new name equal (after folding) to a name still held by another pair of the batch, or
+//   - a new name the batch never mentions that already exists on disk
+// are all reported up front instead of one kResultAlreadyExists at a time.
+// Returns one code per entry: kResultSuccess, or kResultNameCollision for a pair that must not run.
+// Without probeDisk nothing is stat'ed: names the batch does not mention count as free and every
+// item as a file, so only conflicts within the batch are found.
+// The paths of batch are read from paths.
+std::vector<int> FindNameCollisions(const PathStore& paths, const std::vector<SwapEntry>& batch,
+                                    bool probeDisk = true);
+
+// True when swapping the pair only changes the case or normalization of each name
+// ("Readme.txt" + "README.md" with the extension preserved). exchange() sees such a target as
+// already taken by the item itself, so these pairs go through ExchangeCaseOnly instead.
+bool IsCaseOnlySwap(const std::wstring& path1, const std::wstring& path2, bool preserveExt);
+
+// Swap a case-only pair by parking both items under UniqueTempName and then giving each its
+// final name. On failure every rename done so far is rolled back. Returns an exchange() code.
+int ExchangeCaseOnly(const std::wstring& path1, const std::wstring& path2, bool preserveExt);
@@ -0,0 +1,69 @@
+#include "concurrency_tuner.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+constexpr auto kMinWindow = std::chrono::milliseconds(100);
+constexpr size_t kMinWindowSamples = 8;
+constexpr double kLatencyTolerance = 1.5;
+constexpr double kMaxErrorRate = 0.05;
+constexpr double kBaselineDrift = 0.002;
+}  // namespace
+
+void ConcurrencyTuner::Reset(uint32_t ceiling, std::chrono::steady_clock::time_point now) {
+    stats_ = TuningStats{};
+    ceiling_ = (std::max)(ceiling, 1u);
+    slowStart_ = true;
+    saturated_ = false;
+    samples_.clear();
+    failures_ = 0;
+    windowStart_ = now;
+}
+
+void ConcurrencyTuner::SetCeiling(uint32_t ceiling) {
+    ceiling_ = (std::max)(ceiling, 1u);
+    stats_.limit = (std::min)(stats_.limit, ceiling_);
+}
+
+bool ConcurrencyTuner::Finished(int64_t micros, bool failed, std::chrono::steady_clock::time_point now) {
+    samples_.push_back(micros);
+    failures_ += failed ? 1 : 0;
+    if (samples_.size() < (std::max)(kMinWindowSamples, size_t{stats_.limit} * 2) || now - windowStart_ < kMinWindow) {
+        return false;
+    }
+    CloseWindow();
+    windowStart_ = now;
+    return true;
+}
+
+void ConcurrencyTuner::CloseWindow() {
+    const auto p99 = samples_.begin() + static_cast<std::ptrdiff_t>(samples_.size() * 99 / 100);
+    std::nth_element(samples_.begin(), p99, samples_.end());
+    stats_.p99Ms = static_cast<double>(*p99) / 1000.0;
+    stats_.errorRate = static_cast<double>(failures_) / static_cast<double>(samples_.size());
+    stats_.baselineMs = stats_.windows == 0 || stats_.limit == 1
+                            ? stats_.p99Ms
+                            : (std::min)(stats_.p99Ms, stats_.baselineMs * (1.0 + kBaselineDrift));
+    ++stats_.windows;
+    if (stats_.limit == 1) slowStart_ = true;
+
+    const uint32_t limit = stats_.limit;
+    if (stats_.errorRate > kMaxErrorRate || stats_.p99Ms > stats_.baselineMs * kLatencyTolerance) {
+        stats_.decision =
+            stats_.errorRate > kMaxErrorRate ? TuningDecision::BackoffErrors : TuningDecision::BackoffLatency;
+        stats_.limit = (std::max)(1u, (std::min)(limit - 1, limit * 3 / 4));
+        slowStart_ = false;
+    } else if (saturated_ && limit < ceiling_) {
+        stats_.decision = slowStart_ ? TuningDecision::SlowStart : TuningDecision::Probe;
+        stats_.limit = (std::min)(ceiling_, slowStart_ ? limit * 2 : limit + 1);
+    } else {
+        stats_.decision = TuningDecision::Hold;
+    }
+    if (stats_.limit > limit) ++stats_.raises;
+    if (stats_.limit < limit) ++stats_.cuts;
+
+    saturated_ = false;
+    samples_.clear();
+    failures_ = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// What the adaptive in-flight limit did at the end of its last window
+enum class TuningDecision : uint8_t { None, SlowStart, Probe, Hold, BackoffLatency, BackoffErrors };
+
+// Live view of the adaptive in-flight limit
+struct TuningStats {
+    uint32_t limit = 1;
+    TuningDecision decision = TuningDecision::None;
+    double p99Ms = 0.0;       // Of the last window
+    double baselineMs = 0.0;  // p99 the windows are held against
+    double errorRate = 0.0;   // Of the last window
+    uint64_t windows = 0;
+    uint64_t raises = 0;  // Slow-start doublings and probes
+    uint64_t cuts = 0;
+};
+
+// AIMD controller of the in-flight limit. Swaps are measured in windows of at least 100 ms and
+// max(8, 2 x limit) swaps. A window whose p99 latency rose past 1.5x the baseline, or in which more
+// than 5% of the swaps failed, cuts the limit by a quarter. A window with flat latency in which the
+// limit was reached raises it by one, or doubles it until the first cut. The baseline is the lowest
+// windowed p99, drifting up 0.2% per window. A share that got slower for everyone is cut down to a
+// limit of 1, where the baseline is simply the last p99 and doubling starts over.
+class ConcurrencyTuner {
+public:
+    // Start over at a limit of 1, in slow start
+    void Reset(uint32_t ceiling, std::chrono::steady_clock::time_point now);
+    void SetCeiling(uint32_t ceiling);
+
+    uint32_t Limit() const { return stats_.limit; }
+    const TuningStats& Stats() const { return stats_; }
+
+    // A swap started and inFlight swaps now run, itself included
+    void Started(uint32_t inFlight) { saturated_ = saturated_ || inFlight >= stats_.limit; }
+    // A swap finished; failed means it failed in a way that may come from load. True if this closed
+    // a window, which may have changed the limit.
+    bool Finished(int64_t micros, bool failed, std::chrono::steady_clock::time_point now);
+
+private:
+    void CloseWindow();
+
+    TuningStats stats_;
+    uint32_t ceiling_ = 1;
+    bool slowStart_ = true;
+    bool saturated_ = false;  // The limit was reached during this window
+    std::vector<int64_t> samples_;
+    size_t failures_ = 0;
+    std::chrono::steady_clock::time_point windowStart_;
+};
@@ -0,0 +1,133 @@
+#include "content_hash.h"
+
+#include <cstring>
+
+// NX_NO_SSE2 keeps to the scalar stripes, which the tests hold to the same values as the SSE2 ones
+#if !defined(NX_NO_SSE2) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NAME_EXCHANGER_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr size_t kStripeSize = 64;
+constexpr size_t kLanes = kStripeSize / sizeof(uint64_t);
+constexpr size_t kStripesPerBlock = 16;
+
+constexpr uint64_t kPrime32_1 = 0x9E3779B1ULL;
+constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+
+alignas(16) constexpr uint64_t kStripeKey[kLanes] = {
+    0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+    0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+};
+
+alignas(16) constexpr uint64_t kScrambleKey[kLanes] = {
+    0xCB00C391BB52283CULL, 0xA32E531B8B65D088ULL, 0x4EF90DA297486471ULL, 0xD8ACDEA946EF1938ULL,
+    0x3F349CE33F76FAA8ULL, 0x1D4F0BC7C7BBDCF9ULL, 0x3159B4CD4BE0518AULL, 0x647378D9C97E9FC8ULL,
+};
+
+uint64_t Avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t Mix2(uint64_t lo, uint64_t hi) {
+    const uint64_t a = lo * kPrime64_2;
+    const uint64_t b = ((hi << 31) | (hi >> 33)) * kPrime64_1;
+    return a ^ b ^ (a >> 29);
+}
+
+#if NAME_EXCHANGER_HASH_SSE2
+void AccumulateStripe(uint64_t* acc, const unsigned char* input) {
+    auto* xacc = reinterpret_cast<__m128i*>(acc);
+    const auto* xinput = reinterpret_cast<const __m128i*>(input);
+    const auto* xkey = reinterpret_cast<const __m128i*>(kStripeKey);
+    for (size_t i = 0; i < kStripeSize / sizeof(__m128i); ++i) {
+        const __m128i dataVec = _mm_loadu_si128(xinput + i);
+        const __m128i dataKey = _mm_xor_si128(dataVec, _mm_load_si128(xkey + i));
+        const __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i product = _mm_mul_epu32(dataKey, dataKeyHi);
+        const __m128i dataSwap = _mm_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+        xacc[i] = _mm_add_epi64(product, _mm_add_epi64(xacc[i], dataSwap));
+    }
+}
+
+void ScrambleAccumulators(uint64_t* acc) {
+    auto* xacc = reinterpret_cast<__m128i*>(acc);
+    const auto* xkey = reinterpret_cast<const __m128i*>(kScrambleKey);
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+    for (size_t i = 0; i < kStripeSize / sizeof(__m128i); ++i) {
+        const __m128i shifted = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+        const __m128i dataKey = _mm_xor_si128(shifted, _mm_load_si128(xkey + i));
+        const __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i productLo = _mm_mul_epu32(dataKey, prime);
+        const __m128i productHi = _mm_mul_epu32(dataKeyHi, prime);
+        xacc[i] = _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32));
+    }
+}
+#else
+uint64_t Read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void AccumulateStripe(uint64_t* acc, const unsigned char* input) {
+    for (size_t i = 0; i < kLanes; ++i) {
+        const uint64_t dataVal = Read64(input + i * 8);
+        const uint64_t dataKey = dataVal ^ kStripeKey[i];
+        acc[i ^ 1] += dataVal;
+        acc[i] += (dataKey & 0xFFFFFFFFULL) * (dataKey >> 32);
+    }
+}
+
+void ScrambleAccumulators(uint64_t* acc) {
+    for (size_t i = 0; i < kLanes; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= kScrambleKey[i];
+        acc[i] = a * kPrime32_1;
+    }
+}
+#endif
+}  // namespace
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+    const auto* input = static_cast<const unsigned char*>(data);
+    alignas(16) uint64_t acc[kLanes] = {
+        kPrime32_1 ^ seed, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_1 ^ seed, kPrime64_2, kPrime64_3, kPrime32_1,
+    };
+
+    const size_t blockSize = kStripeSize * kStripesPerBlock;
+    size_t offset = 0;
+    while (size - offset >= blockSize) {
+        for (size_t s = 0; s < kStripesPerBlock; ++s) {
+            AccumulateStripe(acc, input + offset + s * kStripeSize);
+        }
+        ScrambleAccumulators(acc);
+        offset += blockSize;
+    }
+    while (size - offset >= kStripeSize) {
+        AccumulateStripe(acc, input + offset);
+        offset += kStripeSize;
+    }
+    if (offset < size) {
+        alignas(16) unsigned char tail[kStripeSize] = {};
+        std::memcpy(tail, input + offset, size - offset);
+        AccumulateStripe(acc, tail);
+    }
+
+    uint64_t h = static_cast<uint64_t>(size) * kPrime64_1 ^ seed;
+    for (size_t i = 0; i < kLanes; i += 2) {
+        h += Mix2(acc[i], acc[i + 1]);
+    }
+    return Avalanche(h);
+}
+
+uint64_t CombineHashes(uint64_t accumulated, uint64_t next) {
+    return Avalanche(Mix2(accumulated ^ kPrime64_3, next) + accumulated);
+}
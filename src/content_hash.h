@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Fast non-cryptographic 64-bit hash over a block of memory.
+// Processes 64-byte stripes with SSE2 when available; the scalar path produces identical results.
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+// Fold an ordered sequence of block hashes into one value
+uint64_t CombineHashes(uint64_t accumulated, uint64_t next);
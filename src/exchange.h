@@ -0,0 +1,21 @@
+#pragma once
+
+// External function from the Rust library
+extern "C" int exchange(const char* path1, const char* path2, bool preserve_ext);
+
+// Return codes of exchange() (see GetOutputInfo for the localized messages)
+constexpr int kResultSuccess = 0;
+constexpr int kResultNoExist = 1;
+constexpr int kResultPermissionDenied = 2;
+constexpr int kResultAlreadyExists = 3;
+constexpr int kResultSameFile = 4;
+constexpr int kResultInvalidPath = 5;
+
+// Codes produced on this side of the library boundary
+constexpr int kResultVerifyFailed = 6;
+constexpr int kResultNameCollision = 7;  // Another item of the batch or the volume holds the new name
+constexpr int kResultMetadataFailed = 8;  // --swap-metadata could not move the metadata along
+constexpr int kResultResumeInDoubt = 9;   // --resume cannot tell whether an interrupted swap took place
+constexpr int kResultWorkerLost = 10;     // --workers: the worker running the pair exited mid-swap
+constexpr int kResultBusy = 11;           // A pinned toggle found another swap holding one of its items
+constexpr int kResultHalfSwapped = 12;    // A failed swap could not be rolled back; the items moved
@@ -0,0 +1,99 @@
+#include "folder_watcher.h"
+
+namespace {
+// Per-folder notification buffer; ReadDirectoryChangesW rejects buffers above 64 KiB on network shares
+constexpr DWORD kBufferBytes = 64 * 1024;
+constexpr DWORD kNotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+constexpr ULONG_PTR kInterruptKey = 0;
+}  // namespace
+
+struct FolderWatcher::Dir {
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+    bool pending = false;
+    std::vector<DWORD> buffer = std::vector<DWORD>(kBufferBytes / sizeof(DWORD));  // DWORD-aligned as required
+};
+
+FolderWatcher::~FolderWatcher() {
+    for (auto& dir : dirs_) {
+        if (dir->pending) CancelIoEx(dir->handle, &dir->overlapped);
+    }
+    // The kernel still owns each buffer until its cancelled read completes
+    for (auto& dir : dirs_) {
+        if (dir->pending) {
+            DWORD bytes = 0;
+            GetOverlappedResult(dir->handle, &dir->overlapped, &bytes, TRUE);
+        }
+        CloseHandle(dir->handle);
+    }
+    if (port_) CloseHandle(port_);
+}
+
+size_t FolderWatcher::Add(const std::wstring& dir) {
+    if (!port_) {
+        port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        if (!port_) return SIZE_MAX;
+    }
+
+    auto entry = std::make_unique<Dir>();
+    entry->handle = CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (entry->handle == INVALID_HANDLE_VALUE) {
+        return SIZE_MAX;
+    }
+
+    const size_t index = dirs_.size();
+    // Completion key is index + 1 so that 0 stays free for Interrupt()
+    if (!CreateIoCompletionPort(entry->handle, port_, static_cast<ULONG_PTR>(index + 1), 0) || !Arm(*entry)) {
+        CloseHandle(entry->handle);
+        return SIZE_MAX;
+    }
+    dirs_.push_back(std::move(entry));
+    return index;
+}
+
+bool FolderWatcher::Arm(Dir& dir) {
+    dir.overlapped = {};
+    dir.pending = ReadDirectoryChangesW(dir.handle, dir.buffer.data(), kBufferBytes, FALSE, kNotifyFilter, nullptr,
+                                        &dir.overlapped, nullptr) != FALSE;
+    return dir.pending;
+}
+
+bool FolderWatcher::Poll(DWORD timeoutMs, const ChangeFn& onChange, const OverflowFn& onOverflow) {
+    DWORD bytes = 0;
+    ULONG_PTR key = 0;
+    OVERLAPPED* overlapped = nullptr;
+    const BOOL ok = GetQueuedCompletionStatus(port_, &bytes, &key, &overlapped, timeoutMs);
+    if (!overlapped) {
+        // Timeout (ok == FALSE) or an Interrupt() packet (ok == TRUE, key 0)
+        return !(ok && key == kInterruptKey);
+    }
+
+    const size_t index = static_cast<size_t>(key - 1);
+    Dir& dir = *dirs_[index];
+    dir.pending = false;
+
+    if (!ok || bytes == 0) {
+        // ERROR_NOTIFY_ENUM_DIR or a zero-byte completion: the buffer overflowed
+        if (ok || GetLastError() == ERROR_NOTIFY_ENUM_DIR) onOverflow(index);
+    } else {
+        const auto* base = reinterpret_cast<const BYTE*>(dir.buffer.data());
+        for (DWORD offset = 0;;) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(base + offset);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                onChange(index, std::wstring_view(info->FileName, info->FileNameLength / sizeof(wchar_t)));
+            }
+            if (info->NextEntryOffset == 0) break;
+            offset += info->NextEntryOffset;
+        }
+    }
+
+    // Re-arm after dispatching; changes in between are buffered by the kernel for this handle
+    Arm(dir);
+    return true;
+}
+
+void FolderWatcher::Interrupt() {
+    if (port_) PostQueuedCompletionStatus(port_, 0, kInterruptKey, nullptr);
+}
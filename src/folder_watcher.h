@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <windows.h>
+
+// Directory change notifications for a set of folders (non-recursive), delivered through one
+// completion port so a single thread can service any number of folders. Only names that may now
+// exist are reported: created, modified and renamed-to. Callers pull events with Poll().
+class FolderWatcher {
+public:
+    // dirIndex is the value returned by Add; name is relative to that folder and only valid during the call
+    using ChangeFn = std::function<void(size_t dirIndex, std::wstring_view name)>;
+    // The notification buffer overflowed and events were lost; the folder should be rescanned
+    using OverflowFn = std::function<void(size_t dirIndex)>;
+
+    FolderWatcher() = default;
+    FolderWatcher(const FolderWatcher&) = delete;
+    FolderWatcher& operator=(const FolderWatcher&) = delete;
+    ~FolderWatcher();
+
+    // Start watching a folder; returns its index, or SIZE_MAX if it cannot be opened
+    size_t Add(const std::wstring& dir);
+
+    // Wait up to timeoutMs for one batch of notifications and dispatch it.
+    // Returns false once Interrupt() has been called.
+    bool Poll(DWORD timeoutMs, const ChangeFn& onChange, const OverflowFn& onOverflow);
+
+    // Make a blocked or future Poll() return false; callable from any thread
+    void Interrupt();
+
+private:
+    struct Dir;
+
+    bool Arm(Dir& dir);
+
+    HANDLE port_ = nullptr;
+    std::vector<std::unique_ptr<Dir>> dirs_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+// UI sections whose CPU time is attributed separately
+enum class UiSection {
+    TopBar,
+    Inputs,
+    Options,
+    StartButton,
+    Queue,
+    Count,
+};
+
+// Per-frame CPU time profiler. Costs one branch per scope while disabled.
+class FrameProfiler {
+public:
+    struct Stats {
+        double lastUs = 0.0;
+        double avgUs = 0.0;  // Exponential moving average
+        double maxUs = 0.0;  // Worst frame in the current window of kMaxWindow frames
+    };
+
+    bool enabled = false;
+
+    void BeginFrame() {
+        if (enabled) frameStart_ = Clock::now();
+    }
+
+    void EndFrame() {
+        if (!enabled) return;
+        Record(frame_, frameStart_);
+        if (++framesInWindow_ >= kMaxWindow) {
+            framesInWindow_ = 0;
+            frame_.maxUs = frame_.lastUs;
+            for (Stats& s : sections_) s.maxUs = s.lastUs;
+        }
+    }
+
+    void BeginSection(UiSection section) {
+        if (enabled) sectionStart_[Index(section)] = Clock::now();
+    }
+
+    void EndSection(UiSection section) {
+        if (enabled) Record(sections_[Index(section)], sectionStart_[Index(section)]);
+    }
+
+    const Stats& Frame() const { return frame_; }
+    const Stats& Section(UiSection section) const { return sections_[Index(section)]; }
+
+    static const char* Name(UiSection section) {
+        switch (section) {
+            case UiSection::TopBar:
+                return "top bar";
+            case UiSection::Inputs:
+                return "inputs";
+            case UiSection::Options:
+                return "options";
+            case UiSection::StartButton:
+                return "start";
+            case UiSection::Queue:
+                return "queue";
+            default:
+                return "?";
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t kSections = static_cast<size_t>(UiSection::Count);
+    static constexpr int kMaxWindow = 120;
+    static constexpr double kAvgWeight = 0.05;
+
+    static size_t Index(UiSection section) { return static_cast<size_t>(section); }
+
+    static void Record(Stats& stats, Clock::time_point start) {
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        stats.lastUs = us;
+        stats.avgUs = stats.avgUs == 0.0 ? us : stats.avgUs + (us - stats.avgUs) * kAvgWeight;
+        stats.maxUs = (std::max)(stats.maxUs, us);
+    }
+
+    Clock::time_point frameStart_{};
+    Clock::time_point sectionStart_[kSections]{};
+    Stats frame_;
+    Stats sections_[kSections];
+    int framesInWindow_ = 0;
+};
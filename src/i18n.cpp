@@ -15,20 +15,73 @@ static const LocaleStrings kSimplifiedChinese = {
     /* adminTooltip      */  "切换管理员权限",
     /* sendToTooltip     */  "左键：添加「发送到」快捷方式\n右键：删除「发送到」快捷方式",
     /* aboutMessageW     */ L"拖入 1 个或 2 个文件/文件夹，或手动输入路径。\n程序可常驻系统托盘，悬停按钮可查看提示。\n\n功能：\n○ 置顶窗口\n○ 切换管理员权限\n○ 创建/删除「发送到」快捷方式\n○ 保留扩展名或完整交换文件名",
-    /* trayTooltip       */ L"FilenameExchanger\n左键：显示/隐藏\n右键：退出",
+    /* trayTooltip       */ L"FilenameExchanger\n左键：显示/隐藏\n右键：菜单",
+    /* trayUnpinMenu     */ L"取消固定",
+    /* trayExitMenu      */ L"退出",
     /* shortcutCreated   */ L"已添加到「发送到」",
     /* shortcutRemoved   */ L"已从「发送到」移除",
     /* tipsTitle         */ L"提示",
     /* errorTitle        */ L"错误",
     /* warningTitle      */ L"警告",
     /* cmdErrorPrefix    */ L"交换失败：",
-    /* cmdUsage          */ L"用法：\n  name_exchanger <path1> <path2> [preserve]\n\n参数说明：\n  preserve 为可选参数，默认 true（保留扩展名），可选 false（完整交换文件名）。",
+    /* cmdUsage          */ L"用法：\n  name_exchanger <path1> <path2> [preserve] [--verify] [--swap-metadata <classes>]\n  name_exchanger - [preserve] [--verify] [--swap-metadata <classes>] [--pipeline-depth <n>] [--max-rate <ops/s>] [--max-in-flight <n|auto>] [--io-priority background|normal] [--name-rules windows|posix|smb|none] [--simulate-latency <rtt[:jitter[:errors]]>] [--plan]\n  name_exchanger --manifest <file> [preserve] [...] [--checkpoint <file> [--resume] | --workers <n>] | --manifest <file> --compile-manifest <out>\n  name_exchanger --watch <dir> <*.ext> [--watch ...]\n  name_exchanger --pair-rule <root> <pattern> <replacement> [--pair-rule ...]\n\n参数说明：\n  preserve 为可选参数，默认 true（保留扩展名），可选 false（完整交换文件名）。\n  --verify 交换后校验两项内容是否已对调。\n  --swap-metadata 让所选元数据留在名称上（times 时间戳、attrs 只读/隐藏等属性、streams 备用数据流，逗号分隔或 all）。\n  - 从标准输入逐对读取路径（以换行或 NUL 分隔），结果以 JSON 行输出到标准输出。\n  --plan 只生成执行计划不交换：标准输出为每对一行的 JSON 计划（可直接作为 - 的输入执行），标准错误输出各策略的数量与预计耗时。\n  --manifest 从内存映射的清单文件读取路径对（文本格式同 -，或二进制清单），其余同 -；--compile-manifest 把清单转换为二进制格式。\n  --checkpoint 把已完成的路径对记录到检查点文件；中断后加 --resume 重新运行同一命令即可跳过已完成的对继续执行，全部成功后自动删除该文件。\n  --workers 按目录把清单分片，交给 n 个工作进程并行执行（互不触及同一目录）；工作进程退出时，其未开始的对交给其他进程继续。\n  --pipeline-depth 同时进行的交换数（默认 1），适合高延迟的网络共享；共用路径的交换仍按顺序执行。\n  --max-rate、--max-in-flight、--io-priority 限制批量交换的速率、同时进行数与 I/O 优先级；可在队列面板中随时调整，向已运行的实例再次传入即可更新；--max-in-flight auto 按交换延迟与失败率自动调节同时进行数（以流水线深度为上限）。\n  --name-rules 执行前按目标卷的命名规则检查交换后的新名称（windows 默认：禁止 <>:\"/\\|?* 与控制字符、结尾的点或空格及 CON、NUL、COM1 等设备名；posix：禁止 NUL 与 /，不超过 255 字节；smb：Samba 共享，两者皆须满足；none：不检查），不符合的对直接报告为无效路径。\n  --simulate-latency 不访问磁盘，改用模拟的高延迟共享（往返毫秒数[:抖动[:失败率]]）。\n  --watch 常驻托盘，当目录中出现与同名文件相邻的 <*.ext> 文件（如 X.new 与 X）时自动交换二者。\n  --pair-rule 扫描 <root> 下所有子目录，把名称匹配 <pattern> 的项目与同目录下按 <replacement> 命名的项目配对并加入交换队列（如 *.prod.json 与 *.staging.json；re: 前缀表示正则，$1 引用分组）。",
+    /* cmdWatchInvalid   */ L"无法监视：",
+    /* cmdPairRuleInvalid*/ L"配对规则无效或根目录无法读取：",
+    /* cmdManifestInvalid*/ L"无法读取清单文件：",
+    /* cmdManifestWriteFailed*/ L"无法写入清单文件：",
+    /* cmdCheckpointInvalid*/ L"无法使用检查点文件（无法创建、格式不对或属于另一个清单）：",
+    /* cmdCheckpointUnfinished*/ L"检查点文件已存在，请加 --resume 继续或先删除它：",
+    /* cmdInvalidArgument*/ L"参数无效。",
+    /* queueAddButton    */  "加入队列",
+    /* pairPinButton     */  "固定组合",
+    /* queueRunButton    */  "执行",
+    /* queueClearButton  */  "清除已完成",
+    /* queueFilterHint   */  "筛选路径",
+    /* queueStatusColumn */  "状态",
+    /* stateAll          */  "全部",
+    /* statePending      */  "等待中",
+    /* stateRunning      */  "执行中",
+    /* stateDone         */  "已完成",
+    /* stateFailed       */  "失败",
+    /* queueLimitsButton */  "限速",
+    /* throttleRateLabel */  "每秒交换数",
+    /* throttleInFlightLabel*/  "同时进行数",
+    /* throttleBackgroundLabel*/  "后台 I/O 优先级",
+    /* throttleUnlimited */  "不限",
+    /* throttleAutoLabel */  "自动调节",
+    /* throttleTuningStatus*/  "当前 %u 个，p99 %.1f 毫秒（基线 %.1f），调高 %llu 次，调低 %llu 次",
+    /* pathStatusFile    */  "文件",
+    /* pathStatusDirectory*/  "文件夹",
+    /* pathStatusMissing */  "不存在",
+    /* pathStatusInvalid */  "路径无效",
+    /* pathStatusSameItem*/  "与另一路径为同一项",
+    /* pathStatusCollision*/  "交换后的名称已被占用",
+    /* planHeader        */ L"执行计划：共 %zu 对，规划耗时 %.0f 毫秒（另探测 %.0f 毫秒）",
+    /* planStrategyRename*/ L"重命名（三步）",
+    /* planStrategyCaseOnly*/ L"仅大小写（四步）",
+    /* planStrategyCrossVolume*/ L"跨卷复制",
+    /* planStrategySkip  */ L"跳过",
+    /* planVolume        */ L"卷 %ls：%zu 对，查询 %.0f 微秒，重命名 %.0f 微秒，复制 %.0f MB/s%ls",
+    /* planVolumeDefault */ L"（默认值，未实测）",
+    /* planEstimate      */ L"预计耗时：%.1f 秒（流水线深度 %zu）",
+    /* shardHeader       */ L"分片执行：%zu 对，%zu 个分片，%zu 个工作进程，耗时 %.1f 秒（%.0f 对/秒）",
+    /* shardWorker       */ L"  工作进程 %zu：%zu 个分片，%zu 对，重启 %zu 次",
+    /* shardLost         */ L"%zu 对在工作进程退出时正在交换，结果未知",
+    /* shardLocal        */ L"没有可用的工作进程，%zu 对在本进程中执行",
+    /* tuningSummary     */ L"自动调节同时进行数：最终 %u 个，p99 %.1f 毫秒（基线 %.1f 毫秒），调高 %llu 次、调低 %llu 次（共 %llu 个窗口）",
     /* resultSuccess     */  "成功",
     /* resultNoExist     */  "文件或目录不存在",
     /* resultPermDenied  */  "权限不足",
     /* resultAlreadyExists */"目标路径已存在",
     /* resultSameFile    */ "两个路径指向同一项",
     /* resultInvalidPath */ "路径无效",
+    /* resultVerifyFailed */"交换后校验失败",
+    /* resultNameCollision */"新名称与同批次其他项目或已有文件冲突（不区分大小写）",
+    /* resultMetadataFailed */"无法随名称一并交换元数据",
+    /* resultResumeInDoubt */ "上次运行在交换过程中中断，无法确认是否已交换，请手动检查",
+    /* resultWorkerLost  */ "工作进程在交换过程中退出，无法确认是否已交换，请手动检查",
+    /* resultBusy        */ "另一项交换正在使用其中的项目，请稍后再试",
+    /* resultHalfSwapped */ "交换失败且无法撤销，项目现位于：",
     /* resultUnknown     */ "未知错误",
 };
 
@@ -43,20 +96,73 @@ static const LocaleStrings kTraditionalChinese = {
     /* adminTooltip      */  "以系統管理員執行",
     /* sendToTooltip     */  "點擊新增至右鍵選單「傳送到」選項\n點擊右鍵取消",
     /* aboutMessageW     */ L"拖入檔案即可使用，軟件將常駐任務欄，\n懸停滑鼠於按鍵上可獲得提示。\n\n軟件包含以下功能\n○以系統管理員執行\n○建立/刪除「傳送到」選單快捷方式\n○置頂",
-    /* trayTooltip       */ L"FilenameExchanger\n左鍵顯示/隱藏\n右鍵退出",
+    /* trayTooltip       */ L"FilenameExchanger\n左鍵顯示/隱藏\n右鍵選單",
+    /* trayUnpinMenu     */ L"取消固定",
+    /* trayExitMenu      */ L"結束",
     /* shortcutCreated   */ L"已建立",
     /* shortcutRemoved   */ L"已刪除",
     /* tipsTitle         */ L"提示",
     /* errorTitle        */ L"錯誤",
     /* warningTitle      */ L"警告",
     /* cmdErrorPrefix    */ L"交換失敗：",
-    /* cmdUsage          */ L"用法：\n  name_exchanger <path1> <path2> [preserve]\n\n參數說明：\n  preserve 為可選參數，默認 true（保留副檔名），可選 false（完整交換檔名）。",
+    /* cmdUsage          */ L"用法：\n  name_exchanger <path1> <path2> [preserve] [--verify] [--swap-metadata <classes>]\n  name_exchanger - [preserve] [--verify] [--swap-metadata <classes>] [--pipeline-depth <n>] [--max-rate <ops/s>] [--max-in-flight <n|auto>] [--io-priority background|normal] [--name-rules windows|posix|smb|none] [--simulate-latency <rtt[:jitter[:errors]]>] [--plan]\n  name_exchanger --manifest <file> [preserve] [...] [--checkpoint <file> [--resume] | --workers <n>] | --manifest <file> --compile-manifest <out>\n  name_exchanger --watch <dir> <*.ext> [--watch ...]\n  name_exchanger --pair-rule <root> <pattern> <replacement> [--pair-rule ...]\n\n參數說明：\n  preserve 為可選參數，默認 true（保留副檔名），可選 false（完整交換檔名）。\n  --verify 交換後校驗兩項內容是否已對調。\n  --swap-metadata 讓所選中繼資料留在名稱上（times 時間戳記、attrs 唯讀/隱藏等屬性、streams 替代資料流，逗號分隔或 all）。\n  - 從標準輸入逐對讀取路徑（以換行或 NUL 分隔），結果以 JSON 行輸出到標準輸出。\n  --plan 只產生執行計畫不交換：標準輸出為每對一行的 JSON 計畫（可直接作為 - 的輸入執行），標準錯誤輸出各策略的數量與預計耗時。\n  --manifest 從記憶體對應的清單檔案讀取路徑對（文字格式同 -，或二進位清單），其餘同 -；--compile-manifest 把清單轉換為二進位格式。\n  --checkpoint 把已完成的路徑對記錄到檢查點檔案；中斷後加 --resume 重新執行同一命令即可略過已完成的對繼續執行，全部成功後自動刪除該檔案。\n  --workers 按目錄把清單分片，交給 n 個工作行程並行執行（互不觸及同一目錄）；工作行程結束時，其未開始的對交給其他行程繼續。\n  --pipeline-depth 同時進行的交換數（預設 1），適合高延遲的網路共用；共用路徑的交換仍按順序執行。\n  --max-rate、--max-in-flight、--io-priority 限制批次交換的速率、同時進行數與 I/O 優先權；可在佇列面板中隨時調整，向已執行的實例再次傳入即可更新；--max-in-flight auto 依交換延遲與失敗率自動調節同時進行數（以管線深度為上限）。\n  --name-rules 執行前按目標磁碟區的命名規則檢查交換後的新名稱（windows 預設：禁止 <>:\"/\\|?* 與控制字元、結尾的點或空格及 CON、NUL、COM1 等裝置名稱；posix：禁止 NUL 與 /，不超過 255 位元組；smb：Samba 共用，兩者皆須符合；none：不檢查），不符合的對直接回報為無效路徑。\n  --simulate-latency 不存取磁碟，改用模擬的高延遲共用（往返毫秒數[:抖動[:失敗率]]）。\n  --watch 常駐任務欄，當目錄中出現與同名檔案相鄰的 <*.ext> 檔案（如 X.new 與 X）時自動交換二者。\n  --pair-rule 掃描 <root> 下所有子目錄，把名稱符合 <pattern> 的項目與同目錄下按 <replacement> 命名的項目配對並加入交換佇列（如 *.prod.json 與 *.staging.json；re: 前綴表示正規表示式，$1 引用群組）。",
+    /* cmdWatchInvalid   */ L"無法監視：",
+    /* cmdPairRuleInvalid*/ L"配對規則無效或根目錄無法讀取：",
+    /* cmdManifestInvalid*/ L"無法讀取清單檔案：",
+    /* cmdManifestWriteFailed*/ L"無法寫入清單檔案：",
+    /* cmdCheckpointInvalid*/ L"無法使用檢查點檔案（無法建立、格式不符或屬於另一個清單）：",
+    /* cmdCheckpointUnfinished*/ L"檢查點檔案已存在，請加 --resume 繼續或先刪除它：",
+    /* cmdInvalidArgument*/ L"參數無效。",
+    /* queueAddButton    */  "加入佇列",
+    /* pairPinButton     */  "固定組合",
+    /* queueRunButton    */  "執行",
+    /* queueClearButton  */  "清除已完成",
+    /* queueFilterHint   */  "篩選路徑",
+    /* queueStatusColumn */  "狀態",
+    /* stateAll          */  "全部",
+    /* statePending      */  "等待中",
+    /* stateRunning      */  "執行中",
+    /* stateDone         */  "已完成",
+    /* stateFailed       */  "失敗",
+    /* queueLimitsButton */  "限速",
+    /* throttleRateLabel */  "每秒交換數",
+    /* throttleInFlightLabel*/  "同時進行數",
+    /* throttleBackgroundLabel*/  "背景 I/O 優先權",
+    /* throttleUnlimited */  "不限",
+    /* throttleAutoLabel */  "自動調節",
+    /* throttleTuningStatus*/  "目前 %u 個，p99 %.1f 毫秒（基準 %.1f），調高 %llu 次，調低 %llu 次",
+    /* pathStatusFile    */  "檔案",
+    /* pathStatusDirectory*/  "資料夾",
+    /* pathStatusMissing */  "不存在",
+    /* pathStatusInvalid */  "路徑無效",
+    /* pathStatusSameItem*/  "與另一路徑為同一項",
+    /* pathStatusCollision*/  "交換後的名稱已被佔用",
+    /* planHeader        */ L"執行計畫：共 %zu 對，規劃耗時 %.0f 毫秒（另探測 %.0f 毫秒）",
+    /* planStrategyRename*/ L"重新命名（三步）",
+    /* planStrategyCaseOnly*/ L"僅大小寫（四步）",
+    /* planStrategyCrossVolume*/ L"跨磁碟區複製",
+    /* planStrategySkip  */ L"略過",
+    /* planVolume        */ L"磁碟區 %ls：%zu 對，查詢 %.0f 微秒，重新命名 %.0f 微秒，複製 %.0f MB/s%ls",
+    /* planVolumeDefault */ L"（預設值，未實測）",
+    /* planEstimate      */ L"預計耗時：%.1f 秒（管線深度 %zu）",
+    /* shardHeader       */ L"分片執行：%zu 對，%zu 個分片，%zu 個工作行程，耗時 %.1f 秒（%.0f 對/秒）",
+    /* shardWorker       */ L"  工作行程 %zu：%zu 個分片，%zu 對，重新啟動 %zu 次",
+    /* shardLost         */ L"%zu 對在工作行程結束時正在交換，結果未知",
+    /* shardLocal        */ L"沒有可用的工作行程，%zu 對在本行程中執行",
+    /* tuningSummary     */ L"自動調節同時進行數：最終 %u 個，p99 %.1f 毫秒（基準 %.1f 毫秒），調高 %llu 次、調低 %llu 次（共 %llu 個視窗）",
     /* resultSuccess     */  "成功",
     /* resultNoExist     */  "檔案不存在",
     /* resultPermDenied  */  "權限不足",
     /* resultAlreadyExists */"目標檔案已存在",
     /* resultSameFile    */ "兩個路徑指向同一檔案",
     /* resultInvalidPath */ "無效路徑",
+    /* resultVerifyFailed */"交換後校驗失敗",
+    /* resultNameCollision */"新名稱與同批次其他項目或既有檔案衝突（不區分大小寫）",
+    /* resultMetadataFailed */"無法隨名稱一併交換中繼資料",
+    /* resultResumeInDoubt */ "上次執行在交換過程中中斷，無法確認是否已交換，請手動檢查",
+    /* resultWorkerLost  */ "工作行程在交換過程中結束，無法確認是否已交換，請手動檢查",
+    /* resultBusy        */ "另一項交換正在使用其中的項目，請稍後再試",
+    /* resultHalfSwapped */ "交換失敗且無法復原，項目現位於：",
     /* resultUnknown     */ "未知錯誤",
 };
 
@@ -71,20 +177,73 @@ static const LocaleStrings kEnglish = {
     /* adminTooltip      */  "Toggle administrator mode",
     /* sendToTooltip     */  "Left-click: add a Send To shortcut\nRight-click: remove the Send To shortcut",
     /* aboutMessageW     */ L"Drop one or two files/folders, or type paths manually.\nThe app can stay in the system tray.\nHover toolbar buttons to view tips.\n\nFeatures:\n- Always on top\n- Toggle administrator mode\n- Create/remove Send To shortcut\n- Preserve extensions or swap full names",
-    /* trayTooltip       */ L"FilenameExchanger\nLeft-click: Show/Hide\nRight-click: Exit",
+    /* trayTooltip       */ L"FilenameExchanger\nLeft-click: Show/Hide\nRight-click: Menu",
+    /* trayUnpinMenu     */ L"Unpin",
+    /* trayExitMenu      */ L"Exit",
     /* shortcutCreated   */ L"Added to Send To",
     /* shortcutRemoved   */ L"Removed from Send To",
     /* tipsTitle         */ L"Info",
     /* errorTitle        */ L"Error",
     /* warningTitle      */ L"Warn",
     /* cmdErrorPrefix    */ L"Exchange failed: ",
-    /* cmdUsage          */ L"Usage:\n  name_exchanger <path1> <path2> [preserve]\n\n[preserve] is optional and defaults to true (preserve extensions), you can set it to false (swap full names).",
+    /* cmdUsage          */ L"Usage:\n  name_exchanger <path1> <path2> [preserve] [--verify] [--swap-metadata <classes>]\n  name_exchanger - [preserve] [--verify] [--swap-metadata <classes>] [--pipeline-depth <n>] [--max-rate <ops/s>] [--max-in-flight <n|auto>] [--io-priority background|normal] [--name-rules windows|posix|smb|none] [--simulate-latency <rtt[:jitter[:errors]]>] [--plan]\n  name_exchanger --manifest <file> [preserve] [...] [--checkpoint <file> [--resume] | --workers <n>] | --manifest <file> --compile-manifest <out>\n  name_exchanger --watch <dir> <*.ext> [--watch ...]\n  name_exchanger --pair-rule <root> <pattern> <replacement> [--pair-rule ...]\n\n[preserve] is optional and defaults to true (preserve extensions), you can set it to false (swap full names).\n--verify checks afterwards that the two items really traded names.\n--swap-metadata keeps the selected metadata with the names (times, attrs, streams, comma-separated, or all).\n- reads path pairs from stdin (newline- or NUL-delimited) and writes one JSON result per line to stdout.\n--plan only plans: one JSON plan record per pair on stdout (feed it back to - to run it), counts and estimated time per strategy on stderr.\n--manifest reads the pairs from a memory-mapped file (text as for -, or a binary manifest) and otherwise works like -; --compile-manifest converts a manifest to the binary format.\n--checkpoint records completed pairs in a file; after an interruption, run the same command with --resume to skip them and carry on. The file is deleted once every pair succeeded.\n--workers splits the manifest by folder and runs the shards on n worker processes that never touch the same folder; the pairs a worker that exits had not started go to another one.\n--pipeline-depth keeps up to n swaps in flight (default 1) for high-latency shares; swaps sharing a path stay in order.\n--max-rate, --max-in-flight and --io-priority limit batch swaps; adjust them live in the queue panel or by passing them to the running instance again; --max-in-flight auto tunes the number in flight from swap latency and failures, up to the pipeline depth.\n--name-rules checks the names each pair gets against the target volume before anything runs (windows, the default: no <>:\"/\\|?* or control characters, no trailing dot or space, no device names such as CON, NUL or COM1; posix: no NUL or /, at most 255 bytes; smb: a Samba share, both; none: no check) and reports pairs that break them as invalid paths.\n--simulate-latency swaps on a simulated share instead of the disk (round trip ms[:jitter[:error rate]]).\n--watch stays in the tray and swaps X.ext with X whenever a <*.ext> file settles next to a same-named file in <dir>.\n--pair-rule scans <root> recursively and queues every item matching <pattern> with the item named by <replacement> in the same folder (e.g. *.prod.json with *.staging.json; a re: prefix selects a regex, $1 refers to a group).",
+    /* cmdWatchInvalid   */ L"Cannot watch: ",
+    /* cmdPairRuleInvalid*/ L"Invalid pair rule or unreadable root: ",
+    /* cmdManifestInvalid*/ L"Cannot read manifest: ",
+    /* cmdManifestWriteFailed*/ L"Cannot write manifest: ",
+    /* cmdCheckpointInvalid*/ L"Cannot use checkpoint (not writable, not a checkpoint, or for another manifest): ",
+    /* cmdCheckpointUnfinished*/ L"Checkpoint already exists; continue with --resume or delete it: ",
+    /* cmdInvalidArgument*/ L"Invalid argument.",
+    /* queueAddButton    */  "Add to queue",
+    /* pairPinButton     */  "Pin pair",
+    /* queueRunButton    */  "Run",
+    /* queueClearButton  */  "Clear finished",
+    /* queueFilterHint   */  "Filter paths",
+    /* queueStatusColumn */  "Status",
+    /* stateAll          */  "All",
+    /* statePending      */  "Pending",
+    /* stateRunning      */  "Running",
+    /* stateDone         */  "Done",
+    /* stateFailed       */  "Failed",
+    /* queueLimitsButton */  "Limits",
+    /* throttleRateLabel */  "Swaps per second",
+    /* throttleInFlightLabel*/  "Max in flight",
+    /* throttleBackgroundLabel*/  "Background I/O priority",
+    /* throttleUnlimited */  "Unlimited",
+    /* throttleAutoLabel */  "Auto-tune",
+    /* throttleTuningStatus*/  "Now %u, p99 %.1f ms (baseline %.1f), %llu raises, %llu cuts",
+    /* pathStatusFile    */  "File",
+    /* pathStatusDirectory*/  "Folder",
+    /* pathStatusMissing */  "Not found",
+    /* pathStatusInvalid */  "Invalid path",
+    /* pathStatusSameItem*/  "Same item as the other path",
+    /* pathStatusCollision*/  "Swapped name is already taken",
+    /* planHeader        */ L"Plan: %zu pairs, planned in %.0f ms (+%.0f ms probing)",
+    /* planStrategyRename*/ L"rename (3 steps)",
+    /* planStrategyCaseOnly*/ L"case-only (4 steps)",
+    /* planStrategyCrossVolume*/ L"cross-volume copy",
+    /* planStrategySkip  */ L"skipped",
+    /* planVolume        */ L"Volume %ls: %zu pairs, stat %.0f us, rename %.0f us, copy %.0f MB/s%ls",
+    /* planVolumeDefault */ L" (defaults, not measured)",
+    /* planEstimate      */ L"Estimated run time: %.1f s at pipeline depth %zu",
+    /* shardHeader       */ L"Sharded run: %zu pairs in %zu shards on %zu workers, %.1f s (%.0f pairs/s)",
+    /* shardWorker       */ L"  worker %zu: %zu shards, %zu pairs, %zu restarts",
+    /* shardLost         */ L"%zu pairs were mid-swap when their worker exited; their outcome is unknown",
+    /* shardLocal        */ L"No worker was left; %zu pairs ran in this process",
+    /* tuningSummary     */ L"Adaptive in-flight limit: %u at the end, p99 %.1f ms (baseline %.1f ms), %llu raises and %llu cuts over %llu windows",
     /* resultSuccess     */  "Success",
     /* resultNoExist     */  "File or directory does not exist",
     /* resultPermDenied  */  "Permission denied",
     /* resultAlreadyExists */"Target file already exists",
     /* resultSameFile    */  "Both paths refer to the same item",
     /* resultInvalidPath */  "Invalid path",
+    /* resultVerifyFailed */ "Post-swap verification failed",
+    /* resultNameCollision */ "New name collides with another item in the batch or an existing file (ignoring case)",
+    /* resultMetadataFailed */ "Metadata could not be swapped along with the names",
+    /* resultResumeInDoubt */ "Interrupted mid-swap by the previous run; whether it took place is unknown, check it by hand",
+    /* resultWorkerLost  */ "The worker process exited mid-swap; whether it took place is unknown, check it by hand",
+    /* resultBusy        */ "Another swap is using one of these items; try again in a moment",
+    /* resultHalfSwapped */ "The swap failed and could not be undone; the items are now at:",
     /* resultUnknown     */  "Unknown error",
 };
 
@@ -138,6 +297,20 @@ const char* GetOutputInfo(int id) {
             return locale.resultSameFile;
         case 5:
             return locale.resultInvalidPath;
+        case 6:
+            return locale.resultVerifyFailed;
+        case 7:
+            return locale.resultNameCollision;
+        case 8:
+            return locale.resultMetadataFailed;
+        case 9:
+            return locale.resultResumeInDoubt;
+        case 10:
+            return locale.resultWorkerLost;
+        case 11:
+            return locale.resultBusy;
+        case 12:
+            return locale.resultHalfSwapped;
         default:
             return locale.resultUnknown;
     }
@@ -20,6 +20,8 @@ struct LocaleStrings {
     const char* sendToTooltip;
     const wchar_t* aboutMessageW;
     const wchar_t* trayTooltip;
+    const wchar_t* trayUnpinMenu;
+    const wchar_t* trayExitMenu;
     const wchar_t* shortcutCreated;
     const wchar_t* shortcutRemoved;
     const wchar_t* tipsTitle;
@@ -27,6 +29,60 @@ struct LocaleStrings {
     const wchar_t* warningTitle;
     const wchar_t* cmdErrorPrefix;
     const wchar_t* cmdUsage;
+    const wchar_t* cmdWatchInvalid;
+    const wchar_t* cmdPairRuleInvalid;
+    const wchar_t* cmdManifestInvalid;
+    const wchar_t* cmdManifestWriteFailed;
+    const wchar_t* cmdCheckpointInvalid;
+    const wchar_t* cmdCheckpointUnfinished;
+    const wchar_t* cmdInvalidArgument;
+
+    // Swap queue panel
+    const char* queueAddButton;
+    const char* pairPinButton;
+    const char* queueRunButton;
+    const char* queueClearButton;
+    const char* queueFilterHint;
+    const char* queueStatusColumn;
+    const char* stateAll;
+    const char* statePending;
+    const char* stateRunning;
+    const char* stateDone;
+    const char* stateFailed;
+    const char* queueLimitsButton;
+    const char* throttleRateLabel;
+    const char* throttleInFlightLabel;
+    const char* throttleBackgroundLabel;
+    const char* throttleUnlimited;
+    const char* throttleAutoLabel;
+    const char* throttleTuningStatus;  // limit, p99 ms, baseline ms, raises, cuts
+
+    // Status right of the path labels
+    const char* pathStatusFile;
+    const char* pathStatusDirectory;
+    const char* pathStatusMissing;
+    const char* pathStatusInvalid;
+    const char* pathStatusSameItem;
+    const char* pathStatusCollision;
+
+    // Dry-run plan summary (--plan), printf formats
+    const wchar_t* planHeader;  // pairs, planning ms, probing ms
+    const wchar_t* planStrategyRename;
+    const wchar_t* planStrategyCaseOnly;
+    const wchar_t* planStrategyCrossVolume;
+    const wchar_t* planStrategySkip;
+    const wchar_t* planVolume;  // root, pairs, stat us, rename us, copy MB/s, planVolumeDefault or ""
+    const wchar_t* planVolumeDefault;
+    const wchar_t* planEstimate;  // seconds, pipeline depth
+
+    // Sharded run summary (--workers), printf formats
+    const wchar_t* shardHeader;  // pairs, shards, workers, seconds, pairs per second
+    const wchar_t* shardWorker;  // worker, shards, pairs, restarts
+    const wchar_t* shardLost;    // pairs
+    const wchar_t* shardLocal;   // pairs
+
+    // Adaptive in-flight limit after a "-" or --manifest run (--max-in-flight auto), printf format
+    const wchar_t* tuningSummary;  // limit, p99 ms, baseline ms, raises, cuts, windows
 
     // Result messages
     const char* resultSuccess;
@@ -35,6 +91,13 @@ struct LocaleStrings {
     const char* resultAlreadyExists;
     const char* resultSameFile;
     const char* resultInvalidPath;
+    const char* resultVerifyFailed;
+    const char* resultNameCollision;
+    const char* resultMetadataFailed;
+    const char* resultResumeInDoubt;
+    const char* resultWorkerLost;
+    const char* resultBusy;
+    const char* resultHalfSwapped;
     const char* resultUnknown;
 };
 
@@ -47,5 +110,5 @@ const LocaleStrings& GetLocaleStrings(Language lang);
 // Get the localized strings for the detected system language (cached)
 const LocaleStrings& GetCurrentLocale();
 
-// Get result message by exchange() return code
+// Get result message by exchange() return code (see exchange.h)
 const char* GetOutputInfo(int id);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Append `text` to `out` as a quoted JSON string. Input is expected to be UTF-8 and is passed
+// through unchanged apart from the escapes JSON requires.
+inline void AppendJsonString(std::string& out, std::string_view text) {
+    out.push_back('"');
+    for (char ch : text) {
+        switch (ch) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    char esc[8];
+                    std::snprintf(esc, sizeof(esc), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(ch)));
+                    out += esc;
+                } else {
+                    out.push_back(ch);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+// Read the quoted JSON string at the start of `in` into `out` as UTF-8 and advance `in` past it.
+// False if `in` does not start with a well-formed string.
+inline bool ReadJsonString(std::string_view& in, std::string& out) {
+    if (in.empty() || in.front() != '"') return false;
+    out.clear();
+    size_t i = 1;
+    auto hex4 = [&](unsigned& value) {
+        if (in.size() - i < 4) return false;
+        value = 0;
+        for (int k = 0; k < 4; ++k, ++i) {
+            const char ch = in[i];
+            const unsigned digit = ch >= '0' && ch <= '9'   ? ch - '0'
+                                   : ch >= 'a' && ch <= 'f' ? ch - 'a' + 10
+                                   : ch >= 'A' && ch <= 'F' ? ch - 'A' + 10
+                                                            : 16u;
+            if (digit > 15) return false;
+            value = value * 16 + digit;
+        }
+        return true;
+    };
+    while (i < in.size()) {
+        const char ch = in[i++];
+        if (ch == '"') {
+            in.remove_prefix(i);
+            return true;
+        }
+        if (ch != '\\') {
+            out.push_back(ch);
+            continue;
+        }
+        if (i == in.size()) return false;
+        switch (in[i++]) {
+            case '"':
+                out.push_back('"');
+                break;
+            case '\\':
+                out.push_back('\\');
+                break;
+            case '/':
+                out.push_back('/');
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u': {
+                unsigned cp = 0;
+                if (!hex4(cp)) return false;
+                if (cp >= 0xD800 && cp < 0xDC00) {
+                    unsigned low = 0;
+                    if (in.size() - i < 2 || in[i] != '\\' || in[i + 1] != 'u') return false;
+                    i += 2;
+                    if (!hex4(low) || low < 0xDC00 || low >= 0xE000) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (cp < 0x80) {
+                    out.push_back(static_cast<char>(cp));
+                } else if (cp < 0x800) {
+                    out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                } else if (cp < 0x10000) {
+                    out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                } else {
+                    out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
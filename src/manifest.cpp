@@ -0,0 +1,263 @@
+#include "manifest.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MANIFEST_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+// Text is split into slices of at least this size, one per work item
+constexpr size_t kScanSlice = 4u << 20;
+// Span layout: 40 bits of offset (1 TB files), 24 bits of length (16 MB records)
+constexpr int kSpanLengthBits = 24;
+constexpr uint64_t kSpanLengthMask = (1ull << kSpanLengthBits) - 1;
+constexpr uint64_t kMaxTextSize = 1ull << 40;
+
+unsigned LowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Offset of the first NUL or newline in [data, data + size), or size
+size_t FindDelimiter(const char* data, size_t size) {
+    size_t i = 0;
+#ifdef MANIFEST_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, zero));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask) return i + LowestBit(mask);
+    }
+#endif
+    for (; i < size; ++i) {
+        if (data[i] == '\n' || data[i] == '\0') return i;
+    }
+    return size;
+}
+
+// Append the absolute offset of every `delim` in [begin, end) to out
+void CollectDelimiters(const char* data, size_t begin, size_t end, char delim, std::vector<uint64_t>& out) {
+    size_t i = begin;
+#ifdef MANIFEST_SSE2
+    const __m128i needle = _mm_set1_epi8(delim);
+    for (; i + 16 <= end; i += 16) {
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), needle)));
+        while (mask) {
+            out.push_back(i + LowestBit(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < end; ++i) {
+        if (data[i] == delim) out.push_back(i);
+    }
+}
+
+// Add the record [begin, end) unless it is blank text
+bool AddSpan(const char* data, uint64_t begin, uint64_t end, char delim, std::vector<uint64_t>& spans) {
+    if (delim == '\n' && end > begin && data[end - 1] == '\r') --end;
+    if (delim == '\n' && end == begin) return true;
+    if (end - begin > kSpanLengthMask) return false;
+    spans.push_back(begin << kSpanLengthBits | (end - begin));
+    return true;
+}
+
+bool WriteAll(HANDLE file, const void* data, size_t size) {
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+        const DWORD chunk = static_cast<DWORD>((std::min)(size, size_t{1} << 30));
+        DWORD written = 0;
+        if (!WriteFile(file, cursor, chunk, &written, nullptr) || written != chunk) return false;
+        cursor += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+}  // namespace
+
+bool Manifest::Open(const std::wstring& path) {
+    Close();
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                        nullptr);
+    LARGE_INTEGER fileSize = {};
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &fileSize)) {
+        Close();
+        return false;
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    if (size_ == 0) return true;  // A file mapping cannot be empty; neither is there anything to map
+
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data_ = mapping_ ? static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    if (!data_) {
+        Close();
+        return false;
+    }
+
+    // Binary: check the header and that every record points into the string table
+    if (size_ >= sizeof(BinaryManifestHeader) && std::memcmp(data_, kBinaryManifestMagic, 8) == 0) {
+        BinaryManifestHeader header;
+        std::memcpy(&header, data_, sizeof(header));
+        const bool headerOk = header.version == kBinaryManifestVersion &&
+                              header.recordSize == sizeof(BinaryManifestRecord) && header.recordsOffset % 8 == 0 &&
+                              header.recordsOffset <= size_ &&
+                              header.pairCount <= (size_ - header.recordsOffset) / sizeof(BinaryManifestRecord) &&
+                              header.stringsOffset <= size_ && header.stringsSize <= size_ - header.stringsOffset;
+        if (!headerOk) {
+            Close();
+            return false;
+        }
+        const auto* records = reinterpret_cast<const BinaryManifestRecord*>(data_ + header.recordsOffset);
+        for (uint64_t i = 0; i < header.pairCount; ++i) {
+            const BinaryManifestRecord& r = records[i];
+            if (r.path1 > header.stringsSize || r.length1 > header.stringsSize - r.path1 ||
+                r.path2 > header.stringsSize || r.length2 > header.stringsSize - r.path2 ||
+                r.preserve > kManifestSwapFullName) {
+                Close();
+                return false;
+            }
+        }
+        records_ = records;
+        strings_ = data_ + header.stringsOffset;
+        pairCount_ = static_cast<size_t>(header.pairCount);
+        return true;
+    }
+
+    // Text: the delimiter is whichever of NUL or newline comes first, as on stdin
+    if (size_ >= kMaxTextSize) {
+        Close();
+        return false;
+    }
+    const size_t start = (size_ >= 3 && std::memcmp(data_, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+    const size_t first = start + FindDelimiter(data_ + start, size_ - start);
+    const char delim = first < size_ ? data_[first] : '\n';
+
+    const size_t threads = (std::max)(1u, std::thread::hardware_concurrency());
+    const size_t slices = std::clamp((size_ - start) / kScanSlice, size_t{1}, threads * 4);
+    const size_t sliceSize = (size_ - start + slices - 1) / slices;
+    std::vector<std::vector<uint64_t>> found(slices);
+    ParallelFor(slices, [&](size_t s) {
+        const size_t begin = start + s * sliceSize;
+        const size_t end = (std::min)(size_, begin + sliceSize);
+        found[s].reserve((end - begin) / 32);
+        CollectDelimiters(data_, begin, end, delim, found[s]);
+    });
+
+    size_t delimiters = 0;
+    for (const auto& slice : found) delimiters += slice.size();
+    spans_.reserve(delimiters + 1);
+    uint64_t begin = start;
+    bool ok = true;
+    for (auto& slice : found) {
+        for (uint64_t end : slice) {
+            ok = AddSpan(data_, begin, end, delim, spans_) && ok;
+            begin = end + 1;
+        }
+        std::vector<uint64_t>().swap(slice);
+    }
+    if (begin < size_) ok = AddSpan(data_, begin, size_, delim, spans_) && ok;
+    if (!ok) {
+        Close();
+        return false;
+    }
+    pairCount_ = (spans_.size() + 1) / 2;
+    return true;
+}
+
+void Manifest::Close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    pairCount_ = 0;
+    std::vector<uint64_t>().swap(spans_);
+    records_ = nullptr;
+    strings_ = nullptr;
+}
+
+std::string_view Manifest::Record(size_t r) const {
+    if (r >= spans_.size()) return {};
+    return std::string_view(data_ + (spans_[r] >> kSpanLengthBits), static_cast<size_t>(spans_[r] & kSpanLengthMask));
+}
+
+std::string_view Manifest::Path1(size_t i) const {
+    if (records_) return std::string_view(strings_ + records_[i].path1, records_[i].length1);
+    return Record(i * 2);
+}
+
+std::string_view Manifest::Path2(size_t i) const {
+    if (records_) return std::string_view(strings_ + records_[i].path2, records_[i].length2);
+    return Record(i * 2 + 1);
+}
+
+std::optional<bool> Manifest::PreserveExt(size_t i) const {
+    if (!records_ || records_[i].preserve == kManifestPreserveDefault) return std::nullopt;
+    return records_[i].preserve == kManifestPreserveExt;
+}
+
+bool WriteBinaryManifest(const std::wstring& path, const Manifest& source) {
+    BinaryManifestHeader header = {};
+    std::memcpy(header.magic, kBinaryManifestMagic, sizeof(header.magic));
+    header.version = kBinaryManifestVersion;
+    header.recordSize = sizeof(BinaryManifestRecord);
+    header.pairCount = source.Size();
+    header.recordsOffset = sizeof(header);
+    header.stringsOffset = header.recordsOffset + header.pairCount * sizeof(BinaryManifestRecord);
+
+    // Records first, so the string table can be streamed after them in the same order
+    std::vector<BinaryManifestRecord> records(source.Size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < source.Size(); ++i) {
+        BinaryManifestRecord& r = records[i];
+        const std::optional<bool> preserve = source.PreserveExt(i);
+        r.preserve = !preserve ? kManifestPreserveDefault : *preserve ? kManifestPreserveExt : kManifestSwapFullName;
+        r.path1 = offset;
+        r.length1 = static_cast<uint32_t>(source.Path1(i).size());
+        offset += r.length1 + 1;
+        r.path2 = offset;
+        r.length2 = static_cast<uint32_t>(source.Path2(i).size());
+        offset += r.length2 + 1;
+    }
+    header.stringsSize = offset;
+
+    HANDLE file =
+        CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    bool ok = WriteAll(file, &header, sizeof(header)) &&
+              WriteAll(file, records.data(), records.size() * sizeof(BinaryManifestRecord));
+    std::string buf;
+    for (size_t i = 0; ok && i < source.Size(); ++i) {
+        for (std::string_view text : {source.Path1(i), source.Path2(i)}) {
+            buf.append(text);
+            buf.push_back('\0');
+        }
+        if (buf.size() >= (1u << 20)) {
+            ok = WriteAll(file, buf.data(), buf.size());
+            buf.clear();
+        }
+    }
+    ok = ok && WriteAll(file, buf.data(), buf.size());
+    CloseHandle(file);
+    if (!ok) DeleteFileW(path.c_str());
+    return ok;
+}
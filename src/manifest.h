@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <windows.h>
+
+// Binary manifest ("--manifest" input that needs no parsing). All fields are little-endian:
+//
+//   header   BinaryManifestHeader at offset 0
+//   records  pairCount x BinaryManifestRecord at recordsOffset (8-byte aligned)
+//   strings  stringsSize bytes at stringsOffset: UTF-8 paths, each followed by a NUL
+//
+// Records refer to their paths by offset into the string table, so paths may be shared.
+struct BinaryManifestHeader {
+    char magic[8];           // kBinaryManifestMagic
+    uint32_t version;        // kBinaryManifestVersion
+    uint32_t recordSize;     // sizeof(BinaryManifestRecord)
+    uint64_t pairCount;
+    uint64_t recordsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+struct BinaryManifestRecord {
+    uint64_t path1;    // Offset into the string table
+    uint64_t path2;
+    uint32_t length1;  // Bytes, without the NUL
+    uint32_t length2;
+    uint32_t preserve;  // kManifestPreserve*
+    uint32_t reserved;  // 0
+};
+
+static_assert(sizeof(BinaryManifestHeader) == 48, "manifest header layout is fixed");
+static_assert(sizeof(BinaryManifestRecord) == 32, "manifest record layout is fixed");
+
+constexpr char kBinaryManifestMagic[8] = {'N', 'X', 'M', 'A', 'N', 'I', 'F', '\x1a'};
+constexpr uint32_t kBinaryManifestVersion = 1;
+
+// Per-pair extension handling in a binary manifest
+constexpr uint32_t kManifestPreserveDefault = 0;  // The [preserve] argument decides
+constexpr uint32_t kManifestPreserveExt = 1;
+constexpr uint32_t kManifestSwapFullName = 2;
+
+// A list of path pairs read straight from a memory-mapped file. Paths are views into the mapping:
+// nothing is copied, and they stay valid as long as the Manifest lives.
+//
+// Text manifests hold the same records as "-" mode: NUL- or newline-delimited (whichever comes
+// first), consecutive records forming a pair, blank lines and a UTF-8 BOM ignored. They are indexed
+// on all cores with SSE2, 16 bytes per compare, into 8 bytes per record. Binary manifests are only
+// bounds-checked: their records are used in place.
+class Manifest {
+public:
+    Manifest() = default;
+    Manifest(const Manifest&) = delete;
+    Manifest& operator=(const Manifest&) = delete;
+    ~Manifest() { Close(); }
+
+    // Map and index the file; false if it cannot be read or a binary manifest is malformed
+    bool Open(const std::wstring& path);
+    void Close();
+
+    bool IsBinary() const { return records_ != nullptr; }
+    size_t Size() const { return pairCount_; }
+
+    // Paths of pair i. A text manifest with an odd number of records ends in a pair whose
+    // second path is empty, which the swap reports as an invalid path.
+    std::string_view Path1(size_t i) const;
+    std::string_view Path2(size_t i) const;
+
+    // Extension handling recorded for pair i, if the manifest has one
+    std::optional<bool> PreserveExt(size_t i) const;
+
+private:
+    std::string_view Record(size_t r) const;
+
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t pairCount_ = 0;
+    std::vector<uint64_t> spans_;  // Text: offset << 24 | length per record
+    const BinaryManifestRecord* records_ = nullptr;
+    const char* strings_ = nullptr;
+};
+
+// Write the pairs of source as a binary manifest; false if path cannot be written
+bool WriteBinaryManifest(const std::wstring& path, const Manifest& source);
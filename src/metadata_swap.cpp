@@ -0,0 +1,199 @@
+#include "metadata_swap.h"
+
+#include "exchange.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cwctype>
+#include <string_view>
+#include <vector>
+
+namespace {
+constexpr DWORD kSwappableAttributes = FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM |
+                                       FILE_ATTRIBUTE_ARCHIVE | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED;
+// Alternate streams are copied through memory; anything bigger is not metadata
+constexpr uint64_t kMaxStreamBytes = 64ull << 20;
+
+struct NamedStream {
+    std::wstring name;  // ":name:$DATA"
+    std::vector<char> data;
+};
+
+struct Item {
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    FILE_BASIC_INFO basic = {};
+    std::vector<NamedStream> streams;
+
+    ~Item() {
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+    }
+};
+
+// Attribute access does not conflict with the DELETE access the renames need, and the handle keeps
+// pointing at the item wherever it is renamed to
+HANDLE OpenForMetadata(const std::wstring& path) {
+    return CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES | FILE_WRITE_ATTRIBUTES | SYNCHRONIZE,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, nullptr);
+}
+
+// Current path of an open item, "\\?\"-prefixed
+std::wstring PathOf(HANDLE handle) {
+    std::wstring path(MAX_PATH, L'\0');
+    DWORD len = GetFinalPathNameByHandleW(handle, path.data(), static_cast<DWORD>(path.size()), FILE_NAME_NORMALIZED);
+    if (len >= path.size()) {
+        path.resize(len);
+        len = GetFinalPathNameByHandleW(handle, path.data(), static_cast<DWORD>(path.size()), FILE_NAME_NORMALIZED);
+    }
+    path.resize(len < path.size() ? len : 0);
+    return path;
+}
+
+// Read every alternate stream of the item at path; false if one cannot be read or they are too big
+bool ReadStreams(HANDLE handle, const std::wstring& path, std::vector<NamedStream>& streams) {
+    std::vector<unsigned char> buffer(16 * 1024);
+    while (!GetFileInformationByHandleEx(handle, FileStreamInfo, buffer.data(), static_cast<DWORD>(buffer.size()))) {
+        const DWORD error = GetLastError();
+        if (error == ERROR_HANDLE_EOF) return true;  // No streams at all (e.g. a directory)
+        if (error != ERROR_MORE_DATA || buffer.size() >= (1u << 20)) return false;
+        buffer.resize(buffer.size() * 2);
+    }
+
+    uint64_t total = 0;
+    const unsigned char* cursor = buffer.data();
+    for (;;) {
+        const auto* info = reinterpret_cast<const FILE_STREAM_INFO*>(cursor);
+        const std::wstring_view name(info->StreamName, info->StreamNameLength / sizeof(wchar_t));
+        if (name != L"::$DATA") {
+            total += static_cast<uint64_t>(info->StreamSize.QuadPart);
+            if (total > kMaxStreamBytes) return false;
+
+            NamedStream stream;
+            stream.name = name;
+            stream.data.resize(static_cast<size_t>(info->StreamSize.QuadPart));
+            HANDLE file = CreateFileW((path + stream.name).c_str(), GENERIC_READ,
+                                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                      FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            const DWORD size = static_cast<DWORD>(stream.data.size());
+            DWORD read = 0;
+            const bool ok = size == 0 || (ReadFile(file, stream.data.data(), size, &read, nullptr) && read == size);
+            CloseHandle(file);
+            if (!ok) return false;
+            streams.push_back(std::move(stream));
+        }
+        if (info->NextEntryOffset == 0) break;
+        cursor += info->NextEntryOffset;
+    }
+    return true;
+}
+
+// Replace the alternate streams of the item at path with the given ones
+bool ReplaceStreams(const std::wstring& path, const std::vector<NamedStream>& current,
+                    const std::vector<NamedStream>& wanted) {
+    for (const NamedStream& stream : current) {
+        if (!DeleteFileW((path + stream.name).c_str())) return false;
+    }
+    for (const NamedStream& stream : wanted) {
+        HANDLE file = CreateFileW((path + stream.name).c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                  FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        const DWORD size = static_cast<DWORD>(stream.data.size());
+        DWORD written = 0;
+        const bool ok = size == 0 || (WriteFile(file, stream.data.data(), size, &written, nullptr) && written == size);
+        CloseHandle(file);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// What `self` ends up with: the other item's metadata for the selected classes, its own otherwise.
+// Zero fields mean "leave as is" to SetFileInformationByHandle, so ChangeTime is never touched and
+// attributes are only written when they are swapped or have to be restored.
+FILE_BASIC_INFO MergedBasicInfo(const FILE_BASIC_INFO& self, const FILE_BASIC_INFO& other, uint32_t classes,
+                                bool restoreAttributes) {
+    FILE_BASIC_INFO info = self;
+    if (classes & kMetadataTimes) {
+        info.CreationTime = other.CreationTime;
+        info.LastAccessTime = other.LastAccessTime;
+        info.LastWriteTime = other.LastWriteTime;
+    }
+    info.ChangeTime.QuadPart = 0;
+    info.FileAttributes = 0;
+    if (classes & kMetadataAttributes) {
+        info.FileAttributes = other.FileAttributes & kSwappableAttributes;
+    } else if (restoreAttributes) {
+        info.FileAttributes = self.FileAttributes & kSwappableAttributes;
+    } else {
+        return info;
+    }
+    if (info.FileAttributes == 0) info.FileAttributes = FILE_ATTRIBUTE_NORMAL;
+    return info;
+}
+}  // namespace
+
+bool ParseMetadataClasses(const std::wstring& spec, uint32_t& classes) {
+    uint32_t parsed = 0;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        const size_t end = (std::min)(spec.find(L',', start), spec.size());
+        std::wstring field = spec.substr(start, end - start);
+        std::transform(field.begin(), field.end(), field.begin(), [](wchar_t ch) { return std::towlower(ch); });
+        if (field == L"times") {
+            parsed |= kMetadataTimes;
+        } else if (field == L"attrs") {
+            parsed |= kMetadataAttributes;
+        } else if (field == L"streams") {
+            parsed |= kMetadataStreams;
+        } else if (field == L"all") {
+            parsed |= kMetadataAll;
+        } else {
+            return false;
+        }
+        start = end + 1;
+    }
+    classes = parsed;
+    return true;
+}
+
+int ExchangeWithMetadata(const std::wstring& path1, const std::wstring& path2, uint32_t classes,
+                         const std::function<int()>& swap) {
+    Item items[2];
+    const std::wstring* paths[2] = {&path1, &path2};
+    for (int i = 0; i < 2; ++i) {
+        items[i].handle = OpenForMetadata(*paths[i]);
+        if (items[i].handle == INVALID_HANDLE_VALUE ||
+            !GetFileInformationByHandleEx(items[i].handle, FileBasicInfo, &items[i].basic, sizeof(items[i].basic))) {
+            return swap();  // Let the swap report the precise reason
+        }
+        if ((classes & kMetadataStreams) && !ReadStreams(items[i].handle, PathOf(items[i].handle), items[i].streams)) {
+            return kResultMetadataFailed;
+        }
+    }
+
+    const int result = swap();
+    if (result != kResultSuccess) {
+        return result;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < 2; ++i) {
+        Item& self = items[i];
+        const Item& other = items[1 - i];
+        bool madeWritable = false;
+        if ((classes & kMetadataStreams) && (!self.streams.empty() || !other.streams.empty())) {
+            // A read-only item refuses stream writes; the final update below restores the flag
+            if (self.basic.FileAttributes & FILE_ATTRIBUTE_READONLY) {
+                FILE_BASIC_INFO writable = {};
+                writable.FileAttributes = self.basic.FileAttributes & kSwappableAttributes & ~FILE_ATTRIBUTE_READONLY;
+                if (writable.FileAttributes == 0) writable.FileAttributes = FILE_ATTRIBUTE_NORMAL;
+                madeWritable = SetFileInformationByHandle(self.handle, FileBasicInfo, &writable, sizeof(writable));
+            }
+            ok = ReplaceStreams(PathOf(self.handle), self.streams, other.streams) && ok;
+        }
+        // Always written: stream writes bump the last write time, which must end up as selected
+        FILE_BASIC_INFO info = MergedBasicInfo(self.basic, other.basic, classes, madeWritable);
+        ok = SetFileInformationByHandle(self.handle, FileBasicInfo, &info, sizeof(info)) && ok;
+    }
+    return ok ? kResultSuccess : kResultMetadataFailed;
+}
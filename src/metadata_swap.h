@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Metadata classes that can follow the names in a swap ("--swap-metadata times,attrs,streams")
+enum MetadataClass : uint32_t {
+    kMetadataTimes = 1 << 0,       // Creation, last access and last write time
+    kMetadataAttributes = 1 << 1,  // Read-only, hidden, system, archive, not-indexed
+    kMetadataStreams = 1 << 2,     // Alternate data streams (Zone.Identifier, tags, ...)
+    kMetadataAll = kMetadataTimes | kMetadataAttributes | kMetadataStreams,
+};
+
+// Parse a comma-separated list of "times", "attrs", "streams" or "all"; false if malformed
+bool ParseMetadataClasses(const std::wstring& spec, uint32_t& classes);
+
+// Run swap (a plain name swap of path1 and path2) so that the selected metadata stays with the
+// names instead of travelling with the content. Both items are opened once up front and the same
+// handles, which follow the items through the renames, are used to read the metadata before and
+// write it after: a fixed two queries and two updates per pair, plus one read and one write per
+// alternate stream. Returns the swap's code, or kResultMetadataFailed if the metadata could not be
+// moved: streams that cannot be read (or exceed 64 MB) are refused before anything is renamed, a
+// failed update afterwards leaves the names swapped.
+int ExchangeWithMetadata(const std::wstring& path1, const std::wstring& path2, uint32_t classes,
+                         const std::function<int()>& swap);
@@ -0,0 +1,79 @@
+#include "name_fold.h"
+
+#include <windows.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NAME_FOLD_SSE2 1
+#endif
+
+namespace {
+// Upper-case ASCII in place; false (with out untouched past the ASCII prefix) if a unit is >= 0x80
+bool FoldAscii(const wchar_t* src, size_t len, wchar_t* out) {
+    size_t i = 0;
+#ifdef NAME_FOLD_SSE2
+    const __m128i highBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i beforeA = _mm_set1_epi16('a' - 1);
+    const __m128i afterZ = _mm_set1_epi16('z' + 1);
+    const __m128i caseBit = _mm_set1_epi16(0x20);
+    for (; i + 8 <= len; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, highBits), zero)) != 0xFFFF) {
+            return false;
+        }
+        // All units are < 0x80 here, so the signed compares are exact
+        const __m128i lower = _mm_and_si128(_mm_cmpgt_epi16(v, beforeA), _mm_cmpgt_epi16(afterZ, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi16(v, _mm_and_si128(lower, caseBit)));
+    }
+#endif
+    for (; i < len; ++i) {
+        const wchar_t ch = src[i];
+        if (ch >= 0x80) return false;
+        out[i] = (ch >= L'a' && ch <= L'z') ? static_cast<wchar_t>(ch - 0x20) : ch;
+    }
+    return true;
+}
+
+// Below U+0300 there are no combining marks, so NFC is the identity
+bool NeedsNormalization(std::wstring_view name) {
+    for (wchar_t ch : name) {
+        if (ch >= 0x300) return true;
+    }
+    return false;
+}
+
+std::wstring UpperInvariant(const std::wstring& text) {
+    std::wstring out(text.size(), L'\0');
+    const int len = LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, text.c_str(), static_cast<int>(text.size()),
+                                  out.data(), static_cast<int>(out.size()), nullptr, nullptr, 0);
+    if (len <= 0) return text;
+    out.resize(static_cast<size_t>(len));
+    return out;
+}
+
+std::wstring NormalizeNfc(std::wstring_view name) {
+    const int src = static_cast<int>(name.size());
+    int cap = NormalizeString(NormalizationC, name.data(), src, nullptr, 0);
+    // The estimate can be too small; the API reports the size it needs in that case
+    for (int attempt = 0; cap > 0 && attempt < 4; ++attempt) {
+        std::wstring out(static_cast<size_t>(cap), L'\0');
+        const int len = NormalizeString(NormalizationC, name.data(), src, out.data(), cap);
+        if (len > 0) {
+            out.resize(static_cast<size_t>(len));
+            return out;
+        }
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) break;
+        cap = -len;
+    }
+    return std::wstring(name);  // Invalid UTF-16: compare as-is
+}
+}  // namespace
+
+std::wstring FoldName(std::wstring_view name) {
+    std::wstring out(name.size(), L'\0');
+    if (FoldAscii(name.data(), name.size(), out.data())) {
+        return out;
+    }
+    return UpperInvariant(NeedsNormalization(name) ? NormalizeNfc(name) : std::wstring(name));
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Comparison key for a file name on a case-insensitive volume: NFC-normalized, then upper-cased
+// with the invariant locale (NTFS compares names through an upper-case table). Two names with the
+// same key denote the same entry on NTFS/FAT, or would after a normalizing copy.
+//
+// Pure-ASCII names (the common case) are folded 8 UTF-16 units at a time with SSE2 and never
+// reach the Windows APIs; names below U+0300 skip normalization, which cannot change them.
+std::wstring FoldName(std::wstring_view name);
@@ -0,0 +1,294 @@
+#include "name_rules.h"
+
+#include "exchange.h"
+#include "parallel.h"
+#include "path_store.h"
+#include "swap_queue.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+// NX_NO_SSE2 keeps to the scalar loops, which the tests check the SSE2 ones against
+#if !defined(NX_NO_SSE2) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#include <emmintrin.h>
+#define NAME_RULES_SSE2 1
+#endif
+
+namespace {
+constexpr size_t kMaxNameSize = 255;  // UTF-16 units on Windows, bytes on POSIX
+// Bytes of a valid name: a UTF-16 unit takes at most 3 of them in UTF-8
+constexpr size_t kMaxNameBytes = 3 * kMaxNameSize;
+// Pairs per ParallelFor work item, as in FindNameCollisions
+constexpr size_t kCheckChunk = 1024;
+
+// Bytes Windows forbids besides the control characters
+constexpr char kWindowsForbidden[] = {'<', '>', ':', '"', '/', '\\', '|', '?', '*'};
+
+// Device names in lower case; "\xC2\xB9", "\xC2\xB2" and "\xC2\xB3" are the superscript digits in UTF-8
+constexpr std::string_view kDeviceNames[] = {
+    "con",  "prn",  "aux",  "nul",
+    "com0", "com1", "com2", "com3", "com4", "com5", "com6", "com7", "com8", "com9",
+    "lpt0", "lpt1", "lpt2", "lpt3", "lpt4", "lpt5", "lpt6", "lpt7", "lpt8", "lpt9",
+    "com\xC2\xB9", "com\xC2\xB2", "com\xC2\xB3", "lpt\xC2\xB9", "lpt\xC2\xB2", "lpt\xC2\xB3",
+};
+constexpr size_t kMinDeviceName = 3;
+constexpr size_t kMaxDeviceName = 5;
+
+// Up to 8 bytes of a name with ASCII letters lower-cased, packed little-endian
+constexpr uint64_t PackName(std::string_view name) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < name.size(); ++i) {
+        uint8_t c = static_cast<uint8_t>(name[i]);
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        key |= uint64_t{c} << (8 * i);
+    }
+    return key;
+}
+
+// Perfect hash of the packed device names: the first multiplier of a fixed odd sequence under which
+// no two of them share a slot is found while compiling
+constexpr int kSlotBits = 7;
+constexpr size_t kSlots = size_t{1} << kSlotBits;
+
+constexpr size_t Slot(uint64_t key, uint64_t multiplier) {
+    return static_cast<size_t>((key * multiplier) >> (64 - kSlotBits));
+}
+
+constexpr uint64_t FindMultiplier() {
+    uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    for (int attempt = 0; attempt < 4096; ++attempt) {
+        bool used[kSlots] = {};
+        bool perfect = true;
+        for (const std::string_view name : kDeviceNames) {
+            const size_t slot = Slot(PackName(name), multiplier);
+            perfect = perfect && !used[slot];
+            used[slot] = true;
+        }
+        if (perfect) return multiplier;
+        multiplier += 0x7F4A7C15F39CC060ull;  // Even, so the multiplier stays odd
+    }
+    return 0;
+}
+
+constexpr uint64_t kDeviceMultiplier = FindMultiplier();
+static_assert(kDeviceMultiplier != 0, "no perfect hash for the device names");
+
+struct DeviceTable {
+    uint64_t keys[kSlots] = {};  // 0 for an empty slot; no name packs to 0
+};
+
+constexpr DeviceTable BuildDeviceTable() {
+    DeviceTable table;
+    for (const std::string_view name : kDeviceNames) {
+        table.keys[Slot(PackName(name), kDeviceMultiplier)] = PackName(name);
+    }
+    return table;
+}
+
+constexpr DeviceTable kDeviceTable = BuildDeviceTable();
+
+// Windows reserves a device name with any extension, and ignores spaces before the extension
+bool IsDeviceName(std::string_view name) {
+    std::string_view base = name.substr(0, name.find('.'));
+    while (!base.empty() && base.back() == ' ') base.remove_suffix(1);
+    if (base.size() < kMinDeviceName || base.size() > kMaxDeviceName) {
+        return false;
+    }
+    const uint64_t key = PackName(base);
+    return kDeviceTable.keys[Slot(key, kDeviceMultiplier)] == key;
+}
+
+// Bit 0: Windows forbids the byte, bit 1: POSIX does
+constexpr uint8_t kForbiddenWindows = 1;
+constexpr uint8_t kForbiddenPosix = 2;
+
+struct ByteTable {
+    uint8_t flags[256] = {};
+};
+
+constexpr ByteTable BuildByteTable() {
+    ByteTable table;
+    for (size_t c = 0; c < 0x20; ++c) table.flags[c] |= kForbiddenWindows;
+    for (const char forbidden : kWindowsForbidden) table.flags[static_cast<uint8_t>(forbidden)] |= kForbiddenWindows;
+    table.flags[0] |= kForbiddenPosix;
+    table.flags[static_cast<uint8_t>('/')] |= kForbiddenPosix;
+    return table;
+}
+
+constexpr ByteTable kByteTable = BuildByteTable();
+
+#ifdef NAME_RULES_SSE2
+// Lanes of v that hold a forbidden byte
+__m128i ForbiddenLanes(__m128i v, bool windows) {
+    if (!windows) {
+        return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()), _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    }
+    // max(c, 0x1F) == 0x1F exactly for the control characters
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i hits = _mm_cmpeq_epi8(_mm_max_epu8(v, control), control);
+    for (const char forbidden : kWindowsForbidden) {
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8(forbidden)));
+    }
+    return hits;
+}
+#endif
+
+// Whether name holds a byte the rules forbid: 16 bytes at a time, then the tail through kByteTable
+bool HasForbiddenByte(std::string_view name, bool windows) {
+    size_t i = 0;
+#ifdef NAME_RULES_SSE2
+    __m128i hits = _mm_setzero_si128();
+    for (; i + 16 <= name.size(); i += 16) {
+        hits = _mm_or_si128(hits, ForbiddenLanes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(name.data() + i)),
+                                                 windows));
+    }
+    if (_mm_movemask_epi8(hits) != 0) {
+        return true;
+    }
+#endif
+    const uint8_t mask = windows ? kForbiddenWindows : kForbiddenPosix;
+    uint8_t found = 0;
+    for (; i < name.size(); ++i) {
+        found |= kByteTable.flags[static_cast<uint8_t>(name[i])];
+    }
+    return (found & mask) != 0;
+}
+
+// UTF-16 units of a UTF-8 name: one per byte that is no continuation byte, plus one per 4-byte lead
+size_t Utf16Units(std::string_view name) {
+    size_t units = 0;
+    size_t i = 0;
+#ifdef NAME_RULES_SSE2
+    // As signed bytes the continuation bytes 0x80-0xBF are exactly those below 0xC0
+    const __m128i continuationEnd = _mm_set1_epi8(static_cast<char>(0xC0));
+    const __m128i fourByteLead = _mm_set1_epi8(static_cast<char>(0xF0));
+    for (; i + 16 <= name.size(); i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(name.data() + i));
+        const auto continuation = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmplt_epi8(v, continuationEnd)));
+        const auto leads = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, fourByteLead), v)));
+        units += 16 - std::popcount(continuation) + std::popcount(leads);
+    }
+#endif
+    for (; i < name.size(); ++i) {
+        const auto c = static_cast<uint8_t>(name[i]);
+        units += ((c & 0xC0) != 0x80 ? 1 : 0) + (c >= 0xF0 ? 1 : 0);
+    }
+    return units;
+}
+
+// Last component of a path, ignoring trailing separators and a drive prefix
+std::string_view LeafOf(std::string_view path) {
+    const auto separator = [](char c) { return c == '\\' || c == '/'; };
+    while (!path.empty() && separator(path.back())) path.remove_suffix(1);
+    // A plain loop: find_last_of looks every byte up in its set of two
+    for (size_t i = path.size(); i > 0; --i) {
+        if (separator(path[i - 1])) return path.substr(i);
+    }
+    if (path.size() >= 2 && path[1] == ':') {
+        path.remove_prefix(2);  // "C:name" is relative to the current folder of C:
+    }
+    return path;
+}
+
+// Where the extension starts, as std::filesystem::path splits names: a leading dot starts none
+size_t ExtensionStart(std::string_view name) {
+    const size_t dot = name.rfind('.');
+    return dot == std::string_view::npos || dot == 0 || name == ".." ? name.size() : dot;
+}
+}  // namespace
+
+bool ParseNameRules(const std::wstring& text, NameRules& rules) {
+    if (text == L"windows") {
+        rules = NameRules::Windows;
+    } else if (text == L"posix") {
+        rules = NameRules::Posix;
+    } else if (text == L"smb") {
+        rules = NameRules::SmbShare;
+    } else if (text == L"none") {
+        rules = NameRules::None;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool IsValidName(std::string_view name, NameRules rules) {
+    if (name.empty() || name == "." || name == "..") {
+        return false;
+    }
+    if (rules == NameRules::None) {
+        return true;
+    }
+    const bool windows = rules != NameRules::Posix;
+    if (HasForbiddenByte(name, windows) || (rules != NameRules::Windows && name.size() > kMaxNameSize)) {
+        return false;
+    }
+    if (!windows) {
+        return true;
+    }
+    // No name of up to 255 bytes can have more UTF-16 units than that
+    if (name.size() > kMaxNameSize && Utf16Units(name) > kMaxNameSize) {
+        return false;
+    }
+    return name.back() != '.' && name.back() != ' ' && !IsDeviceName(name);
+}
+
+int CheckSwappedNames(std::string_view path1, std::string_view path2, bool preserveExt, NameRules rules) {
+    if (rules == NameRules::None) {
+        return kResultSuccess;
+    }
+    const std::string_view leaf1 = LeafOf(path1);
+    const std::string_view leaf2 = LeafOf(path2);
+    const auto unusable = [](std::string_view leaf) { return leaf.empty() || leaf == "." || leaf == ".."; };
+    if (unusable(leaf1) || unusable(leaf2)) {
+        return kResultSuccess;
+    }
+
+    // Full names change places, as they also do for folders with preserveExt
+    if (!IsValidName(leaf1, rules) || !IsValidName(leaf2, rules)) {
+        return kResultInvalidPath;
+    }
+    const size_t ext1 = ExtensionStart(leaf1);
+    const size_t ext2 = ExtensionStart(leaf2);
+    if (!preserveExt || leaf1.substr(ext1) == leaf2.substr(ext2)) {
+        return kResultSuccess;
+    }
+
+    // Files keep their extensions and trade stems. Both leaves are valid, so both new names fit.
+    char buffer[2 * kMaxNameBytes];
+    const auto joined = [&buffer](std::string_view stem, std::string_view ext) {
+        std::memcpy(buffer, stem.data(), stem.size());
+        std::memcpy(buffer + stem.size(), ext.data(), ext.size());
+        return std::string_view(buffer, stem.size() + ext.size());
+    };
+    if (!IsValidName(joined(leaf2.substr(0, ext2), leaf1.substr(ext1)), rules) ||
+        !IsValidName(joined(leaf1.substr(0, ext1), leaf2.substr(ext2)), rules)) {
+        return kResultInvalidPath;
+    }
+    return kResultSuccess;
+}
+
+std::vector<int> FindInvalidNames(const PathStore& paths, const std::vector<SwapEntry>& batch, NameRules rules) {
+    std::vector<int> codes(batch.size(), kResultSuccess);
+    if (rules == NameRules::None) {
+        return codes;
+    }
+    const size_t chunks = (batch.size() + kCheckChunk - 1) / kCheckChunk;
+    ParallelFor(chunks, [&](size_t chunk) {
+        const size_t end = (std::min)(batch.size(), (chunk + 1) * kCheckChunk);
+        PathReader reader1(paths);
+        PathReader reader2(paths);
+        for (size_t i = chunk * kCheckChunk; i < end; ++i) {
+            const SwapEntry& entry = batch[i];
+            // Only the names matter, and the store keeps them apart from their folders; a path
+            // that ends in a separator has none of its own and is read in full
+            std::string_view path1 = paths.Leaf(entry.path1);
+            std::string_view path2 = paths.Leaf(entry.path2);
+            if (path1.empty()) path1 = reader1.Read(entry.path1);
+            if (path2.empty()) path2 = reader2.Read(entry.path2);
+            codes[i] = CheckSwappedNames(path1, path2, entry.preserveExt, rules);
+        }
+    });
+    return codes;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class PathStore;
+struct SwapEntry;
+
+// Names a volume accepts, checked before a batch runs so that a pair is reported up front instead of
+// failing with kResultInvalidPath between the renames of a swap.
+//   Windows   no control characters or <>:"/\|?*, no trailing dot or space, no device name (CON,
+//             PRN, AUX, NUL, COM0-9, LPT0-9 and COM¹²³/LPT¹²³, with any extension), at most
+//             255 UTF-16 units
+//   Posix     no NUL or '/', at most 255 bytes
+//   SmbShare  both: clients hold a Samba share to the Windows rules, and it stores the names as
+//             UTF-8 on a POSIX file system
+//   None      anything goes
+enum class NameRules : uint8_t { None, Windows, Posix, SmbShare };
+
+// "windows", "posix", "smb" or "none"; false for anything else
+bool ParseNameRules(const std::wstring& text, NameRules& rules);
+
+// Whether one UTF-8 path component may be used as a name under rules; "", "." and ".." never may.
+// Forbidden bytes and the UTF-16 length are found 16 bytes at a time with SSE2, and device names
+// with a perfect hash built at compile time.
+bool IsValidName(std::string_view name, NameRules rules);
+
+// Check the names the two items of a pair get by the swap (see TargetName in collision_index.cpp)
+// without touching the disk. With preserveExt, an item that turns out to be a folder keeps no
+// extension, so both names it may get are checked. Pairs whose paths end in no usable name are left
+// to exchange(). Returns kResultSuccess or kResultInvalidPath.
+int CheckSwappedNames(std::string_view path1, std::string_view path2, bool preserveExt, NameRules rules);
+
+// CheckSwappedNames for every entry of a batch, on all cores; the paths of batch are read from paths
+std::vector<int> FindInvalidNames(const PathStore& paths, const std::vector<SwapEntry>& batch, NameRules rules);
@@ -0,0 +1,316 @@
+#include "pair_rule.h"
+
+#include "name_fold.h"
+#include "utils.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+// Entries per GetFileInformationByHandleEx call come out of one buffer this size (~500 typical names)
+constexpr DWORD kEnumBufferSize = 64 * 1024;
+
+bool EqualsIgnoreCase(std::wstring_view a, std::wstring_view b) {
+    return a.size() == b.size() && CompareStringOrdinal(a.data(), static_cast<int>(a.size()), b.data(),
+                                                        static_cast<int>(b.size()), TRUE) == CSTR_EQUAL;
+}
+
+std::wstring JoinPath(const std::wstring& dir, const std::wstring& name) {
+    return dir.back() == L'\\' ? dir + name : dir + L'\\' + name;
+}
+
+// Open with the \\?\ prefix so that deep trees are not cut off at MAX_PATH
+HANDLE OpenFolder(const std::wstring& dir) {
+    const std::wstring path = dir.rfind(L"\\\\", 0) == 0 ? dir : L"\\\\?\\" + dir;
+    return CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+}
+
+// Folders still to be listed, shared by the scan threads; the scan ends when it is empty and idle
+class FolderQueue {
+public:
+    explicit FolderQueue(std::wstring root) { folders_.push_back(std::move(root)); }
+
+    bool Next(std::wstring& folder) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !folders_.empty() || busy_ == 0; });
+        if (folders_.empty()) {
+            return false;
+        }
+        folder = std::move(folders_.back());
+        folders_.pop_back();
+        ++busy_;
+        return true;
+    }
+
+    void Done(std::vector<std::wstring>& found) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::wstring& folder : found) folders_.push_back(std::move(folder));
+            --busy_;
+        }
+        found.clear();
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::wstring> folders_;
+    size_t busy_ = 0;
+};
+
+// List one folder in bulk: names of its items into names, its real subfolders (no junctions or
+// symlinks, which could loop) into subfolders. Unreadable folders are skipped.
+void ListFolder(const std::wstring& dir, std::vector<std::wstring>& names, std::vector<std::wstring>& subfolders,
+                std::vector<unsigned char>& buffer) {
+    HANDLE handle = OpenFolder(dir);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    FILE_INFO_BY_HANDLE_CLASS infoClass = FileFullDirectoryRestartInfo;
+    while (GetFileInformationByHandleEx(handle, infoClass, buffer.data(), static_cast<DWORD>(buffer.size()))) {
+        infoClass = FileFullDirectoryInfo;
+        const unsigned char* cursor = buffer.data();
+        for (;;) {
+            const auto* info = reinterpret_cast<const FILE_FULL_DIR_INFO*>(cursor);
+            const std::wstring_view name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+            if (name != L"." && name != L"..") {
+                names.emplace_back(name);
+                if ((info->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+                    !(info->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+                    subfolders.push_back(JoinPath(dir, names.back()));
+                }
+            }
+            if (info->NextEntryOffset == 0) break;
+            cursor += info->NextEntryOffset;
+        }
+    }
+    CloseHandle(handle);
+}
+
+// Pair the matching names of one folder with their partners, looked up case-insensitively
+void PairFolder(const PairRule& rule, const std::wstring& dir, const std::vector<std::wstring>& names, SwapBatch& out) {
+    struct Match {
+        size_t name = 0;
+        std::wstring partnerKey;
+    };
+    std::vector<Match> matches;
+    std::unordered_map<std::wstring, size_t> wanted;  // Folded partner name -> match
+    std::wstring partner;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (rule.Apply(names[i], partner)) {
+            matches.push_back({i, FoldName(partner)});
+            wanted.emplace(matches.back().partnerKey, matches.size() - 1);
+        }
+    }
+    if (matches.empty()) {
+        return;
+    }
+
+    // One pass over the folder resolves every partner to its name as stored
+    std::vector<size_t> found(matches.size(), SIZE_MAX);
+    std::vector<std::wstring> keys(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        keys[i] = FoldName(names[i]);
+        auto it = wanted.find(keys[i]);
+        if (it != wanted.end()) found[it->second] = i;
+    }
+
+    for (size_t m = 0; m < matches.size(); ++m) {
+        const size_t self = matches[m].name;
+        const size_t other = found[m];
+        if (other == SIZE_MAX || other == self) continue;
+        // A rule like "*.a" <-> "*.b" matches from both sides; keep the pair once
+        auto back = wanted.find(keys[self]);
+        if (back != wanted.end() && matches[back->second].name == other && keys[other] < keys[self]) continue;
+
+        out.Add(Utf16ToUtf8(JoinPath(dir, names[self])), Utf16ToUtf8(JoinPath(dir, names[other])), false);
+    }
+}
+}  // namespace
+
+bool PairRule::Compile(const std::wstring& root, const std::wstring& pattern, const std::wstring& replacement,
+                       PairRule& rule) {
+    PairRule parsed;
+    if (root.empty() || pattern.empty() || replacement.empty()) {
+        return false;
+    }
+    std::wstring full(MAX_PATH, L'\0');
+    DWORD len = GetFullPathNameW(root.c_str(), static_cast<DWORD>(full.size()), full.data(), nullptr);
+    if (len >= full.size()) {
+        full.resize(len);
+        len = GetFullPathNameW(root.c_str(), static_cast<DWORD>(full.size()), full.data(), nullptr);
+    }
+    if (len == 0) {
+        return false;
+    }
+    full.resize(len);
+    while (full.size() > 3 && full.back() == L'\\') full.pop_back();  // "C:\" stays: "C:" is the volume
+    parsed.root_ = std::move(full);
+
+    size_t groups = 0;
+    if (pattern.rfind(L"re:", 0) == 0) {
+        try {
+            parsed.regex_ = std::make_shared<const std::wregex>(
+                pattern.substr(3), std::regex_constants::ECMAScript | std::regex_constants::icase |
+                                       std::regex_constants::optimize);
+        } catch (const std::regex_error&) {
+            return false;
+        }
+        groups = parsed.regex_->mark_count();
+    } else {
+        for (wchar_t ch : pattern) {
+            if (ch == L'*' || ch == L'?') {
+                Token token;
+                token.kind = ch == L'*' ? Token::Star : Token::Question;
+                parsed.pattern_.push_back(token);
+                parsed.minLength_ += ch == L'?';
+                ++groups;
+            } else {
+                if (parsed.pattern_.empty() || parsed.pattern_.back().kind != Token::Literal) {
+                    parsed.pattern_.emplace_back();
+                }
+                parsed.pattern_.back().text += ch;
+                ++parsed.minLength_;
+            }
+        }
+        if (parsed.pattern_.front().kind == Token::Literal) parsed.prefix_ = parsed.pattern_.front().text;
+        if (parsed.pattern_.back().kind == Token::Literal) parsed.suffix_ = parsed.pattern_.back().text;
+    }
+
+    // Replacement: $1..$9 name a capture, '*'/'?' take the next one, "$$" is a literal '$'
+    size_t nextGroup = 1;
+    for (size_t i = 0; i < replacement.size(); ++i) {
+        const wchar_t ch = replacement[i];
+        Token token;
+        if (ch == L'$' && i + 1 < replacement.size() && replacement[i + 1] >= L'1' && replacement[i + 1] <= L'9') {
+            token.kind = Token::Group;
+            token.group = replacement[++i] - L'0';
+        } else if (!parsed.regex_ && (ch == L'*' || ch == L'?')) {
+            token.kind = Token::Group;
+            token.group = static_cast<int>(nextGroup++);
+        } else {
+            if (ch == L'$' && i + 1 < replacement.size() && replacement[i + 1] == L'$') ++i;
+            if (parsed.replacement_.empty() || parsed.replacement_.back().kind != Token::Literal) {
+                parsed.replacement_.emplace_back();
+            }
+            parsed.replacement_.back().text += ch;
+            continue;
+        }
+        if (static_cast<size_t>(token.group) > groups) {
+            return false;
+        }
+        parsed.replacement_.push_back(token);
+    }
+
+    rule = std::move(parsed);
+    return true;
+}
+
+bool PairRule::MatchGlob(std::wstring_view name, size_t token, size_t pos,
+                         std::vector<std::wstring_view>& captures) const {
+    if (token == pattern_.size()) {
+        return pos == name.size();
+    }
+    const Token& t = pattern_[token];
+    switch (t.kind) {
+        case Token::Literal:
+            return name.size() - pos >= t.text.size() && EqualsIgnoreCase(name.substr(pos, t.text.size()), t.text) &&
+                   MatchGlob(name, token + 1, pos + t.text.size(), captures);
+        case Token::Question:
+            if (pos >= name.size()) return false;
+            captures.push_back(name.substr(pos, 1));
+            if (MatchGlob(name, token + 1, pos + 1, captures)) return true;
+            captures.pop_back();
+            return false;
+        default:
+            // Greedy, like (.*) in a regex
+            for (size_t len = name.size() - pos;; --len) {
+                captures.push_back(name.substr(pos, len));
+                if (MatchGlob(name, token + 1, pos + len, captures)) return true;
+                captures.pop_back();
+                if (len == 0) return false;
+            }
+    }
+}
+
+bool PairRule::Apply(std::wstring_view name, std::wstring& partner) const {
+    thread_local std::vector<std::wstring_view> captures;
+    captures.clear();
+    if (regex_) {
+        std::match_results<const wchar_t*> match;
+        if (!std::regex_match(name.data(), name.data() + name.size(), match, *regex_)) {
+            return false;
+        }
+        for (size_t i = 1; i < match.size(); ++i) {
+            captures.emplace_back(match[i].first, static_cast<size_t>(match[i].length()));
+        }
+    } else {
+        // Most names of a big folder fail on length or the literal ends, before any backtracking
+        if (name.size() < minLength_ ||
+            (!prefix_.empty() && !EqualsIgnoreCase(name.substr(0, (std::min)(name.size(), prefix_.size())), prefix_)) ||
+            (!suffix_.empty() &&
+             !EqualsIgnoreCase(name.substr(name.size() - (std::min)(name.size(), suffix_.size())), suffix_)) ||
+            !MatchGlob(name, 0, 0, captures)) {
+            return false;
+        }
+    }
+
+    partner.clear();
+    for (const Token& t : replacement_) {
+        if (t.kind == Token::Literal) {
+            partner += t.text;
+        } else {
+            partner += captures[static_cast<size_t>(t.group - 1)];
+        }
+    }
+    return !partner.empty();
+}
+
+bool ScanPairRule(const PairRule& rule, SwapBatch& pairs) {
+    HANDLE root = OpenFolder(rule.Root());
+    if (root == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    CloseHandle(root);
+
+    FolderQueue queue(rule.Root());
+    const size_t threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    std::vector<SwapBatch> found(threadCount);
+    auto worker = [&](size_t t) {
+        std::vector<unsigned char> buffer(kEnumBufferSize);
+        std::vector<std::wstring> names;
+        std::vector<std::wstring> subfolders;
+        std::wstring folder;
+        while (queue.Next(folder)) {
+            names.clear();
+            ListFolder(folder, names, subfolders, buffer);
+            PairFolder(rule, folder, names, found[t]);
+            queue.Done(subfolders);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threadCount - 1);
+    for (size_t t = 1; t < threadCount; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    const size_t first = pairs.entries.size();
+    for (const SwapBatch& part : found) {
+        pairs.Append(part);
+    }
+    const PathStore& paths = pairs.paths;
+    std::sort(pairs.entries.begin() + static_cast<std::ptrdiff_t>(first), pairs.entries.end(),
+              [&paths](const SwapEntry& a, const SwapEntry& b) { return paths.Compare(a.path1, b.path1) < 0; });
+    return true;
+}
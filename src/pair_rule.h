@@ -0,0 +1,51 @@
+#pragma once
+
+#include "swap_queue.h"
+
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// "--pair-rule <root> <pattern> <replacement>": every item under root whose name matches pattern is
+// paired with the item named by the replacement in the same folder, e.g. "*.prod.json" with
+// "*.staging.json", or "re:(.*)\.prod\.json" with "$1.staging.json".
+//
+// Glob patterns understand '*' and '?', each captured in order; the replacement refers to them as
+// $1..$9, or consumes them in order with its own '*'/'?'. A "re:" prefix selects an ECMAScript
+// regex over the whole name instead. Names compare case-insensitively either way.
+class PairRule {
+public:
+    // Compile a rule once; false if the pattern is malformed or the replacement uses a missing group
+    static bool Compile(const std::wstring& root, const std::wstring& pattern, const std::wstring& replacement,
+                        PairRule& rule);
+
+    const std::wstring& Root() const { return root_; }
+
+    // If name matches, store the partner's name in partner and return true
+    bool Apply(std::wstring_view name, std::wstring& partner) const;
+
+private:
+    struct Token {
+        enum Kind : uint8_t { Literal, Star, Question, Group } kind = Literal;
+        std::wstring text;  // Literal text
+        int group = 0;      // Capture referenced by a replacement token
+    };
+
+    bool MatchGlob(std::wstring_view name, size_t token, size_t pos, std::vector<std::wstring_view>& captures) const;
+
+    std::wstring root_;
+    std::vector<Token> pattern_;      // Glob pattern
+    std::wstring prefix_;             // Literal text before the first wildcard, for a quick reject
+    std::wstring suffix_;             // Literal text after the last wildcard
+    size_t minLength_ = 0;            // Shortest name the glob can match
+    std::shared_ptr<const std::wregex> regex_;  // Set for "re:" patterns; shared so rules stay copyable
+    std::vector<Token> replacement_;
+};
+
+// Enumerate rule.Root() recursively on all cores, reading each folder's entries in bulk, and append
+// one full-name swap per matching item whose partner exists. A pair whose partner maps back to the
+// item is listed once. Pairs come out sorted by first path. False if the root cannot be opened.
+bool ScanPairRule(const PairRule& rule, SwapBatch& pairs);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run fn(i) for every i in [0, count) on up to hardware_concurrency threads.
+// Work items are handed out dynamically, so uneven items balance themselves.
+template <typename Fn>
+void ParallelFor(size_t count, Fn&& fn, size_t maxThreads = 0) {
+    if (count == 0) {
+        return;
+    }
+    size_t threads = maxThreads ? maxThreads : (std::max)(1u, std::thread::hardware_concurrency());
+    threads = (std::min)(threads, count);
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+}
@@ -0,0 +1,177 @@
+#include "path_completion.h"
+
+#include "name_fold.h"
+#include "utils.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+namespace {
+// Entries per GetFileInformationByHandleEx call come out of one buffer this size (~500 typical names)
+constexpr DWORD kEnumBufferSize = 64 * 1024;
+// A folder is listed at most this long after the first keystroke that asked for it
+constexpr auto kMaxDebounce = std::chrono::milliseconds(500);
+
+bool IsSeparator(char ch) { return ch == '\\' || ch == '/'; }
+
+// "C:\..." or "\\server\share\...": relative paths depend on a working directory the user cannot see
+bool IsAbsolute(const std::string& dir) {
+    if (dir.size() >= 3 && std::isalpha(static_cast<unsigned char>(dir[0])) && dir[1] == ':' && IsSeparator(dir[2])) {
+        return true;
+    }
+    return dir.size() >= 3 && IsSeparator(dir[0]) && IsSeparator(dir[1]);
+}
+
+// All entries of one folder in bulk; an unreadable folder lists as empty
+std::shared_ptr<const DirListing> ListFolder(const std::wstring& dir) {
+    std::vector<std::wstring> names;
+    std::vector<bool> directories;
+    // The \\?\ prefix lifts MAX_PATH; UNC paths are used as they are
+    const std::wstring path = dir.rfind(L"\\\\", 0) == 0 ? dir : L"\\\\?\\" + dir;
+    HANDLE handle =
+        CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle != INVALID_HANDLE_VALUE) {
+        std::vector<unsigned char> buffer(kEnumBufferSize);
+        FILE_INFO_BY_HANDLE_CLASS infoClass = FileFullDirectoryRestartInfo;
+        while (GetFileInformationByHandleEx(handle, infoClass, buffer.data(), static_cast<DWORD>(buffer.size()))) {
+            infoClass = FileFullDirectoryInfo;
+            const unsigned char* cursor = buffer.data();
+            for (;;) {
+                const auto* info = reinterpret_cast<const FILE_FULL_DIR_INFO*>(cursor);
+                const std::wstring_view name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+                if (name != L"." && name != L"..") {
+                    names.emplace_back(name);
+                    directories.push_back((info->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+                }
+                if (info->NextEntryOffset == 0) break;
+                cursor += info->NextEntryOffset;
+            }
+        }
+        CloseHandle(handle);
+    }
+    return std::make_shared<const DirListing>(std::move(names), std::move(directories));
+}
+}  // namespace
+
+DirListing::DirListing(std::vector<std::wstring> names, std::vector<bool> directories) {
+    std::vector<std::wstring> keys(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        keys[i] = FoldName(names[i]);
+    }
+    std::vector<size_t> order(names.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    keys_.reserve(order.size());
+    names_.reserve(order.size());
+    directories_.reserve(order.size());
+    for (size_t i : order) {
+        keys_.push_back(std::move(keys[i]));
+        names_.push_back(Utf16ToUtf8(names[i]));
+        directories_.push_back(directories[i]);
+    }
+}
+
+void DirListing::Find(std::wstring_view foldedPrefix, const std::string& dir, size_t max,
+                      std::vector<PathSuggestion>& out) const {
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), foldedPrefix,
+                               [](const std::wstring& key, std::wstring_view prefix) { return key < prefix; });
+    for (size_t found = 0; found < max && it != keys_.end() && it->starts_with(foldedPrefix); ++found, ++it) {
+        const size_t i = static_cast<size_t>(it - keys_.begin());
+        PathSuggestion& suggestion = out.emplace_back();
+        suggestion.name = names_[i];
+        suggestion.directory = directories_[i];
+        suggestion.path = dir + names_[i];
+        if (suggestion.directory) suggestion.path += '\\';
+    }
+}
+
+PathCompleter::PathCompleter(size_t capacity, std::chrono::milliseconds debounce, std::chrono::seconds ttl)
+    : capacity_((std::max)(capacity, size_t{1})), ttl_(ttl), debounce_(debounce, kMaxDebounce) {
+    worker_ = std::thread(&PathCompleter::WorkerLoop, this);
+}
+
+void PathCompleter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+bool PathCompleter::Complete(const std::string& text, size_t max, std::vector<PathSuggestion>& out) {
+    out.clear();
+    const size_t slash = text.find_last_of("\\/");
+    if (slash == std::string::npos || !IsAbsolute(text.substr(0, slash + 1))) {
+        return true;  // Nothing to complete
+    }
+    const std::string dir = text.substr(0, slash + 1);
+    std::wstring wdir = Utf8ToUtf16(dir);
+    std::replace(wdir.begin(), wdir.end(), L'/', L'\\');
+    const std::wstring key = FoldName(wdir);
+
+    std::shared_ptr<const DirListing> listing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(key);
+        if (it == cache_.end()) {
+            Request(key, wdir);
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        listing = it->second.listing;
+        if (std::chrono::steady_clock::now() - it->second.loaded > ttl_) {
+            Request(key, wdir);  // The old listing keeps serving until the new one is in
+        }
+    }
+    listing->Find(FoldName(Utf8ToUtf16(text.substr(slash + 1))), dir, max, out);
+    return true;
+}
+
+void PathCompleter::Request(const std::wstring& key, const std::wstring& dir) {
+    if (key == pendingKey_ || key == listingKey_) {
+        return;
+    }
+    pendingKey_ = key;
+    pendingDir_ = dir;
+    debounce_.Notify(std::chrono::steady_clock::now());
+    cv_.notify_one();
+}
+
+void PathCompleter::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (!debounce_.Pending()) {
+            cv_.wait(lock);
+            continue;
+        }
+        if (!debounce_.Poll(std::chrono::steady_clock::now())) {
+            cv_.wait_until(lock, debounce_.Deadline());
+            continue;
+        }
+        listingKey_ = std::move(pendingKey_);
+        pendingKey_.clear();
+        const std::wstring dir = std::move(pendingDir_);
+
+        lock.unlock();
+        std::shared_ptr<const DirListing> listing = ListFolder(dir);
+        lock.lock();
+
+        auto it = cache_.find(listingKey_);
+        if (it == cache_.end()) {
+            lru_.push_front(listingKey_);
+            it = cache_.emplace(listingKey_, Entry{nullptr, {}, lru_.begin()}).first;
+        }
+        it->second.listing = std::move(listing);
+        it->second.loaded = std::chrono::steady_clock::now();
+        while (cache_.size() > capacity_) {
+            cache_.erase(lru_.back());
+            lru_.pop_back();
+        }
+        listingKey_.clear();
+    }
+}
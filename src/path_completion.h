@@ -0,0 +1,83 @@
+#pragma once
+
+#include "change_coalescer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct PathSuggestion {
+    std::string path;  // Full text for the input field; folders end in a backslash
+    std::string name;  // The entry name alone, for display
+    bool directory = false;
+};
+
+// The entries of one folder sorted by their folded name (see FoldName), so that all names starting
+// with a prefix form one range found by binary search: a lookup costs O(log n + results).
+class DirListing {
+public:
+    DirListing(std::vector<std::wstring> names, std::vector<bool> directories);
+
+    size_t Size() const { return names_.size(); }
+
+    // Append up to max entries whose names start with foldedPrefix, in name order
+    void Find(std::wstring_view foldedPrefix, const std::string& dir, size_t max,
+              std::vector<PathSuggestion>& out) const;
+
+private:
+    std::vector<std::wstring> keys_;  // Folded, sorted
+    std::vector<std::string> names_;  // UTF-8, as stored on disk, in key order
+    std::vector<bool> directories_;
+};
+
+// Path completion for the input fields, served from an in-memory cache of folder listings that a
+// background thread fills. A folder is listed once typing has paused on it (debounced), and again
+// in the background once its listing is older than the TTL; the least recently used listings are
+// dropped beyond the capacity. A lookup holds the cache lock only to pick up the listing, so it
+// never waits for the disk.
+class PathCompleter {
+public:
+    explicit PathCompleter(size_t capacity = 16, std::chrono::milliseconds debounce = std::chrono::milliseconds(120),
+                           std::chrono::seconds ttl = std::chrono::seconds(5));
+    PathCompleter(const PathCompleter&) = delete;
+    PathCompleter& operator=(const PathCompleter&) = delete;
+    ~PathCompleter() { Stop(); }
+
+    // Fill out with up to max completions of an absolute path being typed. Returns false while
+    // the listing of its folder is not cached yet (it has been asked for; try again later).
+    bool Complete(const std::string& text, size_t max, std::vector<PathSuggestion>& out);
+
+    // Stop the listing thread; called by the destructor
+    void Stop();
+
+private:
+    struct Entry {
+        std::shared_ptr<const DirListing> listing;
+        std::chrono::steady_clock::time_point loaded;
+        std::list<std::wstring>::iterator lru;
+    };
+
+    void Request(const std::wstring& key, const std::wstring& dir);
+    void WorkerLoop();
+
+    size_t capacity_;
+    std::chrono::seconds ttl_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::wstring, Entry> cache_;  // Keyed by folded folder path
+    std::list<std::wstring> lru_;                    // Most recently used first
+    ChangeCoalescer debounce_;
+    std::wstring pendingKey_;  // Folder to list once the debounce is due
+    std::wstring pendingDir_;
+    std::wstring listingKey_;  // Folder being listed right now
+    bool stop_ = false;
+    std::thread worker_;
+};
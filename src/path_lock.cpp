@@ -0,0 +1,173 @@
+#include "path_lock.h"
+
+#include <atomic>
+#include <cwchar>
+#include <utility>
+#include <windows.h>
+
+namespace {
+constexpr uint32_t kStripeBits = 12;
+constexpr uint32_t kStripeCount = 1u << kStripeBits;
+
+// 0 = free, 1 = held, 2 = held and another thread may be parked on it
+std::atomic<uint32_t> g_stripes[kStripeCount];
+// Per-stripe lock files, opened on first use and kept for the life of the process
+std::atomic<HANDLE> g_lockFiles[kStripeCount];
+std::atomic<uint64_t> g_tempSequence{0};
+
+uint32_t StripeOf(const std::wstring& path) {
+    std::wstring full(MAX_PATH, L'\0');
+    DWORD len = GetFullPathNameW(path.c_str(), static_cast<DWORD>(full.size()), full.data(), nullptr);
+    if (len >= full.size()) {
+        full.resize(len);
+        len = GetFullPathNameW(path.c_str(), static_cast<DWORD>(full.size()), full.data(), nullptr);
+    }
+    full.resize(len);
+    if (full.empty()) full = path;
+    // "\\?\C:\x" and "C:\x" name the same item and must share a stripe
+    if (full.rfind(L"\\\\?\\UNC\\", 0) == 0) {
+        full.replace(0, 8, L"\\\\");
+    } else if (full.rfind(L"\\\\?\\", 0) == 0) {
+        full.erase(0, 4);
+    }
+    CharLowerBuffW(full.data(), static_cast<DWORD>(full.size()));
+
+    // FNV-1a over the UTF-16 code units; the top bits are the best mixed
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (wchar_t ch : full) {
+        hash ^= static_cast<uint16_t>(ch);
+        hash *= 0x100000001b3ull;
+    }
+    return static_cast<uint32_t>(hash >> (64 - kStripeBits));
+}
+
+void LockInProcess(uint32_t stripe) {
+    std::atomic<uint32_t>& word = g_stripes[stripe];
+    uint32_t expected = 0;
+    if (word.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+        return;
+    }
+    // Contended: advertise a waiter so the unlocker knows to wake someone
+    while (word.exchange(2, std::memory_order_acquire) != 0) {
+        word.wait(2, std::memory_order_relaxed);
+    }
+}
+
+bool TryLockInProcess(uint32_t stripe) {
+    uint32_t expected = 0;
+    return g_stripes[stripe].compare_exchange_strong(expected, 1, std::memory_order_acquire);
+}
+
+void UnlockInProcess(uint32_t stripe) {
+    std::atomic<uint32_t>& word = g_stripes[stripe];
+    if (word.exchange(0, std::memory_order_release) == 2) {
+        word.notify_one();
+    }
+}
+
+HANDLE LockFileFor(uint32_t stripe) {
+    HANDLE file = g_lockFiles[stripe].load(std::memory_order_acquire);
+    if (file) {
+        return file;
+    }
+
+    wchar_t dir[MAX_PATH + 1];
+    const DWORD len = GetTempPathW(MAX_PATH + 1, dir);
+    if (len == 0 || len > MAX_PATH - 40) {
+        return INVALID_HANDLE_VALUE;
+    }
+    wcscat_s(dir, L"FilenameExchanger.locks\\");
+    CreateDirectoryW(dir, nullptr);
+
+    wchar_t path[MAX_PATH + 1];
+    swprintf_s(path, L"%s%03x.lock", dir, stripe);
+    file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return file;  // Not published, so the next locker of the stripe tries again
+    }
+
+    // Publish; a thread that lost the race uses the winner's handle
+    HANDLE expected = nullptr;
+    if (!g_lockFiles[stripe].compare_exchange_strong(expected, file, std::memory_order_acq_rel)) {
+        CloseHandle(file);
+        file = expected;
+    }
+    return file;
+}
+
+// Takes the stripe for this process and then for other processes. Without wait, gives up at once
+// if either is held. False if the stripe was not taken, in which case nothing is held.
+bool LockStripe(uint32_t stripe, bool wait) {
+    // The in-process word is taken first, so at most one thread per process waits on the file lock
+    if (wait) {
+        LockInProcess(stripe);
+    } else if (!TryLockInProcess(stripe)) {
+        return false;
+    }
+    // Without its lock file another instance would not be kept out, so the swap must not go ahead
+    HANDLE file = LockFileFor(stripe);
+    OVERLAPPED overlapped = {};
+    const DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+    if (file == INVALID_HANDLE_VALUE || !LockFileEx(file, flags, 0, 1, 0, &overlapped)) {
+        const DWORD error = GetLastError();
+        UnlockInProcess(stripe);
+        SetLastError(error);
+        return false;
+    }
+    return true;
+}
+
+void UnlockStripe(uint32_t stripe) {
+    HANDLE file = g_lockFiles[stripe].load(std::memory_order_acquire);
+    if (file) {
+        OVERLAPPED overlapped = {};
+        if (!UnlockFileEx(file, 0, 1, 0, &overlapped)) {
+            // Closing the handle drops its locks; the next locker of this stripe opens a new one.
+            // Nobody else in this process touches the handle while we hold the in-process word.
+            g_lockFiles[stripe].store(nullptr, std::memory_order_release);
+            CloseHandle(file);
+        }
+    }
+    UnlockInProcess(stripe);
+}
+
+// Fills stripes in locking order and returns how many distinct stripes there are
+int SortedStripes(const std::wstring& path1, const std::wstring& path2, uint32_t (&stripes)[2]) {
+    stripes[0] = StripeOf(path1);
+    stripes[1] = StripeOf(path2);
+    if (stripes[0] > stripes[1]) {
+        std::swap(stripes[0], stripes[1]);
+    }
+    return stripes[0] == stripes[1] ? 1 : 2;
+}
+}  // namespace
+
+PathPairLock::PathPairLock(const std::wstring& path1, const std::wstring& path2) : PathPairLock(path1, path2, true) {}
+
+PathPairLock::PathPairLock(const std::wstring& path1, const std::wstring& path2, std::try_to_lock_t)
+    : PathPairLock(path1, path2, false) {}
+
+PathPairLock::PathPairLock(const std::wstring& path1, const std::wstring& path2, bool wait) {
+    const int count = SortedStripes(path1, path2, stripes_);
+    for (int i = 0; i < count; ++i) {
+        if (!LockStripe(stripes_[i], wait)) {
+            while (i-- > 0) UnlockStripe(stripes_[i]);
+            return;
+        }
+    }
+    count_ = count;
+}
+
+PathPairLock::~PathPairLock() {
+    for (int i = count_ - 1; i >= 0; --i) {
+        UnlockStripe(stripes_[i]);
+    }
+}
+
+std::wstring UniqueTempName(const std::wstring& stem) {
+    wchar_t suffix[64];
+    swprintf_s(suffix, L"._exch_%lx_%llx_tmp_", GetCurrentProcessId(),
+               static_cast<unsigned long long>(g_tempSequence.fetch_add(1, std::memory_order_relaxed)));
+    return stem + suffix;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Advisory lock over the two paths of a swap, held for the lifetime of the object. Every swap in
+// this process and in other instances takes one before touching the file system, so overlapping
+// pairs are serialized instead of interleaving their renames.
+//
+// Paths hash (case-insensitively, after full-path resolution) onto a fixed set of stripes. Each
+// stripe is an atomic word for threads of this process plus a byte-range lock on a per-stripe
+// file under %TEMP% for other processes. Stripes are always taken in ascending order, so no two
+// lockers can wait on each other. Unrelated paths sharing a stripe merely serialize.
+//
+// A lock that could not be taken (another locker holds a stripe for the try_to_lock form, or the
+// per-stripe file could not be opened or locked) holds nothing and OwnsLock() is false; the swap
+// must not go ahead then.
+class PathPairLock {
+public:
+    PathPairLock(const std::wstring& path1, const std::wstring& path2);
+    // Takes the lock only if no other locker holds either stripe, without waiting
+    PathPairLock(const std::wstring& path1, const std::wstring& path2, std::try_to_lock_t);
+    ~PathPairLock();
+    PathPairLock(const PathPairLock&) = delete;
+    PathPairLock& operator=(const PathPairLock&) = delete;
+
+    bool OwnsLock() const { return count_ != 0; }
+
+private:
+    PathPairLock(const std::wstring& path1, const std::wstring& path2, bool wait);
+
+    uint32_t stripes_[2] = {};
+    int count_ = 0;
+};
+
+// A name for parking an item during a swap that no other swap, in this or any other process,
+// will pick: stem + "._exch_" + process id + "_" + per-process sequence number + "_tmp_"
+std::wstring UniqueTempName(const std::wstring& stem);
@@ -0,0 +1,214 @@
+#include "path_store.h"
+
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint32_t kNoNode = UINT32_MAX;
+constexpr size_t kMinSlots = 1024;
+constexpr size_t kMaxNameSize = UINT16_MAX;
+// Folder names Path keeps from its first walk up the tree
+constexpr size_t kInlineDepth = 32;
+
+// Compare two diverging components, each followed by a backslash if it is a folder and by the end
+// of the path if it is the last component
+int CompareComponents(std::string_view a, bool aFolder, std::string_view b, bool bFolder) {
+    const size_t common = (std::min)(a.size(), b.size());
+    if (const int c = std::memcmp(a.data(), b.data(), common); c != 0) {
+        return c < 0 ? -1 : 1;
+    }
+    // The shorter one continues with its terminator: a backslash, or nothing at all
+    const auto next = [](std::string_view s, size_t at, bool folder) {
+        return at < s.size() ? static_cast<int>(static_cast<unsigned char>(s[at])) : folder ? '\\' : -1;
+    };
+    const int ca = next(a, common, aFolder);
+    const int cb = next(b, common, bFolder);
+    return ca < cb ? -1 : ca > cb ? 1 : 0;
+}
+}  // namespace
+
+PathStore::PathStore() {
+    // Node 0 is "no folder" and name 0 is ""
+    nodes_.Allocate(1);
+    *nodes_.At(0) = Node{0, 0};
+    names_.Allocate(2);
+    std::memset(names_.At(0), 0, 2);
+}
+
+std::string_view PathStore::Name(uint32_t offset) const {
+    const char* p = names_.At(offset);
+    uint16_t size = 0;
+    std::memcpy(&size, p, sizeof(size));
+    return std::string_view(p + sizeof(size), size);
+}
+
+uint32_t PathStore::AddName(std::string_view name) {
+    if (name.empty()) {
+        return 0;
+    }
+    if (name.size() > kMaxNameSize) {
+        return kNoNode;
+    }
+    const uint64_t offset = names_.Allocate(name.size() + sizeof(uint16_t));
+    if (offset == UINT64_MAX) {
+        return kNoNode;
+    }
+    char* p = names_.At(offset);
+    const auto size = static_cast<uint16_t>(name.size());
+    std::memcpy(p, &size, sizeof(size));
+    std::memcpy(p + sizeof(size), name.data(), name.size());
+    return static_cast<uint32_t>(offset);
+}
+
+std::optional<PathRef> PathStore::Intern(std::string_view path) {
+    PathRef ref;
+    const size_t slash = path.rfind('\\');
+    if (slash != std::string_view::npos) {
+        const std::string_view dir = path.substr(0, slash);
+        if (lastDirNode_ != kNoNode && dir == lastDir_) {
+            ref.dir = lastDirNode_;
+        } else {
+            ref.dir = InternFolder(dir);
+            if (ref.dir == kNoNode) {
+                return std::nullopt;
+            }
+            lastDir_.assign(dir);
+            lastDirNode_ = ref.dir;
+        }
+        path.remove_prefix(slash + 1);
+    }
+    ref.leaf = AddName(path);
+    if (ref.leaf == kNoNode) {
+        return std::nullopt;
+    }
+    return ref;
+}
+
+std::optional<PathRef> PathStore::Import(const PathStore& from, PathRef ref) {
+    return Intern(from.Path(ref, importBuffer_));
+}
+
+uint32_t PathStore::InternFolder(std::string_view dir) {
+    uint32_t node = 0;
+    for (;;) {
+        const size_t slash = dir.find('\\');
+        node = FindOrAddFolder(node, dir.substr(0, slash));
+        if (node == kNoNode || slash == std::string_view::npos) {
+            return node;
+        }
+        dir.remove_prefix(slash + 1);
+    }
+}
+
+uint32_t PathStore::FindOrAddFolder(uint32_t parent, std::string_view name) {
+    if ((nodes_.Size() + 1) * 2 > slots_.size()) {
+        Rehash((std::max)(kMinSlots, slots_.size() * 2));
+    }
+    const size_t mask = slots_.size() - 1;
+    size_t slot = HashBytes(name.data(), name.size(), parent) & mask;
+    for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+        const Node& node = *nodes_.At(slots_[slot]);
+        if (node.parent == parent && Name(node.name) == name) {
+            return slots_[slot];
+        }
+    }
+
+    const uint32_t nameOffset = AddName(name);
+    const uint64_t id = nameOffset == kNoNode ? UINT64_MAX : nodes_.Allocate(1);
+    if (id == UINT64_MAX) {
+        return kNoNode;
+    }
+    *nodes_.At(id) = Node{parent, nameOffset};
+    slots_[slot] = static_cast<uint32_t>(id);
+    return static_cast<uint32_t>(id);
+}
+
+void PathStore::Rehash(size_t slots) {
+    std::vector<uint32_t> rehashed(slots, 0);
+    const size_t mask = slots - 1;
+    for (uint64_t id = 1; id < nodes_.Size(); ++id) {
+        const Node& node = *nodes_.At(id);
+        const std::string_view name = Name(node.name);
+        size_t slot = HashBytes(name.data(), name.size(), node.parent) & mask;
+        while (rehashed[slot] != 0) slot = (slot + 1) & mask;
+        rehashed[slot] = static_cast<uint32_t>(id);
+    }
+    slots_.swap(rehashed);
+}
+
+std::string_view PathStore::Path(PathRef ref, std::string& buffer) const {
+    // One walk up the folders collects the names of all but very deep paths; those take a second
+    std::string_view names[kInlineDepth];
+    size_t depth = 0;
+    const std::string_view leaf = Name(ref.leaf);
+    size_t size = leaf.size();
+    for (uint32_t n = ref.dir; n != 0;) {
+        const Node& node = *nodes_.At(n);
+        const std::string_view name = Name(node.name);
+        if (depth < kInlineDepth) names[depth] = name;
+        ++depth;
+        size += name.size() + 1;
+        n = node.parent;
+    }
+    buffer.resize(size);
+
+    // Filled back to front, leaf first
+    char* end = buffer.data() + size;
+    end -= leaf.size();
+    std::memcpy(end, leaf.data(), leaf.size());
+    uint32_t n = ref.dir;
+    for (size_t i = 0; i < depth; ++i) {
+        const Node& node = *nodes_.At(n);
+        const std::string_view name = i < kInlineDepth ? names[i] : Name(node.name);
+        *--end = '\\';
+        end -= name.size();
+        std::memcpy(end, name.data(), name.size());
+        n = node.parent;
+    }
+    return buffer;
+}
+
+std::string_view PathStore::Leaf(PathRef ref) const { return Name(ref.leaf); }
+
+int PathStore::Compare(PathRef a, PathRef b) const {
+    if (a.dir == b.dir) {
+        return CompareComponents(Name(a.leaf), false, Name(b.leaf), false);
+    }
+    // Folder chains from the root down; equal nodes mean equal prefixes
+    thread_local std::vector<uint32_t> chainA;
+    thread_local std::vector<uint32_t> chainB;
+    const auto chain = [this](uint32_t n, std::vector<uint32_t>& out) {
+        out.clear();
+        for (; n != 0; n = nodes_.At(n)->parent) out.push_back(n);
+        std::reverse(out.begin(), out.end());
+    };
+    chain(a.dir, chainA);
+    chain(b.dir, chainB);
+    size_t i = 0;
+    while (i < chainA.size() && i < chainB.size() && chainA[i] == chainB[i]) ++i;
+
+    const bool aFolder = i < chainA.size();
+    const bool bFolder = i < chainB.size();
+    return CompareComponents(aFolder ? Name(nodes_.At(chainA[i])->name) : Name(a.leaf), aFolder,
+                             bFolder ? Name(nodes_.At(chainB[i])->name) : Name(b.leaf), bFolder);
+}
+
+size_t PathStore::MemoryUsage() const {
+    return names_.AllocatedBytes() + nodes_.AllocatedBytes() + slots_.capacity() * sizeof(uint32_t) +
+           lastDir_.capacity() + importBuffer_.capacity();
+}
+
+std::string_view PathReader::Read(PathRef ref) {
+    if (ref.dir != dir_ || ref.dir == 0) {
+        store_.Path(ref, buffer_);
+        dir_ = ref.dir;
+        dirSize_ = buffer_.size() - store_.Leaf(ref).size();
+        return buffer_;
+    }
+    const std::string_view leaf = store_.Leaf(ref);
+    buffer_.resize(dirSize_);
+    buffer_.append(leaf);
+    return buffer_;
+}
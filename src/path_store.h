@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Append-only array whose elements never move: blocks double from 2^kFirstBits up to 2^kLastBits
+// elements and stay at that size after, so a small array costs little and a huge one wastes at most
+// one block. An element can be read without a lock by any thread that learned its index after it
+// was written; Allocate must be called by one thread at a time.
+template <typename T, int kFirstBits, int kLastBits, uint64_t kCapacity>
+class GrowingArray {
+public:
+    // First of count contiguous new elements; the rest of the current block is skipped if they do
+    // not fit in it. UINT64_MAX once the capacity is reached.
+    uint64_t Allocate(uint64_t count) {
+        uint64_t start = size_;
+        size_t block = 0;
+        uint64_t offset = 0;
+        Locate(start, block, offset);
+        if (offset + count > BlockSize(block)) {
+            do {
+                ++block;
+            } while (block < kBlocks && count > BlockSize(block));
+            start = BlockStart(block);
+        }
+        if (block >= kBlocks || start + count > kCapacity) {
+            return UINT64_MAX;
+        }
+        if (!blocks_[block]) {
+            blocks_[block].reset(new T[BlockSize(block)]);
+            allocatedBytes_ += BlockSize(block) * sizeof(T);
+        }
+        size_ = start + count;
+        return start;
+    }
+
+    T* At(uint64_t index) const {
+        size_t block = 0;
+        uint64_t offset = 0;
+        Locate(index, block, offset);
+        return blocks_[block].get() + offset;
+    }
+
+    uint64_t Size() const { return size_; }
+    size_t AllocatedBytes() const { return allocatedBytes_; }
+
+private:
+    static constexpr int kDoublingBlocks = kLastBits - kFirstBits + 1;
+    static constexpr uint64_t kDoublingEnd = ((uint64_t{1} << kDoublingBlocks) - 1) << kFirstBits;
+    static constexpr size_t kBlocks =
+        kDoublingBlocks + static_cast<size_t>((kCapacity - kDoublingEnd + (uint64_t{1} << kLastBits) - 1) >> kLastBits);
+
+    static void Locate(uint64_t index, size_t& block, uint64_t& offset) {
+        if (index < kDoublingEnd) {
+            block = static_cast<size_t>(std::bit_width((index >> kFirstBits) + 1) - 1);
+        } else {
+            block = kDoublingBlocks + static_cast<size_t>((index - kDoublingEnd) >> kLastBits);
+        }
+        offset = index - BlockStart(block);
+    }
+    static uint64_t BlockStart(size_t block) {
+        if (block < kDoublingBlocks) return ((uint64_t{1} << block) - 1) << kFirstBits;
+        return kDoublingEnd + (static_cast<uint64_t>(block - kDoublingBlocks) << kLastBits);
+    }
+    static uint64_t BlockSize(size_t block) {
+        return uint64_t{1} << (block < kDoublingBlocks ? kFirstBits + static_cast<int>(block) : kLastBits);
+    }
+
+    std::array<std::unique_ptr<T[]>, kBlocks> blocks_;
+    uint64_t size_ = 0;
+    size_t allocatedBytes_ = 0;
+};
+
+// A path held by a PathStore: its folder and its last component
+struct PathRef {
+    uint32_t dir = 0;   // Folder node; 0 for a path without a backslash
+    uint32_t leaf = 0;  // Offset of the last component in the store's names; 0 is ""
+
+    bool operator==(const PathRef& other) const { return dir == other.dir && leaf == other.leaf; }
+};
+
+// The paths of a large batch with their folders shared. A path is split at backslashes and each
+// folder is interned once, as its parent's node plus its own name, so a path costs its 8-byte
+// PathRef and its last component however deep it is and however many siblings it has. Paths are
+// rebuilt on demand into a caller's buffer, byte for byte as they were added.
+//
+// Storage only grows and never moves: a PathRef can be read on any thread that received it after
+// Intern returned (through a lock or a queue) while another thread keeps interning. Intern and
+// Import must be called by one thread at a time.
+class PathStore {
+public:
+    PathStore();
+    PathStore(PathStore&&) noexcept = default;
+    PathStore& operator=(PathStore&&) noexcept = default;
+
+    // Add a path. Nothing when it cannot be held: a component longer than 64 KB, or a store past
+    // 4 GB of names or 2^28 folders.
+    std::optional<PathRef> Intern(std::string_view path);
+    // Add a path held by another store
+    std::optional<PathRef> Import(const PathStore& from, PathRef ref);
+
+    // Rebuild the path into buffer and return it; buffer keeps its capacity between calls
+    std::string_view Path(PathRef ref, std::string& buffer) const;
+
+    // Last component alone
+    std::string_view Leaf(PathRef ref) const;
+
+    // Byte-wise order of two full paths, like std::string::compare, without rebuilding them
+    int Compare(PathRef a, PathRef b) const;
+
+    size_t Folders() const { return static_cast<size_t>(nodes_.Size() - 1); }
+    // Bytes held for names, folder nodes and the folder index
+    size_t MemoryUsage() const;
+
+private:
+    struct Node {
+        uint32_t parent;
+        uint32_t name;  // Offset in names_
+    };
+
+    std::string_view Name(uint32_t offset) const;
+    uint32_t AddName(std::string_view name);
+    uint32_t InternFolder(std::string_view dir);
+    uint32_t FindOrAddFolder(uint32_t parent, std::string_view name);
+    void Rehash(size_t slots);
+
+    // Each name is a 16-bit length followed by its bytes
+    GrowingArray<char, 12, 24, uint64_t{1} << 32> names_;
+    GrowingArray<Node, 8, 20, uint64_t{1} << 28> nodes_;
+    std::vector<uint32_t> slots_;  // Open-addressed folder index: node ids, 0 for a free slot
+    std::string lastDir_;          // Consecutive paths usually share their folder
+    uint32_t lastDirNode_ = UINT32_MAX;
+    std::string importBuffer_;
+};
+
+// Rebuilds paths of one store into its own buffer, keeping the folder part while consecutive paths
+// share it, so a batch read in order mostly costs a copy of each last component
+class PathReader {
+public:
+    explicit PathReader(const PathStore& store) : store_(store) {}
+
+    // Valid until the next Read
+    std::string_view Read(PathRef ref);
+
+private:
+    const PathStore& store_;
+    std::string buffer_;
+    uint32_t dir_ = UINT32_MAX;  // Folder whose path (and a backslash) buffer_ starts with
+    size_t dirSize_ = 0;
+};
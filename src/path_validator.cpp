@@ -0,0 +1,144 @@
+#include "path_validator.h"
+
+#include "name_fold.h"
+#include "utils.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// A field is looked at no later than this after the first keystroke that changed it
+constexpr auto kMaxDebounce = std::chrono::milliseconds(400);
+// Results kept; the oldest goes first
+constexpr size_t kCacheCapacity = 64;
+
+// Errors map like NativeVfs::Probe, except that a refused stat says nothing about the path
+PathProbe ProbePath(const std::wstring& path) {
+    PathProbe probe;
+    const DWORD attributes = GetFileAttributesW(path.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        switch (GetLastError()) {
+            case ERROR_FILE_NOT_FOUND:
+            case ERROR_PATH_NOT_FOUND:
+                probe.state = PathProbe::State::Missing;
+                break;
+            case ERROR_INVALID_NAME:
+            case ERROR_BAD_PATHNAME:
+                probe.state = PathProbe::State::Invalid;
+                break;
+            default:
+                break;
+        }
+        return probe;
+    }
+    probe.state = (attributes & FILE_ATTRIBUTE_DIRECTORY) ? PathProbe::State::Directory : PathProbe::State::File;
+
+    HANDLE h = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h != INVALID_HANDLE_VALUE) {
+        FILE_ID_INFO idInfo = {};
+        if (GetFileInformationByHandleEx(h, FileIdInfo, &idInfo, sizeof(idInfo))) {
+            probe.identified = true;
+            probe.volumeSerial = idInfo.VolumeSerialNumber;
+            std::memcpy(probe.fileId, &idInfo.FileId, sizeof(probe.fileId));
+        }
+        CloseHandle(h);
+    }
+    return probe;
+}
+}  // namespace
+
+bool PathProbe::SameItem(const PathProbe& other) const {
+    return identified && other.identified && volumeSerial == other.volumeSerial &&
+           std::memcmp(fileId, other.fileId, sizeof(fileId)) == 0;
+}
+
+PathValidator::PathValidator(std::chrono::milliseconds debounce, std::chrono::milliseconds ttl) : ttl_(ttl) {
+    fields_.reserve(kFields);
+    for (size_t i = 0; i < kFields; ++i) {
+        fields_.push_back(Field{ChangeCoalescer(debounce, kMaxDebounce), {}, {}, {}});
+    }
+    worker_ = std::thread(&PathValidator::WorkerLoop, this);
+}
+
+void PathValidator::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+PathProbe PathValidator::Query(size_t field, const std::string& path) {
+    if (path.empty() || field >= kFields) {
+        return {};
+    }
+    const std::wstring wpath = Utf8ToUtf16(path);
+    const std::wstring key = FoldName(wpath);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        Request(fields_[field], key, wpath);
+        return {};
+    }
+    if (std::chrono::steady_clock::now() - it->second.checked > ttl_) {
+        Request(fields_[field], key, wpath);  // The old result keeps serving until the new one is in
+    }
+    return it->second.probe;
+}
+
+void PathValidator::Request(Field& field, const std::wstring& key, const std::wstring& path) {
+    if (key == field.pendingKey || key == field.statKey) {
+        return;
+    }
+    field.pendingKey = key;
+    field.pendingPath = path;
+    // The worker only needs waking for a new burst; later keystrokes just push the deadline out
+    const bool wake = !field.debounce.Pending();
+    field.debounce.Notify(std::chrono::steady_clock::now());
+    if (wake) cv_.notify_one();
+}
+
+void PathValidator::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        const auto now = std::chrono::steady_clock::now();
+        Field* due = nullptr;
+        auto wake = std::chrono::steady_clock::time_point::max();
+        for (Field& field : fields_) {
+            if (!field.debounce.Pending()) continue;
+            if (field.debounce.Poll(now)) {
+                due = &field;
+                break;
+            }
+            wake = (std::min)(wake, field.debounce.Deadline());
+        }
+        if (!due) {
+            if (wake == std::chrono::steady_clock::time_point::max()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, wake);
+            }
+            continue;
+        }
+        due->statKey = std::move(due->pendingKey);
+        due->pendingKey.clear();
+        const std::wstring path = std::move(due->pendingPath);
+
+        lock.unlock();
+        const PathProbe probe = ProbePath(path);
+        lock.lock();
+
+        if (cache_.size() >= kCacheCapacity && cache_.find(due->statKey) == cache_.end()) {
+            cache_.erase(std::min_element(cache_.begin(), cache_.end(), [](const auto& a, const auto& b) {
+                return a.second.checked < b.second.checked;
+            }));
+        }
+        cache_[due->statKey] = Entry{probe, std::chrono::steady_clock::now()};
+        due->statKey.clear();
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "change_coalescer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// What one stat of a path found
+struct PathProbe {
+    enum class State { Unknown, Missing, Invalid, File, Directory };
+
+    State state = State::Unknown;  // Unknown until the path has been looked at, or if the stat was refused
+    bool identified = false;       // volumeSerial and fileId were read
+    uint64_t volumeSerial = 0;
+    uint8_t fileId[16] = {};
+
+    bool Exists() const { return state == State::File || state == State::Directory; }
+
+    // Both probes found the same item, however differently it was spelled
+    bool SameItem(const PathProbe& other) const;
+};
+
+// Live validation of the path inputs. Paths are looked at on a background thread and the results
+// kept in a small cache keyed by folded path, so the UI reads what a path points at without ever
+// touching the disk. Each field (an input, or the name its item would be renamed to) holds one
+// pending path that every newer one replaces, and is only looked at once typing has paused on it
+// (debounced); the thread runs one stat at a time, so fast typing never has more than one stat in
+// flight per field. A result older than the TTL keeps serving while it is looked at again.
+class PathValidator {
+public:
+    static constexpr size_t kFields = 4;  // Path 1, path 2, and where each of their items would go
+
+    explicit PathValidator(std::chrono::milliseconds debounce = std::chrono::milliseconds(100),
+                           std::chrono::milliseconds ttl = std::chrono::milliseconds(2000));
+    PathValidator(const PathValidator&) = delete;
+    PathValidator& operator=(const PathValidator&) = delete;
+    ~PathValidator() { Stop(); }
+
+    // The cached probe of path in field, or an Unknown one; never waits. The path is asked for when
+    // it is not cached or its result has outlived the TTL.
+    PathProbe Query(size_t field, const std::string& path);
+
+    // Bumped whenever a stat finishes; nothing cached changed while it stays the same
+    uint64_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // Stop the stat thread; called by the destructor
+    void Stop();
+
+private:
+    struct Entry {
+        PathProbe probe;
+        std::chrono::steady_clock::time_point checked;
+    };
+
+    struct Field {
+        ChangeCoalescer debounce;
+        std::wstring pendingKey;  // Path to look at once the debounce is due
+        std::wstring pendingPath;
+        std::wstring statKey;  // Path being looked at right now
+    };
+
+    void Request(Field& field, const std::wstring& key, const std::wstring& path);
+    void WorkerLoop();
+
+    std::chrono::milliseconds ttl_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::wstring, Entry> cache_;  // Keyed by folded path
+    std::vector<Field> fields_;
+    std::atomic<uint64_t> generation_{0};
+    bool stop_ = false;
+    std::thread worker_;
+};
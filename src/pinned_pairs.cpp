@@ -0,0 +1,243 @@
+#include "pinned_pairs.h"
+
+#include "exchange.h"
+#include "path_lock.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+const wchar_t kPinnedPairsKey[] = L"Software\\FilenameExchanger\\PinnedPairs";
+constexpr size_t kLatencySamples = 32;
+
+std::wstring LongPath(const std::wstring& path) {
+    std::wstring full(MAX_PATH, L'\0');
+    DWORD len = GetFullPathNameW(path.c_str(), static_cast<DWORD>(full.size()), full.data(), nullptr);
+    if (len >= full.size()) {
+        full.resize(len);
+        len = GetFullPathNameW(path.c_str(), static_cast<DWORD>(full.size()), full.data(), nullptr);
+    }
+    full.resize(len);
+    if (full.rfind(L"\\\\?\\", 0) == 0) return full;
+    if (full.rfind(L"\\\\", 0) == 0) return L"\\\\?\\UNC\\" + full.substr(2);
+    return L"\\\\?\\" + full;
+}
+
+HANDLE OpenForRename(const std::wstring& path) {
+    return CreateFileW(path.c_str(), DELETE | SYNCHRONIZE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, nullptr);
+}
+
+// Rename an open item to name inside dir, never replacing an existing entry
+bool RenameByHandle(HANDLE item, HANDLE dir, const std::wstring& name) {
+    alignas(FILE_RENAME_INFO) BYTE buffer[sizeof(FILE_RENAME_INFO) + MAX_PATH * sizeof(wchar_t)];
+    const size_t nameBytes = name.size() * sizeof(wchar_t);
+    if (nameBytes >= MAX_PATH * sizeof(wchar_t)) {
+        SetLastError(ERROR_INVALID_NAME);
+        return false;
+    }
+    auto* info = reinterpret_cast<FILE_RENAME_INFO*>(buffer);
+    info->ReplaceIfExists = FALSE;
+    info->RootDirectory = dir;
+    info->FileNameLength = static_cast<DWORD>(nameBytes);
+    memcpy(info->FileName, name.c_str(), nameBytes + sizeof(wchar_t));
+    return SetFileInformationByHandle(item, FileRenameInfo, info, static_cast<DWORD>(sizeof(buffer))) != FALSE;
+}
+
+bool Exists(const std::wstring& path) { return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES; }
+
+// The exchange() code for a failed open or rename; errors it has none for are reported as a denial
+int ResultFromError(DWORD error) {
+    const int result = ResultFromWin32Error(error);
+    return result == -1 ? kResultPermissionDenied : result;
+}
+
+std::wstring JoinName(const std::wstring& dir, const std::wstring& name) {
+    return dir.empty() || dir.back() == L'\\' ? dir + name : dir + L'\\' + name;
+}
+}  // namespace
+
+std::vector<PinnedPair> LoadPinnedPairs() {
+    std::vector<PinnedPair> pairs;
+    for (size_t i = 0; i < kMaxPinnedPairs; ++i) {
+        const std::wstring valueName = std::to_wstring(i);
+        DWORD bytes = 0;
+        if (RegGetValueW(HKEY_CURRENT_USER, kPinnedPairsKey, valueName.c_str(), RRF_RT_REG_MULTI_SZ, nullptr, nullptr,
+                         &bytes) != ERROR_SUCCESS) {
+            break;
+        }
+        std::wstring data(bytes / sizeof(wchar_t), L'\0');
+        if (RegGetValueW(HKEY_CURRENT_USER, kPinnedPairsKey, valueName.c_str(), RRF_RT_REG_MULTI_SZ, nullptr,
+                         data.data(), &bytes) != ERROR_SUCCESS) {
+            break;
+        }
+
+        // path1 \0 path2 \0 "1"|"0" \0 \0
+        std::vector<std::wstring> fields;
+        for (size_t pos = 0; pos < data.size() && data[pos] != L'\0';) {
+            const size_t end = data.find(L'\0', pos);
+            fields.push_back(data.substr(pos, end - pos));
+            pos = end == std::wstring::npos ? data.size() : end + 1;
+        }
+        if (fields.size() < 2) continue;
+        PinnedPair pair;
+        pair.path1 = fields[0];
+        pair.path2 = fields[1];
+        pair.preserveExt = fields.size() < 3 || fields[2] != L"0";
+        pairs.push_back(std::move(pair));
+    }
+    return pairs;
+}
+
+void SavePinnedPairs(const std::vector<PinnedPair>& pairs) {
+    RegDeleteKeyW(HKEY_CURRENT_USER, kPinnedPairsKey);
+    if (pairs.empty()) return;
+
+    HKEY key = nullptr;
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, kPinnedPairsKey, 0, nullptr, 0, KEY_SET_VALUE, nullptr, &key, nullptr) !=
+        ERROR_SUCCESS) {
+        return;
+    }
+    for (size_t i = 0; i < pairs.size() && i < kMaxPinnedPairs; ++i) {
+        std::wstring data = pairs[i].path1;
+        data += L'\0';
+        data += pairs[i].path2;
+        data += L'\0';
+        data += pairs[i].preserveExt ? L"1" : L"0";
+        data += L'\0';
+        data += L'\0';
+        RegSetValueExW(key, std::to_wstring(i).c_str(), 0, REG_MULTI_SZ, reinterpret_cast<const BYTE*>(data.data()),
+                       static_cast<DWORD>(data.size() * sizeof(wchar_t)));
+    }
+    RegCloseKey(key);
+}
+
+PinnedSwap::PinnedSwap(PinnedPair pair) : pair_(std::move(pair)) {
+    const std::filesystem::path full[2] = {LongPath(pair_.path1), LongPath(pair_.path2)};
+    for (int i = 0; i < 2; ++i) {
+        const std::filesystem::path& self = full[i];
+        const std::filesystem::path& other = full[1 - i];
+        const DWORD attrs = GetFileAttributesW(self.c_str());
+        const bool isDirectory = attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY);
+
+        // Same naming rule as exchange(): each item stays in its folder and takes the other's name
+        Side& side = sides_[i];
+        side.dir = self.parent_path().wstring();
+        if (!side.dir.empty() && side.dir.back() == L':') side.dir += L'\\';  // "\\?\C:" alone would open the volume, not its root
+        side.names[0] = self.filename().wstring();
+        side.names[1] = (pair_.preserveExt && !isDirectory)
+                            ? other.stem().wstring() + self.extension().wstring()
+                            : other.filename().wstring();
+        side.dirHandle = CreateFileW(side.dir.c_str(), FILE_LIST_DIRECTORY | FILE_TRAVERSE,
+                                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                     FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    }
+
+    // The pair may have been left swapped by an earlier session
+    state_ = DetectState();
+}
+
+int PinnedSwap::DetectState() const {
+    auto at = [this](int side, int state) { return JoinName(sides_[side].dir, sides_[side].names[state]); };
+    return !(Exists(at(0, 0)) && Exists(at(1, 0))) && Exists(at(0, 1)) && Exists(at(1, 1)) ? 1 : 0;
+}
+
+PinnedSwap::~PinnedSwap() {
+    for (Side& side : sides_) {
+        if (side.dirHandle != INVALID_HANDLE_VALUE) CloseHandle(side.dirHandle);
+    }
+}
+
+int PinnedSwap::Toggle() {
+    const auto start = std::chrono::steady_clock::now();
+    if (sides_[0].dirHandle == INVALID_HANDLE_VALUE || sides_[1].dirHandle == INVALID_HANDLE_VALUE) {
+        return kResultNoExist;
+    }
+    stranded_[0].clear();
+    stranded_[1].clear();
+
+    int result = Swap();
+    if (result == kResultNoExist) {
+        // The items were renamed behind our back (by hand, or by a swap outside this pin); follow them
+        const int onDisk = DetectState();
+        if (onDisk != state_) {
+            state_ = onDisk;
+            result = Swap();
+        }
+    }
+
+    if (result == kResultSuccess) {
+        state_ = 1 - state_;
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        if (samplesUs_.size() < kLatencySamples) {
+            samplesUs_.push_back(static_cast<uint32_t>(us.count()));
+        } else {
+            samplesUs_[nextSample_] = static_cast<uint32_t>(us.count());
+            nextSample_ = (nextSample_ + 1) % kLatencySamples;
+        }
+    }
+    return result;
+}
+
+int PinnedSwap::Swap() {
+    Side& a = sides_[0];
+    Side& b = sides_[1];
+    const std::wstring& curA = a.names[state_];
+    const std::wstring& curB = b.names[state_];
+    const std::wstring& newA = a.names[1 - state_];
+    const std::wstring& newB = b.names[1 - state_];
+    if (a.dir == b.dir && curA == curB) {
+        return kResultSameFile;
+    }
+
+    // A batch swap may hold these stripes for a long time on a slow share; report it instead of blocking
+    const PathPairLock lock(JoinName(a.dir, curA), JoinName(b.dir, curB), std::try_to_lock);
+    if (!lock.OwnsLock()) {
+        return kResultBusy;
+    }
+    const std::wstring tempName = UniqueTempName(curA);
+    HANDLE itemA = OpenForRename(JoinName(a.dir, curA));
+    if (itemA == INVALID_HANDLE_VALUE) {
+        return ResultFromError(GetLastError());
+    }
+    HANDLE itemB = OpenForRename(JoinName(b.dir, curB));
+    if (itemB == INVALID_HANDLE_VALUE) {
+        const DWORD error = GetLastError();
+        CloseHandle(itemA);
+        return ResultFromError(error);
+    }
+
+    // A moves aside, B takes its new name, A takes its new name; undo in reverse on failure
+    int result = kResultSuccess;
+    const std::wstring* nameA = &curA;
+    const std::wstring* nameB = &curB;
+    if (!RenameByHandle(itemA, a.dirHandle, tempName)) {
+        result = ResultFromError(GetLastError());
+    } else if (!RenameByHandle(itemB, b.dirHandle, newB)) {
+        result = ResultFromError(GetLastError());
+        if (!RenameByHandle(itemA, a.dirHandle, curA)) nameA = &tempName;
+    } else if (!RenameByHandle(itemA, a.dirHandle, newA)) {
+        result = ResultFromError(GetLastError());
+        if (!RenameByHandle(itemB, b.dirHandle, curB)) nameB = &newB;
+        if (!RenameByHandle(itemA, a.dirHandle, curA)) nameA = &tempName;
+    }
+    CloseHandle(itemB);
+    CloseHandle(itemA);
+
+    if (nameA != &curA || nameB != &curB) {
+        stranded_[0] = JoinName(a.dir, *nameA);
+        stranded_[1] = JoinName(b.dir, *nameB);
+        return kResultHalfSwapped;
+    }
+    return result;
+}
+
+double PinnedSwap::MedianToggleUs() const {
+    if (samplesUs_.empty()) return 0.0;
+    std::vector<uint32_t> sorted = samplesUs_;
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    return sorted[sorted.size() / 2];
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+// At most this many pairs can be pinned; pair i is bound to Ctrl+Alt+<i+1>
+constexpr size_t kMaxPinnedPairs = 9;
+
+struct PinnedPair {
+    std::wstring path1;
+    std::wstring path2;
+    bool preserveExt = true;
+};
+
+// Pinned pairs are persisted under HKCU\Software\FilenameExchanger\PinnedPairs
+std::vector<PinnedPair> LoadPinnedPairs();
+void SavePinnedPairs(const std::vector<PinnedPair>& pairs);
+
+// A pinned pair prepared for repeated toggling. Paths and target names are resolved once; the
+// parent folders stay open so every toggle is two opens and three handle-relative renames with
+// no validation round-trips through exchange().
+class PinnedSwap {
+public:
+    explicit PinnedSwap(PinnedPair pair);
+    PinnedSwap(const PinnedSwap&) = delete;
+    PinnedSwap& operator=(const PinnedSwap&) = delete;
+    ~PinnedSwap();
+
+    // Swap the two items back or forth; returns an exchange() code. Never waits for another swap
+    // holding either item: that yields kResultBusy, so it is safe to call from the UI thread.
+    int Toggle();
+
+    const PinnedPair& Pair() const { return pair_; }
+
+    // Where the two items were left when the last Toggle() returned kResultHalfSwapped
+    const std::wstring* StrandedPaths() const { return stranded_; }
+
+    // Median of recent successful toggles in microseconds, 0 before the first one
+    double MedianToggleUs() const;
+
+private:
+    struct Side {
+        std::wstring dir;        // "\\?\"-prefixed parent folder
+        HANDLE dirHandle = INVALID_HANDLE_VALUE;
+        std::wstring names[2];   // Item name before / after an odd number of toggles
+    };
+
+    // Which of the two namings is on disk now (0 unless both items carry the swapped names)
+    int DetectState() const;
+    int Swap();
+
+    PinnedPair pair_;
+    Side sides_[2];
+    std::wstring stranded_[2];
+    int state_ = 0;  // Index into Side::names of the current on-disk names
+    std::vector<uint32_t> samplesUs_;
+    size_t nextSample_ = 0;
+};
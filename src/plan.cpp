@@ -0,0 +1,392 @@
+#include "plan.h"
+
+#include "collision_index.h"
+#include "i18n.h"
+#include "jsonl.h"
+#include "name_fold.h"
+#include "name_rules.h"
+#include "parallel.h"
+#include "path_lock.h"
+#include "path_store.h"
+#include "swap_queue.h"
+#include "utils.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <unordered_map>
+
+namespace {
+// Pairs per ParallelFor work item, as in FindNameCollisions
+constexpr size_t kPlanChunk = 1024;
+// Volumes beyond this many keep the default model rather than being probed one by one
+constexpr size_t kMaxCalibratedVolumes = 8;
+constexpr DWORD kProbeBytes = 1 << 20;
+constexpr int kProbeRounds = 8;
+
+double ElapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Volume part of a path: "C:" or "\\server\share", upper-cased; empty for a relative path
+std::wstring VolumeOf(std::wstring_view path) {
+    std::wstring root;
+    if (path.substr(0, 4) == L"\\\\?\\" || path.substr(0, 4) == L"\\\\.\\") {
+        path.remove_prefix(4);
+        if (path.size() >= 4 && CompareStringOrdinal(path.data(), 4, L"UNC\\", 4, TRUE) == CSTR_EQUAL) {
+            path.remove_prefix(4);
+            root = L"\\\\";
+        }
+    } else if (path.substr(0, 2) == L"\\\\") {
+        path.remove_prefix(2);
+        root = L"\\\\";
+    }
+    if (root.empty()) {
+        if (path.size() >= 2 && path[1] == L':') root.assign(path.substr(0, 2));
+    } else {
+        const size_t server = path.find(L'\\');
+        const size_t share = server == std::wstring_view::npos ? server : path.find(L'\\', server + 1);
+        root.append(path.substr(0, share));
+    }
+    return FoldName(root);
+}
+
+// True if one path is a folder containing the other: neither item can take the other's place
+bool IsNested(const std::wstring& a, const std::wstring& b) {
+    const std::wstring& shorter = a.size() < b.size() ? a : b;
+    const std::wstring& longer = a.size() < b.size() ? b : a;
+    return shorter.size() < longer.size() && longer[shorter.size()] == L'\\' &&
+           CompareStringOrdinal(shorter.data(), static_cast<int>(shorter.size()), longer.data(),
+                                static_cast<int>(shorter.size()), TRUE) == CSTR_EQUAL;
+}
+
+uint64_t SizeOf(const std::wstring& path) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) return 0;
+    return (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+}
+
+// Extra stat-sized round trips the swap options add to every executed pair
+double OptionOverheadUs(const PlanOptions& options, const PlanCostModel& model) {
+    double stats = 0.0;
+    if (options.verify) stats += 4.0;    // File identity of both items before and after
+    if (options.metadata) stats += 6.0;  // Two opens, two queries, two updates
+    return stats * model.statUs;
+}
+}  // namespace
+
+const char* PlanStrategyName(PlanStrategy strategy) {
+    switch (strategy) {
+        case PlanStrategy::Rename:
+            return "rename";
+        case PlanStrategy::CaseOnly:
+            return "case-only";
+        case PlanStrategy::CrossVolume:
+            return "cross-volume";
+        default:
+            return "skip";
+    }
+}
+
+bool CalibrateCostModel(const std::wstring& dir, PlanCostModel& model) {
+    const std::filesystem::path base(dir);
+    const std::wstring source = (base / UniqueTempName(L"plan_probe")).wstring();
+    const std::wstring copy = (base / UniqueTempName(L"plan_probe")).wstring();
+    const std::wstring moved = (base / UniqueTempName(L"plan_probe")).wstring();
+
+    HANDLE file = CreateFileW(source.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_HIDDEN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    const std::vector<char> data(kProbeBytes, 'x');
+    DWORD written = 0;
+    const bool filled = WriteFile(file, data.data(), kProbeBytes, &written, nullptr) && written == kProbeBytes &&
+                        FlushFileBuffers(file);
+    CloseHandle(file);
+
+    PlanCostModel measured;
+    bool ok = filled;
+    if (ok) {
+        // Uncached, so the copy measures the volume rather than memory
+        auto start = std::chrono::steady_clock::now();
+        ok = CopyFileExW(source.c_str(), copy.c_str(), nullptr, nullptr, nullptr, COPY_FILE_NO_BUFFERING) != 0;
+        measured.copyBytesPerUs = kProbeBytes / (std::max)(ElapsedUs(start), 1.0);
+    }
+    if (ok) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kProbeRounds && ok; ++i) {
+            ok = MoveFileExW(copy.c_str(), moved.c_str(), 0) && MoveFileExW(moved.c_str(), copy.c_str(), 0);
+        }
+        measured.renameUs = ElapsedUs(start) / (2 * kProbeRounds);
+    }
+    if (ok) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kProbeRounds; ++i) {
+            GetFileAttributesW(i % 2 ? copy.c_str() : source.c_str());
+        }
+        measured.statUs = ElapsedUs(start) / kProbeRounds;
+    }
+    DeleteFileW(source.c_str());
+    DeleteFileW(copy.c_str());
+    DeleteFileW(moved.c_str());
+
+    if (!ok) return false;
+    measured.measured = true;
+    model = measured;
+    return true;
+}
+
+Plan BuildPlan(const PathStore& paths, const std::vector<SwapEntry>& pairs, const PlanOptions& options) {
+    Plan plan;
+    plan.pairs.resize(pairs.size());
+    const auto start = std::chrono::steady_clock::now();
+
+    // Conflicts within the batch and names the target does not accept, without touching the disk
+    const std::vector<int> collisions = FindNameCollisions(paths, pairs, false);
+    const std::vector<int> invalidNames = FindInvalidNames(paths, pairs, options.nameRules);
+
+    // Relative paths live on the volume of the current directory
+    wchar_t cwd[MAX_PATH] = {};
+    GetCurrentDirectoryW(MAX_PATH, cwd);
+    const std::wstring currentVolume = VolumeOf(cwd);
+
+    std::vector<std::wstring> volumes(pairs.size());
+    std::vector<std::wstring> dirs(pairs.size());
+    const size_t chunks = (pairs.size() + kPlanChunk - 1) / kPlanChunk;
+    ParallelFor(chunks, [&](size_t chunk) {
+        const size_t end = (std::min)(pairs.size(), (chunk + 1) * kPlanChunk);
+        PathReader reader1(paths);
+        PathReader reader2(paths);
+        for (size_t i = chunk * kPlanChunk; i < end; ++i) {
+            const SwapEntry& entry = pairs[i];
+            PlannedPair& planned = plan.pairs[i];
+            planned.strategy = PlanStrategy::Skip;
+            const std::string_view path1 = reader1.Read(entry.path1);
+            const std::string_view path2 = reader2.Read(entry.path2);
+            if (path1.empty() || path2.empty()) {
+                planned.code = kResultInvalidPath;
+                continue;
+            }
+            const std::filesystem::path p1 = std::filesystem::path(Utf8ToUtf16(path1)).lexically_normal();
+            const std::filesystem::path p2 = std::filesystem::path(Utf8ToUtf16(path2)).lexically_normal();
+            const std::wstring& w1 = p1.native();
+            const std::wstring& w2 = p2.native();
+            if (CompareStringOrdinal(w1.data(), static_cast<int>(w1.size()), w2.data(), static_cast<int>(w2.size()),
+                                     TRUE) == CSTR_EQUAL) {
+                planned.code = kResultSameFile;
+                continue;
+            }
+            if (IsNested(w1, w2)) {
+                planned.code = kResultInvalidPath;
+                continue;
+            }
+            if (invalidNames[i] != kResultSuccess || collisions[i] != kResultSuccess) {
+                planned.code = invalidNames[i] != kResultSuccess ? invalidNames[i] : collisions[i];
+                continue;
+            }
+
+            std::wstring v1 = VolumeOf(w1);
+            std::wstring v2 = VolumeOf(w2);
+            if (v1.empty()) v1 = currentVolume;
+            if (v2.empty()) v2 = currentVolume;
+            planned.code = kResultSuccess;
+            if (v1 != v2) {
+                planned.strategy = PlanStrategy::CrossVolume;
+            } else if (FoldName(p1.stem().native()) == FoldName(p2.stem().native()) &&
+                       IsCaseOnlySwap(w1, w2, entry.preserveExt)) {
+                // Equal folded stems are necessary for a case-only swap and cheap to rule out
+                planned.strategy = PlanStrategy::CaseOnly;
+            } else {
+                planned.strategy = PlanStrategy::Rename;
+            }
+            volumes[i] = std::move(v1);
+            dirs[i] = p1.parent_path().native();
+        }
+    });
+
+    // Number the volumes in order of first use
+    std::unordered_map<std::wstring, size_t> volumeIndex;
+    std::vector<size_t> volumeOf(pairs.size(), SIZE_MAX);
+    std::vector<size_t> firstPair;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (volumes[i].empty()) continue;
+        const auto [it, added] = volumeIndex.emplace(std::move(volumes[i]), plan.volumes.size());
+        if (added) {
+            plan.volumes.push_back(PlanVolume{it->first, options.fixedModel ? *options.fixedModel : PlanCostModel{}});
+            firstPair.push_back(i);
+        }
+        volumeOf[i] = it->second;
+        ++plan.volumes[it->second].pairs;
+    }
+
+    plan.planningMs = ElapsedUs(start) / 1000.0;
+    const auto probeStart = std::chrono::steady_clock::now();
+    if (!options.fixedModel) {
+        for (size_t v = 0; v < plan.volumes.size() && v < kMaxCalibratedVolumes; ++v) {
+            const std::wstring& dir = dirs[firstPair[v]];
+            CalibrateCostModel(dir.empty() ? std::wstring(L".") : dir, plan.volumes[v].model);
+        }
+    }
+
+    // Cross-volume pairs move their content, so their cost depends on the sizes
+    std::vector<size_t> crossing;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (plan.pairs[i].strategy == PlanStrategy::CrossVolume) crossing.push_back(i);
+    }
+    std::vector<uint64_t> bytes(crossing.size(), 0);
+    if (!options.fixedModel) {
+        ParallelFor(crossing.size(), [&](size_t c) {
+            std::string buffer;
+            const SwapEntry& entry = pairs[crossing[c]];
+            bytes[c] = SizeOf(Utf8ToUtf16(paths.Path(entry.path1, buffer))) +
+                       SizeOf(Utf8ToUtf16(paths.Path(entry.path2, buffer)));
+        });
+    }
+    plan.probingMs = ElapsedUs(probeStart) / 1000.0;
+
+    const auto costStart = std::chrono::steady_clock::now();
+    size_t nextCrossing = 0;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        PlannedPair& planned = plan.pairs[i];
+        if (planned.strategy == PlanStrategy::Skip) continue;
+        const PlanCostModel& model = plan.volumes[volumeOf[i]].model;
+        const double probe = 2.0 * model.statUs + OptionOverheadUs(options, model);
+        switch (planned.strategy) {
+            case PlanStrategy::Rename:
+                planned.costUs = probe + 3.0 * model.renameUs;
+                break;
+            case PlanStrategy::CaseOnly:
+                planned.costUs = probe + 4.0 * model.renameUs;
+                break;
+            default:
+                // Each item is written to the other volume and removed from its own
+                planned.costUs = probe + 4.0 * model.renameUs + bytes[nextCrossing++] / model.copyBytesPerUs;
+                break;
+        }
+    }
+    plan.planningMs += ElapsedUs(costStart) / 1000.0;
+    return plan;
+}
+
+double EstimatePlanRunUs(const Plan& plan, const PlanOptions& options) {
+    double totalUs = 0.0;
+    size_t running = 0;
+    for (const PlannedPair& planned : plan.pairs) {
+        if (planned.strategy == PlanStrategy::Skip) continue;
+        totalUs += planned.costUs;
+        ++running;
+    }
+    double runUs = totalUs / static_cast<double>((std::max)(options.depth, size_t{1}));
+    if (options.opsPerSecond > 0.0) {
+        runUs = (std::max)(runUs, running / options.opsPerSecond * 1e6);
+    }
+    return runUs;
+}
+
+void AppendPlanRecord(std::string& out, uint64_t seq, std::string_view path1, std::string_view path2,
+                      bool preserveExt, const PlannedPair& planned) {
+    out += "{\"seq\":";
+    out += std::to_string(seq);
+    out += ",\"path1\":";
+    AppendJsonString(out, path1);
+    out += ",\"path2\":";
+    AppendJsonString(out, path2);
+    out += preserveExt ? ",\"preserve\":true" : ",\"preserve\":false";
+    out += ",\"strategy\":\"";
+    out += PlanStrategyName(planned.strategy);
+    out += "\",\"code\":";
+    out += std::to_string(planned.code);
+    out += ",\"cost_us\":";
+    out += std::to_string(static_cast<int64_t>(planned.costUs + 0.5));
+    out += "}\n";
+}
+
+bool ParsePlanRecord(std::string_view line, PlanRecord& record) {
+    auto skipSpace = [&line] {
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t' || line.front() == '\r')) {
+            line.remove_prefix(1);
+        }
+    };
+    auto take = [&line, &skipSpace](char ch) {
+        skipSpace();
+        if (line.empty() || line.front() != ch) return false;
+        line.remove_prefix(1);
+        return true;
+    };
+
+    PlanRecord parsed;
+    bool havePath1 = false;
+    bool havePath2 = false;
+    bool skip = false;
+    int code = kResultSuccess;
+    std::string key;
+    std::string text;
+    if (!take('{')) return false;
+    if (take('}')) return false;
+    do {
+        skipSpace();
+        if (!ReadJsonString(line, key) || !take(':')) return false;
+        skipSpace();
+        if (!line.empty() && line.front() == '"') {
+            if (!ReadJsonString(line, text)) return false;
+            if (key == "path1") {
+                parsed.path1 = std::move(text);
+                havePath1 = true;
+            } else if (key == "path2") {
+                parsed.path2 = std::move(text);
+                havePath2 = true;
+            } else if (key == "strategy") {
+                skip = text == PlanStrategyName(PlanStrategy::Skip);
+            }
+        } else {
+            // Numbers and literals; only "preserve" and "code" matter
+            const size_t end = (std::min)(line.find_first_of(",}"), line.size());
+            std::string_view value = line.substr(0, end);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            line.remove_prefix(end);
+            if (key == "preserve") {
+                if (value != "true" && value != "false") return false;
+                parsed.preserveExt = value == "true";
+            } else if (key == "code") {
+                code = std::atoi(std::string(value).c_str());
+            }
+        }
+    } while (take(','));
+    if (!take('}') || !havePath1 || !havePath2) return false;
+
+    parsed.code = skip ? (code != kResultSuccess ? code : kResultInvalidPath) : kResultSuccess;
+    record = std::move(parsed);
+    return true;
+}
+
+std::wstring DescribePlan(const Plan& plan, const PlanOptions& options) {
+    const auto& L = GetCurrentLocale();
+    const wchar_t* labels[] = {L.planStrategyRename, L.planStrategyCaseOnly, L.planStrategyCrossVolume,
+                               L.planStrategySkip};
+    size_t counts[4] = {};
+    double costs[4] = {};
+    for (const PlannedPair& planned : plan.pairs) {
+        counts[static_cast<size_t>(planned.strategy)]++;
+        costs[static_cast<size_t>(planned.strategy)] += planned.costUs;
+    }
+
+    std::wstring text;
+    wchar_t line[512];
+    swprintf_s(line, L.planHeader, plan.pairs.size(), plan.planningMs, plan.probingMs);
+    text += line;
+    for (size_t s = 0; s < 4; ++s) {
+        swprintf_s(line, L"\n  %-28ls %10zu  %10.1f s", labels[s], counts[s], costs[s] / 1e6);
+        text += line;
+    }
+    for (const PlanVolume& volume : plan.volumes) {
+        swprintf_s(line, L.planVolume, volume.root.c_str(), volume.pairs, volume.model.statUs, volume.model.renameUs,
+                   volume.model.copyBytesPerUs, volume.model.measured ? L"" : L.planVolumeDefault);
+        text += L"\n";
+        text += line;
+    }
+    swprintf_s(line, L.planEstimate, EstimatePlanRunUs(plan, options) / 1e6, options.depth);
+    text += L"\n";
+    text += line;
+    return text;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "exchange.h"
+#include "name_rules.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class PathStore;
+struct SwapEntry;
+
+// How a pair will be carried out by NativeVfs
+enum class PlanStrategy : uint8_t {
+    Rename,       // exchange(): three renames through a temporary name on one volume
+    CaseOnly,     // ExchangeCaseOnly: both names park under temporary names, four renames
+    CrossVolume,  // The items live on different volumes, so their content is copied across
+    Skip,         // Cannot succeed; reported with its code without running
+};
+
+// Stable name used in plan records ("rename", "case-only", "cross-volume", "skip")
+const char* PlanStrategyName(PlanStrategy strategy);
+
+// What one operation costs on a volume, in microseconds
+struct PlanCostModel {
+    double statUs = 50.0;
+    double renameUs = 300.0;
+    double copyBytesPerUs = 100.0;  // 100 MB/s
+    bool measured = false;          // False while these are the defaults above
+};
+
+// Time a handful of stats and renames and a 1 MB uncached copy of a scratch file created in dir,
+// then remove it. Takes a few tens of milliseconds; false (model untouched) if dir is not writable.
+bool CalibrateCostModel(const std::wstring& dir, PlanCostModel& model);
+
+struct PlanOptions {
+    bool verify = false;          // --verify adds identity checks around every swap
+    uint32_t metadata = 0;        // --swap-metadata classes add handle opens and updates
+    size_t depth = 1;             // --pipeline-depth, for the wall-clock estimate
+    double opsPerSecond = 0.0;    // --max-rate, for the wall-clock estimate; 0 = unlimited
+    const PlanCostModel* fixedModel = nullptr;  // Use this instead of probing (--simulate-latency)
+    NameRules nameRules = NameRules::Windows;   // --name-rules: pairs whose new names break them are skipped
+};
+
+struct PlannedPair {
+    PlanStrategy strategy = PlanStrategy::Rename;
+    int code = kResultSuccess;  // Why the pair is skipped
+    double costUs = 0.0;
+};
+
+struct PlanVolume {
+    std::wstring root;  // "C:" or "\\server\share"
+    PlanCostModel model;
+    size_t pairs = 0;   // Pairs whose first path lives here
+};
+
+struct Plan {
+    std::vector<PlannedPair> pairs;
+    std::vector<PlanVolume> volumes;  // In order of first use
+    double planningMs = 0.0;          // Classification and costing, without the calibration probes
+    double probingMs = 0.0;
+};
+
+// Decide the strategy of every pair and estimate its cost, mirroring NativeVfs::Exchange. Pairs are
+// classified from their paths alone (plus the collision screen within the batch) on all cores, aiming
+// at well under a second per million pairs; only cross-volume pairs are stat'ed, for their size.
+// Volumes are told apart by drive letter or share, not by mount points inside them. Each volume
+// (up to eight) is calibrated once in the folder of its first pair. The paths are read from paths.
+Plan BuildPlan(const PathStore& paths, const std::vector<SwapEntry>& pairs, const PlanOptions& options);
+
+// Estimated wall-clock time of the whole plan in microseconds, given the pipeline depth and rate cap
+double EstimatePlanRunUs(const Plan& plan, const PlanOptions& options);
+
+// A pair as a plan record carries it
+struct PlanRecord {
+    std::string path1;
+    std::string path2;
+    bool preserveExt = true;
+    int code = kResultSuccess;  // The skip reason, or kResultSuccess for pairs that run
+};
+
+// First line of a plan written by --plan. "-" mode reads its input as a plan only when it starts
+// with exactly this line; a record of plain input never contains '"', which Windows forbids in names.
+constexpr std::string_view kPlanHeader = "{\"format\":\"name_exchanger-plan\",\"version\":1}";
+
+// Append one plan record as a JSON line:
+// {"seq":0,"path1":"a.txt","path2":"b.txt","preserve":true,"strategy":"rename","code":0,"cost_us":912}
+void AppendPlanRecord(std::string& out, uint64_t seq, std::string_view path1, std::string_view path2,
+                      bool preserveExt, const PlannedPair& planned);
+
+// Read a line written by AppendPlanRecord back into record. False if it is not a plan record.
+bool ParsePlanRecord(std::string_view line, PlanRecord& record);
+
+// Human-readable summary: pairs and estimated time per strategy, the volume models, the total
+std::wstring DescribePlan(const Plan& plan, const PlanOptions& options);
@@ -0,0 +1,123 @@
+#include "queue_view.h"
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+namespace {
+// State changes during a run refresh the filtered index at most this often
+constexpr auto kStateRebuildInterval = std::chrono::milliseconds(100);
+
+bool MatchesFilter(QueueFilter filter, SwapState state) {
+    switch (filter) {
+        case QueueFilter::Pending:
+            return state == SwapState::Pending;
+        case QueueFilter::Running:
+            return state == SwapState::Running;
+        case QueueFilter::Done:
+            return state == SwapState::Done;
+        case QueueFilter::Failed:
+            return state == SwapState::Failed;
+        case QueueFilter::All:
+        default:
+            return true;
+    }
+}
+
+char FoldAscii(char ch) { return static_cast<char>(std::tolower(static_cast<unsigned char>(ch))); }
+
+// ASCII case-insensitive substring test; needle must already be lower-case
+bool ContainsFolded(std::string_view haystack, const std::string& needle) {
+    return std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(),
+                       [](char a, char b) { return FoldAscii(a) == b; }) != haystack.end();
+}
+}  // namespace
+
+void QueueView::Update(const PathStore& paths, const std::vector<SwapEntry>& entries, uint64_t revision,
+                       uint64_t layoutRevision) {
+    const bool layoutChanged = layoutRevision != seenLayoutRevision_;
+    const bool orderChanged = layoutChanged || sortKey != seenSortKey_;
+    const bool textChanged = layoutChanged || filterText != seenFilterText_;
+    const bool settingsChanged = orderChanged || textChanged || filter != seenFilter_ || descending != seenDescending_;
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!settingsChanged) {
+        if (revision == seenRevision_ || now - lastRebuild_ < kStateRebuildInterval) {
+            return;
+        }
+    }
+
+    if (orderChanged) {
+        RebuildOrder(paths, entries);
+    }
+    if (textChanged) {
+        RebuildTextMatch(paths, entries);
+    }
+    RebuildRows(entries);
+
+    seenRevision_ = revision;
+    seenLayoutRevision_ = layoutRevision;
+    seenFilter_ = filter;
+    seenFilterText_ = filterText;
+    seenSortKey_ = sortKey;
+    seenDescending_ = descending;
+    lastRebuild_ = now;
+}
+
+void QueueView::RebuildOrder(const PathStore& paths, const std::vector<SwapEntry>& entries) {
+    order_.resize(entries.size());
+    std::iota(order_.begin(), order_.end(), 0u);
+    if (sortKey == QueueSortKey::Path1) {
+        std::stable_sort(order_.begin(), order_.end(),
+                         [&](uint32_t a, uint32_t b) { return paths.Compare(entries[a].path1, entries[b].path1) < 0; });
+    } else if (sortKey == QueueSortKey::Path2) {
+        std::stable_sort(order_.begin(), order_.end(),
+                         [&](uint32_t a, uint32_t b) { return paths.Compare(entries[a].path2, entries[b].path2) < 0; });
+    }
+}
+
+void QueueView::RebuildTextMatch(const PathStore& paths, const std::vector<SwapEntry>& entries) {
+    textMatch_.clear();
+    if (filterText.empty()) {
+        return;
+    }
+    std::string needle = filterText;
+    std::transform(needle.begin(), needle.end(), needle.begin(), FoldAscii);
+    textMatch_.resize(entries.size());
+    PathReader reader1(paths);
+    PathReader reader2(paths);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        textMatch_[i] = ContainsFolded(reader1.Read(entries[i].path1), needle) ||
+                        ContainsFolded(reader2.Read(entries[i].path2), needle);
+    }
+}
+
+void QueueView::RebuildRows(const std::vector<SwapEntry>& entries) {
+    rows_.clear();
+    rows_.reserve(order_.size());
+    auto accept = [&](uint32_t i) {
+        return (textMatch_.empty() || textMatch_[i]) && MatchesFilter(filter, entries[i].state);
+    };
+
+    if (sortKey == QueueSortKey::Status) {
+        // Bucket by state, keeping insertion order inside each bucket
+        const SwapState states[] = {SwapState::Running, SwapState::Pending, SwapState::Failed, SwapState::Done};
+        for (int k = 0; k < 4; ++k) {
+            const SwapState state = states[descending ? 3 - k : k];
+            for (uint32_t i : order_) {
+                if (entries[i].state == state && accept(i)) rows_.push_back(i);
+            }
+        }
+        return;
+    }
+
+    if (descending) {
+        for (auto it = order_.rbegin(); it != order_.rend(); ++it) {
+            if (accept(*it)) rows_.push_back(*it);
+        }
+    } else {
+        for (uint32_t i : order_) {
+            if (accept(i)) rows_.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "swap_queue.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class QueueFilter {
+    All,
+    Pending,
+    Running,
+    Done,
+    Failed,
+};
+
+enum class QueueSortKey {
+    Order,
+    Path1,
+    Path2,
+    Status,
+};
+
+// Filtered and sorted row index over a SwapQueue. Rows are referenced by entry index, never copied.
+// Path orderings are only recomputed when entries are added or removed; state changes during a
+// run cost one linear pass over the index, at most a few times per second.
+class QueueView {
+public:
+    QueueFilter filter = QueueFilter::All;
+    std::string filterText;
+    QueueSortKey sortKey = QueueSortKey::Order;
+    bool descending = false;
+
+    // Refresh the index if the queue or the view settings changed. Call under the queue lock.
+    void Update(const PathStore& paths, const std::vector<SwapEntry>& entries, uint64_t revision,
+                uint64_t layoutRevision);
+
+    const std::vector<uint32_t>& Rows() const { return rows_; }
+
+private:
+    void RebuildOrder(const PathStore& paths, const std::vector<SwapEntry>& entries);
+    void RebuildTextMatch(const PathStore& paths, const std::vector<SwapEntry>& entries);
+    void RebuildRows(const std::vector<SwapEntry>& entries);
+
+    std::vector<uint32_t> rows_;
+    std::vector<uint32_t> order_;      // Entry indices sorted by the current path key
+    std::vector<uint8_t> textMatch_;   // Per entry: matches filterText
+    uint64_t seenRevision_ = UINT64_MAX;
+    uint64_t seenLayoutRevision_ = UINT64_MAX;
+    QueueFilter seenFilter_ = QueueFilter::All;
+    std::string seenFilterText_;
+    QueueSortKey seenSortKey_ = QueueSortKey::Order;
+    bool seenDescending_ = false;
+    std::chrono::steady_clock::time_point lastRebuild_{};
+};
@@ -0,0 +1,84 @@
+#include "settings_observer.h"
+
+namespace {
+// HKCU subkeys whose values feed ThemeInputs
+constexpr const wchar_t* kWatchedKeys[] = {
+    L"Software\\Microsoft\\Windows\\CurrentVersion\\Themes\\Personalize",  // AppsUseLightTheme
+    L"Software\\Microsoft\\Windows\\DWM",                                  // ColorizationColor
+    L"Control Panel\\Colors",                                              // GetSysColor values
+};
+
+// Notifications are one-shot; re-arm after every signal
+bool Arm(HKEY key, HANDLE event) {
+    return RegNotifyChangeKeyValue(key, FALSE, REG_NOTIFY_CHANGE_LAST_SET, event, TRUE) == ERROR_SUCCESS;
+}
+}  // namespace
+
+bool SettingsObserver::Start(HWND window, UINT message) {
+    Stop();
+    window_ = window;
+    message_ = message;
+
+    bool any = false;
+    for (int i = 0; i < kKeyCount; ++i) {
+        if (RegOpenKeyExW(HKEY_CURRENT_USER, kWatchedKeys[i], 0, KEY_NOTIFY, &keys_[i]) != ERROR_SUCCESS) {
+            keys_[i] = nullptr;
+            continue;
+        }
+        events_[i] = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!events_[i] || !Arm(keys_[i], events_[i])) {
+            if (events_[i]) CloseHandle(events_[i]);
+            RegCloseKey(keys_[i]);
+            events_[i] = nullptr;
+            keys_[i] = nullptr;
+            continue;
+        }
+        any = true;
+    }
+    if (!any) return false;
+
+    stop_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stop_) {
+        Stop();
+        return false;
+    }
+    thread_ = std::thread(&SettingsObserver::Run, this);
+    return true;
+}
+
+void SettingsObserver::Stop() {
+    if (thread_.joinable()) {
+        SetEvent(stop_);
+        thread_.join();
+    }
+    if (stop_) {
+        CloseHandle(stop_);
+        stop_ = nullptr;
+    }
+    for (int i = 0; i < kKeyCount; ++i) {
+        if (keys_[i]) RegCloseKey(keys_[i]);
+        if (events_[i]) CloseHandle(events_[i]);
+        keys_[i] = nullptr;
+        events_[i] = nullptr;
+    }
+}
+
+void SettingsObserver::Run() {
+    HANDLE handles[kKeyCount + 1] = {stop_};
+    int slots[kKeyCount + 1] = {};
+    DWORD count = 1;
+    for (int i = 0; i < kKeyCount; ++i) {
+        if (events_[i]) {
+            slots[count] = i;
+            handles[count++] = events_[i];
+        }
+    }
+
+    for (;;) {
+        const DWORD wait = WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+        if (wait <= WAIT_OBJECT_0 || wait >= WAIT_OBJECT_0 + count) return;  // Stopped or failed
+        const int key = slots[wait - WAIT_OBJECT_0];
+        Arm(keys_[key], events_[key]);
+        PostMessageW(window_, message_, 0, 0);
+    }
+}
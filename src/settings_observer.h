@@ -0,0 +1,31 @@
+#pragma once
+
+#include <thread>
+#include <windows.h>
+
+// Watches the registry keys the UI theme is derived from (app light/dark mode, DWM accent color,
+// classic system colors) and posts `message` to `window` whenever one of them is written. One
+// thread waits on all keys at once; unrelated WM_SETTINGCHANGE broadcasts never reach it.
+class SettingsObserver {
+public:
+    SettingsObserver() = default;
+    SettingsObserver(const SettingsObserver&) = delete;
+    SettingsObserver& operator=(const SettingsObserver&) = delete;
+    ~SettingsObserver() { Stop(); }
+
+    // False if none of the keys could be opened (the caller still gets window messages)
+    bool Start(HWND window, UINT message);
+    void Stop();
+
+private:
+    static constexpr int kKeyCount = 3;
+
+    void Run();
+
+    HWND window_ = nullptr;
+    UINT message_ = 0;
+    HKEY keys_[kKeyCount] = {};
+    HANDLE events_[kKeyCount] = {};
+    HANDLE stop_ = nullptr;
+    std::thread thread_;
+};
@@ -0,0 +1,502 @@
+#include "shard_executor.h"
+
+#include "exchange.h"
+#include "i18n.h"
+#include "manifest.h"
+#include "name_fold.h"
+#include "name_rules.h"
+#include "parallel.h"
+#include "stream_mode.h"
+#include "swap_pipeline.h"
+#include "utils.h"
+#include "vfs.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cwchar>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+// Shards per worker: enough for the fast workers to take over the share of a slow one
+constexpr size_t kShardsPerWorker = 4;
+// Times a slot starts a worker again after its last one exited or failed to start
+constexpr size_t kMaxWorkerRestarts = 3;
+constexpr DWORD kPipeBufferSize = 64 * 1024;
+// Pairs per ParallelFor work item when screening names
+constexpr size_t kScreenChunk = 1024;
+constexpr DWORD kConnectTimeoutMs = 10000;
+// A worker whose pipe was closed gets this long to finish the pairs in flight before it is ended
+constexpr DWORD kExitGraceMs = 5000;
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+// Called right before a pair's swap; false refuses it. end is called once the pair finished.
+using BeginFn = std::function<bool(uint64_t pair)>;
+using EndFn = std::function<void(uint64_t pair, int code, int64_t micros)>;
+
+class DisjointSets {
+public:
+    uint32_t Add() {
+        parent_.push_back(static_cast<uint32_t>(parent_.size()));
+        return parent_.back();
+    }
+    uint32_t Find(uint32_t x) {
+        while (parent_[x] != x) {
+            parent_[x] = parent_[parent_[x]];
+            x = parent_[x];
+        }
+        return x;
+    }
+    void Unite(uint32_t a, uint32_t b) {
+        a = Find(a);
+        b = Find(b);
+        if (a != b) parent_[b] = a;
+    }
+
+private:
+    std::vector<uint32_t> parent_;
+};
+
+// Folder part of a path; "" for a bare name
+std::string_view ParentOf(std::string_view path) {
+    const size_t slash = path.find_last_of("\\/");
+    return slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+}
+
+// Comparison key of a folder: backslashes only, no trailing one, folded
+std::wstring FolderKey(std::string_view path) {
+    std::wstring wide = Utf8ToUtf16(path);
+    std::replace(wide.begin(), wide.end(), L'/', L'\\');
+    while (!wide.empty() && wide.back() == L'\\') wide.pop_back();
+    return FoldName(wide);
+}
+
+// Read exactly count space-separated numbers
+bool ParseNumbers(std::string_view text, int64_t* values, size_t count) {
+    const char* p = text.data();
+    const char* end = text.data() + text.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0 && (p == end || *p++ != ' ')) return false;
+        const auto [next, error] = std::from_chars(p, end, values[i]);
+        if (error != std::errc() || values[i] < 0) return false;
+        p = next;
+    }
+    return p == end;
+}
+
+// "S <pair> <pair> ..."
+bool ParseShard(std::string_view line, const Manifest& manifest, std::vector<uint64_t>& pairs) {
+    pairs.clear();
+    if (line.empty() || line[0] != 'S') return false;
+    const char* p = line.data() + 1;
+    const char* end = line.data() + line.size();
+    while (p != end) {
+        uint64_t pair = 0;
+        if (*p++ != ' ') return false;
+        const auto [next, error] = std::from_chars(p, end, pair);
+        if (error != std::errc() || pair >= manifest.Size()) return false;
+        pairs.push_back(pair);
+        p = next;
+    }
+    return true;
+}
+
+// Run pairs of the manifest in the given order through a SwapPipeline, as RunStreamMode would
+void RunShard(Vfs& vfs, const Manifest& manifest, bool preserveExt, size_t depth, const std::vector<uint64_t>& pairs,
+              const BeginFn& begin, const EndFn& end) {
+    auto run = [&](uint64_t pair, const std::string& path1, const std::string& path2, bool preserve) {
+        for (const std::string* path : {&path1, &path2}) {
+            const int code = vfs.Probe(*path);
+            if (code != kResultSuccess) return code;
+        }
+        // Refused once the coordinator is gone; nobody is left to read the code
+        if (!begin(pair)) return kResultPermissionDenied;
+        return vfs.Exchange(path1, path2, preserve);
+    };
+
+    SwapPipeline pipeline(depth, run, end);
+    for (uint64_t pair : pairs) {
+        std::string path1(manifest.Path1(pair));
+        std::string path2(manifest.Path2(pair));
+        if (path1.empty() || path2.empty()) {
+            end(pair, kResultInvalidPath, 0);
+            continue;
+        }
+        pipeline.Submit(pair, std::move(path1), std::move(path2), manifest.PreserveExt(pair).value_or(preserveExt));
+    }
+    pipeline.Finish();
+}
+}  // namespace
+
+std::vector<std::vector<uint64_t>> ShardManifest(const Manifest& manifest, size_t shardCount) {
+    const size_t pairCount = manifest.Size();
+    std::unordered_map<std::wstring, uint32_t> folders;  // Folder key -> its set
+    DisjointSets sets;
+    auto folderOf = [&](std::string_view path) {
+        auto [it, added] = folders.try_emplace(FolderKey(ParentOf(path)), 0);
+        if (added) it->second = sets.Add();
+        return it->second;
+    };
+    std::vector<uint32_t> pairFolder(pairCount);
+    for (size_t i = 0; i < pairCount; ++i) {
+        pairFolder[i] = folderOf(manifest.Path1(i));
+        sets.Unite(pairFolder[i], folderOf(manifest.Path2(i)));
+    }
+
+    // Renaming a folder moves every folder below it, so those belong to the pair's group too
+    std::vector<std::pair<std::wstring_view, uint32_t>> sorted(folders.begin(), folders.end());
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < pairCount; ++i) {
+        for (const std::string_view item : {manifest.Path1(i), manifest.Path2(i)}) {
+            std::wstring key = FolderKey(item);
+            if (auto it = folders.find(key); it != folders.end()) sets.Unite(pairFolder[i], it->second);
+            key += L'\\';
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(std::wstring_view(key), 0u));
+            for (; it != sorted.end() && it->first.starts_with(key); ++it) sets.Unite(pairFolder[i], it->second);
+        }
+    }
+
+    std::unordered_map<uint32_t, std::vector<uint64_t>> groups;  // Set -> its pairs in manifest order
+    for (size_t i = 0; i < pairCount; ++i) {
+        groups[sets.Find(pairFolder[i])].push_back(i);
+    }
+    std::vector<std::vector<uint64_t>*> largest;
+    largest.reserve(groups.size());
+    for (auto& [set, pairs] : groups) largest.push_back(&pairs);
+    std::sort(largest.begin(), largest.end(), [](const auto* a, const auto* b) { return a->size() > b->size(); });
+
+    // Each group goes to the shard with the fewest pairs so far
+    std::vector<std::vector<uint64_t>> shards((std::min)((std::max)(shardCount, size_t{1}), groups.size()));
+    using Load = std::pair<size_t, size_t>;  // Pairs, shard
+    std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+    for (size_t s = 0; s < shards.size(); ++s) loads.emplace(0, s);
+    for (const std::vector<uint64_t>* group : largest) {
+        auto [load, s] = loads.top();
+        loads.pop();
+        shards[s].insert(shards[s].end(), group->begin(), group->end());
+        loads.emplace(load + group->size(), s);
+    }
+    for (std::vector<uint64_t>& shard : shards) {
+        std::sort(shard.begin(), shard.end());
+    }
+    return shards;
+}
+
+PipeChannel::PipeChannel(HANDLE pipe, HANDLE process, bool overlapped)
+    : pipe_(pipe), process_(process), overlapped_(overlapped) {
+    if (overlapped_) event_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+}
+
+PipeChannel::~PipeChannel() {
+    CloseHandle(pipe_);  // A worker sees its pipe break and exits
+    if (process_) {
+        if (WaitForSingleObject(process_, kExitGraceMs) != WAIT_OBJECT_0) TerminateProcess(process_, 1);
+        CloseHandle(process_);
+    }
+    if (event_) CloseHandle(event_);
+}
+
+bool PipeChannel::Transfer(bool write, char* data, DWORD size, DWORD& done) {
+    done = 0;
+    if (!overlapped_) {
+        const BOOL ok = write ? WriteFile(pipe_, data, size, &done, nullptr) : ReadFile(pipe_, data, size, &done, nullptr);
+        return ok != FALSE;
+    }
+    OVERLAPPED ov = {};
+    ov.hEvent = event_;
+    const BOOL ok = write ? WriteFile(pipe_, data, size, nullptr, &ov) : ReadFile(pipe_, data, size, nullptr, &ov);
+    if (!ok && GetLastError() != ERROR_IO_PENDING) return false;
+    return GetOverlappedResult(pipe_, &ov, &done, TRUE) != FALSE;
+}
+
+bool PipeChannel::Send(std::string_view line) {
+    std::string data;
+    data.reserve(line.size() + 1);
+    data.append(line);
+    data += '\n';
+    for (size_t sent = 0; sent < data.size();) {
+        DWORD done = 0;
+        const DWORD chunk = static_cast<DWORD>((std::min)(data.size() - sent, size_t{kPipeBufferSize}));
+        if (!Transfer(true, data.data() + sent, chunk, done) || done == 0) return false;
+        sent += done;
+    }
+    return true;
+}
+
+bool PipeChannel::Receive(std::string& line) {
+    for (;;) {
+        const size_t newline = buffer_.find('\n', bufferStart_);
+        if (newline != std::string::npos) {
+            line.assign(buffer_, bufferStart_, newline - bufferStart_);
+            bufferStart_ = newline + 1;
+            return true;
+        }
+        buffer_.erase(0, bufferStart_);
+        bufferStart_ = 0;
+        const size_t used = buffer_.size();
+        buffer_.resize(used + kPipeBufferSize);
+        DWORD got = 0;
+        const bool ok = Transfer(false, buffer_.data() + used, kPipeBufferSize, got);
+        buffer_.resize(used + got);
+        if (!ok) return false;
+    }
+}
+
+std::unique_ptr<ShardChannel> LocalProcessTransport::Connect(size_t /*slot*/) {
+    wchar_t name[64];
+    swprintf_s(name, L"\\\\.\\pipe\\name_exchanger-%lu-%u", GetCurrentProcessId(), nextPipe_.fetch_add(1));
+    HANDLE pipe = CreateNamedPipeW(name, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                   PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1,
+                                   kPipeBufferSize, kPipeBufferSize, 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    std::wstring commandLine = commandLine_ + L" --shard-worker " + name;
+    STARTUPINFOW si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    if (!CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr, &si,
+                        &pi)) {
+        CloseHandle(pipe);
+        return nullptr;
+    }
+    CloseHandle(pi.hThread);
+    // From here on the channel owns the worker, and ends it if it never connects
+    auto channel = std::make_unique<PipeChannel>(pipe, pi.hProcess, true);
+
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    bool connected = ConnectNamedPipe(pipe, &ov) != FALSE;
+    const DWORD error = connected ? ERROR_SUCCESS : GetLastError();
+    if (error == ERROR_PIPE_CONNECTED) {
+        connected = true;
+    } else if (error == ERROR_IO_PENDING) {
+        // Wait for the worker to open its end, unless it exits first
+        HANDLE waits[2] = {ov.hEvent, pi.hProcess};
+        DWORD unused = 0;
+        if (WaitForMultipleObjects(2, waits, FALSE, kConnectTimeoutMs) == WAIT_OBJECT_0) {
+            connected = GetOverlappedResult(pipe, &ov, &unused, FALSE) != FALSE;
+        } else {
+            CancelIoEx(pipe, &ov);
+            GetOverlappedResult(pipe, &ov, &unused, TRUE);
+        }
+    }
+    CloseHandle(ov.hEvent);
+    if (!connected) {
+        return nullptr;
+    }
+    return channel;
+}
+
+std::wstring RunShardCoordinator(Vfs& vfs, const Manifest& manifest, bool preserveExt, size_t depth,
+                                 NameRules rules, ShardTransport& transport, size_t workers, int* exitCode) {
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<std::vector<uint64_t>> shards = ShardManifest(manifest, workers * kShardsPerWorker);
+    const size_t shardCount = shards.size();
+
+    struct WorkerStats {
+        size_t shards = 0;
+        size_t pairs = 0;
+        size_t starts = 0;
+    };
+    std::vector<WorkerStats> stats(workers);
+
+    std::mutex mutex;  // Guards everything below
+    std::condition_variable cv;
+    std::deque<std::vector<uint64_t>> queue(std::make_move_iterator(shards.begin()),
+                                            std::make_move_iterator(shards.end()));
+    size_t busy = 0;  // Shards a worker has right now
+    std::string out;
+    size_t lost = 0;
+    bool allSucceeded = true;
+
+    // Call with mutex held
+    auto report = [&](uint64_t pair, int code, int64_t micros) {
+        allSucceeded = allSucceeded && code == kResultSuccess;
+        AppendResultRecord(out, pair, manifest.Path1(pair), manifest.Path2(pair), code, micros);
+        if (out.size() >= kFlushThreshold) {
+            WriteUtf8ToStdout(out);
+            out.clear();
+        }
+    };
+
+    // Pairs whose new names the volume rejects are reported here and never reach a worker
+    std::vector<uint8_t> invalid(manifest.Size());
+    ParallelFor((manifest.Size() + kScreenChunk - 1) / kScreenChunk, [&](size_t chunk) {
+        const size_t end = (std::min)(manifest.Size(), (chunk + 1) * kScreenChunk);
+        for (size_t pair = chunk * kScreenChunk; pair < end; ++pair) {
+            invalid[pair] = CheckSwappedNames(manifest.Path1(pair), manifest.Path2(pair),
+                                              manifest.PreserveExt(pair).value_or(preserveExt),
+                                              rules) != kResultSuccess;
+        }
+    });
+    for (std::vector<uint64_t>& shard : queue) {
+        std::erase_if(shard, [&](uint64_t pair) {
+            if (invalid[pair]) report(pair, kResultInvalidPath, 0);
+            return invalid[pair] != 0;
+        });
+    }
+    std::erase_if(queue, [](const std::vector<uint64_t>& shard) { return shard.empty(); });
+
+    // Run a shard on a worker. False if the worker went away; the pairs it never started are left
+    // in left, the ones it had started are reported as lost.
+    auto runOnWorker = [&](ShardChannel& channel, const std::vector<uint64_t>& shard, std::vector<uint64_t>& left,
+                           WorkerStats& stat) {
+        std::string line = "S";
+        for (uint64_t pair : shard) {
+            line += ' ';
+            line += std::to_string(pair);
+        }
+        std::unordered_set<uint64_t> begun;
+        std::unordered_set<uint64_t> ended;
+        bool alive = channel.Send(line);
+        while (alive && channel.Receive(line)) {
+            int64_t values[3] = {};
+            if (line == "D") {
+                ++stat.shards;
+                return true;
+            }
+            if (line.starts_with("B ") && ParseNumbers(std::string_view(line).substr(2), values, 1) &&
+                static_cast<uint64_t>(values[0]) < manifest.Size()) {
+                begun.insert(static_cast<uint64_t>(values[0]));
+            } else if (line.starts_with("E ") && ParseNumbers(std::string_view(line).substr(2), values, 3) &&
+                       static_cast<uint64_t>(values[0]) < manifest.Size()) {
+                const auto pair = static_cast<uint64_t>(values[0]);
+                begun.erase(pair);
+                ended.insert(pair);
+                ++stat.pairs;
+                std::lock_guard<std::mutex> lock(mutex);
+                report(pair, static_cast<int>(values[1]), values[2]);
+            } else {
+                alive = false;  // Not speaking the protocol; treated like a worker that exited
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint64_t pair : begun) {
+            report(pair, kResultWorkerLost, 0);
+            ++lost;
+        }
+        for (uint64_t pair : shard) {
+            if (!begun.contains(pair) && !ended.contains(pair)) left.push_back(pair);
+        }
+        return false;
+    };
+
+    auto slot = [&](size_t w) {
+        std::unique_ptr<ShardChannel> channel;
+        for (;;) {
+            std::vector<uint64_t> shard;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !queue.empty() || busy == 0; });
+                if (queue.empty()) break;
+                shard = std::move(queue.front());
+                queue.pop_front();
+                ++busy;
+            }
+            while (!channel && stats[w].starts <= kMaxWorkerRestarts) {
+                ++stats[w].starts;
+                channel = transport.Connect(w);
+            }
+            std::vector<uint64_t> left;
+            if (!channel) {
+                left = std::move(shard);  // This slot is out; another worker, or this process, takes the shard
+            } else if (!runOnWorker(*channel, shard, left, stats[w])) {
+                channel.reset();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!left.empty()) queue.push_front(std::move(left));
+                --busy;
+            }
+            cv.notify_all();
+            if (!channel && stats[w].starts > kMaxWorkerRestarts) break;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back(slot, w);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    // Every slot gave up: run what is left here rather than fail the batch
+    size_t local = 0;
+    for (const std::vector<uint64_t>& shard : queue) {
+        local += shard.size();
+        RunShard(
+            vfs, manifest, preserveExt, depth, shard, [](uint64_t) { return true; },
+            [&](uint64_t pair, int code, int64_t micros) {
+                std::lock_guard<std::mutex> lock(mutex);
+                report(pair, code, micros);
+            });
+    }
+    if (!out.empty()) {
+        WriteUtf8ToStdout(out);
+    }
+    if (exitCode) *exitCode = allSucceeded ? 0 : 1;
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const auto& L = GetCurrentLocale();
+    std::wstring text;
+    wchar_t line[256];
+    swprintf_s(line, L.shardHeader, manifest.Size(), shardCount, workers, seconds,
+               static_cast<double>(manifest.Size()) / (std::max)(seconds, 1e-3));
+    text += line;
+    for (size_t w = 0; w < workers; ++w) {
+        swprintf_s(line, L.shardWorker, w + 1, stats[w].shards, stats[w].pairs,
+                   stats[w].starts > 0 ? stats[w].starts - 1 : 0);
+        text += L"\n";
+        text += line;
+    }
+    if (lost > 0) {
+        swprintf_s(line, L.shardLost, lost);
+        text += L"\n";
+        text += line;
+    }
+    if (local > 0) {
+        swprintf_s(line, L.shardLocal, local);
+        text += L"\n";
+        text += line;
+    }
+    return text;
+}
+
+int RunShardWorker(Vfs& vfs, const Manifest& manifest, bool preserveExt, size_t depth, const std::wstring& pipe) {
+    HANDLE handle = CreateFileW(pipe.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return 1;
+    }
+    PipeChannel channel(handle, nullptr, false);
+    std::mutex sendMutex;  // Pipeline workers report one at a time
+    const auto send = [&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        return channel.Send(message);
+    };
+
+    std::string line;
+    std::vector<uint64_t> pairs;
+    while (channel.Receive(line) && ParseShard(line, manifest, pairs)) {
+        // "B" is on its way to the coordinator before the swap starts, so a crash mid-swap is never
+        // mistaken for a pair that did not run
+        RunShard(
+            vfs, manifest, preserveExt, depth, pairs, [&](uint64_t pair) { return send("B " + std::to_string(pair)); },
+            [&](uint64_t pair, int code, int64_t micros) {
+                send("E " + std::to_string(pair) + " " + std::to_string(code) + " " + std::to_string(micros));
+            });
+        if (!send("D")) break;
+    }
+    return 0;
+}
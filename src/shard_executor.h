@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <windows.h>
+
+class Manifest;
+class Vfs;
+enum class NameRules : uint8_t;
+
+// Split the pairs of a manifest into at most shardCount shards, no two of which touch the same
+// folder: pairs are grouped by the folders they rename in (compared like FoldName), folders whose
+// own name a pair changes are grouped with everything below them, and the groups are spread over
+// the shards largest first. Each shard lists its pair indices in manifest order.
+std::vector<std::vector<uint64_t>> ShardManifest(const Manifest& manifest, size_t shardCount);
+
+// A connection to one worker, carrying whole lines in both directions:
+//   to the worker      "S <pair> <pair> ..."  run these manifest pairs in order
+//   from the worker    "B <pair>"             the pair's swap is about to start
+//                      "E <pair> <code> <us>" the pair finished with an exchange() code
+//                      "D"                    the shard is done
+// Closing the connection tells a worker to exit.
+class ShardChannel {
+public:
+    virtual ~ShardChannel() = default;
+
+    // Send one line (without its newline); false once the other side is gone
+    virtual bool Send(std::string_view line) = 0;
+    // Next line from the other side, without its newline; false once it is gone
+    virtual bool Receive(std::string& line) = 0;
+};
+
+// Starts workers and connects to them. The coordinator only exchanges lines with its workers, so
+// workers on other machines need nothing but another transport.
+class ShardTransport {
+public:
+    virtual ~ShardTransport() = default;
+
+    // Start a worker for slot and connect to it; nullptr if it could not be started
+    virtual std::unique_ptr<ShardChannel> Connect(size_t slot) = 0;
+};
+
+// One end of a named pipe. A coordinator's end also owns the worker process, which is ended with it.
+class PipeChannel final : public ShardChannel {
+public:
+    // overlapped: the pipe was opened for overlapped I/O
+    PipeChannel(HANDLE pipe, HANDLE process, bool overlapped);
+    PipeChannel(const PipeChannel&) = delete;
+    PipeChannel& operator=(const PipeChannel&) = delete;
+    ~PipeChannel() override;
+
+    bool Send(std::string_view line) override;
+    bool Receive(std::string& line) override;
+
+private:
+    bool Transfer(bool write, char* data, DWORD size, DWORD& done);
+
+    HANDLE pipe_;
+    HANDLE process_;
+    HANDLE event_ = nullptr;
+    bool overlapped_;
+    std::string buffer_;  // Received bytes not yet returned as a line
+    size_t bufferStart_ = 0;
+};
+
+// Workers as child processes of this one, each connected through its own named pipe
+class LocalProcessTransport final : public ShardTransport {
+public:
+    // Workers run commandLine (the coordinator's own) with "--shard-worker <pipe>" appended
+    explicit LocalProcessTransport(std::wstring commandLine) : commandLine_(std::move(commandLine)) {}
+
+    std::unique_ptr<ShardChannel> Connect(size_t slot) override;
+
+private:
+    std::wstring commandLine_;
+    std::atomic<uint32_t> nextPipe_{0};
+};
+
+// "--manifest <file> --workers <n>": hand the shards of the manifest to n workers, several shards
+// each, and write their results to stdout as RunStreamMode would. A worker that exits has the pairs
+// it never started handed to the next free worker (started again in its slot, up to a few times);
+// a pair it had started is reported as kResultWorkerLost, never swapped twice. Pairs no worker is
+// left for run in this process on vfs. Pairs whose new names break rules are reported as
+// kResultInvalidPath before any shard starts. Returns the readable summary: time, throughput and
+// the share of each worker. exitCode, if given, is set as RunStreamMode returns it.
+std::wstring RunShardCoordinator(Vfs& vfs, const Manifest& manifest, bool preserveExt, size_t depth,
+                                 NameRules rules, ShardTransport& transport, size_t workers,
+                                 int* exitCode = nullptr);
+
+// "--shard-worker <pipe>": connect to a coordinator and run the shards it sends on vfs, up to
+// depth pairs at a time, until it closes the pipe. Returns 0, or 1 if the pipe cannot be opened.
+int RunShardWorker(Vfs& vfs, const Manifest& manifest, bool preserveExt, size_t depth, const std::wstring& pipe);
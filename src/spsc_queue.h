@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Bounded lock-free single-producer / single-consumer ring buffer.
+// Push blocks while the ring is full, which is how backpressure travels upstream through a pipeline;
+// Pop blocks while it is empty and returns false once the producer has closed and the ring is drained.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool TryPush(T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        Signal(produced_, consumerWaiting_);
+        return true;
+    }
+
+    std::optional<T> TryPop() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(slots_[head & mask_]));
+        head_.store(head + 1, std::memory_order_release);
+        Signal(consumed_, producerWaiting_);
+        return value;
+    }
+
+    void Push(T value) {
+        for (int spin = 0; !TryPush(value); ++spin) {
+            if (spin < kSpinCount) {
+                continue;
+            }
+            // Announce the wait before the final re-check so the consumer cannot miss it
+            producerWaiting_.store(true);
+            const uint32_t seen = consumed_.load();
+            if (!TryPush(value)) {
+                consumed_.wait(seen);
+                producerWaiting_.store(false);
+                continue;
+            }
+            producerWaiting_.store(false);
+            return;
+        }
+    }
+
+    bool Pop(T& out) {
+        for (int spin = 0;; ++spin) {
+            if (auto value = TryPop()) {
+                out = std::move(*value);
+                return true;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                // Re-check: the producer may have pushed right before closing
+                if (auto value = TryPop()) {
+                    out = std::move(*value);
+                    return true;
+                }
+                return false;
+            }
+            if (spin < kSpinCount) {
+                continue;
+            }
+            consumerWaiting_.store(true);
+            const uint32_t seen = produced_.load();
+            if (Empty() && !closed_.load()) {
+                produced_.wait(seen);
+            }
+            consumerWaiting_.store(false);
+        }
+    }
+
+    // Called by the producer after its last Push
+    void Close() {
+        closed_.store(true);
+        produced_.fetch_add(1);
+        produced_.notify_one();
+    }
+
+    bool Empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr int kSpinCount = 64;
+
+    // Wake the other side only when it has parked; the fence pairs with the waiter's
+    // flag store so either the waiter sees the new index or we see its flag.
+    static void Signal(std::atomic<uint32_t>& counter, const std::atomic<bool>& waiting) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) {
+            counter.fetch_add(1);
+            counter.notify_one();
+        }
+    }
+
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::atomic<uint32_t> produced_{0};
+    alignas(64) std::atomic<uint32_t> consumed_{0};
+    std::atomic<bool> producerWaiting_{false};
+    std::atomic<bool> consumerWaiting_{false};
+    std::atomic<bool> closed_{false};
+};
@@ -0,0 +1,352 @@
+#include "stream_mode.h"
+
+#include "checkpoint.h"
+#include "exchange.h"
+#include "i18n.h"
+#include "jsonl.h"
+#include "manifest.h"
+#include "name_rules.h"
+#include "plan.h"
+#include "spsc_queue.h"
+#include "swap_pipeline.h"
+#include "swap_queue.h"
+#include "utils.h"
+#include "vfs.h"
+
+#include <windows.h>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+constexpr size_t kQueueDepth = 1024;
+constexpr DWORD kReadChunk = 64 * 1024;
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+struct StreamPair {
+    uint64_t seq = 0;
+    std::string path1;
+    std::string path2;
+    bool preserveExt = true;
+    int code = kResultSuccess;  // Set by validation (or a plan); execution only runs while it is still success
+    int64_t micros = 0;
+};
+
+using PairQueue = SpscQueue<StreamPair>;
+
+// Stage 1: split stdin into records and group them into pairs.
+// The delimiter is whichever of NUL or newline shows up first in the stream. Input whose first
+// record is kPlanHeader is a plan written by --plan instead: one record per line, each holding a
+// whole pair.
+void ReadPairs(PairQueue& out, bool preserveExt) {
+    HANDLE hIn = GetStdHandle(STD_INPUT_HANDLE);
+    std::vector<char> buf(kReadChunk);
+    std::string pending;
+    std::string first;
+    bool haveFirst = false;
+    char delim = '\0';
+    bool delimKnown = false;
+    bool firstRecord = true;
+    bool planInput = false;
+    uint64_t seq = 0;
+
+    auto emitRecord = [&](std::string&& record) {
+        if (delim == '\n') {
+            if (!record.empty() && record.back() == '\r') record.pop_back();
+            if (record.empty()) return;  // Tolerate blank lines in text input
+        }
+        if (firstRecord) {
+            firstRecord = false;
+            planInput = record == kPlanHeader;
+            if (planInput) return;
+        }
+        if (planInput) {
+            // Skipped pairs keep the plan's code and are reported without running
+            PlanRecord planned;
+            StreamPair pair;
+            pair.seq = seq++;
+            if (ParsePlanRecord(record, planned)) {
+                pair.path1 = std::move(planned.path1);
+                pair.path2 = std::move(planned.path2);
+                pair.preserveExt = planned.preserveExt;
+                pair.code = planned.code;
+            } else {
+                pair.path1 = std::move(record);
+                pair.code = kResultInvalidPath;
+            }
+            out.Push(std::move(pair));
+            return;
+        }
+        if (!haveFirst) {
+            first = std::move(record);
+            haveFirst = true;
+            return;
+        }
+        StreamPair pair;
+        pair.seq = seq++;
+        pair.path1 = std::move(first);
+        pair.path2 = std::move(record);
+        pair.preserveExt = preserveExt;
+        haveFirst = false;
+        out.Push(std::move(pair));
+    };
+
+    DWORD got = 0;
+    while (hIn && hIn != INVALID_HANDLE_VALUE && ReadFile(hIn, buf.data(), kReadChunk, &got, nullptr) && got > 0) {
+        const char* data = buf.data();
+        size_t start = 0;
+        if (!delimKnown) {
+            for (size_t i = 0; i < got; ++i) {
+                if (data[i] == '\0' || data[i] == '\n') {
+                    delim = data[i];
+                    delimKnown = true;
+                    break;
+                }
+            }
+        }
+        if (delimKnown) {
+            while (const void* hit = std::memchr(data + start, delim, got - start)) {
+                const size_t end = static_cast<size_t>(static_cast<const char*>(hit) - data);
+                pending.append(data + start, end - start);
+                emitRecord(std::move(pending));
+                pending.clear();
+                start = end + 1;
+            }
+        }
+        pending.append(data + start, got - start);
+    }
+
+    if (!pending.empty()) {
+        emitRecord(std::move(pending));
+    }
+    if (haveFirst) {
+        // Unpaired trailing record; validation reports it as an invalid path
+        StreamPair pair;
+        pair.seq = seq;
+        pair.path1 = std::move(first);
+        out.Push(std::move(pair));
+    }
+    out.Close();
+}
+
+// Stage 1 for --manifest: pairs are already indexed in the mapping; only the ones handed to the
+// pipeline are copied out, a queue's worth at a time. Pairs a checkpoint has as done are skipped;
+// the ones it could not settle are reported with their code first.
+void ReadManifestPairs(const Manifest& manifest, bool preserveExt, PairQueue& out,
+                       const Checkpoint* checkpoint = nullptr,
+                       const std::vector<std::pair<uint64_t, int>>& settled = {}) {
+    for (const auto& [i, code] : settled) {
+        StreamPair pair;
+        pair.seq = i;
+        pair.path1.assign(manifest.Path1(i));
+        pair.path2.assign(manifest.Path2(i));
+        pair.code = code;
+        out.Push(std::move(pair));
+    }
+    for (size_t i = 0; i < manifest.Size(); ++i) {
+        if (checkpoint && checkpoint->Done(i)) continue;
+        StreamPair pair;
+        pair.seq = i;
+        pair.path1.assign(manifest.Path1(i));
+        pair.path2.assign(manifest.Path2(i));
+        pair.preserveExt = manifest.PreserveExt(i).value_or(preserveExt);
+        out.Push(std::move(pair));
+    }
+    out.Close();
+}
+
+// Syntactic checks only; existence is probed inside the pipeline where round trips overlap
+int Validate(const StreamPair& pair, NameRules rules) {
+    if (pair.path1.empty() || pair.path2.empty()) {
+        return kResultInvalidPath;
+    }
+    return CheckSwappedNames(pair.path1, pair.path2, pair.preserveExt, rules);
+}
+
+// Stage 2: reject pairs that cannot succeed without touching the swap engine
+void ValidatePairs(PairQueue& in, PairQueue& out, NameRules rules) {
+    StreamPair pair;
+    while (in.Pop(pair)) {
+        if (pair.code == kResultSuccess) pair.code = Validate(pair, rules);
+        out.Push(std::move(pair));
+    }
+    out.Close();
+}
+
+// Stage 3: probe and swap, keeping up to `depth` pairs in flight. Pairs that share a path still
+// run in input order; unrelated pairs may finish, and be reported, out of order.
+// With a checkpoint, each swap is recorded in it while in flight and marked once it succeeded.
+void ExecutePairs(PairQueue& in, PairQueue& out, Vfs& vfs, size_t depth, Checkpoint* checkpoint) {
+    std::mutex outMutex;  // Pipeline workers take turns as the single producer of `out`
+    std::unordered_map<uint64_t, StreamPair> inFlight;
+
+    auto run = [&vfs, checkpoint](uint64_t seq, const std::string& path1, const std::string& path2, bool preserve) {
+        for (const std::string* path : {&path1, &path2}) {
+            const int code = vfs.Probe(*path);
+            if (code != kResultSuccess) return code;
+        }
+        if (!checkpoint) return vfs.Exchange(path1, path2, preserve);
+        const size_t slot = checkpoint->Begin(seq, path1, preserve);
+        const int code = vfs.Exchange(path1, path2, preserve);
+        checkpoint->End(slot, seq, code == kResultSuccess);
+        return code;
+    };
+    auto complete = [&](uint64_t seq, int code, int64_t micros) {
+        std::lock_guard<std::mutex> lock(outMutex);
+        auto it = inFlight.find(seq);
+        StreamPair pair = std::move(it->second);
+        inFlight.erase(it);
+        pair.code = code;
+        pair.micros = micros;
+        out.Push(std::move(pair));
+    };
+
+    {
+        SwapPipeline pipeline(depth, run, complete);
+        StreamPair pair;
+        while (in.Pop(pair)) {
+            if (pair.code != kResultSuccess) {
+                std::lock_guard<std::mutex> lock(outMutex);
+                out.Push(std::move(pair));
+                continue;
+            }
+            const uint64_t seq = pair.seq;
+            const bool preserveExt = pair.preserveExt;
+            std::string path1 = pair.path1;
+            std::string path2 = pair.path2;
+            {
+                std::lock_guard<std::mutex> lock(outMutex);
+                inFlight.emplace(seq, std::move(pair));
+            }
+            // Not under outMutex: Submit may block on a full window until workers complete pairs
+            pipeline.Submit(seq, std::move(path1), std::move(path2), preserveExt);
+        }
+        pipeline.Finish();
+    }
+    out.Close();
+}
+
+// Stage 4: serialize results as JSON lines. Output is flushed whenever the stage runs dry,
+// so the first result is visible as soon as it exists.
+int WriteResults(PairQueue& in) {
+    std::string buf;
+    bool allSucceeded = true;
+
+    auto flush = [&]() {
+        if (!buf.empty()) {
+            WriteUtf8ToStdout(buf);
+        }
+        buf.clear();
+    };
+
+    StreamPair pair;
+    while (in.Pop(pair)) {
+        allSucceeded = allSucceeded && pair.code == kResultSuccess;
+        AppendResultRecord(buf, pair.seq, pair.path1, pair.path2, pair.code, pair.micros);
+        if (buf.size() >= kFlushThreshold || in.Empty()) {
+            flush();
+        }
+    }
+    flush();
+    return allSucceeded ? 0 : 1;
+}
+}  // namespace
+
+void AppendResultRecord(std::string& out, uint64_t seq, std::string_view path1, std::string_view path2, int code,
+                        int64_t micros) {
+    out += "{\"seq\":";
+    out += std::to_string(seq);
+    out += ",\"path1\":";
+    AppendJsonString(out, path1);
+    out += ",\"path2\":";
+    AppendJsonString(out, path2);
+    out += ",\"code\":";
+    out += std::to_string(code);
+    out += ",\"message\":";
+    AppendJsonString(out, GetOutputInfo(code));
+    out += ",\"us\":";
+    out += std::to_string(micros);
+    out += "}\n";
+}
+
+int RunStreamMode(Vfs& vfs, bool preserveExt, size_t depth, NameRules rules, const Manifest* manifest,
+                  Checkpoint* checkpoint) {
+    // Settle what an interrupted run left in flight before anything else touches those pairs
+    std::vector<std::pair<uint64_t, int>> settled;
+    if (manifest && checkpoint) settled = checkpoint->Recover(*manifest);
+
+    PairQueue parsed(kQueueDepth);
+    PairQueue validated(kQueueDepth);
+    PairQueue executed(kQueueDepth);
+    int exitCode = 0;
+
+    std::thread validator(ValidatePairs, std::ref(parsed), std::ref(validated), rules);
+    std::thread executor(ExecutePairs, std::ref(validated), std::ref(executed), std::ref(vfs), depth,
+                         manifest ? checkpoint : nullptr);
+    std::thread writer([&]() { exitCode = WriteResults(executed); });
+
+    if (manifest) {
+        ReadManifestPairs(*manifest, preserveExt, parsed, checkpoint, settled);
+    } else {
+        ReadPairs(parsed, preserveExt);
+    }
+
+    validator.join();
+    executor.join();
+    writer.join();
+    return exitCode;
+}
+
+std::wstring RunPlanMode(bool preserveExt, const PlanOptions& options, const Manifest* manifest, int* exitCode) {
+    // Collect the whole batch first: the collision screen needs every pair
+    PairQueue parsed(kQueueDepth);
+    SwapBatch batch;  // Paths interned as they arrive; a batch of millions shares its folders
+    std::vector<int> given;  // Codes of pairs a plan given as input already skips
+    std::thread collector([&]() {
+        StreamPair pair;
+        while (parsed.Pop(pair)) {
+            batch.Add(pair.path1, pair.path2, pair.preserveExt);
+            given.push_back(pair.code);
+        }
+    });
+    if (manifest) {
+        ReadManifestPairs(*manifest, preserveExt, parsed);
+    } else {
+        ReadPairs(parsed, preserveExt);
+    }
+    collector.join();
+
+    const std::vector<SwapEntry>& entries = batch.entries;
+    Plan plan = BuildPlan(batch.paths, entries, options);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (given[i] != kResultSuccess) {
+            plan.pairs[i] = PlannedPair{PlanStrategy::Skip, given[i], 0.0};
+        }
+    }
+
+    std::string buf(kPlanHeader);
+    buf += '\n';
+    bool allRun = true;
+    PathReader reader1(batch.paths);
+    PathReader reader2(batch.paths);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const SwapEntry& entry = entries[i];
+        allRun = allRun && plan.pairs[i].code == kResultSuccess;
+        AppendPlanRecord(buf, i, reader1.Read(entry.path1), reader2.Read(entry.path2), entry.preserveExt,
+                         plan.pairs[i]);
+        if (buf.size() >= kFlushThreshold) {
+            WriteUtf8ToStdout(buf);
+            buf.clear();
+        }
+    }
+    if (!buf.empty()) {
+        WriteUtf8ToStdout(buf);
+    }
+    if (exitCode) *exitCode = allRun ? 0 : 1;
+    return DescribePlan(plan, options);
+}
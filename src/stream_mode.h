@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class Checkpoint;
+class Manifest;
+class Vfs;
+enum class NameRules : uint8_t;
+struct PlanOptions;
+
+// Streaming mode ("name_exchanger - [preserve]"): read NUL- or newline-delimited path pairs from stdin
+// and swap them as they arrive. Parsing, validation, execution and output run as overlapped stages
+// connected by bounded queues, so a slow consumer of stdout throttles the whole pipeline.
+// Execution keeps up to `depth` independent pairs in flight on vfs. Pairs whose new names break
+// rules are reported without running.
+// One JSON object per pair is written to stdout. Returns 0 when every pair succeeded, 1 otherwise.
+// The input may also be a plan written by --plan (it starts with kPlanHeader); its pairs run with
+// their own preserve flag.
+// With a manifest (--manifest), its pairs are the input instead of stdin. A checkpoint opened for
+// that manifest (--checkpoint) skips the pairs it has as done and records the ones that finish.
+int RunStreamMode(Vfs& vfs, bool preserveExt, size_t depth, NameRules rules, const Manifest* manifest = nullptr,
+                  Checkpoint* checkpoint = nullptr);
+
+// Append one result as RunStreamMode writes it:
+// {"seq":0,"path1":"a.txt","path2":"b.txt","code":0,"message":"Success","us":412}
+void AppendResultRecord(std::string& out, uint64_t seq, std::string_view path1, std::string_view path2, int code,
+                        int64_t micros);
+
+// "name_exchanger - [preserve] --plan": read pairs like RunStreamMode, but only plan them (see
+// BuildPlan). kPlanHeader and one plan record per pair go to stdout; returns the readable summary.
+// exitCode, if given, is set to 0 when every pair would run and 1 when the plan skips any.
+std::wstring RunPlanMode(bool preserveExt, const PlanOptions& options, const Manifest* manifest = nullptr,
+                         int* exitCode = nullptr);
@@ -0,0 +1,144 @@
+#include "swap_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+std::filesystem::path WidePath(const std::string& utf8) {
+    const std::u8string_view text(reinterpret_cast<const char8_t*>(utf8.data()), utf8.size());
+    return std::filesystem::path(text).lexically_normal();
+}
+
+// Both paths, plus every path exchange() may move an item to: the other item's name in the
+// item's own folder, or with preserveExt the other's stem with the item's extension. Folder and
+// name are folded apart, as MakeSide in collision_index.cpp keys them. Directories keep no
+// extension but the disk is not asked here, so both names are claimed then.
+std::vector<std::wstring> JobKeys(const std::string& path1, const std::string& path2, bool preserveExt,
+                                  SwapPipeline::KeyFold fold) {
+    const std::filesystem::path paths[2] = {WidePath(path1), WidePath(path2)};
+    std::vector<std::wstring> keys;
+    keys.reserve(6);
+    for (int i = 0; i < 2; ++i) {
+        const std::filesystem::path& self = paths[i];
+        const std::filesystem::path& other = paths[1 - i];
+        const std::wstring dirKey = fold(self.parent_path().wstring()) + L'\\';
+        keys.push_back(dirKey + fold(self.filename().wstring()));
+        keys.push_back(dirKey + fold(other.filename().wstring()));
+        if (preserveExt && self.extension() != other.extension()) {
+            keys.push_back(dirKey + fold(other.stem().wstring() + self.extension().wstring()));
+        }
+    }
+    return keys;
+}
+}  // namespace
+
+SwapPipeline::SwapPipeline(size_t depth, Executor executor, Completion completion, KeyFold fold)
+    : executor_(std::move(executor)),
+      completion_(std::move(completion)),
+      fold_(fold),
+      window_((std::max)(depth, size_t{1}) * 4) {
+    depth = (std::max)(depth, size_t{1});
+    workers_.reserve(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        workers_.emplace_back(&SwapPipeline::WorkerLoop, this);
+    }
+}
+
+void SwapPipeline::Submit(uint64_t ticket, std::string path1, std::string path2, bool preserveExt) {
+    Job job;
+    job.ticket = ticket;
+    job.keys = JobKeys(path1, path2, preserveExt, fold_);
+    job.path1 = std::move(path1);
+    job.path2 = std::move(path2);
+    job.preserveExt = preserveExt;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    spaceCv_.wait(lock, [this] { return waiting_.size() < window_ || cancelled_; });
+    if (cancelled_) {
+        return;
+    }
+    waiting_.push_back(std::move(job));
+    workCv_.notify_one();
+}
+
+void SwapPipeline::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    workCv_.notify_all();
+    Join();
+}
+
+std::vector<uint64_t> SwapPipeline::Cancel() {
+    std::vector<uint64_t> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        for (const Job& job : waiting_) dropped.push_back(job.ticket);
+        waiting_.clear();
+    }
+    workCv_.notify_all();
+    spaceCv_.notify_all();
+    Join();
+    return dropped;
+}
+
+void SwapPipeline::Join() {
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+// Pick the oldest waiting job whose keys are neither running nor claimed by an older waiting job
+bool SwapPipeline::TakeRunnable(Job& job) {
+    std::unordered_set<std::wstring_view> claimed;
+    for (auto it = waiting_.begin(); it != waiting_.end(); ++it) {
+        const bool free = std::none_of(it->keys.begin(), it->keys.end(), [&](const std::wstring& key) {
+            return busy_.count(key) || claimed.count(key);
+        });
+        if (free) {
+            job = std::move(*it);
+            waiting_.erase(it);
+            for (const std::wstring& key : job.keys) ++busy_[key];
+            return true;
+        }
+        claimed.insert(it->keys.begin(), it->keys.end());
+    }
+    return false;
+}
+
+void SwapPipeline::WorkerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                if (cancelled_) return;
+                if (TakeRunnable(job)) break;
+                if (closing_ && waiting_.empty()) return;
+                workCv_.wait(lock);
+            }
+        }
+        spaceCv_.notify_one();
+
+        const auto start = std::chrono::steady_clock::now();
+        const int code = executor_(job.ticket, job.path1, job.path2, job.preserveExt);
+        const auto micros =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        completion_(job.ticket, code, micros);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const std::wstring& key : job.keys) {
+                auto it = busy_.find(key);
+                if (--it->second == 0) busy_.erase(it);
+            }
+        }
+        // Jobs queued behind these paths may be runnable now, and so may finishing workers
+        workCv_.notify_all();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "name_fold.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Runs up to `depth` swaps at once so that independent pairs overlap their metadata round trips
+// (each one costs milliseconds on a remote share). Two pairs still run one after the other in
+// submission order when they share a path or when one of them takes a name the other holds or
+// takes, e.g. (D\old.txt, E\new.txt) frees D\old.txt for (D\c.bin, F\old.txt). Paths and names
+// are compared as FindNameCollisions compares them: normalized, then folded with FoldName.
+// With depth 1 every swap runs in submission order, as a plain loop would.
+class SwapPipeline {
+public:
+    // Runs one pair on a worker thread; returns an exchange() code
+    using Executor =
+        std::function<int(uint64_t ticket, const std::string& path1, const std::string& path2, bool preserveExt)>;
+    // Called on the worker thread once a pair finished, before pairs waiting on its paths may start
+    using Completion = std::function<void(uint64_t ticket, int code, int64_t micros)>;
+
+    // Folds a folder or file name into the key every spelling of the same entry shares
+    using KeyFold = std::wstring (*)(std::wstring_view text);
+
+    // fold is FoldName except in tests, which may not have the Windows case tables
+    SwapPipeline(size_t depth, Executor executor, Completion completion, KeyFold fold = FoldName);
+    SwapPipeline(const SwapPipeline&) = delete;
+    SwapPipeline& operator=(const SwapPipeline&) = delete;
+    ~SwapPipeline() { Finish(); }
+
+    // Queue a pair. Blocks while the look-ahead window (4 x depth waiting pairs) is full.
+    void Submit(uint64_t ticket, std::string path1, std::string path2, bool preserveExt);
+
+    // Run everything submitted so far to completion and stop the workers
+    void Finish();
+
+    // Drop pairs that have not started, wait for the running ones and stop the workers.
+    // Returns the tickets of the dropped pairs; their completion is never called.
+    std::vector<uint64_t> Cancel();
+
+private:
+    struct Job {
+        uint64_t ticket = 0;
+        std::string path1;
+        std::string path2;
+        bool preserveExt = true;
+        std::vector<std::wstring> keys;  // Folded paths and new names used for conflict detection
+    };
+
+    void WorkerLoop();
+    bool TakeRunnable(Job& job);
+    void Join();
+
+    Executor executor_;
+    Completion completion_;
+    KeyFold fold_;
+    size_t window_;
+
+    std::mutex mutex_;
+    std::condition_variable workCv_;   // A job was queued or a path was released
+    std::condition_variable spaceCv_;  // A waiting job started
+    std::deque<Job> waiting_;
+    std::unordered_map<std::wstring, int> busy_;  // Keys of running jobs
+    bool closing_ = false;
+    bool cancelled_ = false;
+    std::vector<std::thread> workers_;
+};
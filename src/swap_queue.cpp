@@ -0,0 +1,226 @@
+#include "swap_queue.h"
+
+#include "exchange.h"
+#include "swap_pipeline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+namespace {
+// Whether a run started with autoRunOnly takes entry
+bool Runnable(const SwapEntry& entry, bool autoRunOnly) {
+    return entry.state == SwapState::Pending && (entry.autoRun || !autoRunOnly);
+}
+
+// Give entry its interned paths; a pair the store could not hold fails with kResultInvalidPath
+// rather than running on an empty path
+void SetPaths(SwapEntry& entry, std::optional<PathRef> path1, std::optional<PathRef> path2) {
+    entry.path1 = path1.value_or(PathRef{});
+    entry.path2 = path2.value_or(PathRef{});
+    if (!path1 || !path2) {
+        entry.state = SwapState::Failed;
+        entry.code = kResultInvalidPath;
+    }
+}
+}  // namespace
+
+void SwapBatch::Add(std::string_view path1, std::string_view path2, bool preserveExt) {
+    SwapEntry& entry = entries.emplace_back();
+    SetPaths(entry, paths.Intern(path1), paths.Intern(path2));
+    entry.preserveExt = preserveExt;
+}
+
+void SwapBatch::Append(const SwapBatch& other) {
+    entries.reserve(entries.size() + other.entries.size());
+    for (SwapEntry entry : other.entries) {
+        SetPaths(entry, paths.Import(other.paths, entry.path1), paths.Import(other.paths, entry.path2));
+        entries.push_back(entry);
+    }
+}
+
+void SwapQueue::Add(std::string_view path1, std::string_view path2, bool preserveExt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SwapEntry entry;
+    SetPaths(entry, paths_.Intern(path1), paths_.Intern(path2));
+    entry.preserveExt = preserveExt;
+    entries_.push_back(entry);
+    counts_[static_cast<size_t>(entry.state)].fetch_add(1, std::memory_order_relaxed);
+    layoutRevision_.fetch_add(1, std::memory_order_release);
+    revision_.fetch_add(1, std::memory_order_release);
+}
+
+void SwapQueue::AddBatch(SwapBatch batch, bool autoRun) {
+    if (batch.entries.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // An idle empty queue takes the batch's store as it is; nothing refers to the old one
+    const bool adopt = entries_.empty() && !running_.load(std::memory_order_acquire);
+    if (adopt) {
+        paths_ = std::move(batch.paths);
+    }
+    entries_.reserve(entries_.size() + batch.entries.size());
+    for (SwapEntry entry : batch.entries) {
+        if (!adopt) {
+            SetPaths(entry, paths_.Import(batch.paths, entry.path1), paths_.Import(batch.paths, entry.path2));
+        }
+        // Pairs that could not be interned stay failed; the rest start out pending
+        if (entry.state != SwapState::Failed) entry.state = SwapState::Pending;
+        entry.autoRun = autoRun;
+        entries_.push_back(entry);
+        counts_[static_cast<size_t>(entry.state)].fetch_add(1, std::memory_order_relaxed);
+    }
+    layoutRevision_.fetch_add(1, std::memory_order_release);
+    revision_.fetch_add(1, std::memory_order_release);
+}
+
+void SwapQueue::Run(Executor executor, size_t depth, Screener screener, bool autoRunOnly) {
+    std::lock_guard<std::mutex> runLock(runMutex_);
+    {
+        // The worker clears running_ under mutex_ once it finds nothing pending, so an entry
+        // added before this check is either seen by the running worker or by a new one
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_.load(std::memory_order_acquire)) {
+            return;
+        }
+        running_.store(true, std::memory_order_release);
+    }
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    stop_.store(false, std::memory_order_release);
+    worker_ =
+        std::thread(&SwapQueue::WorkerLoop, this, std::move(executor), depth, std::move(screener), autoRunOnly);
+}
+
+void SwapQueue::Stop() {
+    std::lock_guard<std::mutex> runLock(runMutex_);
+    stop_.store(true, std::memory_order_release);
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void SwapQueue::ClearFinished() {
+    // Checked under the lock: Run sets running_ under it, and the worker reads paths_ outside it
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [](const SwapEntry& e) {
+                                      return e.state == SwapState::Done || e.state == SwapState::Failed;
+                                  }),
+                   entries_.end());
+    // The store only grows; moving the remaining paths to a new one frees the rest
+    PathStore kept;
+    size_t failed = 0;
+    for (SwapEntry& entry : entries_) {
+        SetPaths(entry, kept.Import(paths_, entry.path1), kept.Import(paths_, entry.path2));
+        failed += entry.state == SwapState::Failed;
+    }
+    paths_ = std::move(kept);
+    counts_[static_cast<size_t>(SwapState::Pending)].fetch_sub(failed, std::memory_order_relaxed);
+    counts_[static_cast<size_t>(SwapState::Done)].store(0, std::memory_order_relaxed);
+    counts_[static_cast<size_t>(SwapState::Failed)].store(failed, std::memory_order_relaxed);
+    layoutRevision_.fetch_add(1, std::memory_order_release);
+    revision_.fetch_add(1, std::memory_order_release);
+}
+
+void SwapQueue::SetState(SwapEntry& entry, SwapState state) {
+    counts_[static_cast<size_t>(entry.state)].fetch_sub(1, std::memory_order_relaxed);
+    counts_[static_cast<size_t>(state)].fetch_add(1, std::memory_order_relaxed);
+    entry.state = state;
+    revision_.fetch_add(1, std::memory_order_release);
+}
+
+// Run the screener over a snapshot of the runnable entries from `from` on, outside the lock, and
+// fail the rejected ones. Returns the end of the screened range; later entries wait for a round.
+size_t SwapQueue::Screen(const Screener& screener, size_t from, bool autoRunOnly) {
+    std::vector<SwapEntry> snapshot;
+    std::vector<size_t> indices;
+    size_t end = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end = entries_.size();
+        for (size_t i = from; i < end; ++i) {
+            if (Runnable(entries_[i], autoRunOnly)) {
+                snapshot.push_back(entries_[i]);
+                indices.push_back(i);
+            }
+        }
+    }
+    if (snapshot.empty()) {
+        return end;
+    }
+
+    const std::vector<int> codes = screener(paths_, snapshot);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t k = 0; k < indices.size() && k < codes.size(); ++k) {
+        SwapEntry& entry = entries_[indices[k]];
+        if (codes[k] != kResultSuccess && entry.state == SwapState::Pending) {
+            entry.code = codes[k];
+            SetState(entry, SwapState::Failed);
+        }
+    }
+    return end;
+}
+
+void SwapQueue::WorkerLoop(Executor executor, size_t depth, Screener screener, bool autoRunOnly) {
+    auto complete = [this](uint64_t index, int code, int64_t /*micros*/) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[index].code = code;
+        SetState(entries_[index], code == kResultSuccess ? SwapState::Done : SwapState::Failed);
+    };
+    auto run = [&executor](uint64_t /*index*/, const std::string& path1, const std::string& path2, bool preserveExt) {
+        return executor(path1, path2, preserveExt);
+    };
+
+    size_t i = 0;
+    for (;;) {
+        const size_t roundEnd = screener ? Screen(screener, i, autoRunOnly) : SIZE_MAX;
+        SwapPipeline pipeline(depth, run, complete);
+        while (!stop_.load(std::memory_order_acquire)) {
+            std::string path1;
+            std::string path2;
+            bool preserveExt = true;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const size_t end = (std::min)(entries_.size(), roundEnd);
+                while (i < end && !Runnable(entries_[i], autoRunOnly)) {
+                    ++i;
+                }
+                if (i >= end) {
+                    break;
+                }
+                SetState(entries_[i], SwapState::Running);
+                paths_.Path(entries_[i].path1, path1);
+                paths_.Path(entries_[i].path2, path2);
+                preserveExt = entries_[i].preserveExt;
+            }
+            pipeline.Submit(i++, std::move(path1), std::move(path2), preserveExt);
+        }
+
+        if (stop_.load(std::memory_order_acquire)) {
+            const std::vector<uint64_t> dropped = pipeline.Cancel();
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (uint64_t index : dropped) {
+                SetState(entries_[index], SwapState::Pending);
+            }
+            running_.store(false, std::memory_order_release);
+            return;
+        }
+        pipeline.Finish();
+
+        // Entries added while the pipeline drained get another round; otherwise we are done
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (i < entries_.size() && !Runnable(entries_[i], autoRunOnly)) {
+            ++i;
+        }
+        if (i >= entries_.size()) {
+            running_.store(false, std::memory_order_release);
+            return;
+        }
+    }
+}
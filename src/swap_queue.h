@@ -0,0 +1,107 @@
+#pragma once
+
+#include "path_store.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class SwapState : uint8_t {
+    Pending,
+    Running,
+    Done,
+    Failed,
+};
+
+// A pair whose paths live in a PathStore (the queue's, or a SwapBatch's)
+struct SwapEntry {
+    PathRef path1;
+    PathRef path2;
+    bool preserveExt = true;
+    bool autoRun = false;  // Queued to run on its own (by a watch rule) rather than on Start
+    SwapState state = SwapState::Pending;
+    int code = 0;  // exchange() code once Done/Failed
+};
+
+// Pairs gathered by a producer (a rule scan, the watch thread, a plan) together with their paths
+struct SwapBatch {
+    PathStore paths;
+    std::vector<SwapEntry> entries;
+
+    void Add(std::string_view path1, std::string_view path2, bool preserveExt);
+    // Append the pairs of another batch, re-interning their paths here
+    void Append(const SwapBatch& other);
+};
+
+// Pairs waiting to be swapped, fed in insertion order through a SwapPipeline by a background worker.
+// Entries are only ever appended while the worker runs, so indices stay stable.
+class SwapQueue {
+public:
+    using Executor = std::function<int(const std::string&, const std::string&, bool)>;
+    // Looks at the pending entries before they run; returns one code per entry, and entries
+    // given anything but kResultSuccess fail with that code without being executed
+    using Screener = std::function<std::vector<int>(const PathStore&, const std::vector<SwapEntry>&)>;
+
+    SwapQueue() = default;
+    SwapQueue(const SwapQueue&) = delete;
+    SwapQueue& operator=(const SwapQueue&) = delete;
+    ~SwapQueue() { Stop(); }
+
+    void Add(std::string_view path1, std::string_view path2, bool preserveExt);
+
+    // Append several entries under a single lock, marked autoRun if given
+    void AddBatch(SwapBatch batch, bool autoRun = false);
+
+    // Start executing every pending entry, or with autoRunOnly only the autoRun ones, up to depth at
+    // once; matching entries added meanwhile are picked up too. Each round of them is passed through
+    // screener first, if one is given. Safe to call from any thread; a call while the worker is busy
+    // is a no-op.
+    void Run(Executor executor, size_t depth = 1, Screener screener = nullptr, bool autoRunOnly = false);
+
+    // Ask the worker to finish the pairs in flight and wait for it; unstarted ones return to Pending
+    void Stop();
+
+    // Drop done and failed entries, and the paths only they used; ignored while the worker runs
+    void ClearFinished();
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    bool Empty() const { return Count(SwapState::Pending) + Count(SwapState::Running) + Finished() == 0; }
+    size_t Count(SwapState state) const { return counts_[static_cast<size_t>(state)].load(std::memory_order_relaxed); }
+    size_t Finished() const { return Count(SwapState::Done) + Count(SwapState::Failed); }
+
+    // Bumped whenever any entry changes state, is added or removed
+    uint64_t Revision() const { return revision_.load(std::memory_order_acquire); }
+    // Bumped only when entries are added or removed
+    uint64_t LayoutRevision() const { return layoutRevision_.load(std::memory_order_acquire); }
+
+    // Call fn(const PathStore&, const std::vector<SwapEntry>&) under the queue lock. Keep fn short:
+    // the worker waits on it.
+    template <typename Fn>
+    void Read(Fn&& fn) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fn(static_cast<const PathStore&>(paths_), static_cast<const std::vector<SwapEntry>&>(entries_));
+    }
+
+private:
+    void WorkerLoop(Executor executor, size_t depth, Screener screener, bool autoRunOnly);
+    size_t Screen(const Screener& screener, size_t from, bool autoRunOnly);
+    void SetState(SwapEntry& entry, SwapState state);
+
+    mutable std::mutex mutex_;
+    std::mutex runMutex_;  // Serializes Run/Stop, which may come from the UI and the watch thread
+    std::vector<SwapEntry> entries_;
+    // Paths of entries_. Interned under mutex_; the worker reads them without it, which is safe since
+    // a store never moves what it holds and is only replaced while the worker is stopped.
+    PathStore paths_;
+    std::atomic<size_t> counts_[4] = {};
+    std::atomic<uint64_t> revision_{0};
+    std::atomic<uint64_t> layoutRevision_{0};
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_{false};
+};
@@ -0,0 +1,180 @@
+#include "swap_session.h"
+
+#include "collision_index.h"
+#include "exchange.h"
+#include "metadata_swap.h"
+#include "name_rules.h"
+#include "swap_pipeline.h"
+#include "swap_queue.h"
+#include "vfs.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct nx_session {
+    std::mutex mutex;     // Guards batch, micros and executed
+    std::mutex runMutex;  // Held by nx_session_execute
+    SwapBatch batch;      // Entries still Pending have not been executed
+    std::vector<int64_t> micros;
+    size_t executed = 0;  // Entries before this one have a result
+};
+
+namespace {
+constexpr uint32_t kDefaultDepth = 8;
+
+// nx_options.name_rules is cast straight to NameRules
+static_assert(static_cast<uint32_t>(NameRules::None) == NX_NAME_RULES_NONE &&
+              static_cast<uint32_t>(NameRules::Windows) == NX_NAME_RULES_WINDOWS &&
+              static_cast<uint32_t>(NameRules::Posix) == NX_NAME_RULES_POSIX &&
+              static_cast<uint32_t>(NameRules::SmbShare) == NX_NAME_RULES_SMB);
+}  // namespace
+
+void nx_options_init(nx_options* options) {
+    if (!options) return;
+    options->pipeline_depth = kDefaultDepth;
+    options->verify = 0;
+    options->metadata = 0;
+    options->screen_collisions = 1;
+    options->name_rules = NX_NAME_RULES_WINDOWS;
+}
+
+nx_session* nx_session_open(void) {
+    try {
+        return new nx_session;
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void nx_session_close(nx_session* session) {
+    if (!session) return;
+    {
+        // Let an execution in progress finish
+        std::lock_guard<std::mutex> run(session->runMutex);
+    }
+    delete session;
+}
+
+int nx_session_add(nx_session* session, const char* const* paths1, const char* const* paths2,
+                   const uint8_t* preserve_ext, size_t count) {
+    if (!session || (count > 0 && (!paths1 || !paths2))) {
+        return NX_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!paths1[i] || !paths2[i]) return NX_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->batch.entries.reserve(session->batch.entries.size() + count);
+        session->micros.reserve(session->micros.size() + count);
+        for (size_t i = 0; i < count; ++i) {
+            session->batch.Add(paths1[i], paths2[i], !preserve_ext || preserve_ext[i] != 0);
+            session->micros.push_back(0);
+        }
+    } catch (const std::bad_alloc&) {
+        return NX_ERROR_OUT_OF_MEMORY;
+    }
+    return NX_OK;
+}
+
+int nx_session_execute(nx_session* session, const nx_options* options) {
+    nx_options defaults;
+    nx_options_init(&defaults);
+    if (!options) options = &defaults;
+    if (!session || (options->metadata & ~static_cast<uint32_t>(kMetadataAll)) != 0 ||
+        options->name_rules > NX_NAME_RULES_SMB) {
+        return NX_ERROR_INVALID_ARGUMENT;
+    }
+    std::unique_lock<std::mutex> run(session->runMutex, std::try_to_lock);
+    if (!run.owns_lock()) {
+        return NX_ERROR_BUSY;
+    }
+
+    try {
+        // The pending pairs are copied out so that nx_session_add can keep appending. Their paths
+        // are read from the store without the lock: it never moves what it holds.
+        std::vector<SwapEntry> pending;
+        size_t first = 0;
+        {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            first = session->executed;
+            pending.assign(session->batch.entries.begin() + static_cast<std::ptrdiff_t>(first),
+                           session->batch.entries.end());
+        }
+        const PathStore& paths = session->batch.paths;
+        std::vector<int> codes = FindInvalidNames(paths, pending, static_cast<NameRules>(options->name_rules));
+        if (options->screen_collisions) {
+            const std::vector<int> collisions = FindNameCollisions(paths, pending);
+            for (size_t k = 0; k < codes.size(); ++k) {
+                if (codes[k] == kResultSuccess) codes[k] = collisions[k];
+            }
+        }
+
+        NativeVfs vfs(options->verify != 0, options->metadata);
+        auto swap = [&vfs](uint64_t, const std::string& path1, const std::string& path2, bool preserve) {
+            for (const std::string* path : {&path1, &path2}) {
+                const int code = vfs.Probe(*path);
+                if (code != kResultSuccess) return code;
+            }
+            return vfs.Exchange(path1, path2, preserve);
+        };
+        auto finish = [session](uint64_t index, int code, int64_t micros) {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            SwapEntry& entry = session->batch.entries[index];
+            entry.code = code;
+            entry.state = code == kResultSuccess ? SwapState::Done : SwapState::Failed;
+            session->micros[index] = micros;
+        };
+
+        SwapPipeline pipeline((std::max)(options->pipeline_depth, 1u), swap, finish);
+        PathReader reader1(paths);
+        PathReader reader2(paths);
+        for (size_t k = 0; k < pending.size(); ++k) {
+            const SwapEntry& entry = pending[k];
+            const std::string_view path1 = reader1.Read(entry.path1);
+            const std::string_view path2 = reader2.Read(entry.path2);
+            if (codes[k] == kResultSuccess && (path1.empty() || path2.empty())) {
+                codes[k] = kResultInvalidPath;
+            }
+            if (codes[k] != kResultSuccess) {
+                finish(first + k, codes[k], 0);
+                continue;
+            }
+            pipeline.Submit(first + k, std::string(path1), std::string(path2), entry.preserveExt);
+        }
+        pipeline.Finish();
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->executed = first + pending.size();
+    } catch (const std::bad_alloc&) {
+        return NX_ERROR_OUT_OF_MEMORY;
+    }
+    return NX_OK;
+}
+
+size_t nx_session_size(nx_session* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->batch.entries.size();
+}
+
+int nx_session_results(nx_session* session, size_t first, size_t count, int32_t* codes, int64_t* micros) {
+    if (!session || (count > 0 && !codes)) {
+        return NX_ERROR_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    const std::vector<SwapEntry>& entries = session->batch.entries;
+    if (first > entries.size() || count > entries.size() - first) {
+        return NX_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const SwapEntry& entry = entries[first + i];
+        codes[i] = entry.state == SwapState::Pending ? NX_RESULT_NOT_RUN : entry.code;
+        if (micros) micros[i] = session->micros[first + i];
+    }
+    return NX_OK;
+}
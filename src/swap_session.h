@@ -0,0 +1,80 @@
+#pragma once
+
+// C interface of the swap engine for tools that swap in-process instead of spawning
+// name_exchanger per pair. Pairs are added to a session in arrays, executed in one call through
+// the same pipeline as the command line's "-" mode, and their exchange() codes and times read back.
+//
+// Every function may be called from any thread. Sessions are independent; a session serializes
+// its own calls, except that pairs may be added and results read while it executes. Only one
+// nx_session_execute runs per session at a time.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(NX_SHARED)
+#if defined(NX_BUILDING)
+#define NX_API __declspec(dllexport)
+#else
+#define NX_API __declspec(dllimport)
+#endif
+#else
+#define NX_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returned by the functions below
+#define NX_OK 0
+#define NX_ERROR_INVALID_ARGUMENT (-1)
+#define NX_ERROR_BUSY (-2)           // The session is already executing
+#define NX_ERROR_OUT_OF_MEMORY (-3)
+
+// Names the target volume accepts (nx_options.name_rules); pairs whose new names break them fail
+// with code 5 before any pair runs
+#define NX_NAME_RULES_NONE 0
+#define NX_NAME_RULES_WINDOWS 1  // No <>:"/\|?* or control characters, trailing dots or spaces, or device names
+#define NX_NAME_RULES_POSIX 2    // No NUL or '/', at most 255 bytes
+#define NX_NAME_RULES_SMB 3      // Both, for a Samba share
+
+// Code of a pair that has not been executed yet; executed pairs have an exchange() code (0 is success)
+#define NX_RESULT_NOT_RUN (-1)
+
+typedef struct nx_session nx_session;
+
+typedef struct nx_options {
+    uint32_t pipeline_depth;     // Pairs in flight at once; 1 runs them strictly in order
+    int verify;                  // Check each swap by file identity, or content hash where IDs do not survive
+    uint32_t metadata;           // Metadata that stays with the names: 1 times, 2 attributes, 4 streams
+    int screen_collisions;       // Fail pairs whose new names would collide before any of them runs
+    uint32_t name_rules;         // NX_NAME_RULES_*
+} nx_options;
+
+// Defaults: depth 8, no verification, no metadata, collisions screened, Windows name rules
+NX_API void nx_options_init(nx_options* options);
+
+// NULL if out of memory
+NX_API nx_session* nx_session_open(void);
+// Waits for an execution in progress to finish
+NX_API void nx_session_close(nx_session* session);
+
+// Append count pairs of UTF-8 paths. preserve_ext holds one flag per pair (nonzero keeps the
+// extensions) or is NULL to keep them for all.
+NX_API int nx_session_add(nx_session* session, const char* const* paths1, const char* const* paths2,
+                          const uint8_t* preserve_ext, size_t count);
+
+// Execute every pair not executed yet, in the order added, and return once all have finished.
+// Pairs added meanwhile wait for the next call. options may be NULL for the defaults.
+NX_API int nx_session_execute(nx_session* session, const nx_options* options);
+
+// Pairs added so far
+NX_API size_t nx_session_size(nx_session* session);
+
+// Copy the results of pairs [first, first + count): their codes, and the microseconds each swap
+// took (0 for pairs screened out or not run) unless micros is NULL
+NX_API int nx_session_results(nx_session* session, size_t first, size_t count, int32_t* codes, int64_t* micros);
+
+#ifdef __cplusplus
+}
+#endif
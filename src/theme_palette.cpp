@@ -0,0 +1,101 @@
+#include "theme_palette.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+ImVec4 FromColorRef(uint32_t color) {
+    return ImVec4((color & 0xFF) / 255.0f, ((color >> 8) & 0xFF) / 255.0f, ((color >> 16) & 0xFF) / 255.0f, 1.0f);
+}
+
+float Luminance(const ImVec4& color) { return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z; }
+
+ImVec4 ShiftLuminanceToRange(const ImVec4& color, float minLum, float maxLum) {
+    const float lum = Luminance(color);
+    float delta = 0.0f;
+    if (lum < minLum) {
+        delta = minLum - lum;
+    } else if (lum > maxLum) {
+        delta = maxLum - lum;
+    }
+
+    ImVec4 out = color;
+    out.x = std::clamp(out.x + delta, 0.0f, 1.0f);
+    out.y = std::clamp(out.y + delta, 0.0f, 1.0f);
+    out.z = std::clamp(out.z + delta, 0.0f, 1.0f);
+    return out;
+}
+}  // namespace
+
+bool ThemeInputs::operator==(const ThemeInputs& other) const {
+    return darkMode == other.darkMode && window == other.window && windowText == other.windowText &&
+           shadow == other.shadow && buttonFace == other.buttonFace && scrollbar == other.scrollbar &&
+           accent == other.accent;
+}
+
+bool ThemePalette::operator==(const ThemePalette& other) const {
+    static_assert(sizeof(ThemePalette) % sizeof(ImVec4) == 0, "ThemePalette must hold only ImVec4 fields");
+    return std::memcmp(this, &other, sizeof(ThemePalette)) == 0;
+}
+
+ThemePalette DeriveThemePalette(const ThemeInputs& inputs) {
+    const bool darkMode = inputs.darkMode;
+    ImVec4 windowBg = FromColorRef(inputs.window);
+    ImVec4 text = FromColorRef(inputs.windowText);
+    ImVec4 border = FromColorRef(inputs.shadow);
+    ImVec4 frameBg = FromColorRef(inputs.buttonFace);
+    ImVec4 scrollbarBg = FromColorRef(inputs.scrollbar);
+    ImVec4 accent = FromColorRef(inputs.accent);
+
+    if (darkMode) {
+        windowBg = ShiftLuminanceToRange(windowBg, 0.08f, 0.18f);
+        text = ShiftLuminanceToRange(text, 0.82f, 0.96f);
+        border = ShiftLuminanceToRange(border, 0.28f, 0.42f);
+        frameBg = ShiftLuminanceToRange(frameBg, 0.14f, 0.24f);
+        scrollbarBg = ShiftLuminanceToRange(scrollbarBg, 0.12f, 0.22f);
+        accent = ShiftLuminanceToRange(accent, 0.08f, 0.12f);
+    } else {
+        windowBg = ShiftLuminanceToRange(windowBg, 0.90f, 0.98f);
+        text = ShiftLuminanceToRange(text, 0.05f, 0.20f);
+        border = ShiftLuminanceToRange(border, 0.50f, 0.70f);
+        frameBg = ShiftLuminanceToRange(frameBg, 0.94f, 1.00f);
+        scrollbarBg = ShiftLuminanceToRange(scrollbarBg, 0.90f, 0.98f);
+        accent = ShiftLuminanceToRange(accent, 0.35f, 0.62f);
+    }
+
+    ThemePalette palette;
+    palette.windowBg = windowBg;
+    palette.text = text;
+    palette.border = border;
+    palette.frameBg = frameBg;
+    palette.frameBgHovered = ShiftLuminanceToRange(frameBg, darkMode ? 0.20f : 0.88f, darkMode ? 0.32f : 0.94f);
+    palette.frameBgActive = ShiftLuminanceToRange(frameBg, darkMode ? 0.24f : 0.82f, darkMode ? 0.38f : 0.90f);
+    palette.button = ShiftLuminanceToRange(frameBg, darkMode ? 0.18f : 0.90f, darkMode ? 0.28f : 0.96f);
+    palette.buttonHovered = ShiftLuminanceToRange(frameBg, darkMode ? 0.24f : 0.82f, darkMode ? 0.36f : 0.92f);
+    palette.buttonActive = ShiftLuminanceToRange(frameBg, darkMode ? 0.30f : 0.75f, darkMode ? 0.44f : 0.86f);
+    palette.scrollbarBg = scrollbarBg;
+    palette.scrollbarGrab = ShiftLuminanceToRange(accent, darkMode ? 0.36f : 0.45f, darkMode ? 0.55f : 0.65f);
+    palette.scrollbarGrabHovered = ShiftLuminanceToRange(accent, darkMode ? 0.46f : 0.55f, darkMode ? 0.62f : 0.75f);
+    palette.scrollbarGrabActive = ShiftLuminanceToRange(accent, darkMode ? 0.56f : 0.65f, darkMode ? 0.72f : 0.85f);
+
+    palette.topBarBg = accent;
+    palette.topBarText =
+        (Luminance(accent) > 0.50f) ? ImVec4(0.0f, 0.0f, 0.0f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+    palette.topBarButtonHovered = ImVec4(palette.topBarText.x, palette.topBarText.y, palette.topBarText.z, 0.14f);
+    palette.topBarButtonActive = ImVec4(palette.topBarText.x, palette.topBarText.y, palette.topBarText.z, 0.24f);
+    palette.tooltipBg = ShiftLuminanceToRange(windowBg, darkMode ? 0.16f : 0.94f, darkMode ? 0.24f : 1.0f);
+    return palette;
+}
+
+std::optional<ThemePalette> RefreshThemePalette(ThemeInputs& current, const ThemePalette& applied,
+                                                const ThemeInputs& inputs) {
+    if (inputs == current) {
+        return std::nullopt;
+    }
+    current = inputs;
+    ThemePalette palette = DeriveThemePalette(inputs);
+    if (palette == applied) {
+        return std::nullopt;
+    }
+    return palette;
+}
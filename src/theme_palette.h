@@ -0,0 +1,62 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+// Raw system settings the UI colors are derived from. Colors are COLORREFs (0x00BBGGRR).
+struct ThemeInputs {
+    bool darkMode = false;     // AppsUseLightTheme == 0
+    uint32_t window = 0;       // COLOR_WINDOW
+    uint32_t windowText = 0;   // COLOR_WINDOWTEXT
+    uint32_t shadow = 0;       // COLOR_3DSHADOW
+    uint32_t buttonFace = 0;   // COLOR_BTNFACE
+    uint32_t scrollbar = 0;    // COLOR_SCROLLBAR
+    uint32_t accent = 0;       // DWM colorization color, or COLOR_HIGHLIGHT without DWM
+
+    bool operator==(const ThemeInputs& other) const;
+    bool operator!=(const ThemeInputs& other) const { return !(*this == other); }
+};
+
+// Every color the UI takes from the system theme
+struct ThemePalette {
+    ImVec4 windowBg;
+    ImVec4 text;
+    ImVec4 border;
+    ImVec4 frameBg;
+    ImVec4 frameBgHovered;
+    ImVec4 frameBgActive;
+    ImVec4 button;
+    ImVec4 buttonHovered;
+    ImVec4 buttonActive;
+    ImVec4 scrollbarBg;
+    ImVec4 scrollbarGrab;
+    ImVec4 scrollbarGrabHovered;
+    ImVec4 scrollbarGrabActive;
+    ImVec4 topBarBg;
+    ImVec4 topBarText;
+    ImVec4 topBarButtonHovered;
+    ImVec4 topBarButtonActive;
+    ImVec4 tooltipBg;
+
+    bool operator==(const ThemePalette& other) const;
+    bool operator!=(const ThemePalette& other) const { return !(*this == other); }
+};
+
+// Map the system colors into luminance bands that keep the UI readable in light and dark mode.
+// Pure function of its input, so equal inputs give bit-identical palettes.
+ThemePalette DeriveThemePalette(const ThemeInputs& inputs);
+
+// Theme notifications arrive in bursts (one per registry value written, then WM_THEMECHANGED,
+// WM_SYSCOLORCHANGE, ...). The palette is refreshed once they have been quiet for kThemeRefreshQuiet,
+// and at the latest kThemeRefreshMaxDelay after the first one (see ChangeCoalescer).
+constexpr std::chrono::milliseconds kThemeRefreshQuiet{150};
+constexpr std::chrono::milliseconds kThemeRefreshMaxDelay{1000};
+
+// Take freshly read inputs into current. Returns the palette to apply, or nothing when the inputs
+// did not change or still derive the palette already applied, which is what most
+// WM_SETTINGCHANGE broadcasts (environment, wallpaper, ...) come down to.
+std::optional<ThemePalette> RefreshThemePalette(ThemeInputs& current, const ThemePalette& applied,
+                                                const ThemeInputs& inputs);
@@ -0,0 +1,214 @@
+#include "throttle.h"
+
+#include "cli.h"
+#include "exchange.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+
+namespace {
+// Tokens the bucket may hold, in seconds of the configured rate
+constexpr double kBurstSeconds = 0.05;
+
+// Ceiling of the in-flight limit, and of the adaptive one when no cap is set
+constexpr uint32_t kMaxInFlight = 256;
+
+double BurstSize(double opsPerSecond) { return (std::max)(1.0, opsPerSecond * kBurstSeconds); }
+
+// Background mode is per thread and only the thread itself can enter or leave it
+void SetThreadBackground(bool background) {
+    thread_local bool current = false;
+    if (background != current &&
+        SetThreadPriority(GetCurrentThread(), background ? THREAD_MODE_BACKGROUND_BEGIN : THREAD_MODE_BACKGROUND_END)) {
+        current = background;
+    }
+}
+
+// Codes about the pair itself say nothing about how loaded the volume is
+bool IsLoadFailure(int code) {
+    return code != kResultSuccess && code != kResultNoExist && code != kResultAlreadyExists &&
+           code != kResultSameFile && code != kResultInvalidPath;
+}
+
+// A ThrottleUpdate as it crosses processes: plain integers, so that any byte the sender put in a flag can be
+// checked instead of being read as a bool
+struct ThrottleMessage {
+    uint32_t fields;
+    uint32_t maxInFlight;
+    double opsPerSecond;
+    uint8_t adaptive;
+    uint8_t background;
+};
+
+bool ParseNumber(const std::wstring& text, double max, double& value) {
+    wchar_t* end = nullptr;
+    value = wcstod(text.c_str(), &end);
+    return !text.empty() && *end == L'\0' && value >= 0.0 && value <= max;
+}
+}  // namespace
+
+void SwapThrottle::Apply(const ThrottleSettings& settings) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = std::chrono::steady_clock::now();
+        Refill(now);
+        const uint32_t ceiling = settings.maxInFlight > 0 ? settings.maxInFlight : kMaxInFlight;
+        if (settings.adaptive && !settings_.adaptive) {
+            tuner_.Reset(ceiling, now);
+        } else {
+            tuner_.SetCeiling(ceiling);
+        }
+        settings_ = settings;
+        tokens_ = (std::min)(tokens_, BurstSize(settings.opsPerSecond));
+        limited_.store(settings.opsPerSecond > 0.0 || settings.maxInFlight > 0 || settings.adaptive,
+                       std::memory_order_release);
+        background_.store(settings.background, std::memory_order_relaxed);
+    }
+    cv_.notify_all();
+}
+
+ThrottleSettings SwapThrottle::Settings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+TuningStats SwapThrottle::Tuning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tuner_.Stats();
+}
+
+void SwapThrottle::Refill(std::chrono::steady_clock::time_point now) {
+    if (settings_.opsPerSecond > 0.0) {
+        const double elapsed = std::chrono::duration<double>(now - refilled_).count();
+        tokens_ = (std::min)(BurstSize(settings_.opsPerSecond), tokens_ + elapsed * settings_.opsPerSecond);
+    }
+    refilled_ = now;
+}
+
+void SwapThrottle::Acquire() {
+    SetThreadBackground(background_.load(std::memory_order_relaxed));
+    if (!limited_.load(std::memory_order_acquire)) {
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        Refill(now);
+        const uint32_t cap = settings_.adaptive ? tuner_.Limit() : settings_.maxInFlight;
+        const bool slot = cap == 0 || inFlight_.load(std::memory_order_relaxed) < cap;
+        if (slot && (settings_.opsPerSecond <= 0.0 || tokens_ >= 1.0)) {
+            if (settings_.opsPerSecond > 0.0) tokens_ -= 1.0;
+            break;
+        }
+        if (slot) {
+            // Sleep until the next token is due; Apply or Release wake us earlier
+            const std::chrono::duration<double> due((1.0 - tokens_) / settings_.opsPerSecond);
+            cv_.wait_until(lock, now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+        } else {
+            cv_.wait(lock);
+        }
+    }
+    const uint32_t inFlight = inFlight_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (settings_.adaptive) tuner_.Started(inFlight);
+}
+
+void SwapThrottle::Release(int64_t micros, bool failed) {
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    if (limited_.load(std::memory_order_acquire)) {
+        // Taking the lock orders this wake-up after a waiter's check, so it cannot be lost
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint32_t limit = tuner_.Limit();
+        if (settings_.adaptive && tuner_.Finished(micros, failed, std::chrono::steady_clock::now()) &&
+            tuner_.Limit() > limit) {
+            cv_.notify_all();
+        } else {
+            cv_.notify_one();
+        }
+    }
+}
+
+int ThrottledVfs::Exchange(const std::string& path1, const std::string& path2, bool preserveExt) {
+    throttle_.Acquire();
+    const auto started = std::chrono::steady_clock::now();
+    const int code = inner_.Exchange(path1, path2, preserveExt);
+    const auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+    throttle_.Release(micros, IsLoadFailure(code));
+    return code;
+}
+
+bool ParseThrottleSwitches(const CommandLine& cmd, ThrottleUpdate& update) {
+    ThrottleUpdate parsed;
+    if (cmd.maxRate) {
+        if (!ParseNumber(*cmd.maxRate, 1e6, parsed.settings.opsPerSecond)) return false;
+        parsed.fields |= ThrottleUpdate::kRate;
+    }
+    if (cmd.maxInFlight) {
+        double value = 0.0;
+        if (*cmd.maxInFlight == L"auto") {
+            parsed.settings.adaptive = true;
+        } else if (!ParseNumber(*cmd.maxInFlight, kMaxInFlight, value) || value != static_cast<uint32_t>(value)) {
+            return false;
+        }
+        parsed.settings.maxInFlight = static_cast<uint32_t>(value);
+        parsed.fields |= ThrottleUpdate::kInFlight;
+    }
+    if (cmd.ioPriority) {
+        if (*cmd.ioPriority != L"background" && *cmd.ioPriority != L"normal") return false;
+        parsed.settings.background = *cmd.ioPriority == L"background";
+        parsed.fields |= ThrottleUpdate::kPriority;
+    }
+    update = parsed;
+    return true;
+}
+
+ThrottleSettings MergeThrottleUpdate(const ThrottleSettings& current, const ThrottleUpdate& update) {
+    ThrottleSettings merged = current;
+    if (update.fields & ThrottleUpdate::kRate) merged.opsPerSecond = update.settings.opsPerSecond;
+    if (update.fields & ThrottleUpdate::kInFlight) {
+        merged.maxInFlight = update.settings.maxInFlight;
+        merged.adaptive = update.settings.adaptive;
+    }
+    if (update.fields & ThrottleUpdate::kPriority) merged.background = update.settings.background;
+    return merged;
+}
+
+bool SendThrottleUpdate(HWND window, const ThrottleUpdate& update) {
+    ThrottleMessage message = {};
+    message.fields = update.fields;
+    message.maxInFlight = update.settings.maxInFlight;
+    message.opsPerSecond = update.settings.opsPerSecond;
+    message.adaptive = update.settings.adaptive ? 1 : 0;
+    message.background = update.settings.background ? 1 : 0;
+    COPYDATASTRUCT data = {};
+    data.dwData = kCopyDataThrottle;
+    data.cbData = sizeof(message);
+    data.lpData = &message;
+    DWORD_PTR result = 0;
+    return SendMessageTimeoutW(window, WM_COPYDATA, 0, reinterpret_cast<LPARAM>(&data), SMTO_ABORTIFHUNG, 2000,
+                               &result) &&
+           result == TRUE;
+}
+
+bool ReadThrottleUpdate(const COPYDATASTRUCT& data, ThrottleUpdate& update) {
+    if (data.dwData != kCopyDataThrottle || data.cbData != sizeof(ThrottleMessage) || !data.lpData) {
+        return false;
+    }
+    ThrottleMessage message;
+    std::memcpy(&message, data.lpData, sizeof(message));
+    // The sender is another process; check what it sent like any other input
+    constexpr uint32_t kKnownFields = ThrottleUpdate::kRate | ThrottleUpdate::kInFlight | ThrottleUpdate::kPriority;
+    if ((message.fields & ~kKnownFields) != 0 || !(message.opsPerSecond >= 0.0 && message.opsPerSecond <= 1e6) ||
+        message.maxInFlight > kMaxInFlight || message.adaptive > 1 || message.background > 1) {
+        return false;
+    }
+    update.fields = message.fields;
+    update.settings.opsPerSecond = message.opsPerSecond;
+    update.settings.maxInFlight = message.maxInFlight;
+    update.settings.adaptive = message.adaptive == 1;
+    update.settings.background = message.background == 1;
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "concurrency_tuner.h"
+#include "vfs.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+struct CommandLine;
+
+// Limits for batch runs (swap queue and "-" mode); all of them can change while a run is going
+struct ThrottleSettings {
+    double opsPerSecond = 0.0;  // Token-bucket cap on swaps started per second; 0 = unlimited
+    uint32_t maxInFlight = 0;   // Swaps running at once, below the pipeline depth; 0 = no extra cap
+    bool adaptive = false;      // Tune the in-flight cap from observed latency; maxInFlight is then its ceiling
+    bool background = false;    // Run swaps in THREAD_MODE_BACKGROUND (low I/O and memory priority)
+};
+
+// Gate every batch swap passes through. With no limits set, Acquire/Release are two atomic
+// operations; otherwise callers queue on a mutex until a token and an in-flight slot are free.
+// The bucket holds 50 ms worth of tokens (at least one), so bursts stay short at any rate.
+// With adaptive set, a ConcurrencyTuner fed by Release decides the in-flight cap.
+class SwapThrottle {
+public:
+    // Replace the limits; waiting callers re-check them at once
+    void Apply(const ThrottleSettings& settings);
+    ThrottleSettings Settings() const;
+    // State of the adaptive limit, as of its last window
+    TuningStats Tuning() const;
+
+    // Block until a swap may start, then count it as in flight. Also moves the calling thread in or
+    // out of background mode as configured.
+    void Acquire();
+    // A swap that took micros finished; failed as for ConcurrencyTuner::Finished
+    void Release(int64_t micros, bool failed);
+
+private:
+    void Refill(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    ThrottleSettings settings_;
+    ConcurrencyTuner tuner_;
+    double tokens_ = 0.0;
+    std::chrono::steady_clock::time_point refilled_ = std::chrono::steady_clock::now();
+    std::atomic<bool> limited_{false};
+    std::atomic<bool> background_{false};
+    std::atomic<uint32_t> inFlight_{0};
+};
+
+// Vfs whose swaps go through a SwapThrottle; probes pass straight through
+class ThrottledVfs final : public Vfs {
+public:
+    ThrottledVfs(Vfs& inner, SwapThrottle& throttle) : inner_(inner), throttle_(throttle) {}
+
+    int Probe(const std::string& path) override { return inner_.Probe(path); }
+    int Exchange(const std::string& path1, const std::string& path2, bool preserveExt) override;
+
+private:
+    Vfs& inner_;
+    SwapThrottle& throttle_;
+};
+
+// Throttle switches found on a command line; each field is only meaningful if its bit is set
+struct ThrottleUpdate {
+    enum : uint32_t { kRate = 1 << 0, kInFlight = 1 << 1, kPriority = 1 << 2 };
+    uint32_t fields = 0;
+    ThrottleSettings settings;
+};
+
+// Read "--max-rate <ops/s>", "--max-in-flight <n|auto>" and "--io-priority <background|normal>";
+// false if one of them is malformed
+bool ParseThrottleSwitches(const CommandLine& cmd, ThrottleUpdate& update);
+
+// Apply the fields of update that are set on top of the current settings
+ThrottleSettings MergeThrottleUpdate(const ThrottleSettings& current, const ThrottleUpdate& update);
+
+// WM_COPYDATA tag of a ThrottleUpdate sent to the running instance
+constexpr ULONG_PTR kCopyDataThrottle = 0x54485254;  // 'THRT'
+
+// Hand update to the instance owning window; false if it did not accept it
+bool SendThrottleUpdate(HWND window, const ThrottleUpdate& update);
+
+// Decode a WM_COPYDATA payload; false if it is not a ThrottleUpdate or holds a value no switch can set
+bool ReadThrottleUpdate(const COPYDATASTRUCT& data, ThrottleUpdate& update);
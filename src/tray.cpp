@@ -26,3 +26,29 @@ void SetupTrayIcon(HWND hwnd) {
 }
 
 void RemoveTrayIcon() { Shell_NotifyIconW(NIM_DELETE, &g_nid); }
+
+UINT ShowTrayMenu(HWND hwnd, const std::vector<std::wstring>& pinLabels) {
+    const auto& locale = GetCurrentLocale();
+    HMENU menu = CreatePopupMenu();
+    if (!menu) return 0;
+
+    if (!pinLabels.empty()) {
+        HMENU unpin = CreatePopupMenu();
+        for (UINT i = 0; i < pinLabels.size(); ++i) {
+            AppendMenuW(menu, MF_STRING, kTrayCmdToggle + i, pinLabels[i].c_str());
+            AppendMenuW(unpin, MF_STRING, kTrayCmdUnpin + i, pinLabels[i].substr(0, pinLabels[i].find(L'\t')).c_str());
+        }
+        AppendMenuW(menu, MF_POPUP, reinterpret_cast<UINT_PTR>(unpin), locale.trayUnpinMenu);
+        AppendMenuW(menu, MF_SEPARATOR, 0, nullptr);
+    }
+    AppendMenuW(menu, MF_STRING, kTrayCmdExit, locale.trayExitMenu);
+
+    // Required for the menu to close when the user clicks elsewhere
+    SetForegroundWindow(hwnd);
+    POINT pt;
+    GetCursorPos(&pt);
+    const UINT cmd = static_cast<UINT>(
+        TrackPopupMenu(menu, TPM_RETURNCMD | TPM_NONOTIFY | TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwnd, nullptr));
+    DestroyMenu(menu);
+    return cmd;
+}
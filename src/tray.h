@@ -1,10 +1,21 @@
 #pragma once
 
+#include <string>
+#include <vector>
 #include <windows.h>
 
+// Tray menu commands; pinned pair i maps to kTrayCmdToggle + i / kTrayCmdUnpin + i
+constexpr UINT kTrayCmdExit = 1;
+constexpr UINT kTrayCmdToggle = 100;
+constexpr UINT kTrayCmdUnpin = 200;
+
 // Setup the system tray icon for the given window.
 // Uses the application's own icon from resources.
 void SetupTrayIcon(HWND hwnd);
 
 // Remove the system tray icon.
 void RemoveTrayIcon();
+
+// Show the tray context menu at the cursor: one entry per pinned pair, an unpin submenu and Exit.
+// Returns the chosen kTrayCmd* command, or 0 if the menu was dismissed.
+UINT ShowTrayMenu(HWND hwnd, const std::vector<std::wstring>& pinLabels);
@@ -0,0 +1,212 @@
+#include "ui_harness.h"
+
+#include "app.h"
+#include "jsonl.h"
+#include "ui_script.h"
+#include "utils.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr float kDeltaTime = 1.0f / 60.0f;
+
+struct StepStats {
+    int frames = 0;
+    double cpuSumUs = 0.0;
+    double cpuMaxUs = 0.0;
+    double sectionSumUs[static_cast<int>(UiSection::Count)] = {};
+    uint64_t vertices = 0;
+    uint64_t indices = 0;
+    uint64_t allocs = 0;
+    uint64_t allocBytes = 0;
+};
+
+struct AllocCounter {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+AllocCounter g_allocs;
+
+void* CountingAlloc(size_t size, void* user) {
+    auto* counter = static_cast<AllocCounter*>(user);
+    ++counter->count;
+    counter->bytes += size;
+    return std::malloc(size);
+}
+
+void CountingFree(void* ptr, void* /*user*/) { std::free(ptr); }
+
+// Null renderer: accept every texture request without uploading anything
+void UpdateNullTextures() {
+    for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+        if (tex->Status == ImTextureStatus_WantCreate || tex->Status == ImTextureStatus_WantUpdates) {
+            tex->SetTexID(static_cast<ImTextureID>(1));
+            tex->SetStatus(ImTextureStatus_OK);
+        } else if (tex->Status == ImTextureStatus_WantDestroy && tex->UnusedFrames > 0) {
+            tex->SetTexID(ImTextureID_Invalid);
+            tex->SetStatus(ImTextureStatus_Destroyed);
+        }
+    }
+}
+
+void RunFrame(App& app, StepStats& stats) {
+    ImGuiIO& io = ImGui::GetIO();
+    io.DeltaTime = kDeltaTime;
+    io.DisplaySize = ImVec2(364 * app.dpiScale, app.WindowHeight());
+
+    const AllocCounter before = g_allocs;
+    app.profiler.BeginFrame();
+    ImGui::NewFrame();
+    app.RenderUI();
+    ImGui::Render();
+    app.profiler.EndFrame();
+    UpdateNullTextures();
+
+    const ImDrawData* drawData = ImGui::GetDrawData();
+    const double cpuUs = app.profiler.Frame().lastUs;
+    ++stats.frames;
+    stats.cpuSumUs += cpuUs;
+    stats.cpuMaxUs = (std::max)(stats.cpuMaxUs, cpuUs);
+    for (int i = 0; i < static_cast<int>(UiSection::Count); ++i) {
+        stats.sectionSumUs[i] += app.profiler.Section(static_cast<UiSection>(i)).lastUs;
+    }
+    stats.vertices += static_cast<uint64_t>(drawData->TotalVtxCount);
+    stats.indices += static_cast<uint64_t>(drawData->TotalIdxCount);
+    stats.allocs += g_allocs.count - before.count;
+    stats.allocBytes += g_allocs.bytes - before.bytes;
+}
+
+void RunStep(App& app, const UiStep& step, StepStats& stats) {
+    ImGuiIO& io = ImGui::GetIO();
+    switch (step.kind) {
+        case UiStepKind::Idle:
+            for (int i = 0; i < step.frames; ++i) RunFrame(app, stats);
+            return;
+
+        case UiStepKind::Type: {
+            // Click into the input, then feed one character per frame like a typist would
+            const float s = app.dpiScale;
+            const float inputY = (step.field == 2 ? 120.0f : 62.0f) * s + 14.0f * s;
+            io.AddMousePosEvent(182.0f * s, inputY);
+            io.AddMouseButtonEvent(ImGuiMouseButton_Left, true);
+            RunFrame(app, stats);
+            io.AddMouseButtonEvent(ImGuiMouseButton_Left, false);
+            RunFrame(app, stats);
+            io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+            for (const std::string& ch : SplitCodePoints(step.text)) {
+                io.AddInputCharactersUTF8(ch.c_str());
+                RunFrame(app, stats);
+            }
+            return;
+        }
+
+        case UiStepKind::Drop: {
+            app.AcceptDroppedPaths(SplitDropPaths(step.text));
+            break;
+        }
+
+        case UiStepKind::Dpi:
+            app.dpiScale = step.value;
+            app.RebuildFonts();
+            break;
+
+        case UiStepKind::Theme:
+            app.ApplySystemTheme();
+            break;
+
+        case UiStepKind::Queue: {
+            // Synthetic pairs; the queue is never run, so the paths need not exist
+            const int count = static_cast<int>(step.value);
+            char path1[96];
+            char path2[96];
+            for (int i = 0; i < count; ++i) {
+                snprintf(path1, sizeof(path1), "C:\\Bench\\set-%03d\\left-%06d.dat", i % 997, i);
+                snprintf(path2, sizeof(path2), "D:\\Bench\\set-%03d\\right-%06d.dat", (i * 7) % 997, i);
+                app.swapQueue.Add(path1, path2, true);
+            }
+            break;
+        }
+    }
+    for (int i = 0; i < step.frames; ++i) RunFrame(app, stats);
+}
+
+void AppendStepJson(std::string& out, const UiStep& step, const StepStats& stats) {
+    const double frames = (std::max)(1, stats.frames);
+    char num[64];
+    auto field = [&](const char* name, double value, bool last = false) {
+        snprintf(num, sizeof(num), "%.2f", value);
+        out += '"';
+        out += name;
+        out += "\":";
+        out += num;
+        if (!last) out += ',';
+    };
+
+    out += "{\"step\":";
+    AppendJsonString(out, step.label);
+    out += ",\"frames\":" + std::to_string(stats.frames) + ",";
+    field("cpu_avg_us", stats.cpuSumUs / frames);
+    field("cpu_max_us", stats.cpuMaxUs);
+    out += "\"sections_avg_us\":{";
+    for (int i = 0; i < static_cast<int>(UiSection::Count); ++i) {
+        field(FrameProfiler::Name(static_cast<UiSection>(i)), stats.sectionSumUs[i] / frames,
+              i + 1 == static_cast<int>(UiSection::Count));
+    }
+    out += "},";
+    field("vtx_avg", static_cast<double>(stats.vertices) / frames);
+    field("idx_avg", static_cast<double>(stats.indices) / frames);
+    field("allocs_per_frame", static_cast<double>(stats.allocs) / frames);
+    field("alloc_bytes_per_frame", static_cast<double>(stats.allocBytes) / frames, true);
+    out += "}\n";
+}
+}  // namespace
+
+int RunUiBenchmark(App& app, const std::wstring& scriptPath) {
+    std::vector<UiStep> steps;
+    if (scriptPath.empty()) {
+        steps = DefaultUiScript();
+    } else if (!LoadUiScript(scriptPath, steps)) {
+        return 1;
+    }
+
+    ImGui::SetAllocatorFunctions(CountingAlloc, CountingFree, &g_allocs);
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+    io.IniFilename = nullptr;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+
+    app.isForeground = true;
+    app.profiler.enabled = true;
+    app.ApplySystemTheme();
+    app.RebuildFonts();
+    // Typed paths are validated as in window mode, so their status lookups are part of the timings
+    app.pathValidator = std::make_unique<PathValidator>();
+
+    // Warm-up frame builds the font atlas and window state outside the measurements
+    StepStats warmup;
+    RunFrame(app, warmup);
+
+    std::string report;
+    for (const UiStep& step : steps) {
+        StepStats stats;
+        RunStep(app, step, stats);
+        AppendStepJson(report, step, stats);
+    }
+
+    app.pathValidator.reset();
+    ImGui::DestroyContext();
+    WriteUtf8ToStdout(report);
+    return 0;
+}
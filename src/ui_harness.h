@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+struct App;
+
+// Headless UI benchmark ("--ui-bench [script]"). Drives App::RenderUI against a null renderer
+// (no window, no D3D device) with scripted input and writes one JSON object per script step
+// to stdout: frame CPU time, per-section time, vertex/index counts and ImGui allocations.
+//
+// Script lines ('#' starts a comment):
+//   idle <frames>            render unchanged frames
+//   type <1|2> <text>        click a path input and type text, one character per frame
+//   drop <path>[|<path>...]  drop items on the window
+//   dpi <scale>              switch DPI scale and rebuild fonts
+//   theme                    re-apply the system theme
+//   queue <count>            append synthetic pairs to the swap queue (never run)
+// An empty script path runs the built-in scenario.
+// Returns 0 on success, 1 if the script could not be read.
+int RunUiBenchmark(App& app, const std::wstring& scriptPath);
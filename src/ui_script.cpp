@@ -0,0 +1,99 @@
+#include "ui_script.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+bool ParseUiStep(const std::string& line, UiStep& step) {
+    std::istringstream in(line);
+    std::string verb;
+    in >> verb;
+    step.label = line;
+    if (verb == "idle") {
+        step.kind = UiStepKind::Idle;
+        int frames = 0;
+        if (in >> frames) step.frames = frames;
+    } else if (verb == "type") {
+        step.kind = UiStepKind::Type;
+        in >> step.field;
+        in >> std::ws;
+        std::getline(in, step.text);
+    } else if (verb == "drop") {
+        step.kind = UiStepKind::Drop;
+        in >> std::ws;
+        std::getline(in, step.text);
+    } else if (verb == "dpi") {
+        step.kind = UiStepKind::Dpi;
+        in >> step.value;
+    } else if (verb == "theme") {
+        step.kind = UiStepKind::Theme;
+    } else if (verb == "queue") {
+        step.kind = UiStepKind::Queue;
+        in >> step.value;
+    } else {
+        return false;
+    }
+    return !in.bad() && step.frames > 0 && (step.kind != UiStepKind::Dpi || step.value > 0.0f) &&
+           (step.kind != UiStepKind::Queue || step.value >= 1.0f);
+}
+
+bool LoadUiScript(const std::wstring& path, std::vector<UiStep>& steps) {
+    std::ifstream file{std::filesystem::path(path)};
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+        UiStep step;
+        if (!ParseUiStep(line.substr(first), step)) {
+            return false;
+        }
+        steps.push_back(std::move(step));
+    }
+    return true;
+}
+
+std::vector<UiStep> DefaultUiScript() {
+    const char* lines[] = {
+        "idle 120",
+        "type 1 C:\\Users\\bench\\Documents\\Reports\\2024\\quarterly-report-final.xlsx",
+        "type 2 D:\\Archive\\Reports\\2024\\quarterly-report-draft.xlsx",
+        "idle 120",
+        "drop C:\\Projects\\alpha\\config.prod.json|C:\\Projects\\alpha\\config.staging.json",
+        "dpi 1.5",
+        "dpi 1.0",
+        "theme",
+        "queue 10",
+        "queue 990",
+        "queue 99000",
+    };
+    std::vector<UiStep> steps;
+    for (const char* line : lines) {
+        UiStep step;
+        ParseUiStep(line, step);
+        steps.push_back(std::move(step));
+    }
+    return steps;
+}
+
+std::vector<std::string> SplitCodePoints(const std::string& text) {
+    std::vector<std::string> out;
+    for (size_t i = 0; i < text.size();) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        const size_t len = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : 4;
+        out.push_back(text.substr(i, len));
+        i += len;
+    }
+    return out;
+}
+
+std::vector<std::string> SplitDropPaths(const std::string& text) {
+    std::vector<std::string> files;
+    std::istringstream in(text);
+    std::string file;
+    while (std::getline(in, file, '|')) files.push_back(file);
+    return files;
+}
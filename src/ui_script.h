@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Script of the headless UI benchmark (see ui_harness.h for the line format)
+enum class UiStepKind { Idle, Type, Drop, Dpi, Theme, Queue };
+
+struct UiStep {
+    std::string label;  // Script line, echoed in the report
+    UiStepKind kind = UiStepKind::Idle;
+    int field = 1;       // Type: 1 or 2
+    std::string text;    // Type: the text; Drop: paths separated by '|'
+    float value = 0.0f;  // Dpi: the scale; Queue: the pair count
+    int frames = 60;     // Rendered after the step's input, to let it settle
+};
+
+// Parse one script line with its leading whitespace stripped; false on an unknown verb or a bad argument
+bool ParseUiStep(const std::string& line, UiStep& step);
+
+// Read a script file, skipping blank lines and '#' comments; false if it cannot be read or a line is bad
+bool LoadUiScript(const std::wstring& path, std::vector<UiStep>& steps);
+
+// The built-in scenario, run when no script is given
+std::vector<UiStep> DefaultUiScript();
+
+// Split a UTF-8 string into one string per code point, as a typist would enter it
+std::vector<std::string> SplitCodePoints(const std::string& text);
+
+// The paths of a drop step
+std::vector<std::string> SplitDropPaths(const std::string& text);
@@ -1,5 +1,7 @@
 #include "utils.h"
 
+#include "exchange.h"
+
 #include <shellapi.h>
 
 std::string Utf16ToUtf8(const std::wstring& wstr) {
@@ -17,7 +19,7 @@ std::string Utf16ToUtf8(const std::wstring& wstr) {
     return result;
 }
 
-std::wstring Utf8ToUtf16(const std::string& str) {
+std::wstring Utf8ToUtf16(std::string_view str) {
     if (str.empty()) {
         return {};
     }
@@ -30,6 +32,36 @@ std::wstring Utf8ToUtf16(const std::string& str) {
     return result;
 }
 
+int ResultFromWin32Error(DWORD error) {
+    switch (error) {
+        case ERROR_FILE_NOT_FOUND:
+        case ERROR_PATH_NOT_FOUND:
+            return kResultNoExist;
+        case ERROR_ACCESS_DENIED:
+        case ERROR_SHARING_VIOLATION:
+        case ERROR_LOCK_VIOLATION:
+            return kResultPermissionDenied;
+        case ERROR_ALREADY_EXISTS:
+        case ERROR_FILE_EXISTS:
+            return kResultAlreadyExists;
+        case ERROR_INVALID_NAME:
+        case ERROR_BAD_PATHNAME:
+        case ERROR_INVALID_HANDLE:
+            return kResultInvalidPath;
+        default:
+            return -1;
+    }
+}
+
+bool WriteUtf8ToStdout(const std::string& text) {
+    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (hOut == nullptr || hOut == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD written = 0;
+    return WriteFile(hOut, text.data(), static_cast<DWORD>(text.size()), &written, nullptr) != 0;
+}
+
 bool IsRunAsAdmin() {
     BOOL isAdmin = FALSE;
     PSID adminGroup = nullptr;
@@ -43,7 +75,48 @@ bool IsRunAsAdmin() {
     return isAdmin != FALSE;
 }
 
-static bool LaunchUnelevatedViaExplorer(const wchar_t* exePath) {
+// Quote arg so that CommandLineToArgvW reads it back unchanged
+static std::wstring QuoteArgument(const std::wstring& arg) {
+    if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos) {
+        return arg;
+    }
+    std::wstring quoted = L"\"";
+    for (size_t i = 0;; ++i) {
+        size_t backslashes = 0;
+        while (i < arg.size() && arg[i] == L'\\') {
+            ++backslashes;
+            ++i;
+        }
+        if (i == arg.size()) {
+            // Backslashes before the closing quote are doubled so that it stays a quote
+            quoted.append(backslashes * 2, L'\\');
+            break;
+        }
+        if (arg[i] == L'"') {
+            quoted.append(backslashes * 2 + 1, L'\\');
+        } else {
+            quoted.append(backslashes, L'\\');
+        }
+        quoted += arg[i];
+    }
+    quoted += L'"';
+    return quoted;
+}
+
+// The switches and arguments this process was started with (argv[0] excluded), quoted again
+static std::wstring ForwardedArguments() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    std::wstring arguments;
+    for (int i = 1; argv && i < argc; ++i) {
+        if (!arguments.empty()) arguments += L' ';
+        arguments += QuoteArgument(argv[i]);
+    }
+    if (argv) LocalFree(argv);
+    return arguments;
+}
+
+static bool LaunchUnelevatedViaExplorer(const wchar_t* exePath, const std::wstring& arguments) {
     HWND shellWnd = GetShellWindow();
     if (!shellWnd) return false;
 
@@ -71,7 +144,10 @@ static bool LaunchUnelevatedViaExplorer(const wchar_t* exePath) {
     si.cb = sizeof(si);
     PROCESS_INFORMATION pi{};
 
-    ok = CreateProcessWithTokenW(hPrimaryToken, 0, exePath, nullptr, 0, nullptr, nullptr, &si, &pi);
+    // The command line must be writable, and its first token is argv[0] of the new process
+    std::wstring commandLine = QuoteArgument(exePath);
+    if (!arguments.empty()) commandLine += L' ' + arguments;
+    ok = CreateProcessWithTokenW(hPrimaryToken, 0, exePath, commandLine.data(), 0, nullptr, nullptr, &si, &pi);
 
     CloseHandle(hPrimaryToken);
 
@@ -92,6 +168,8 @@ bool RunAsAdmin(bool privilege) {
         return false;
     }
     szPath.resize(len);
+    // The new instance gets the same switches (--watch, --pair-rule, --verify, ...)
+    const std::wstring arguments = ForwardedArguments();
 
     // Release the mutex so the new elevated instance can start
     if (g_hMutex) {
@@ -105,13 +183,14 @@ bool RunAsAdmin(bool privilege) {
         sei.cbSize = sizeof(sei);
         sei.lpVerb = L"runas";
         sei.lpFile = szPath.c_str();
+        sei.lpParameters = arguments.empty() ? nullptr : arguments.c_str();
         sei.hwnd = nullptr;
         sei.nShow = SW_NORMAL;
         if (ShellExecuteExW(&sei)) {
             ExitProcess(0);
         }
     } else {
-        if (LaunchUnelevatedViaExplorer(szPath.c_str())) {
+        if (LaunchUnelevatedViaExplorer(szPath.c_str(), arguments)) {
             ExitProcess(0);
         }
     }
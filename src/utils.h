@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <windows.h>
 
 const wchar_t PROCESS_MUTEX_GUID[] = L"CFFD3CF9A003453C9893A8CD49EF7ED5";
@@ -8,11 +9,18 @@ const wchar_t PROCESS_MUTEX_GUID[] = L"CFFD3CF9A003453C9893A8CD49EF7ED5";
 // Convert UTF-16 (wchar_t) to UTF-8 (std::string)
 std::string Utf16ToUtf8(const std::wstring& wstr);
 
-// Convert UTF-8 (std::string) to UTF-16 (std::wstring)
-std::wstring Utf8ToUtf16(const std::string& str);
+// Convert UTF-8 to UTF-16 (std::wstring)
+std::wstring Utf8ToUtf16(std::string_view str);
+
+// Map a Win32 error from a failed rename or open to an exchange() code; -1 if none fits
+int ResultFromWin32Error(DWORD error);
+
+// Write UTF-8 bytes to stdout unchanged (for machine-readable output); false if there is no stdout
+bool WriteUtf8ToStdout(const std::string& text);
 
 // Check if the current process is running as administrator
 bool IsRunAsAdmin();
 
-// Relaunch the current process with admin privileges (UAC prompt)
+// Relaunch the current process with admin privileges (UAC prompt), or without them; the new process
+// gets the same command line
 bool RunAsAdmin(bool privilege);
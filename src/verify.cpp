@@ -0,0 +1,250 @@
+#include "verify.h"
+
+#include "content_hash.h"
+#include "exchange.h"
+#include "parallel.h"
+#include "utils.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+// Fixed segment size keeps the combined hash independent of the thread count.
+// Must stay a multiple of the 64 KiB allocation granularity required by MapViewOfFile.
+constexpr uint64_t kSegmentSize = 16ULL << 20;
+
+struct Fingerprint {
+    bool valid = false;
+    bool isDirectory = false;
+    bool stableId = false;  // Volume keeps file IDs across renames (NTFS, ReFS)
+    ULONGLONG volumeSerial = 0;
+    FILE_ID_128 fileId = {};
+    uint64_t size = 0;
+    bool hashed = false;
+    uint64_t hash = 0;
+};
+
+bool IsZeroId(const FILE_ID_128& id) {
+    for (BYTE b : id.Identifier) {
+        if (b != 0) return false;
+    }
+    return true;
+}
+
+Fingerprint Capture(const std::wstring& path) {
+    Fingerprint fp;
+    HANDLE h = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        return fp;
+    }
+
+    FILE_STANDARD_INFO standard = {};
+    if (!GetFileInformationByHandleEx(h, FileStandardInfo, &standard, sizeof(standard))) {
+        CloseHandle(h);
+        return fp;
+    }
+    fp.isDirectory = standard.Directory != FALSE;
+    fp.size = static_cast<uint64_t>(standard.EndOfFile.QuadPart);
+
+    FILE_ID_INFO idInfo = {};
+    if (GetFileInformationByHandleEx(h, FileIdInfo, &idInfo, sizeof(idInfo))) {
+        fp.volumeSerial = idInfo.VolumeSerialNumber;
+        fp.fileId = idInfo.FileId;
+    } else {
+        BY_HANDLE_FILE_INFORMATION info = {};
+        if (GetFileInformationByHandle(h, &info)) {
+            const ULONGLONG index = (static_cast<ULONGLONG>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+            fp.volumeSerial = info.dwVolumeSerialNumber;
+            std::memcpy(fp.fileId.Identifier, &index, sizeof(index));
+        }
+    }
+
+    DWORD fsFlags = 0;
+    if (GetVolumeInformationByHandleW(h, nullptr, 0, nullptr, nullptr, &fsFlags, nullptr, 0)) {
+        fp.stableId = (fsFlags & FILE_SUPPORTS_OPEN_BY_FILE_ID) != 0 && !IsZeroId(fp.fileId);
+    }
+
+    CloseHandle(h);
+    fp.valid = true;
+    return fp;
+}
+
+bool SameIdentity(const Fingerprint& a, const Fingerprint& b) {
+    return a.volumeSerial == b.volumeSerial && std::memcmp(&a.fileId, &b.fileId, sizeof(a.fileId)) == 0;
+}
+
+// SEH cannot live in a function with C++ unwinding, so the mapped read is isolated here.
+// A network or removable volume may fail the page-in, which surfaces as EXCEPTION_IN_PAGE_ERROR.
+bool HashMappedView(const void* view, size_t size, uint64_t* out) {
+    __try {
+        *out = HashBytes(view, size);
+        return true;
+    } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER
+                                                               : EXCEPTION_CONTINUE_SEARCH) {
+        return false;
+    }
+}
+
+uint64_t HashDirectoryListing(const std::wstring& path, bool& ok) {
+    std::vector<std::wstring> names;
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileExW((path + L"\\*").c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr,
+                                    FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        ok = GetLastError() == ERROR_FILE_NOT_FOUND;
+        return 0;
+    }
+    do {
+        names.emplace_back(fd.cFileName);
+    } while (FindNextFileW(hFind, &fd));
+    FindClose(hFind);
+
+    std::sort(names.begin(), names.end());
+    uint64_t h = names.size();
+    for (const auto& name : names) {
+        h = CombineHashes(h, HashBytes(name.data(), name.size() * sizeof(wchar_t)));
+    }
+    ok = true;
+    return h;
+}
+
+struct HashJob {
+    const std::wstring* path = nullptr;
+    Fingerprint* fp = nullptr;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    std::vector<uint64_t> segments;
+    std::atomic<bool> failed{false};
+};
+
+// Fill in the content hash of every fingerprint; segments of all files share one pool
+void HashContents(const std::vector<const std::wstring*>& paths, const std::vector<Fingerprint*>& fps) {
+    std::vector<HashJob> jobs(paths.size());
+    struct Segment {
+        size_t job;
+        size_t index;
+    };
+    std::vector<Segment> work;
+
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        HashJob& job = jobs[j];
+        job.path = paths[j];
+        job.fp = fps[j];
+        if (job.fp->isDirectory) {
+            bool ok = false;
+            job.fp->hash = HashDirectoryListing(*job.path, ok);
+            job.fp->hashed = ok;
+            continue;
+        }
+        if (job.fp->size == 0) {
+            continue;
+        }
+
+        job.file = CreateFileW(job.path->c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (job.file != INVALID_HANDLE_VALUE) {
+            job.mapping = CreateFileMappingW(job.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        if (!job.mapping) {
+            job.failed = true;
+            continue;
+        }
+
+        const size_t count = static_cast<size_t>((job.fp->size + kSegmentSize - 1) / kSegmentSize);
+        job.segments.assign(count, 0);
+        for (size_t s = 0; s < count; ++s) {
+            work.push_back({j, s});
+        }
+    }
+
+    ParallelFor(work.size(), [&](size_t i) {
+        HashJob& job = jobs[work[i].job];
+        const uint64_t offset = work[i].index * kSegmentSize;
+        const size_t length = static_cast<size_t>((std::min)(kSegmentSize, job.fp->size - offset));
+        const void* view = MapViewOfFile(job.mapping, FILE_MAP_READ, static_cast<DWORD>(offset >> 32),
+                                         static_cast<DWORD>(offset & 0xFFFFFFFFULL), length);
+        if (!view || !HashMappedView(view, length, &job.segments[work[i].index])) {
+            job.failed = true;
+        }
+        if (view) {
+            UnmapViewOfFile(view);
+        }
+    });
+
+    for (HashJob& job : jobs) {
+        if (job.mapping) CloseHandle(job.mapping);
+        if (job.file != INVALID_HANDLE_VALUE) CloseHandle(job.file);
+        if (job.fp->isDirectory || job.failed) {
+            continue;
+        }
+        uint64_t h = job.fp->size;
+        for (uint64_t segment : job.segments) {
+            h = CombineHashes(h, segment);
+        }
+        job.fp->hash = h;
+        job.fp->hashed = true;
+    }
+}
+
+bool SameContent(const Fingerprint& a, const Fingerprint& b) {
+    return a.hashed && b.hashed && a.isDirectory == b.isDirectory && a.size == b.size && a.hash == b.hash;
+}
+
+}  // namespace
+
+// Where the item that lived at `from` is expected to be after swapping names with `other`.
+// Names are swapped in place, so the item stays in its own parent directory.
+std::wstring SwappedLocation(const std::wstring& from, const std::wstring& other, bool isDirectory, bool preserveExt) {
+    const std::filesystem::path fromPath(from);
+    const std::filesystem::path otherPath(other);
+    if (preserveExt && !isDirectory) {
+        return (fromPath.parent_path() / (otherPath.stem().wstring() + fromPath.extension().wstring())).wstring();
+    }
+    return (fromPath.parent_path() / otherPath.filename()).wstring();
+}
+
+int ExchangeVerified(const std::string& path1, const std::string& path2, bool preserveExt) {
+    const std::wstring w1 = Utf8ToUtf16(path1);
+    const std::wstring w2 = Utf8ToUtf16(path2);
+
+    Fingerprint before1 = Capture(w1);
+    Fingerprint before2 = Capture(w2);
+    if (!before1.valid || !before2.valid) {
+        // Let the library report the precise reason
+        return exchange(path1.c_str(), path2.c_str(), preserveExt);
+    }
+
+    // Identity alone proves the swap when both volumes keep file IDs across renames
+    const bool needHash = !(before1.stableId && before2.stableId);
+    if (needHash) {
+        HashContents({&w1, &w2}, {&before1, &before2});
+        if (!before1.hashed || !before2.hashed) {
+            return kResultVerifyFailed;
+        }
+    }
+
+    const int returnId = exchange(path1.c_str(), path2.c_str(), preserveExt);
+    if (returnId != kResultSuccess) {
+        return returnId;
+    }
+
+    const std::wstring now1 = SwappedLocation(w1, w2, before1.isDirectory, preserveExt);
+    const std::wstring now2 = SwappedLocation(w2, w1, before2.isDirectory, preserveExt);
+    Fingerprint after1 = Capture(now1);
+    Fingerprint after2 = Capture(now2);
+    if (!after1.valid || !after2.valid) {
+        return kResultVerifyFailed;
+    }
+
+    if (!needHash) {
+        return (SameIdentity(before1, after1) && SameIdentity(before2, after2)) ? kResultSuccess : kResultVerifyFailed;
+    }
+
+    HashContents({&now1, &now2}, {&after1, &after2});
+    return (SameContent(before1, after1) && SameContent(before2, after2)) ? kResultSuccess : kResultVerifyFailed;
+}
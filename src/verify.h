@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// Run exchange() and check afterwards that each name points at the other's former content.
+// File identity (volume serial + file ID) is compared first; content is hashed over memory-mapped
+// views only on volumes whose file IDs do not survive a rename.
+// Returns the exchange() code, or kResultVerifyFailed if the swap did not land as expected.
+int ExchangeVerified(const std::string& path1, const std::string& path2, bool preserveExt);
+
+// Where the item that lived at `from` is expected to be after swapping names with `other`.
+// Names are swapped in place, so the item stays in its own parent directory.
+std::wstring SwappedLocation(const std::wstring& from, const std::wstring& other, bool isDirectory, bool preserveExt);
@@ -0,0 +1,117 @@
+#include "vfs.h"
+
+#include "collision_index.h"
+#include "exchange.h"
+#include "metadata_swap.h"
+#include "path_lock.h"
+#include "utils.h"
+#include "verify.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cwchar>
+#include <random>
+
+namespace {
+// exchange() stats both items and renames three times; count the renames as the round trips
+constexpr int kExchangeRoundTrips = 3;
+
+// Sleep() rounds up to the 15.6 ms scheduler tick, which would swamp a 5 ms RTT
+void PreciseSleep(double ms) {
+    if (ms <= 0.0) return;
+    thread_local HANDLE timer =
+        CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    LARGE_INTEGER due;
+    due.QuadPart = -static_cast<LONGLONG>(ms * 10000.0);  // Relative, in 100 ns units
+    if (timer && SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+        WaitForSingleObject(timer, INFINITE);
+    } else {
+        Sleep(static_cast<DWORD>(ms + 0.5));
+    }
+}
+}  // namespace
+
+int NativeVfs::Probe(const std::string& path) {
+    if (GetFileAttributesW(Utf8ToUtf16(path).c_str()) != INVALID_FILE_ATTRIBUTES) {
+        return kResultSuccess;
+    }
+    switch (GetLastError()) {
+        case ERROR_FILE_NOT_FOUND:
+        case ERROR_PATH_NOT_FOUND:
+            return kResultNoExist;
+        case ERROR_INVALID_NAME:
+        case ERROR_BAD_PATHNAME:
+            return kResultInvalidPath;
+        default:
+            return kResultSuccess;
+    }
+}
+
+int NativeVfs::Exchange(const std::string& path1, const std::string& path2, bool preserveExt) {
+    const std::wstring w1 = Utf8ToUtf16(path1);
+    const std::wstring w2 = Utf8ToUtf16(path2);
+    const PathPairLock lock(w1, w2);
+    if (!lock.OwnsLock()) {
+        return kResultPermissionDenied;
+    }
+    const auto swap = [&] {
+        if (IsCaseOnlySwap(w1, w2, preserveExt)) {
+            return ExchangeCaseOnly(w1, w2, preserveExt);
+        }
+        if (verify_) {
+            return ExchangeVerified(path1, path2, preserveExt);
+        }
+        return exchange(path1.c_str(), path2.c_str(), preserveExt);
+    };
+    return metadata_ ? ExchangeWithMetadata(w1, w2, metadata_, swap) : swap();
+}
+
+bool ParseLatencyProfile(const std::wstring& spec, LatencyProfile& profile) {
+    LatencyProfile parsed;
+    double* parsedFields[] = {&parsed.rttMs, &parsed.jitterMs, &parsed.errorRate};
+    size_t start = 0;
+    for (int i = 0; i < 3 && start <= spec.size(); ++i) {
+        const size_t end = (std::min)(spec.find(L':', start), spec.size());
+        const std::wstring field = spec.substr(start, end - start);
+        wchar_t* stop = nullptr;
+        *parsedFields[i] = wcstod(field.c_str(), &stop);
+        if (field.empty() || *stop != L'\0') {
+            return false;
+        }
+        start = end + 1;
+    }
+    if (start <= spec.size() || parsed.rttMs < 0.0 || parsed.jitterMs < 0.0 || parsed.jitterMs > parsed.rttMs ||
+        parsed.errorRate < 0.0 || parsed.errorRate > 1.0) {
+        return false;
+    }
+    profile = parsed;
+    return true;
+}
+
+bool SimulatedVfs::RoundTrips(int count) const {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    std::uniform_real_distribution<double> jitter(-profile_.jitterMs, profile_.jitterMs);
+    std::bernoulli_distribution fail(profile_.errorRate);
+
+    for (int i = 0; i < count; ++i) {
+        PreciseSleep(profile_.rttMs + jitter(rng));
+        if (fail(rng)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int SimulatedVfs::Probe(const std::string& path) {
+    if (path.empty()) {
+        return kResultInvalidPath;
+    }
+    return RoundTrips(1) ? kResultSuccess : kResultPermissionDenied;
+}
+
+int SimulatedVfs::Exchange(const std::string& path1, const std::string& path2, bool /*preserveExt*/) {
+    if (path1 == path2) {
+        return kResultSameFile;
+    }
+    return RoundTrips(kExchangeRoundTrips) ? kResultSuccess : kResultPermissionDenied;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// File system operations the swap engine is built on. Implementations must be safe to call from
+// several threads at once: the swap pipeline keeps independent pairs in flight concurrently.
+class Vfs {
+public:
+    virtual ~Vfs() = default;
+
+    // Check that path names an existing item: kResultSuccess, kResultNoExist or kResultInvalidPath.
+    // Failures that are none of these return kResultSuccess so the swap reports them precisely.
+    virtual int Probe(const std::string& path) = 0;
+
+    // Swap the names of two items; returns an exchange() code
+    virtual int Exchange(const std::string& path1, const std::string& path2, bool preserveExt) = 0;
+};
+
+// The real file system through exchange(). Each swap holds a PathPairLock and, with verify set,
+// is checked by file identity / content hash (see ExchangeVerified). Pairs whose names only change
+// case go through ExchangeCaseOnly, which exchange() cannot do on a case-insensitive volume.
+// metadata selects MetadataClass bits that stay with the names (see ExchangeWithMetadata).
+class NativeVfs final : public Vfs {
+public:
+    explicit NativeVfs(bool verify, uint32_t metadata = 0) : verify_(verify), metadata_(metadata) {}
+
+    int Probe(const std::string& path) override;
+    int Exchange(const std::string& path1, const std::string& path2, bool preserveExt) override;
+
+private:
+    bool verify_;
+    uint32_t metadata_;
+};
+
+// "--simulate-latency <rtt>[:<jitter>[:<error rate>]]", times in milliseconds
+struct LatencyProfile {
+    double rttMs = 0.0;
+    double jitterMs = 0.0;  // Each round trip takes rtt +/- a uniform share of this
+    double errorRate = 0.0;  // Probability in [0, 1] that an operation fails
+};
+
+// Parse a latency spec; false if it is malformed or out of range
+bool ParseLatencyProfile(const std::wstring& spec, LatencyProfile& profile);
+
+// Stand-in for a remote share that never touches the disk: every path exists and every swap
+// succeeds, but each metadata round trip costs rtt +/- jitter, and a share of operations fail
+// with kResultPermissionDenied. Lets the pipelining be measured on any machine.
+class SimulatedVfs final : public Vfs {
+public:
+    explicit SimulatedVfs(const LatencyProfile& profile) : profile_(profile) {}
+
+    int Probe(const std::string& path) override;
+    int Exchange(const std::string& path1, const std::string& path2, bool preserveExt) override;
+
+private:
+    // Wait out the given number of round trips; false if the operation should fail
+    bool RoundTrips(int count) const;
+
+    LatencyProfile profile_;
+};
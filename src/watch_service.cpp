@@ -0,0 +1,162 @@
+#include "watch_service.h"
+
+#include "utils.h"
+
+namespace {
+// A name must stay quiet this long before it is considered written
+constexpr auto kDebounce = std::chrono::milliseconds(300);
+// How often settled names are collected while any are pending
+constexpr DWORD kFlushTickMs = 50;
+// Swapped-in IDs that are never seen again (e.g. failed swaps) are dropped past this size
+constexpr size_t kMaxSwappedIn = 4096;
+
+void LowerInto(std::wstring& out, std::wstring_view text) {
+    out.assign(text);
+    if (!out.empty()) CharLowerBuffW(out.data(), static_cast<DWORD>(out.size()));
+}
+
+bool QueryFileId(const std::wstring& path, std::pair<DWORD, uint64_t>& id) {
+    HANDLE h = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info = {};
+    const bool ok = GetFileInformationByHandle(h, &info) != FALSE;
+    CloseHandle(h);
+    id = {info.dwVolumeSerialNumber, (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow};
+    return ok;
+}
+
+bool Exists(const std::wstring& path) { return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES; }
+}  // namespace
+
+bool ParseWatchRule(const std::wstring& dir, const std::wstring& pattern, WatchRule& rule) {
+    if (dir.empty() || pattern.size() < 3 || pattern[0] != L'*' || pattern[1] != L'.' ||
+        pattern.find_first_of(L"*?\\/", 1) != std::wstring::npos || pattern.back() == L'.') {
+        return false;
+    }
+    rule.dir = dir;
+    while (rule.dir.size() > 3 && (rule.dir.back() == L'\\' || rule.dir.back() == L'/')) rule.dir.pop_back();
+    rule.suffix = pattern.substr(1);
+    return true;
+}
+
+bool WatchService::Start(const std::vector<WatchRule>& rules, Sink sink, std::wstring& failedDir) {
+    Stop();
+    folders_.clear();
+    for (const WatchRule& rule : rules) {
+        std::wstring dirKey;
+        LowerInto(dirKey, rule.dir);
+        FolderRules* folder = nullptr;
+        for (FolderRules& existing : folders_) {
+            std::wstring existingKey;
+            LowerInto(existingKey, existing.path);
+            if (existingKey == dirKey) folder = &existing;
+        }
+        if (!folder) {
+            folders_.push_back(FolderRules{rule.dir, {}});
+            folder = &folders_.back();
+        }
+        std::wstring suffix;
+        LowerInto(suffix, rule.suffix);
+        folder->suffixesByExt[suffix.substr(suffix.rfind(L'.'))].push_back(suffix);
+    }
+
+    for (const FolderRules& folder : folders_) {
+        if (watcher_.Add(folder.path) == SIZE_MAX) {
+            failedDir = folder.path;
+            return false;
+        }
+    }
+
+    sink_ = std::move(sink);
+    thread_ = std::thread(&WatchService::ThreadLoop, this);
+    return true;
+}
+
+void WatchService::Stop() {
+    if (thread_.joinable()) {
+        watcher_.Interrupt();
+        thread_.join();
+    }
+}
+
+void WatchService::ThreadLoop() {
+    // Pairs that were already waiting before we started count as freshly arrived
+    for (size_t i = 0; i < folders_.size(); ++i) Rescan(i);
+
+    auto onChange = [this](size_t dir, std::wstring_view name) { OnChange(dir, name); };
+    auto onOverflow = [this](size_t dir) { Rescan(dir); };
+    auto lastFlush = std::chrono::steady_clock::now();
+    while (watcher_.Poll(pending_.empty() ? INFINITE : kFlushTickMs, onChange, onOverflow)) {
+        // Under an event storm Poll never times out, so flush on elapsed time rather than on idle
+        const auto now = std::chrono::steady_clock::now();
+        if (!pending_.empty() && now - lastFlush >= std::chrono::milliseconds(kFlushTickMs)) {
+            FlushSettled(now);
+            lastFlush = now;
+        }
+    }
+}
+
+void WatchService::OnChange(size_t dir, std::wstring_view name) {
+    // Cheap rejection first: most events in a busy folder have an extension no rule cares about
+    const size_t dot = name.rfind(L'.');
+    if (dot == std::wstring_view::npos) return;
+    LowerInto(lowerScratch_, name.substr(dot));
+    const auto& index = folders_[dir].suffixesByExt;
+    const auto it = index.find(lowerScratch_);
+    if (it == index.end()) return;
+
+    LowerInto(lowerScratch_, name);
+    for (const std::wstring& suffix : it->second) {
+        if (lowerScratch_.size() <= suffix.size() ||
+            lowerScratch_.compare(lowerScratch_.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        Pending& entry = pending_[std::to_wstring(dir) + L'|' + lowerScratch_];
+        entry.dir = dir;
+        entry.name.assign(name);
+        entry.suffixLength = suffix.size();
+        entry.deadline = std::chrono::steady_clock::now() + kDebounce;
+        return;
+    }
+}
+
+void WatchService::Rescan(size_t dir) {
+    WIN32_FIND_DATAW data;
+    const std::wstring pattern = folders_[dir].path + L"\\*";
+    HANDLE find = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr,
+                                   FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) return;
+    do {
+        OnChange(dir, data.cFileName);
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+}
+
+void WatchService::FlushSettled(std::chrono::steady_clock::time_point now) {
+    SwapBatch batch;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        const Pending& entry = it->second;
+        if (entry.deadline > now) {
+            ++it;
+            continue;
+        }
+
+        const std::wstring& folder = folders_[entry.dir].path;
+        const std::wstring trigger = folder + L'\\' + entry.name;
+        const std::wstring target = folder + L'\\' + entry.name.substr(0, entry.name.size() - entry.suffixLength);
+        it = pending_.erase(it);
+
+        std::pair<DWORD, uint64_t> id;
+        if (!Exists(target) || !QueryFileId(trigger, id)) continue;
+        // Our own swap renames the old target onto the trigger name; don't swap it straight back
+        if (swappedIn_.erase(id) != 0) continue;
+        if (QueryFileId(target, id)) {
+            if (swappedIn_.size() >= kMaxSwappedIn) swappedIn_.clear();
+            swappedIn_.insert(id);
+        }
+
+        batch.Add(Utf16ToUtf8(trigger), Utf16ToUtf8(target), false);
+    }
+    if (!batch.entries.empty()) sink_(std::move(batch));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "folder_watcher.h"
+#include "swap_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// "--watch <dir> <pattern>": when a name matching pattern settles in dir next to the same name
+// without the pattern's suffix, the two are swapped (full names), e.g. "*.new" swaps "X.new" with "X".
+struct WatchRule {
+    std::wstring dir;
+    std::wstring suffix;  // Pattern without the leading '*', e.g. L".new"
+};
+
+// Accepts patterns of the form "*.<ext>" (ext may itself contain dots); false otherwise
+bool ParseWatchRule(const std::wstring& dir, const std::wstring& pattern, WatchRule& rule);
+
+// Resident watcher that turns folder notifications into swap pairs. Bursts for the same name are
+// coalesced until the name has been quiet for the debounce interval; everything that settles in
+// one pass is handed to the sink as a single batch.
+class WatchService {
+public:
+    using Sink = std::function<void(SwapBatch batch)>;
+
+    WatchService() = default;
+    WatchService(const WatchService&) = delete;
+    WatchService& operator=(const WatchService&) = delete;
+    ~WatchService() { Stop(); }
+
+    // Start watching; returns false and names the folder in failedDir if one cannot be watched.
+    // sink runs on the watch thread.
+    bool Start(const std::vector<WatchRule>& rules, Sink sink, std::wstring& failedDir);
+    void Stop();
+
+    bool IsActive() const { return thread_.joinable(); }
+
+private:
+    // Rules for one folder, indexed by the last extension of their suffix (lower-case, with the dot)
+    struct FolderRules {
+        std::wstring path;
+        std::unordered_map<std::wstring, std::vector<std::wstring>> suffixesByExt;
+    };
+
+    struct Pending {
+        size_t dir = 0;
+        std::wstring name;  // Trigger name as reported (original case)
+        size_t suffixLength = 0;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void ThreadLoop();
+    void OnChange(size_t dir, std::wstring_view name);
+    void Rescan(size_t dir);
+    void FlushSettled(std::chrono::steady_clock::time_point now);
+
+    FolderWatcher watcher_;
+    std::vector<FolderRules> folders_;
+    std::unordered_map<std::wstring, Pending> pending_;  // Keyed by folder index + lower-case name
+    std::set<std::pair<DWORD, uint64_t>> swappedIn_;     // IDs of targets we moved onto a trigger name
+    std::wstring lowerScratch_;
+    Sink sink_;
+    std::thread thread_;
+};
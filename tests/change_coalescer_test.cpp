@@ -0,0 +1,77 @@
+#include "change_coalescer.h"
+
+#include "check.h"
+
+#include <chrono>
+
+namespace {
+using std::chrono::milliseconds;
+using Clock = ChangeCoalescer::Clock;
+
+// The theme refresh window: 150 ms of quiet, at most 1 s after the first event
+ChangeCoalescer ThemeCoalescer() { return ChangeCoalescer(milliseconds(150), milliseconds(1000)); }
+
+void TestSingleEventWaitsForQuiet() {
+    ChangeCoalescer coalescer = ThemeCoalescer();
+    const Clock::time_point t0{};
+    CHECK(!coalescer.Pending());
+    CHECK(!coalescer.Poll(t0 + milliseconds(500)));
+
+    CHECK(coalescer.Notify(t0) == t0 + milliseconds(150));
+    CHECK(coalescer.Pending());
+    CHECK(!coalescer.Poll(t0 + milliseconds(149)));
+    CHECK(coalescer.Poll(t0 + milliseconds(150)));
+    // Reported once per burst
+    CHECK(!coalescer.Pending());
+    CHECK(!coalescer.Poll(t0 + milliseconds(400)));
+}
+
+void TestBurstExtendsDeadline() {
+    ChangeCoalescer coalescer = ThemeCoalescer();
+    const Clock::time_point t0{};
+    coalescer.Notify(t0);
+    coalescer.Notify(t0 + milliseconds(100));
+    CHECK(coalescer.Deadline() == t0 + milliseconds(250));
+    CHECK(!coalescer.Poll(t0 + milliseconds(200)));
+    CHECK(coalescer.Poll(t0 + milliseconds(250)));
+}
+
+// A storm that never goes quiet is still acted on 1 s after its first event
+void TestStormCappedAtMaxDelay() {
+    ChangeCoalescer coalescer = ThemeCoalescer();
+    const Clock::time_point t0{};
+    bool fired = false;
+    Clock::time_point firedAt{};
+    for (int ms = 0; ms <= 2000 && !fired; ms += 10) {
+        const Clock::time_point now = t0 + milliseconds(ms);
+        if (coalescer.Poll(now)) {
+            fired = true;
+            firedAt = now;
+            break;
+        }
+        CHECK(coalescer.Notify(now) <= t0 + milliseconds(1000));
+    }
+    CHECK(fired);
+    CHECK(firedAt == t0 + milliseconds(1000));
+}
+
+// After a burst fires, the next event starts a fresh window rather than inheriting the old cap
+void TestNextBurstStartsFresh() {
+    ChangeCoalescer coalescer = ThemeCoalescer();
+    const Clock::time_point t0{};
+    coalescer.Notify(t0);
+    CHECK(coalescer.Poll(t0 + milliseconds(150)));
+    const Clock::time_point t1 = t0 + milliseconds(1500);
+    CHECK(coalescer.Notify(t1) == t1 + milliseconds(150));
+    coalescer.Notify(t1 + milliseconds(900));
+    CHECK(coalescer.Deadline() == t1 + milliseconds(1000));
+}
+}  // namespace
+
+int main() {
+    TestSingleEventWaitsForQuiet();
+    TestBurstExtendsDeadline();
+    TestStormCappedAtMaxDelay();
+    TestNextBurstStartsFresh();
+    return CheckResult();
+}
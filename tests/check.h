@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the unit tests: a failed check prints where it failed and the test keeps
+// going, so one run reports every broken expectation. main() returns CheckResult().
+inline int& CheckFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                                \
+    do {                                                                                           \
+        if (!(cond)) {                                                                             \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);          \
+            ++CheckFailures();                                                                     \
+        }                                                                                          \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                             \
+    do {                                                                                           \
+        const auto& checkA_ = (a);                                                                 \
+        const auto& checkB_ = (b);                                                                 \
+        if (!(checkA_ == checkB_)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed\n", __FILE__, __LINE__, #a, #b);  \
+            ++CheckFailures();                                                                     \
+        }                                                                                          \
+    } while (0)
+
+inline int CheckResult() {
+    if (CheckFailures() != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", CheckFailures());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include "checkpoint.h"
+
+#include "check.h"
+#include "exchange.h"
+#include "manifest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+using Settled = std::vector<std::pair<uint64_t, int>>;
+
+constexpr uint64_t kHash = 0x5eed;
+
+struct Fixture {
+    fs::path dir = fs::temp_directory_path() / "nx_checkpoint_test";
+    fs::path journal = dir / "run.nxckpt";
+    Manifest manifest;
+
+    Fixture() {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+    ~Fixture() {
+        manifest.Close();
+        fs::remove_all(dir);
+    }
+
+    // Create `count` pairs a<i>.txt / b<i>.txt and map their manifest
+    bool MakePairs(int count) {
+        std::ofstream list(dir / "pairs.txt", std::ios::binary);
+        for (int i = 0; i < count; ++i) {
+            const std::string n = std::to_string(i);
+            std::ofstream(dir / ("a" + n + ".txt")) << "a" << n;
+            std::ofstream(dir / ("b" + n + ".txt")) << "b" << n;
+            list << (dir / ("a" + n + ".txt")).string() << '\n' << (dir / ("b" + n + ".txt")).string() << '\n';
+        }
+        list.close();
+        return manifest.Open((dir / "pairs.txt").wstring());
+    }
+
+    fs::path A(int i) const { return dir / ("a" + std::to_string(i) + ".txt"); }
+    fs::path B(int i) const { return dir / ("b" + std::to_string(i) + ".txt"); }
+
+    // What exchange() does to pair i, without the library
+    void SwapByHand(int i) const {
+        fs::rename(A(i), dir / "swap.tmp");
+        fs::rename(B(i), A(i));
+        fs::rename(dir / "swap.tmp", B(i));
+    }
+};
+
+void TestOpenRules() {
+    Fixture f;
+    CHECK(f.MakePairs(1));
+    {
+        Checkpoint checkpoint;
+        CHECK(checkpoint.Open(f.journal.wstring(), kHash, 1, false) == Checkpoint::OpenResult::Ok);
+        CHECK_EQ(checkpoint.Completed(), uint64_t{0});
+    }
+    // The run above never finished: its file stays and is only taken up with resume, for the same batch
+    Checkpoint checkpoint;
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 1, false) == Checkpoint::OpenResult::Unfinished);
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash + 1, 1, true) == Checkpoint::OpenResult::Invalid);
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 2, true) == Checkpoint::OpenResult::Invalid);
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 1, true) == Checkpoint::OpenResult::Ok);
+}
+
+// Killed with three pairs in flight: one never started, one finished, one stopped between renames
+void TestKillAndResume() {
+    Fixture f;
+    CHECK(f.MakePairs(4));
+    {
+        Checkpoint checkpoint;
+        CHECK(checkpoint.Open(f.journal.wstring(), kHash, 4, false) == Checkpoint::OpenResult::Ok);
+        const size_t slot = checkpoint.Begin(3, std::string(f.manifest.Path1(3)), false);
+        f.SwapByHand(3);
+        checkpoint.End(slot, 3, true);
+        for (uint64_t i = 0; i < 3; ++i) {
+            CHECK(checkpoint.Begin(i, std::string(f.manifest.Path1(i)), false) < kCheckpointSlots);
+        }
+        f.SwapByHand(1);
+        fs::rename(f.A(2), f.dir / "swap.tmp");
+        // Killed here: Close only unmaps, as the system does for a dead process
+    }
+
+    Checkpoint checkpoint;
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 4, true) == Checkpoint::OpenResult::Ok);
+    CHECK(checkpoint.Done(3));
+    CHECK_EQ(checkpoint.Recover(f.manifest), (Settled{{2, kResultResumeInDoubt}}));
+    CHECK(!checkpoint.Done(0));  // Still at path1: runs again
+    CHECK(checkpoint.Done(1));   // Found at its swapped location
+    CHECK(checkpoint.Done(2));   // In doubt: never swapped again
+    CHECK_EQ(checkpoint.Completed(), uint64_t{3});
+
+    const size_t slot = checkpoint.Begin(0, std::string(f.manifest.Path1(0)), false);
+    f.SwapByHand(0);
+    checkpoint.End(slot, 0, true);
+    CHECK_EQ(checkpoint.Completed(), uint64_t{4});
+
+    // Every pair is done, but the in-doubt one must still be reported: the file stays
+    CHECK(!checkpoint.Finish());
+    checkpoint.Close();
+    CHECK(fs::exists(f.journal));
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 4, true) == Checkpoint::OpenResult::Ok);
+    CHECK_EQ(checkpoint.Recover(f.manifest), (Settled{{2, kResultResumeInDoubt}}));
+    CHECK(!checkpoint.Finish());
+}
+
+// A pair settled as in doubt is reported by every resume, not just the first
+void TestInDoubtReportedEveryResume() {
+    Fixture f;
+    CHECK(f.MakePairs(1));
+    {
+        Checkpoint checkpoint;
+        CHECK(checkpoint.Open(f.journal.wstring(), kHash, 1, false) == Checkpoint::OpenResult::Ok);
+        CHECK(checkpoint.Begin(0, std::string(f.manifest.Path1(0)), false) < kCheckpointSlots);
+        fs::rename(f.A(0), f.dir / "swap.tmp");
+    }
+    for (int run = 0; run < 2; ++run) {
+        Checkpoint checkpoint;
+        CHECK(checkpoint.Open(f.journal.wstring(), kHash, 1, true) == Checkpoint::OpenResult::Ok);
+        CHECK_EQ(checkpoint.Recover(f.manifest), (Settled{{0, kResultResumeInDoubt}}));
+        CHECK(checkpoint.Done(0));
+    }
+}
+
+// Resumes that leave a full window of pairs in doubt use up no slots: the next run still gets a
+// valid slot for every swap it has in flight
+void TestInDoubtPairsLeaveSlotsFree() {
+    constexpr int kPairs = 2 * kCheckpointSlots;
+    Fixture f;
+    CHECK(f.MakePairs(kPairs));
+    {
+        Checkpoint checkpoint;
+        CHECK(checkpoint.Open(f.journal.wstring(), kHash, kPairs, false) == Checkpoint::OpenResult::Ok);
+        for (int i = 0; i < static_cast<int>(kCheckpointSlots); ++i) {
+            CHECK(checkpoint.Begin(i, std::string(f.manifest.Path1(i)), false) < kCheckpointSlots);
+            fs::rename(f.A(i), f.dir / ("swap" + std::to_string(i) + ".tmp"));
+        }
+    }
+    for (int run = 0; run < 2; ++run) {
+        Checkpoint checkpoint;
+        CHECK(checkpoint.Open(f.journal.wstring(), kHash, kPairs, true) == Checkpoint::OpenResult::Ok);
+        CHECK_EQ(checkpoint.Recover(f.manifest).size(), size_t{kCheckpointSlots});
+        std::vector<size_t> slots;
+        for (int i = kCheckpointSlots; i < kPairs; ++i) {
+            slots.push_back(checkpoint.Begin(i, std::string(f.manifest.Path1(i)), false));
+            CHECK(slots.back() < kCheckpointSlots);
+        }
+        // Killed with every slot in flight on the first run; the second finishes them
+        if (run == 1) {
+            for (size_t n = 0; n < slots.size(); ++n) checkpoint.End(slots[n], kCheckpointSlots + n, false);
+        }
+    }
+}
+
+// With every slot taken, Begin waits for End instead of letting a swap run unrecorded
+void TestBeginWaitsForFreeSlot() {
+    Fixture f;
+    CHECK(f.MakePairs(kCheckpointSlots + 1));
+    Checkpoint checkpoint;
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, kCheckpointSlots + 1, false) == Checkpoint::OpenResult::Ok);
+    CHECK(checkpoint.Recover(f.manifest).empty());
+    std::vector<size_t> slots;
+    for (uint64_t i = 0; i < kCheckpointSlots; ++i) {
+        slots.push_back(checkpoint.Begin(i, std::string(f.manifest.Path1(i)), false));
+    }
+
+    std::atomic<size_t> waited{kCheckpointSlots + 1};
+    std::thread waiter([&]() {
+        waited.store(checkpoint.Begin(kCheckpointSlots, std::string(f.manifest.Path1(kCheckpointSlots)), false));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK_EQ(waited.load(), size_t{kCheckpointSlots + 1});
+    checkpoint.End(slots[7], 7, true);
+    waiter.join();
+    CHECK_EQ(waited.load(), slots[7]);
+}
+
+void TestFinishDeletes() {
+    Fixture f;
+    CHECK(f.MakePairs(2));
+    Checkpoint checkpoint;
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 2, false) == Checkpoint::OpenResult::Ok);
+    CHECK(checkpoint.Recover(f.manifest).empty());
+    const size_t slot = checkpoint.Begin(0, std::string(f.manifest.Path1(0)), false);
+    checkpoint.End(slot, 0, true);
+    CHECK(!checkpoint.Finish());  // Pair 1 is still to run
+    CHECK(checkpoint.Open(f.journal.wstring(), kHash, 2, true) == Checkpoint::OpenResult::Ok);
+    CHECK(checkpoint.Done(0));
+    CHECK(!checkpoint.Done(1));
+    checkpoint.End(checkpoint.Begin(1, std::string(f.manifest.Path1(1)), false), 1, true);
+    CHECK(checkpoint.Finish());
+    CHECK(!fs::exists(f.journal));
+}
+}  // namespace
+
+int main() {
+    TestOpenRules();
+    TestKillAndResume();
+    TestInDoubtReportedEveryResume();
+    TestInDoubtPairsLeaveSlotsFree();
+    TestBeginWaitsForFreeSlot();
+    TestFinishDeletes();
+    return CheckResult();
+}
@@ -0,0 +1,93 @@
+#include "collision_index.h"
+
+#include "check.h"
+#include "exchange.h"
+#include "name_fold.h"
+#include "swap_queue.h"
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<int> Screen(const std::vector<std::vector<const char*>>& pairs, bool preserveExt = false) {
+    SwapBatch batch;
+    for (const auto& pair : pairs) batch.Add(pair[0], pair[1], preserveExt);
+    return FindNameCollisions(batch.paths, batch.entries, false);
+}
+
+void TestFoldName() {
+    CHECK(FoldName(L"readme.txt") == L"README.TXT");
+    // Long enough for the SSE2 path, with the ASCII letters next to the case bit edges
+    CHECK(FoldName(L"@abcxyz[`{AZ_0123456789") == L"@ABCXYZ[`{AZ_0123456789");
+    // Composed and decomposed e-acute fold to the same key, and so do upper and lower case
+    CHECK(FoldName(L"caf\u00e9.txt") == FoldName(L"CAFE\u0301.TXT"));
+    CHECK(FoldName(L"\u00e9") != FoldName(L"e"));
+}
+
+void TestBatchCollisions() {
+    // Both pairs would give an item the name D\b.txt
+    CHECK_EQ(Screen({{"D\\a.txt", "D\\b.txt"}, {"D\\c.txt", "E\\B.TXT"}}), (std::vector<int>{0, kResultNameCollision}));
+    // A chain: the first pair frees D\a.txt before the second takes it
+    CHECK_EQ(Screen({{"D\\a.txt", "E\\x.txt"}, {"D\\q.txt", "F\\A.txt"}}), (std::vector<int>{0, 0}));
+    // Taking a name a later pair still holds, spelled in another normalization form
+    CHECK_EQ(Screen({{"D\\z.txt", "F\\cafe\xcc\x81.txt"}, {"D\\caf\xc3\xa9.txt", "E\\y.txt"}}),
+             (std::vector<int>{kResultNameCollision, 0}));
+    // With preserveExt only the stems move, so the same names no longer meet
+    CHECK_EQ(Screen({{"D\\a.txt", "D\\b.txt"}, {"D\\c.md", "E\\B.TXT"}}, true), (std::vector<int>{0, 0}));
+    // The same item twice is left to exchange(), which reports kResultSameFile
+    CHECK_EQ(Screen({{"D\\a.txt", "d\\A.TXT"}}), (std::vector<int>{0}));
+}
+
+void TestCaseOnlySwap() {
+    CHECK(IsCaseOnlySwap(L"D:\\x\\Readme.txt", L"D:\\x\\README.md", true));
+    CHECK(!IsCaseOnlySwap(L"D:\\x\\Readme.txt", L"D:\\x\\README.md", false));
+    CHECK(!IsCaseOnlySwap(L"D:\\x\\a.txt", L"D:\\x\\b.md", true));
+}
+
+// The name an item in dir really has on disk, with its case
+std::wstring NameOnDisk(const std::wstring& dir, const std::wstring& name) {
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW((dir + name).c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) return {};
+    FindClose(find);
+    return data.cFileName;
+}
+
+void TestExchangeCaseOnly() {
+    wchar_t temp[MAX_PATH + 1];
+    GetTempPathW(MAX_PATH + 1, temp);
+    const std::wstring dir = std::wstring(temp) + L"nx_collision_index_test_" + std::to_wstring(GetCurrentProcessId()) +
+                             L"\\";
+    CreateDirectoryW(dir.c_str(), nullptr);
+    for (const wchar_t* name : {L"Readme.txt", L"README.md"}) {
+        HANDLE file = CreateFileW((dir + name).c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, 0, nullptr);
+        CHECK(file != INVALID_HANDLE_VALUE);
+        CloseHandle(file);
+    }
+
+    CHECK_EQ(ExchangeCaseOnly(dir + L"Readme.txt", dir + L"README.md", true), kResultSuccess);
+    CHECK(NameOnDisk(dir, L"readme.txt") == L"README.txt");
+    CHECK(NameOnDisk(dir, L"readme.md") == L"Readme.md");
+
+    // Directories keep no extension, so the same names are a plain swap for them
+    CHECK(CreateDirectoryW((dir + L"Data.v1").c_str(), nullptr));
+    CHECK(CreateDirectoryW((dir + L"DATA.v2").c_str(), nullptr));
+    CHECK(IsCaseOnlySwap(dir + L"Data.v1x", dir + L"DATA.v2x", true));
+    CHECK(!IsCaseOnlySwap(dir + L"Data.v1", dir + L"DATA.v2", true));
+    RemoveDirectoryW((dir + L"Data.v1").c_str());
+    RemoveDirectoryW((dir + L"DATA.v2").c_str());
+
+    DeleteFileW((dir + L"README.txt").c_str());
+    DeleteFileW((dir + L"Readme.md").c_str());
+    RemoveDirectoryW(dir.c_str());
+}
+}  // namespace
+
+int main() {
+    TestFoldName();
+    TestBatchCollisions();
+    TestCaseOnlySwap();
+    TestExchangeCaseOnly();
+    return CheckResult();
+}
@@ -0,0 +1,167 @@
+#include "concurrency_tuner.h"
+
+#include "check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace {
+using std::chrono::milliseconds;
+using Clock = std::chrono::steady_clock;
+
+// A tuner on a clock of its own that is fed whole windows
+struct Driver {
+    ConcurrencyTuner tuner;
+    Clock::time_point now{};
+
+    explicit Driver(uint32_t ceiling) { tuner.Reset(ceiling, now); }
+
+    // One window of the smallest size that closes it: every swap takes `micros`, the first `failures`
+    // of them fail, and with `saturated` the limit is reached
+    void Window(int64_t micros, size_t failures = 0, bool saturated = true) {
+        const size_t samples = (std::max)(size_t{8}, size_t{tuner.Limit()} * 2);
+        now += milliseconds(100);
+        for (size_t i = 0; i < samples; ++i) {
+            if (saturated) tuner.Started(tuner.Limit());
+            CHECK_EQ(tuner.Finished(micros, i < failures, now), i + 1 == samples);
+        }
+    }
+};
+
+// A window needs both 100 ms and max(8, 2 x limit) swaps
+void TestMinimumWindow() {
+    ConcurrencyTuner tuner;
+    const Clock::time_point t0{};
+    tuner.Reset(16, t0);
+    for (int i = 0; i < 7; ++i) CHECK(!tuner.Finished(1000, false, t0 + milliseconds(500)));
+    CHECK(tuner.Finished(1000, false, t0 + milliseconds(500)));
+    CHECK_EQ(tuner.Stats().windows, uint64_t{1});
+
+    const Clock::time_point t1 = t0 + milliseconds(500);
+    for (int i = 0; i < 20; ++i) CHECK(!tuner.Finished(1000, false, t1 + milliseconds(99)));
+    CHECK(tuner.Finished(1000, false, t1 + milliseconds(100)));
+    CHECK_EQ(tuner.Stats().windows, uint64_t{2});
+
+    // At a limit of 8, 16 swaps
+    Driver driver(16);
+    for (int i = 0; i < 3; ++i) driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 8u);
+    driver.now += milliseconds(100);
+    for (int i = 0; i < 15; ++i) CHECK(!driver.tuner.Finished(1000, false, driver.now));
+    CHECK(driver.tuner.Finished(1000, false, driver.now));
+}
+
+void TestSlowStartDoublesWhenSaturated() {
+    Driver driver(16);
+    CHECK_EQ(driver.tuner.Limit(), 1u);
+    for (const uint32_t expected : {2u, 4u, 8u, 16u}) {
+        driver.Window(1000);
+        CHECK_EQ(driver.tuner.Limit(), expected);
+        CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::SlowStart);
+    }
+    CHECK_EQ(driver.tuner.Stats().raises, uint64_t{4});
+    CHECK_EQ(driver.tuner.Stats().cuts, uint64_t{0});
+}
+
+// Latency that stays flat says nothing about more load unless the limit was reached
+void TestHoldWhenNotSaturated() {
+    Driver driver(16);
+    driver.Window(1000);
+    driver.Window(1000, 0, false);
+    CHECK_EQ(driver.tuner.Limit(), 2u);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::Hold);
+    CHECK_EQ(driver.tuner.Stats().raises, uint64_t{1});
+}
+
+void TestBackoffOnLatency() {
+    Driver driver(64);
+    for (int i = 0; i < 3; ++i) driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 8u);
+    CHECK_EQ(driver.tuner.Stats().baselineMs, 1.0);
+
+    // Within 1.5x of the baseline: still raised, and the baseline only drifts up
+    driver.Window(1400);
+    CHECK_EQ(driver.tuner.Limit(), 16u);
+    CHECK(driver.tuner.Stats().baselineMs < 1.01);
+
+    driver.Window(1600);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::BackoffLatency);
+    CHECK_EQ(driver.tuner.Limit(), 12u);
+    CHECK_EQ(driver.tuner.Stats().cuts, uint64_t{1});
+
+    // Out of slow start: one at a time from here
+    driver.Window(1000);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::Probe);
+    CHECK_EQ(driver.tuner.Limit(), 13u);
+}
+
+void TestBackoffOnErrors() {
+    Driver driver(64);
+    for (int i = 0; i < 2; ++i) driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 4u);
+
+    // 1 in 8 failed
+    driver.Window(1000, 1);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::BackoffErrors);
+    CHECK_EQ(driver.tuner.Stats().errorRate, 0.125);
+    CHECK_EQ(driver.tuner.Limit(), 3u);
+
+    // A cut takes at least one off, and never goes below 1
+    driver.Window(1000, 8);
+    CHECK_EQ(driver.tuner.Limit(), 2u);
+    driver.Window(1000, 8);
+    CHECK_EQ(driver.tuner.Limit(), 1u);
+    driver.Window(1000, 8);
+    CHECK_EQ(driver.tuner.Limit(), 1u);
+    CHECK_EQ(driver.tuner.Stats().cuts, uint64_t{3});
+}
+
+void TestCeiling() {
+    Driver driver(3);
+    driver.Window(1000);
+    driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 3u);
+    driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 3u);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::Hold);
+
+    driver.tuner.SetCeiling(2);
+    CHECK_EQ(driver.tuner.Limit(), 2u);
+    driver.tuner.SetCeiling(0);
+    CHECK_EQ(driver.tuner.Limit(), 1u);
+    driver.tuner.SetCeiling(8);
+    driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 2u);
+}
+
+// Cut down to 1, the last p99 becomes the baseline and doubling starts over, so a share that got
+// slower for everyone is not held to the latency it had before
+void TestCutToOneRestartsSlowStart() {
+    Driver driver(16);
+    driver.Window(1000);
+    CHECK_EQ(driver.tuner.Limit(), 2u);
+    driver.Window(5000);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::BackoffLatency);
+    CHECK_EQ(driver.tuner.Limit(), 1u);
+
+    driver.Window(5000);
+    CHECK_EQ(driver.tuner.Stats().baselineMs, 5.0);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::SlowStart);
+    CHECK_EQ(driver.tuner.Limit(), 2u);
+    driver.Window(5000);
+    CHECK_EQ(driver.tuner.Stats().decision, TuningDecision::SlowStart);
+    CHECK_EQ(driver.tuner.Limit(), 4u);
+}
+}  // namespace
+
+int main() {
+    TestMinimumWindow();
+    TestSlowStartDoublesWhenSaturated();
+    TestHoldWhenNotSaturated();
+    TestBackoffOnLatency();
+    TestBackoffOnErrors();
+    TestCeiling();
+    TestCutToOneRestartsSlowStart();
+    return CheckResult();
+}
@@ -0,0 +1,87 @@
+#include "content_hash.h"
+
+#include "check.h"
+
+#include <cstdint>
+#include <vector>
+
+// Built twice, with the SSE2 stripes and with NX_NO_SSE2; both builds must give the values below,
+// which --verify and the checkpoint hash rely on across machines
+namespace {
+struct Known {
+    size_t size;
+    uint64_t hash;        // Seed 0
+    uint64_t seededHash;  // Seed 0x5eed
+};
+
+// Sizes around the 64-byte stripe and the 1 KB block
+constexpr Known kKnown[] = {
+    {0, 0x89DEE88BC9ED362Bull, 0x8518D540392FA0C3ull},
+    {1, 0x7294A1BF22E68704ull, 0xC79117AAC79E5CAFull},
+    {7, 0x25EA237CE4EDB3A8ull, 0x9B02AFE991C9C362ull},
+    {8, 0x21676403CDBEDD16ull, 0x5F24B50F46D366C3ull},
+    {63, 0x7BCA76BF3894ECADull, 0x8E43CF6E6D691E13ull},
+    {64, 0xFA375AE79F32A411ull, 0x9249D2BC77425231ull},
+    {65, 0xB623C2C747907282ull, 0x0888908205C9C487ull},
+    {127, 0xB7F206303E529EBAull, 0xD5BB3704FACC7196ull},
+    {128, 0x9A99CCD93704C2A7ull, 0xDC869C85BB5732ADull},
+    {1023, 0xFB532A908BF28946ull, 0xFB50E16D61EBB1BFull},
+    {1024, 0x2DC480F8B0EFF697ull, 0xD01165D300D973F8ull},
+    {1025, 0xCB15346A2FE4047Full, 0x4A6D56F031070A79ull},
+    {4096, 0x526A1ACD47F39BC0ull, 0x7188768A574ACBB6ull},
+    {65537, 0x73AE9DA5C9074BA8ull, 0x5E2AD00304CF097Full},
+};
+
+std::vector<unsigned char> Pattern(size_t size) {
+    std::vector<unsigned char> bytes(size);
+    for (size_t i = 0; i < size; ++i) bytes[i] = static_cast<unsigned char>(i * 131 + 7);
+    return bytes;
+}
+
+void TestKnownValues() {
+    const std::vector<unsigned char> bytes = Pattern(65537);
+    for (const Known& known : kKnown) {
+        CHECK_EQ(HashBytes(bytes.data(), known.size), known.hash);
+        CHECK_EQ(HashBytes(bytes.data(), known.size, 0x5eed), known.seededHash);
+    }
+    CHECK_EQ(CombineHashes(1, 2), uint64_t{0xC2C805ACDEBCC128ull});
+}
+
+// The same bytes hash alike wherever they sit in memory
+void TestUnalignedInput() {
+    const std::vector<unsigned char> bytes = Pattern(4096);
+    for (size_t offset = 1; offset < 16; ++offset) {
+        std::vector<unsigned char> shifted(offset + 1025);
+        for (size_t i = 0; i < 1025; ++i) shifted[offset + i] = bytes[i];
+        CHECK_EQ(HashBytes(shifted.data() + offset, 1025), HashBytes(bytes.data(), 1025));
+    }
+}
+
+// Any one changed byte, in a full block, a stripe or the tail, changes the hash
+void TestEveryByteCounts() {
+    std::vector<unsigned char> bytes = Pattern(1100);
+    const uint64_t original = HashBytes(bytes.data(), bytes.size());
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] ^= 1;
+        CHECK(HashBytes(bytes.data(), bytes.size()) != original);
+        bytes[i] ^= 1;
+    }
+    // Trailing zeros are not padding
+    std::vector<unsigned char> longer = bytes;
+    longer.push_back(0);
+    CHECK(HashBytes(longer.data(), longer.size()) != original);
+}
+
+void TestCombineIsOrdered() {
+    CHECK(CombineHashes(CombineHashes(0, 1), 2) != CombineHashes(CombineHashes(0, 2), 1));
+    CHECK(CombineHashes(0, 1) != CombineHashes(1, 0));
+}
+}  // namespace
+
+int main() {
+    TestKnownValues();
+    TestUnalignedInput();
+    TestEveryByteCounts();
+    TestCombineIsOrdered();
+    return CheckResult();
+}
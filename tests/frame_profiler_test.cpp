@@ -0,0 +1,87 @@
+#include "frame_profiler.h"
+
+#include "check.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+using std::chrono::milliseconds;
+
+void Frame(FrameProfiler& profiler, milliseconds sleep = milliseconds(0)) {
+    profiler.BeginFrame();
+    profiler.BeginSection(UiSection::Inputs);
+    if (sleep.count() > 0) std::this_thread::sleep_for(sleep);
+    profiler.EndSection(UiSection::Inputs);
+    profiler.EndFrame();
+}
+
+// While disabled nothing is timed, not even the clock read of a frame begun before enabling
+void TestDisabledRecordsNothing() {
+    FrameProfiler profiler;
+    Frame(profiler, milliseconds(2));
+    CHECK_EQ(profiler.Frame().lastUs, 0.0);
+    CHECK_EQ(profiler.Frame().avgUs, 0.0);
+    CHECK_EQ(profiler.Section(UiSection::Inputs).maxUs, 0.0);
+}
+
+// A section's time is inside its frame's, and sections that did not run stay at zero
+void TestSectionsAttributed() {
+    FrameProfiler profiler;
+    profiler.enabled = true;
+    Frame(profiler, milliseconds(5));
+    const FrameProfiler::Stats& inputs = profiler.Section(UiSection::Inputs);
+    CHECK(inputs.lastUs >= 5000.0);
+    CHECK(profiler.Frame().lastUs >= inputs.lastUs);
+    // The first sample is the average, not a twentieth of it
+    CHECK_EQ(inputs.avgUs, inputs.lastUs);
+    CHECK_EQ(inputs.maxUs, inputs.lastUs);
+    CHECK_EQ(profiler.Section(UiSection::Queue).lastUs, 0.0);
+    CHECK_EQ(profiler.Section(UiSection::TopBar).avgUs, 0.0);
+}
+
+// The average moves a twentieth of the way to each new frame, and the max only grows within a window
+void TestAverageAndMax() {
+    FrameProfiler profiler;
+    profiler.enabled = true;
+    Frame(profiler, milliseconds(20));
+    const double slow = profiler.Frame().lastUs;
+    Frame(profiler);
+    const double fast = profiler.Frame().lastUs;
+    CHECK(fast < slow);
+    const double expected = slow + (fast - slow) * 0.05;
+    CHECK(profiler.Frame().avgUs > expected - 1e-6 && profiler.Frame().avgUs < expected + 1e-6);
+    CHECK_EQ(profiler.Frame().maxUs, slow);
+}
+
+// The max is over a window of 120 frames; at its end it restarts from the last frame
+void TestMaxWindowResets() {
+    FrameProfiler profiler;
+    profiler.enabled = true;
+    Frame(profiler, milliseconds(20));
+    for (int i = 1; i < 119; ++i) Frame(profiler);
+    CHECK(profiler.Frame().maxUs >= 20000.0);
+    CHECK(profiler.Section(UiSection::Inputs).maxUs >= 20000.0);
+    Frame(profiler);
+    CHECK_EQ(profiler.Frame().maxUs, profiler.Frame().lastUs);
+    CHECK_EQ(profiler.Section(UiSection::Inputs).maxUs, profiler.Section(UiSection::Inputs).lastUs);
+    CHECK(profiler.Frame().maxUs < 20000.0);
+}
+
+void TestNames() {
+    CHECK_EQ(std::string(FrameProfiler::Name(UiSection::TopBar)), std::string("top bar"));
+    CHECK_EQ(std::string(FrameProfiler::Name(UiSection::StartButton)), std::string("start"));
+    CHECK_EQ(std::string(FrameProfiler::Name(UiSection::Queue)), std::string("queue"));
+    CHECK_EQ(std::string(FrameProfiler::Name(UiSection::Count)), std::string("?"));
+}
+}  // namespace
+
+int main() {
+    TestDisabledRecordsNothing();
+    TestSectionsAttributed();
+    TestAverageAndMax();
+    TestMaxWindowResets();
+    TestNames();
+    return CheckResult();
+}
@@ -0,0 +1,198 @@
+#include "manifest.h"
+
+#include "check.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+using Pairs = std::vector<std::pair<std::string, std::string>>;
+
+std::filesystem::path TempFile(const char* name) {
+    return std::filesystem::temp_directory_path() / (std::string("nx_manifest_test_") + name);
+}
+
+void WriteBytes(const std::filesystem::path& path, std::string_view bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::string ReadBytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+Pairs PairsOf(const Manifest& manifest) {
+    Pairs pairs;
+    for (size_t i = 0; i < manifest.Size(); ++i) {
+        pairs.emplace_back(std::string(manifest.Path1(i)), std::string(manifest.Path2(i)));
+    }
+    return pairs;
+}
+
+// Open bytes written to a temp file; false if Open rejected them
+bool OpenBytes(Manifest& manifest, std::string_view bytes) {
+    manifest.Close();  // A mapped file cannot be rewritten
+    const std::filesystem::path path = TempFile("input");
+    WriteBytes(path, bytes);
+    return manifest.Open(path.wstring());
+}
+
+void TestNewlineText() {
+    Manifest manifest;
+    // BOM, CRLF and blank lines are dropped; other whitespace is part of the path
+    CHECK(OpenBytes(manifest, "\xEF\xBB\xBF" "a.txt\r\nb.txt\n\n\r\n c.txt\nd.txt\n"));
+    CHECK(!manifest.IsBinary());
+    CHECK_EQ(PairsOf(manifest), (Pairs{{"a.txt", "b.txt"}, {" c.txt", "d.txt"}}));
+    CHECK(!manifest.PreserveExt(0).has_value());
+}
+
+void TestNulText() {
+    Manifest manifest;
+    // The first delimiter decides: newlines are then part of the paths, and empty records count
+    CHECK(OpenBytes(manifest, std::string_view("a\0b\nc\0\0d\0", 9)));
+    CHECK_EQ(PairsOf(manifest), (Pairs{{"a", "b\nc"}, {"", "d"}}));
+}
+
+void TestOddRecordCount() {
+    Manifest manifest;
+    CHECK(OpenBytes(manifest, "a\nb\nc"));
+    CHECK_EQ(PairsOf(manifest), (Pairs{{"a", "b"}, {"c", ""}}));
+}
+
+void TestEmptyFile() {
+    Manifest manifest;
+    CHECK(OpenBytes(manifest, ""));
+    CHECK_EQ(manifest.Size(), size_t{0});
+    CHECK(!manifest.Open(TempFile("missing").wstring()));
+}
+
+// Large enough to be indexed in several slices on several threads, with records straddling the
+// slice and 16-byte block boundaries
+void TestLargeTextAcrossSlices() {
+    constexpr size_t kPairs = 400'000;
+    std::string text;
+    Pairs expected;
+    expected.reserve(kPairs);
+    char path1[64];
+    char path2[64];
+    for (size_t i = 0; i < kPairs; ++i) {
+        std::snprintf(path1, sizeof(path1), "D:\\data\\%zu\\file_%zu.bin", i % 97, i);
+        std::snprintf(path2, sizeof(path2), "E:\\other\\%zu.txt", i * 7);
+        text.append(path1).append(i % 3 ? "\n" : "\r\n").append(path2).append("\n");
+        expected.emplace_back(path1, path2);
+    }
+    CHECK(text.size() > 3 * (4u << 20));
+
+    Manifest manifest;
+    CHECK(OpenBytes(manifest, text));
+    CHECK(PairsOf(manifest) == expected);
+}
+
+void TestOverlongRecordRejected() {
+    Manifest manifest;
+    std::string text(16u << 20, 'x');
+    text += "\nb\n";
+    CHECK(!OpenBytes(manifest, text));
+}
+
+void TestBinaryRoundTrip() {
+    Manifest text;
+    CHECK(OpenBytes(text, "a.txt\nb.txt\nD:\\x y\\c.md\n\xE5\x90\x8D.txt\n"));
+    const std::filesystem::path binaryPath = TempFile("binary");
+    CHECK(WriteBinaryManifest(binaryPath.wstring(), text));
+
+    Manifest binary;
+    CHECK(binary.Open(binaryPath.wstring()));
+    CHECK(binary.IsBinary());
+    CHECK(PairsOf(binary) == PairsOf(text));
+    CHECK(!binary.PreserveExt(1).has_value());
+}
+
+// A header and records written by hand, one per extension setting
+std::string HandWrittenBinary(uint32_t preserve) {
+    const std::string strings = std::string("a.txt\0b.md\0", 11);
+    BinaryManifestHeader header = {};
+    std::memcpy(header.magic, kBinaryManifestMagic, sizeof(header.magic));
+    header.version = kBinaryManifestVersion;
+    header.recordSize = sizeof(BinaryManifestRecord);
+    header.pairCount = 1;
+    header.recordsOffset = sizeof(header);
+    header.stringsOffset = sizeof(header) + sizeof(BinaryManifestRecord);
+    header.stringsSize = strings.size();
+    BinaryManifestRecord record = {0, 6, 5, 4, preserve, 0};
+
+    std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    return bytes + strings;
+}
+
+void TestBinaryPreserveFlags() {
+    Manifest manifest;
+    CHECK(OpenBytes(manifest, HandWrittenBinary(kManifestSwapFullName)));
+    CHECK_EQ(PairsOf(manifest), (Pairs{{"a.txt", "b.md"}}));
+    CHECK(manifest.PreserveExt(0) == std::optional<bool>(false));
+    CHECK(OpenBytes(manifest, HandWrittenBinary(kManifestPreserveExt)));
+    CHECK(manifest.PreserveExt(0) == std::optional<bool>(true));
+    CHECK(OpenBytes(manifest, HandWrittenBinary(kManifestPreserveDefault)));
+    CHECK(!manifest.PreserveExt(0).has_value());
+}
+
+void TestMalformedBinaryRejected() {
+    const std::string good = HandWrittenBinary(kManifestPreserveDefault);
+    auto patched = [&](size_t offset, const void* value, size_t size) {
+        std::string bytes = good;
+        std::memcpy(bytes.data() + offset, value, size);
+        return bytes;
+    };
+    const size_t recordAt = sizeof(BinaryManifestHeader);
+    const uint32_t badVersion = 2;
+    const uint32_t badRecordSize = 24;
+    const uint64_t tooManyPairs = 2;
+    const uint64_t misaligned = sizeof(BinaryManifestHeader) + 4;
+    const uint64_t pastStrings = 8;
+    const uint32_t badPreserve = 3;
+
+    Manifest manifest;
+    CHECK(OpenBytes(manifest, good));
+    CHECK(!OpenBytes(manifest, patched(offsetof(BinaryManifestHeader, version), &badVersion, 4)));
+    CHECK(!OpenBytes(manifest, patched(offsetof(BinaryManifestHeader, recordSize), &badRecordSize, 4)));
+    CHECK(!OpenBytes(manifest, patched(offsetof(BinaryManifestHeader, pairCount), &tooManyPairs, 8)));
+    CHECK(!OpenBytes(manifest, patched(offsetof(BinaryManifestHeader, recordsOffset), &misaligned, 8)));
+    CHECK(!OpenBytes(manifest, patched(recordAt + offsetof(BinaryManifestRecord, path2), &pastStrings, 8)));
+    CHECK(!OpenBytes(manifest, patched(recordAt + offsetof(BinaryManifestRecord, preserve), &badPreserve, 4)));
+    CHECK(!OpenBytes(manifest, std::string_view(good).substr(0, good.size() - 4)));
+
+    // A text file that merely starts like a header is still text once the magic is wrong
+    std::string notMagic = good;
+    notMagic[0] = 'x';
+    CHECK(OpenBytes(manifest, notMagic));
+    CHECK(!manifest.IsBinary());
+}
+}  // namespace
+
+int main() {
+    TestNewlineText();
+    TestNulText();
+    TestOddRecordCount();
+    TestEmptyFile();
+    TestLargeTextAcrossSlices();
+    TestOverlongRecordRejected();
+    TestBinaryRoundTrip();
+    TestBinaryPreserveFlags();
+    TestMalformedBinaryRejected();
+
+    for (const char* name : {"input", "binary"}) {
+        std::error_code ignored;
+        std::filesystem::remove(TempFile(name), ignored);
+    }
+    return CheckResult();
+}
@@ -0,0 +1,157 @@
+#include "metadata_swap.h"
+
+#include "check.h"
+#include "exchange.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+uint32_t Parse(const std::wstring& spec, bool expected = true) {
+    uint32_t classes = 0xdead;
+    CHECK_EQ(ParseMetadataClasses(spec, classes), expected);
+    return classes;
+}
+
+void TestParse() {
+    CHECK_EQ(Parse(L"times"), uint32_t{kMetadataTimes});
+    CHECK_EQ(Parse(L"attrs"), uint32_t{kMetadataAttributes});
+    CHECK_EQ(Parse(L"streams"), uint32_t{kMetadataStreams});
+    CHECK_EQ(Parse(L"all"), uint32_t{kMetadataAll});
+    CHECK_EQ(Parse(L"times,streams"), uint32_t{kMetadataTimes | kMetadataStreams});
+    // Any case, repeats and "all" among others
+    CHECK_EQ(Parse(L"Times,ATTRS,times"), uint32_t{kMetadataTimes | kMetadataAttributes});
+    CHECK_EQ(Parse(L"attrs,all"), uint32_t{kMetadataAll});
+
+    // A failed parse leaves classes alone
+    for (const wchar_t* spec : {L"", L"time", L"times,", L",times", L"times,,attrs", L"times attrs", L" times",
+                                L"times;attrs", L"none"}) {
+        CHECK_EQ(Parse(spec, false), uint32_t{0xdead});
+    }
+}
+
+// Two files in %TEMP% and a swap that renames them, as the library would
+struct Fixture {
+    fs::path dir = fs::temp_directory_path() / "nx_metadata_swap_test";
+    fs::path a = dir / "a.txt";
+    fs::path b = dir / "b.txt";
+
+    Fixture() {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        std::ofstream(a) << "first";
+        std::ofstream(b) << "second";
+    }
+    ~Fixture() {
+        for (const fs::path& path : {a, b}) {
+            std::error_code error;
+            fs::permissions(path, fs::perms::owner_write, fs::perm_options::add, error);
+        }
+        fs::remove_all(dir);
+    }
+
+    int Swap(uint32_t classes) {
+        return ExchangeWithMetadata(a.wstring(), b.wstring(), classes, [this] {
+            const fs::path parked = dir / "parked.tmp";
+            fs::rename(a, parked);
+            fs::rename(b, a);
+            fs::rename(parked, b);
+            return kResultSuccess;
+        });
+    }
+
+    static std::string Content(const fs::path& path) {
+        std::ifstream in(path);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    static bool ReadOnly(const fs::path& path) {
+        return (fs::status(path).permissions() & fs::perms::owner_write) == fs::perms::none;
+    }
+};
+
+// The times stay with the names; without the class they travel with the content
+void TestTimes() {
+    const fs::file_time_type now = fs::file_time_type::clock::now();
+    const fs::file_time_type older = now - std::chrono::hours(24 * 20);
+    const fs::file_time_type newer = now - std::chrono::hours(24 * 10);
+    {
+        Fixture f;
+        fs::last_write_time(f.a, older);
+        fs::last_write_time(f.b, newer);
+        CHECK_EQ(f.Swap(kMetadataTimes), kResultSuccess);
+        CHECK_EQ(Fixture::Content(f.a), std::string("second"));
+        CHECK(fs::last_write_time(f.a) == older);
+        CHECK(fs::last_write_time(f.b) == newer);
+    }
+    {
+        Fixture f;
+        fs::last_write_time(f.a, older);
+        fs::last_write_time(f.b, newer);
+        CHECK_EQ(f.Swap(kMetadataAttributes), kResultSuccess);
+        CHECK(fs::last_write_time(f.a) == newer);
+        CHECK(fs::last_write_time(f.b) == older);
+    }
+}
+
+void TestAttributes() {
+    {
+        Fixture f;
+        fs::permissions(f.a, fs::perms::owner_write, fs::perm_options::remove);
+        CHECK_EQ(f.Swap(kMetadataAttributes), kResultSuccess);
+        CHECK(Fixture::ReadOnly(f.a));
+        CHECK(!Fixture::ReadOnly(f.b));
+    }
+    {
+        Fixture f;
+        fs::permissions(f.a, fs::perms::owner_write, fs::perm_options::remove);
+        CHECK_EQ(f.Swap(kMetadataTimes), kResultSuccess);
+        CHECK(!Fixture::ReadOnly(f.a));
+        CHECK(Fixture::ReadOnly(f.b));
+    }
+}
+
+// Alternate streams move to the other item, also onto one that is read-only, which stays so
+void TestStreams() {
+    Fixture f;
+    std::ofstream(f.a.string() + ":tag") << "zone";
+    fs::permissions(f.b, fs::perms::owner_write, fs::perm_options::remove);
+    CHECK_EQ(f.Swap(kMetadataStreams), kResultSuccess);
+    CHECK_EQ(Fixture::Content(f.a.string() + ":tag"), std::string("zone"));
+    CHECK(!std::ifstream(f.b.string() + ":tag"));
+    CHECK_EQ(Fixture::Content(f.a), std::string("second"));
+    // Read-only went with the content, as attributes were not selected
+    CHECK(Fixture::ReadOnly(f.a));
+}
+
+// A failed swap touches nothing, and an item that cannot be opened is left to the swap to report
+void TestSwapErrorsPassThrough() {
+    Fixture f;
+    const fs::file_time_type older = fs::file_time_type::clock::now() - std::chrono::hours(24 * 20);
+    fs::last_write_time(f.a, older);
+    CHECK_EQ(ExchangeWithMetadata(f.a.wstring(), f.b.wstring(), kMetadataAll, [] { return kResultPermissionDenied; }),
+             kResultPermissionDenied);
+    CHECK(fs::last_write_time(f.a) == older);
+
+    bool swapped = false;
+    const int result = ExchangeWithMetadata((f.dir / "missing.txt").wstring(), f.b.wstring(), kMetadataAll, [&] {
+        swapped = true;
+        return kResultNoExist;
+    });
+    CHECK(swapped);
+    CHECK_EQ(result, kResultNoExist);
+}
+}  // namespace
+
+int main() {
+    TestParse();
+    TestTimes();
+    TestAttributes();
+    TestStreams();
+    TestSwapErrorsPassThrough();
+    return CheckResult();
+}
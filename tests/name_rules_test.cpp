@@ -0,0 +1,208 @@
+#include "name_rules.h"
+
+#include "check.h"
+#include "exchange.h"
+#include "path_store.h"
+#include "swap_queue.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Built twice, with the SSE2 loops and with NX_NO_SSE2; both builds are held to the same byte-at-a-time
+// reference, so they agree with each other
+namespace {
+constexpr NameRules kAllRules[] = {NameRules::None, NameRules::Windows, NameRules::Posix, NameRules::SmbShare};
+constexpr std::string_view kWindowsForbidden = "<>:\"/\\|?*";
+
+// The rules of name_rules.h written out the plain way
+bool ReferenceValid(const std::string& name, NameRules rules) {
+    if (name.empty() || name == "." || name == "..") return false;
+    if (rules == NameRules::None) return true;
+    const bool windows = rules != NameRules::Posix;
+    for (const char c : name) {
+        if (windows && (static_cast<uint8_t>(c) < 0x20 || kWindowsForbidden.find(c) != std::string_view::npos)) {
+            return false;
+        }
+        if (!windows && (c == '\0' || c == '/')) return false;
+    }
+    if (rules != NameRules::Windows && name.size() > 255) return false;
+    if (!windows) return true;
+
+    size_t units = 0;
+    for (const char c : name) {
+        const auto byte = static_cast<uint8_t>(c);
+        units += ((byte & 0xC0) != 0x80 ? 1 : 0) + (byte >= 0xF0 ? 1 : 0);
+    }
+    if (units > 255 || name.back() == '.' || name.back() == ' ') return false;
+
+    std::string base = name.substr(0, name.find('.'));
+    while (!base.empty() && base.back() == ' ') base.pop_back();
+    for (char& c : base) {
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    }
+    if (base == "con" || base == "prn" || base == "aux" || base == "nul") return false;
+    const bool port = base.rfind("com", 0) == 0 || base.rfind("lpt", 0) == 0;
+    if (port && base.size() == 4 && base[3] >= '0' && base[3] <= '9') return false;
+    const std::string_view superscripts[] = {"\xC2\xB9", "\xC2\xB2", "\xC2\xB3"};
+    for (const std::string_view digit : superscripts) {
+        if (port && base.size() == 5 && base.compare(3, 2, digit) == 0) return false;
+    }
+    return true;
+}
+
+// Random names built from pieces that sit on every rule: device names, superscripts, multi-byte
+// characters, forbidden and control bytes, and runs long enough to reach the length limits
+void TestFuzzAgainstReference() {
+    const char* pieces[] = {
+        "a", "Z", " ", ".", "1", "0", "txt",                    // Plain
+        "con", "CoN", "nul", "aux", "prn", "com", "lpt",        // Device names and their stems
+        "\xC2\xB9", "\xC2\xB2", "\xC2\xB4",                     // Superscript 1, 2 and an accent
+        "\xE4\xB8\xAD", "\xF0\x9F\x98\x80", "\xFF", "\x80",     // 1 and 2 UTF-16 units, stray bytes
+        ":", "<", "*", "\\", "/", "\x01", "\x1F", "\x7F",       // Forbidden somewhere, or not at all
+    };
+    std::mt19937_64 rng(42);
+    size_t mismatches = 0;
+    for (int i = 0; i < 200000; ++i) {
+        std::string name;
+        size_t parts = rng() % 8;
+        if (rng() % 50 == 0) parts = 60 + rng() % 120;
+        for (size_t p = 0; p < parts; ++p) name += pieces[rng() % std::size(pieces)];
+        if (rng() % 10 == 0) name += std::string("\0x", 2);
+        for (const NameRules rules : kAllRules) {
+            if (IsValidName(name, rules) != ReferenceValid(name, rules) && mismatches++ < 5) {
+                std::printf("  mismatch: rules %d, %zu bytes\n", static_cast<int>(rules), name.size());
+            }
+        }
+    }
+    CHECK_EQ(mismatches, size_t{0});
+}
+
+// A forbidden byte is found at every offset of the 16-byte blocks and of the tail after them
+void TestForbiddenByteAtEveryOffset() {
+    for (size_t size = 1; size <= 48; ++size) {
+        for (size_t at = 0; at < size; ++at) {
+            std::string name(size, 'x');
+            for (const char c : kWindowsForbidden) {
+                name[at] = c;
+                CHECK(!IsValidName(name, NameRules::Windows));
+                CHECK_EQ(IsValidName(name, NameRules::Posix), c != '/');
+            }
+            for (const char c : {'\0', '\x01', '\x1F'}) {
+                name[at] = c;
+                CHECK(!IsValidName(name, NameRules::Windows));
+                CHECK_EQ(IsValidName(name, NameRules::Posix), c != '\0');
+            }
+            // Bytes of 0x7F and up are no control characters, whatever their sign as char
+            for (const char c : {'\x7F', '\x80', '\xA0', '\xFF'}) {
+                name[at] = c;
+                CHECK(IsValidName(name, NameRules::Windows));
+            }
+        }
+    }
+}
+
+// Windows counts UTF-16 units, POSIX counts bytes; the prefix moves the characters across blocks
+void TestNameLength() {
+    const std::string han = "\xE4\xB8\xAD";         // 3 bytes, 1 unit
+    const std::string emoji = "\xF0\x9F\x98\x80";  // 4 bytes, 2 units
+    for (size_t prefix = 0; prefix < 16; ++prefix) {
+        std::string name(prefix, 'a');
+        for (size_t i = prefix; i < 255; ++i) name += han;
+        CHECK(IsValidName(name, NameRules::Windows));
+        CHECK(!IsValidName(name + han, NameRules::Windows));
+        CHECK(!IsValidName(name, NameRules::Posix));
+
+        // Each emoji is a surrogate pair
+        std::string wide(prefix, 'a');
+        for (size_t units = prefix; units + 2 <= 255; units += 2) wide += emoji;
+        CHECK(IsValidName(wide, NameRules::Windows));
+        CHECK(!IsValidName(wide + emoji, NameRules::Windows));
+    }
+    CHECK(IsValidName(std::string(255, 'a'), NameRules::Posix));
+    CHECK(!IsValidName(std::string(256, 'a'), NameRules::Posix));
+    CHECK(!IsValidName(std::string(256, 'a'), NameRules::SmbShare));
+    CHECK(IsValidName(std::string(1000, 'a'), NameRules::None));
+}
+
+void TestDeviceNames() {
+    for (const char* name : {"CON", "con.txt", "Nul", "aux.tar.gz", "COM1", "lpt9.log", "com0", "COM1 .txt",
+                             "lpt\xC2\xB9", "COM\xC2\xB3.txt"}) {
+        CHECK(!IsValidName(name, NameRules::Windows));
+        CHECK(!IsValidName(name, NameRules::SmbShare));
+        CHECK(IsValidName(name, NameRules::Posix));
+    }
+    for (const char* name : {"conx", "co", "com", "com10", "lpt\xC2\xB4", "x.con", ".con", "nul_", "console"}) {
+        CHECK(IsValidName(name, NameRules::Windows));
+    }
+}
+
+void TestSwappedNames() {
+    struct Case {
+        const char* path1;
+        const char* path2;
+        bool preserveExt;
+        int code;
+    };
+    const Case cases[] = {
+        {"C:\\x\\a.txt", "C:\\y\\b.md", true, kResultSuccess},
+        {"C:\\x\\con.txt", "C:\\y\\b.md", false, kResultInvalidPath},
+        {"C:\\x\\a.", "C:\\y\\b.md", true, kResultInvalidPath},
+        {"C:\\x\\nul", "C:\\y\\b.md", true, kResultInvalidPath},
+        {"C:\\x\\a.txt", "C:\\y\\b.md\\", true, kResultSuccess},
+        {"C:\\", "C:\\y\\b.md", true, kResultSuccess},
+        {"C:foo.txt", "C:\\y\\b.md", true, kResultSuccess},
+        // Both names are fine as they are, but the first item gets the stem "b " and no extension
+        {"C:\\x\\a", "C:\\y\\b .md", true, kResultInvalidPath},
+        {"C:\\x\\a", "C:\\y\\b .md", false, kResultSuccess},
+        // With the whole names swapped, only the names as they are matter
+        {"C:\\x\\a.", "C:\\y\\b", false, kResultInvalidPath},
+        {"/x/a.txt", "/y/b.md", true, kResultSuccess},
+    };
+    for (const Case& c : cases) {
+        CHECK_EQ(CheckSwappedNames(c.path1, c.path2, c.preserveExt, NameRules::Windows), c.code);
+    }
+    CHECK_EQ(CheckSwappedNames("C:\\x\\con.txt", "C:\\y\\b", false, NameRules::Posix), kResultSuccess);
+    CHECK_EQ(CheckSwappedNames("C:\\x\\a:b", "C:\\y\\b", false, NameRules::None), kResultSuccess);
+}
+
+// The batch form reads leaves out of the store and agrees with the pair form, across chunks
+void TestFindInvalidNames() {
+    PathStore store;
+    std::vector<SwapEntry> batch;
+    std::vector<int> expected;
+    for (size_t i = 0; i < 3000; ++i) {
+        const std::string dir = "D:\\share\\dept" + std::to_string(i % 7) + "\\";
+        std::string name1 = "report_" + std::to_string(i) + ".docx";
+        std::string name2 = "summary_" + std::to_string(i) + ".xlsx";
+        if (i % 97 == 0) name1 = "CON.docx";
+        if (i % 89 == 0) name2 = "summary?" + std::to_string(i);
+        if (i % 83 == 0) name2 += "\\";
+        SwapEntry entry;
+        entry.path1 = *store.Intern(dir + name1);
+        entry.path2 = *store.Intern(dir + name2);
+        entry.preserveExt = i % 2 == 0;
+        batch.push_back(entry);
+        expected.push_back(CheckSwappedNames(dir + name1, dir + name2, entry.preserveExt, NameRules::Windows));
+    }
+    CHECK_EQ(FindInvalidNames(store, batch, NameRules::Windows), expected);
+    size_t invalid = 0;
+    for (const int code : expected) invalid += code == kResultInvalidPath;
+    CHECK(invalid > 0);
+    CHECK_EQ(FindInvalidNames(store, batch, NameRules::None), std::vector<int>(batch.size(), kResultSuccess));
+}
+}  // namespace
+
+int main() {
+    TestFuzzAgainstReference();
+    TestForbiddenByteAtEveryOffset();
+    TestNameLength();
+    TestDeviceNames();
+    TestSwappedNames();
+    TestFindInvalidNames();
+    return CheckResult();
+}
@@ -0,0 +1,150 @@
+#include "pair_rule.h"
+
+#include "check.h"
+#include "utils.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+PairRule Compile(const std::wstring& pattern, const std::wstring& replacement) {
+    PairRule rule;
+    CHECK(PairRule::Compile(L".", pattern, replacement, rule));
+    return rule;
+}
+
+// The partner of name, or "-" when the rule does not apply
+std::wstring Partner(const PairRule& rule, const std::wstring& name) {
+    std::wstring partner;
+    return rule.Apply(name, partner) ? partner : L"-";
+}
+
+void TestCompileRejects() {
+    PairRule rule;
+    CHECK(!PairRule::Compile(L"", L"*.a", L"*.b", rule));
+    CHECK(!PairRule::Compile(L".", L"", L"*.b", rule));
+    CHECK(!PairRule::Compile(L".", L"*.a", L"", rule));
+    // More captures than the pattern has, by number or by wildcard
+    CHECK(!PairRule::Compile(L".", L"*.a", L"$2.b", rule));
+    CHECK(!PairRule::Compile(L".", L"*.a", L"*-*.b", rule));
+    CHECK(!PairRule::Compile(L".", L"re:(.*)\\.a", L"$2.b", rule));
+    CHECK(!PairRule::Compile(L".", L"re:(.*", L"$1.b", rule));
+}
+
+void TestGlob() {
+    const PairRule rule = Compile(L"*.prod.json", L"*.staging.json");
+    CHECK(Partner(rule, L"app.prod.json") == L"app.staging.json");
+    // Names compare case-insensitively; the capture keeps the case of the name
+    CHECK(Partner(rule, L"App.PROD.Json") == L"App.staging.json");
+    CHECK(Partner(rule, L"app.json") == L"-");
+    CHECK(Partner(rule, L"app.prod.json.bak") == L"-");
+
+    const PairRule question = Compile(L"img?.png", L"pic?.jpg");
+    CHECK(Partner(question, L"img7.png") == L"pic7.jpg");
+    CHECK(Partner(question, L"img.png") == L"-");
+    CHECK(Partner(question, L"img12.png") == L"-");
+
+    // A literal between two stars; the first star is greedy, like (.*)
+    const PairRule middle = Compile(L"*-*.txt", L"*_*.txt");
+    CHECK(Partner(middle, L"a-b-c.txt") == L"a-b_c.txt");
+    CHECK(Partner(middle, L"-.txt") == L"_.txt");
+}
+
+void TestReplacement() {
+    // $n in any order, and repeated
+    const PairRule swapped = Compile(L"*-*.txt", L"$2-$1.txt");
+    CHECK(Partner(swapped, L"left-right.txt") == L"right-left.txt");
+    CHECK(Partner(Compile(L"*.log", L"$1.$1.log"), L"x.log") == L"x.x.log");
+
+    // "$$" is one '$'; a '$' before anything but a digit or '$' is literal
+    CHECK(Partner(Compile(L"*.txt", L"$$*.bak"), L"x.txt") == L"$x.bak");
+    CHECK(Partner(Compile(L"*.txt", L"*$"), L"x.txt") == L"x$");
+    CHECK(Partner(Compile(L"*.txt", L"$0*"), L"x.txt") == L"$0x");
+
+    // A partner with no name is no partner
+    CHECK(Partner(Compile(L"*.txt", L"*"), L".txt") == L"-");
+}
+
+void TestRegex() {
+    const PairRule rule = Compile(L"re:(.*)\\.prod\\.json", L"$1.staging.json");
+    CHECK(Partner(rule, L"App.Prod.JSON") == L"App.staging.json");
+    // The regex must match the whole name
+    CHECK(Partner(rule, L"app.prod.json.bak") == L"-");
+
+    // Wildcards in the replacement are literal for regex rules
+    const PairRule groups = Compile(L"re:([a-z]+)(\\d+)", L"$2*$1");
+    CHECK(Partner(groups, L"abc123") == L"123*abc");
+    CHECK(Partner(groups, L"abc") == L"-");
+}
+
+struct Fixture {
+    fs::path dir = fs::temp_directory_path() / "nx_pair_rule_test";
+
+    explicit Fixture(std::initializer_list<const char*> files) {
+        fs::remove_all(dir);
+        fs::create_directories(dir / "sub");
+        for (const char* file : files) std::ofstream(dir / file) << file;
+    }
+    ~Fixture() { fs::remove_all(dir); }
+};
+
+std::vector<std::pair<std::string, std::string>> Scan(const PairRule& rule) {
+    SwapBatch batch;
+    CHECK(ScanPairRule(rule, batch));
+    std::vector<std::pair<std::string, std::string>> pairs;
+    const std::string root = Utf16ToUtf8(rule.Root()) + "\\";
+    std::string buffer;
+    for (const SwapEntry& entry : batch.entries) {
+        CHECK(!entry.preserveExt);
+        std::string path1(batch.paths.Path(entry.path1, buffer));
+        std::string path2(batch.paths.Path(entry.path2, buffer));
+        CHECK_EQ(path1.rfind(root, 0), size_t{0});
+        CHECK_EQ(path2.rfind(root, 0), size_t{0});
+        pairs.emplace_back(path1.substr(root.size()), path2.substr(root.size()));
+    }
+    return pairs;
+}
+
+// Partners are found case-insensitively and named as stored, in every subfolder, sorted by first path
+void TestScan() {
+    const Fixture fixture({"one.a", "ONE.B", "two.a", "three.b", "sub/four.a", "sub/four.b"});
+    PairRule rule;
+    CHECK(PairRule::Compile(fixture.dir.wstring(), L"*.a", L"*.b", rule));
+    const std::vector<std::pair<std::string, std::string>> expected = {{"one.a", "ONE.B"},
+                                                                       {"sub\\four.a", "sub\\four.b"}};
+    CHECK(Scan(rule) == expected);
+}
+
+// A rule that maps partners back to each other, like "*.a" <-> "*.b", lists each pair once; a name that
+// maps to itself is no pair
+void TestScanKeepsMutualPairsOnce() {
+    const Fixture fixture({"x_y", "Y_X", "p_q", "a_a", "sub/m_n", "sub/n_m"});
+    PairRule rule;
+    CHECK(PairRule::Compile(fixture.dir.wstring(), L"re:([^_]*)_([^_]*)", L"$2_$1", rule));
+    const std::vector<std::pair<std::string, std::string>> expected = {{"sub\\m_n", "sub\\n_m"}, {"x_y", "Y_X"}};
+    CHECK(Scan(rule) == expected);
+}
+
+void TestScanMissingRoot() {
+    PairRule rule;
+    CHECK(PairRule::Compile((fs::temp_directory_path() / "nx_pair_rule_missing").wstring(), L"*.a", L"*.b", rule));
+    SwapBatch batch;
+    CHECK(!ScanPairRule(rule, batch));
+}
+}  // namespace
+
+int main() {
+    TestCompileRejects();
+    TestGlob();
+    TestReplacement();
+    TestRegex();
+    TestScan();
+    TestScanKeepsMutualPairsOnce();
+    TestScanMissingRoot();
+    return CheckResult();
+}
@@ -0,0 +1,178 @@
+#include "path_completion.h"
+
+#include "check.h"
+
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+using std::chrono::milliseconds;
+
+std::vector<std::string> Names(const std::vector<PathSuggestion>& suggestions) {
+    std::vector<std::string> names;
+    for (const PathSuggestion& suggestion : suggestions) names.push_back(suggestion.name);
+    return names;
+}
+
+// Complete until the listing is in, for up to two seconds
+bool CompleteWhenListed(PathCompleter& completer, const std::string& text, std::vector<PathSuggestion>& out) {
+    for (int i = 0; i < 200; ++i) {
+        if (completer.Complete(text, 8, out)) return true;
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    return false;
+}
+
+// A folder in %TEMP% holding the given files and subfolders
+struct Fixture {
+    fs::path dir;
+    std::string prefix;  // The folder as typed, with its trailing backslash
+
+    explicit Fixture(const char* name, std::initializer_list<const char*> files,
+                     std::initializer_list<const char*> folders = {})
+        : dir(fs::temp_directory_path() / name), prefix(dir.string() + "\\") {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (const char* file : files) std::ofstream(dir / file) << file;
+        for (const char* folder : folders) fs::create_directory(dir / folder);
+    }
+    ~Fixture() { fs::remove_all(dir); }
+};
+
+// Names sort by their folded keys, and a prefix selects one range of them
+void TestDirListing() {
+    const DirListing listing({L"beta.txt", L"Alpha.txt", L"alps", L"ALPINE.md", L"gamma"},
+                             {false, false, true, false, false});
+    CHECK_EQ(listing.Size(), size_t{5});
+    std::vector<PathSuggestion> out;
+    listing.Find(L"ALP", "C:\\dir\\", 8, out);
+    CHECK_EQ(Names(out), (std::vector<std::string>{"Alpha.txt", "ALPINE.md", "alps"}));
+    if (out.size() == 3) {
+        CHECK_EQ(out[0].path, std::string("C:\\dir\\Alpha.txt"));
+        CHECK(!out[0].directory);
+        // Folders end in a backslash, so the next level can be typed right away
+        CHECK_EQ(out[2].path, std::string("C:\\dir\\alps\\"));
+        CHECK(out[2].directory);
+    }
+
+    // Find appends, up to max
+    listing.Find(L"", "C:\\dir\\", 2, out);
+    CHECK_EQ(out.size(), size_t{5});
+    out.clear();
+    listing.Find(L"ALPHA.TXT", "C:\\dir\\", 8, out);
+    CHECK_EQ(out.size(), size_t{1});
+    out.clear();
+    listing.Find(L"ALPHA.TXTX", "C:\\dir\\", 8, out);
+    listing.Find(L"DELTA", "C:\\dir\\", 8, out);
+    CHECK(out.empty());
+}
+
+// Only absolute paths are completed; there is nothing to wait for with the others
+void TestRelativeTextNotCompleted() {
+    PathCompleter completer;
+    std::vector<PathSuggestion> out(1);
+    for (const char* text : {"", "report", "docs\\rep", "C:rep", "\\rep"}) {
+        CHECK(completer.Complete(text, 8, out));
+        CHECK(out.empty());
+    }
+}
+
+void TestComplete() {
+    const Fixture fixture("nx_path_completion_test", {"Report.docx", "report-old.docx", "summary.xlsx"}, {"reports"});
+    PathCompleter completer(16, milliseconds(10));
+    std::vector<PathSuggestion> out;
+    // Not listed yet: asked for, and served once the listing is in
+    CHECK(!completer.Complete(fixture.prefix + "rep", 8, out));
+    CHECK(CompleteWhenListed(completer, fixture.prefix + "rep", out));
+    // In folded order, where '-' sorts before '.'
+    CHECK_EQ(Names(out), (std::vector<std::string>{"report-old.docx", "Report.docx", "reports"}));
+    if (out.size() == 3) {
+        CHECK_EQ(out[1].path, fixture.prefix + "Report.docx");
+        CHECK_EQ(out[2].path, fixture.prefix + "reports\\");
+    }
+
+    // The same folder in another case, or with forward slashes, is the same listing
+    std::string upper = fixture.prefix;
+    for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    CHECK(completer.Complete(upper + "SUM", 8, out));
+    CHECK_EQ(Names(out), std::vector<std::string>{"summary.xlsx"});
+    std::string slashes = fixture.prefix;
+    for (char& c : slashes) c = c == '\\' ? '/' : c;
+    CHECK(completer.Complete(slashes + "sum", 8, out));
+    CHECK_EQ(out.size(), size_t{1});
+    if (!out.empty()) CHECK_EQ(out[0].path, slashes + "summary.xlsx");
+
+    CHECK(completer.Complete(fixture.prefix + "report-", 8, out));
+    CHECK_EQ(out.size(), size_t{1});
+    CHECK(completer.Complete(fixture.prefix + "rep", 1, out));
+    CHECK_EQ(out.size(), size_t{1});
+}
+
+// A folder that cannot be listed lists as empty rather than being asked for again and again
+void TestMissingFolder() {
+    PathCompleter completer(16, milliseconds(10));
+    std::vector<PathSuggestion> out;
+    const std::string missing = (fs::temp_directory_path() / "nx_path_completion_missing").string() + "\\";
+    CHECK(CompleteWhenListed(completer, missing + "a", out));
+    CHECK(out.empty());
+}
+
+// A listing older than the TTL keeps serving while it is listed again in the background
+void TestStaleListingRefreshed() {
+    const Fixture fixture("nx_path_completion_test", {"one.txt"});
+    PathCompleter completer(16, milliseconds(10), std::chrono::seconds(1));
+    std::vector<PathSuggestion> out;
+    CHECK(CompleteWhenListed(completer, fixture.prefix, out));
+    CHECK_EQ(Names(out), std::vector<std::string>{"one.txt"});
+
+    std::ofstream(fixture.dir / "two.txt") << "two";
+    CHECK(completer.Complete(fixture.prefix, 8, out));
+    CHECK_EQ(out.size(), size_t{1});
+
+    std::this_thread::sleep_for(milliseconds(1100));
+    CHECK(completer.Complete(fixture.prefix, 8, out));
+    CHECK_EQ(out.size(), size_t{1});
+    bool refreshed = false;
+    for (int i = 0; i < 200 && !refreshed; ++i) {
+        std::this_thread::sleep_for(milliseconds(10));
+        CHECK(completer.Complete(fixture.prefix, 8, out));
+        refreshed = out.size() == 2;
+    }
+    CHECK(refreshed);
+}
+
+// Beyond the capacity the least recently used listing is dropped
+void TestLeastRecentlyUsedDropped() {
+    const Fixture a("nx_path_completion_a", {"a.txt"});
+    const Fixture b("nx_path_completion_b", {"b.txt"});
+    const Fixture c("nx_path_completion_c", {"c.txt"});
+    PathCompleter completer(2, milliseconds(10));
+    std::vector<PathSuggestion> out;
+    CHECK(CompleteWhenListed(completer, a.prefix, out));
+    CHECK(CompleteWhenListed(completer, b.prefix, out));
+    // Touching a makes b the oldest
+    CHECK(completer.Complete(a.prefix, 8, out));
+    CHECK(CompleteWhenListed(completer, c.prefix, out));
+    CHECK(completer.Complete(a.prefix, 8, out));
+    CHECK(completer.Complete(c.prefix, 8, out));
+    CHECK(!completer.Complete(b.prefix, 8, out));
+    CHECK(out.empty());
+}
+}  // namespace
+
+int main() {
+    TestDirListing();
+    TestRelativeTextNotCompleted();
+    TestComplete();
+    TestMissingFolder();
+    TestStaleListingRefreshed();
+    TestLeastRecentlyUsedDropped();
+    return CheckResult();
+}
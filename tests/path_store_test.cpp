@@ -0,0 +1,88 @@
+#include "path_store.h"
+
+#include "check.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::string PathOf(const PathStore& store, PathRef ref) {
+    std::string buffer;
+    return std::string(store.Path(ref, buffer));
+}
+
+void TestRoundTrip() {
+    PathStore store;
+    const std::vector<std::string> paths = {
+        "C:\\dir\\a.txt", "C:\\dir\\b.txt", "C:\\dir\\sub\\a.txt", "a.txt", "", "C:\\", "\\\\server\\share\\x",
+        "C:\\dir\\\\double", "C:\\dir\\trailing\\",
+    };
+    std::vector<PathRef> refs;
+    for (const std::string& path : paths) {
+        const std::optional<PathRef> ref = store.Intern(path);
+        CHECK(ref.has_value());
+        refs.push_back(ref.value_or(PathRef{}));
+    }
+    PathReader reader(store);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        CHECK_EQ(PathOf(store, refs[i]), paths[i]);
+        CHECK_EQ(std::string(reader.Read(refs[i])), paths[i]);
+    }
+    // Siblings share their folder node
+    CHECK_EQ(refs[0].dir, refs[1].dir);
+    CHECK_EQ(std::string(store.Leaf(refs[2])), std::string("a.txt"));
+    CHECK_EQ(store.Intern("a.txt").value_or(PathRef{}).dir, uint32_t{0});
+}
+
+void TestCompare() {
+    PathStore store;
+    const std::vector<std::string> paths = {"C:\\a\\b", "C:\\a\\b\\c", "C:\\a b", "C:\\a\\c", "C:\\a", "C:\\a0\\b"};
+    for (const std::string& a : paths) {
+        for (const std::string& b : paths) {
+            const int expected = a.compare(b) < 0 ? -1 : a.compare(b) > 0 ? 1 : 0;
+            const int got = store.Compare(*store.Intern(a), *store.Intern(b));
+            CHECK_EQ(got < 0 ? -1 : got > 0 ? 1 : 0, expected);
+        }
+    }
+}
+
+// A component past the 16-bit length of a stored name cannot be held; it must not come back as a
+// shorter or empty path
+void TestOverlongComponent() {
+    PathStore store;
+    const std::string longName(64 * 1024, 'x');
+    CHECK(!store.Intern(longName).has_value());
+    CHECK(!store.Intern("C:\\dir\\" + longName).has_value());
+    CHECK(!store.Intern("C:\\" + longName + "\\a.txt").has_value());
+    CHECK(!store.Intern("C:\\dir\\" + longName + "\\a.txt").has_value());
+
+    // The longest component that fits, and the store still works after a rejection
+    const std::string longest(64 * 1024 - 1, 'y');
+    const std::optional<PathRef> fits = store.Intern("C:\\dir\\" + longest);
+    CHECK(fits.has_value());
+    CHECK_EQ(PathOf(store, fits.value_or(PathRef{})), "C:\\dir\\" + longest);
+    const std::optional<PathRef> after = store.Intern("C:\\dir\\a.txt");
+    CHECK(after.has_value());
+    CHECK_EQ(PathOf(store, after.value_or(PathRef{})), std::string("C:\\dir\\a.txt"));
+}
+
+void TestImport() {
+    PathStore from;
+    PathStore to;
+    const std::optional<PathRef> ref = from.Intern("D:\\x\\y\\z.bin");
+    CHECK(ref.has_value());
+    const std::optional<PathRef> imported = to.Import(from, ref.value_or(PathRef{}));
+    CHECK(imported.has_value());
+    CHECK_EQ(PathOf(to, imported.value_or(PathRef{})), std::string("D:\\x\\y\\z.bin"));
+}
+}  // namespace
+
+int main() {
+    TestRoundTrip();
+    TestCompare();
+    TestOverlongComponent();
+    TestImport();
+    return CheckResult();
+}
@@ -0,0 +1,142 @@
+#include "path_validator.h"
+
+#include "check.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+using std::chrono::milliseconds;
+using State = PathProbe::State;
+
+// A folder in %TEMP% with two files and a subfolder
+struct Fixture {
+    fs::path dir = fs::temp_directory_path() / "nx_path_validator_test";
+
+    Fixture() {
+        fs::remove_all(dir);
+        fs::create_directories(dir / "sub");
+        std::ofstream(dir / "a.txt") << "a";
+        std::ofstream(dir / "b.txt") << "b";
+    }
+    ~Fixture() { fs::remove_all(dir); }
+
+    std::string Path(const fs::path& name) const { return (dir / name).string(); }
+};
+
+// Query until the path has been looked at, for up to two seconds
+PathProbe QueryWhenChecked(PathValidator& validator, size_t field, const std::string& path) {
+    for (int i = 0; i < 200; ++i) {
+        const PathProbe probe = validator.Query(field, path);
+        if (probe.state != State::Unknown) return probe;
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    return {};
+}
+
+// An empty path or a field that does not exist is never looked at
+void TestNothingToCheck() {
+    const Fixture fixture;
+    PathValidator validator(milliseconds(10));
+    CHECK(validator.Query(0, "").state == State::Unknown);
+    CHECK(validator.Query(PathValidator::kFields, fixture.Path("a.txt")).state == State::Unknown);
+    std::this_thread::sleep_for(milliseconds(100));
+    CHECK_EQ(validator.Generation(), uint64_t{0});
+}
+
+// How the stat errors map: a missing item or folder is Missing, a name the volume rejects is Invalid
+void TestStates() {
+    const Fixture fixture;
+    PathValidator validator(milliseconds(10));
+    const PathProbe file = QueryWhenChecked(validator, 0, fixture.Path("a.txt"));
+    CHECK(file.state == State::File);
+    CHECK(file.Exists());
+    CHECK(file.identified);
+    const PathProbe folder = QueryWhenChecked(validator, 1, fixture.Path("sub"));
+    CHECK(folder.state == State::Directory);
+    CHECK(folder.Exists());
+
+    const PathProbe missing = QueryWhenChecked(validator, 2, fixture.Path("missing.txt"));
+    CHECK(missing.state == State::Missing);
+    CHECK(!missing.Exists());
+    CHECK(!missing.identified);
+    CHECK(QueryWhenChecked(validator, 3, fixture.Path(fs::path("nodir") / "x.txt")).state == State::Missing);
+    CHECK(QueryWhenChecked(validator, 0, fixture.Path("a|b.txt")).state == State::Invalid);
+}
+
+// The same item however it is spelled; unidentified probes are never the same item
+void TestSameItem() {
+    const Fixture fixture;
+    PathValidator validator(milliseconds(10));
+    const PathProbe a = QueryWhenChecked(validator, 0, fixture.Path("a.txt"));
+    const PathProbe spelled = QueryWhenChecked(validator, 1, fixture.Path(fs::path(".") / "a.txt"));
+    const PathProbe b = QueryWhenChecked(validator, 2, fixture.Path("b.txt"));
+    CHECK(a.SameItem(spelled));
+    CHECK(spelled.SameItem(a));
+    CHECK(!a.SameItem(b));
+    CHECK(!a.SameItem(PathProbe{}));
+    CHECK(!PathProbe{}.SameItem(PathProbe{}));
+}
+
+// While typing, each keystroke replaces the field's pending path and pushes the stat out; once
+// typing pauses only the last path is looked at
+void TestDebounce() {
+    const Fixture fixture;
+    PathValidator validator(milliseconds(200));
+    const std::string path = fixture.Path("a.txt");
+    for (size_t length = path.size() - 10; length <= path.size(); ++length) {
+        CHECK(validator.Query(0, path.substr(0, length)).state == State::Unknown);
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    CHECK_EQ(validator.Generation(), uint64_t{0});
+    CHECK(QueryWhenChecked(validator, 0, path).state == State::File);
+    CHECK_EQ(validator.Generation(), uint64_t{1});
+    CHECK(validator.Query(1, path.substr(0, path.size() - 1)).state == State::Unknown);
+}
+
+// Each field holds a pending path of its own, and the cache is shared between them
+void TestFieldsIndependent() {
+    const Fixture fixture;
+    PathValidator validator(milliseconds(10));
+    CHECK(validator.Query(0, fixture.Path("a.txt")).state == State::Unknown);
+    CHECK(validator.Query(1, fixture.Path("sub")).state == State::Unknown);
+    CHECK(QueryWhenChecked(validator, 0, fixture.Path("a.txt")).state == State::File);
+    CHECK(QueryWhenChecked(validator, 1, fixture.Path("sub")).state == State::Directory);
+    CHECK_EQ(validator.Generation(), uint64_t{2});
+    CHECK(validator.Query(3, fixture.Path("sub")).state == State::Directory);
+}
+
+// A result older than the TTL keeps serving while the path is looked at again
+void TestStaleResultRefreshed() {
+    const Fixture fixture;
+    PathValidator validator(milliseconds(10), milliseconds(200));
+    const std::string path = fixture.Path("c.txt");
+    CHECK(QueryWhenChecked(validator, 0, path).state == State::Missing);
+    std::ofstream(fixture.dir / "c.txt") << "c";
+    CHECK(validator.Query(0, path).state == State::Missing);
+
+    std::this_thread::sleep_for(milliseconds(250));
+    CHECK(validator.Query(0, path).state == State::Missing);
+    bool refreshed = false;
+    for (int i = 0; i < 200 && !refreshed; ++i) {
+        std::this_thread::sleep_for(milliseconds(10));
+        refreshed = validator.Query(0, path).state == State::File;
+    }
+    CHECK(refreshed);
+}
+}  // namespace
+
+int main() {
+    TestNothingToCheck();
+    TestStates();
+    TestSameItem();
+    TestDebounce();
+    TestFieldsIndependent();
+    TestStaleResultRefreshed();
+    return CheckResult();
+}
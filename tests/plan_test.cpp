@@ -0,0 +1,181 @@
+#include "plan.h"
+
+#include "check.h"
+#include "exchange.h"
+#include "swap_queue.h"
+
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+// Round numbers, so costs can be checked exactly; a fixed model also keeps the plan off the disk
+PlanCostModel Model() {
+    PlanCostModel model;
+    model.statUs = 10.0;
+    model.renameUs = 100.0;
+    model.copyBytesPerUs = 1.0;
+    return model;
+}
+
+struct Planned {
+    SwapBatch batch;
+    PlanCostModel model = Model();
+    PlanOptions options;
+
+    Planned() { options.fixedModel = &model; }
+    Plan Build() const { return BuildPlan(batch.paths, batch.entries, options); }
+};
+
+void TestStrategies() {
+    Planned p;
+    p.batch.Add("C:\\x\\a.txt", "C:\\y\\b.txt", false);
+    p.batch.Add("D:\\x\\Readme.txt", "D:\\x\\README.md", true);
+    p.batch.Add("C:\\x\\c.txt", "E:\\k.txt", false);
+    // Shares compare case-insensitively, and each share is a volume of its own
+    p.batch.Add("\\\\server\\share\\a.txt", "\\\\SERVER\\Share\\dir\\b.txt", false);
+    p.batch.Add("\\\\server\\share\\c.txt", "\\\\server\\other\\d.txt", false);
+    const Plan plan = p.Build();
+    const PlanStrategy expected[] = {PlanStrategy::Rename, PlanStrategy::CaseOnly, PlanStrategy::CrossVolume,
+                                     PlanStrategy::Rename, PlanStrategy::CrossVolume};
+    CHECK_EQ(plan.pairs.size(), std::size(expected));
+    for (size_t i = 0; i < plan.pairs.size() && i < std::size(expected); ++i) {
+        CHECK(plan.pairs[i].strategy == expected[i]);
+        CHECK_EQ(plan.pairs[i].code, kResultSuccess);
+    }
+}
+
+// Pairs that cannot succeed are skipped with the code the swap would give, without running
+void TestSkips() {
+    Planned p;
+    p.batch.Add("C:\\x\\f.txt", "c:\\X\\.\\F.TXT", false);
+    p.batch.Add("C:\\x", "C:\\x\\y\\z", false);
+    p.batch.Add("C:\\x\\g.txt", "C:\\y\\nul", false);
+    p.batch.Add("C:\\x\\a.txt", "C:\\y\\b.txt", false);
+    // Takes C:\x\b.txt, which the pair before gives to C:\x\a.txt
+    p.batch.Add("C:\\x\\h.txt", "E:\\B.TXT", false);
+    const Plan plan = p.Build();
+    const int expected[] = {kResultSameFile, kResultInvalidPath, kResultInvalidPath, kResultSuccess,
+                            kResultNameCollision};
+    CHECK_EQ(plan.pairs.size(), std::size(expected));
+    for (size_t i = 0; i < plan.pairs.size() && i < std::size(expected); ++i) {
+        CHECK_EQ(plan.pairs[i].code, expected[i]);
+        CHECK_EQ(plan.pairs[i].strategy == PlanStrategy::Skip, expected[i] != kResultSuccess);
+        if (expected[i] != kResultSuccess) CHECK_EQ(plan.pairs[i].costUs, 0.0);
+    }
+    // Only the pair that runs has a volume
+    CHECK_EQ(plan.volumes.size(), size_t{1});
+
+    // The same names are fine where the rules allow them
+    p.options.nameRules = NameRules::Posix;
+    CHECK_EQ(p.Build().pairs[2].code, kResultSuccess);
+}
+
+// Two stats to probe the items, then three renames, four for case-only and cross-volume pairs
+void TestCosts() {
+    Planned p;
+    p.batch.Add("C:\\x\\a.txt", "C:\\y\\b.txt", false);
+    p.batch.Add("D:\\x\\Readme.txt", "D:\\x\\README.md", true);
+    p.batch.Add("C:\\x\\c.txt", "E:\\k.txt", false);
+    Plan plan = p.Build();
+    CHECK_EQ(plan.pairs[0].costUs, 320.0);
+    CHECK_EQ(plan.pairs[1].costUs, 420.0);
+    // Sizes are not stat'ed against a fixed model, so nothing is copied
+    CHECK_EQ(plan.pairs[2].costUs, 420.0);
+
+    // --verify adds four identity stats, --swap-metadata six handle operations
+    p.options.verify = true;
+    plan = p.Build();
+    CHECK_EQ(plan.pairs[0].costUs, 360.0);
+    p.options.metadata = 1;
+    plan = p.Build();
+    CHECK_EQ(plan.pairs[0].costUs, 420.0);
+    CHECK_EQ(plan.pairs[1].costUs, 520.0);
+}
+
+void TestVolumes() {
+    Planned p;
+    p.batch.Add("d:\\x\\a.txt", "D:\\y\\b.txt", false);
+    p.batch.Add("C:\\x\\c.txt", "E:\\k.txt", false);
+    p.batch.Add("\\\\server\\share\\a.txt", "\\\\server\\share\\b.txt", false);
+    p.batch.Add("D:\\x\\e.txt", "D:\\y\\f.txt", false);
+    p.batch.Add("C:\\x\\g.txt", "C:\\x\\g.txt", false);
+    const Plan plan = p.Build();
+    // In order of first use, by the first path, and upper-cased
+    CHECK_EQ(plan.volumes.size(), size_t{3});
+    if (plan.volumes.size() == 3) {
+        CHECK(plan.volumes[0].root == L"D:");
+        CHECK_EQ(plan.volumes[0].pairs, size_t{2});
+        CHECK(plan.volumes[1].root == L"C:");
+        CHECK_EQ(plan.volumes[1].pairs, size_t{1});
+        CHECK(plan.volumes[2].root == L"\\\\SERVER\\SHARE");
+        CHECK(!plan.volumes[2].model.measured);
+        CHECK_EQ(plan.volumes[2].model.renameUs, 100.0);
+    }
+}
+
+// Total cost over the pipeline depth, but never faster than the rate cap allows
+void TestEstimate() {
+    Plan plan;
+    plan.pairs.resize(4);
+    for (PlannedPair& pair : plan.pairs) pair.costUs = 1000.0;
+    plan.pairs[3].strategy = PlanStrategy::Skip;
+    PlanOptions options;
+    CHECK_EQ(EstimatePlanRunUs(plan, options), 3000.0);
+    options.depth = 4;
+    CHECK_EQ(EstimatePlanRunUs(plan, options), 750.0);
+    options.depth = 0;
+    CHECK_EQ(EstimatePlanRunUs(plan, options), 3000.0);
+    options.depth = 4;
+    options.opsPerSecond = 1000.0;
+    CHECK_EQ(EstimatePlanRunUs(plan, options), 3000.0);
+    options.opsPerSecond = 1e6;
+    CHECK_EQ(EstimatePlanRunUs(plan, options), 750.0);
+}
+
+void TestPlanRecords() {
+    PlannedPair planned;
+    planned.costUs = 911.6;
+    std::string out;
+    AppendPlanRecord(out, 7, "C:\\a \"1\".txt", "D:\\b.txt", false, planned);
+    CHECK_EQ(out, std::string("{\"seq\":7,\"path1\":\"C:\\\\a \\\"1\\\".txt\",\"path2\":\"D:\\\\b.txt\",\"preserve\":false,"
+                              "\"strategy\":\"rename\",\"code\":0,\"cost_us\":912}\n"));
+    PlanRecord record;
+    CHECK(ParsePlanRecord(out, record));
+    CHECK_EQ(record.path1, std::string("C:\\a \"1\".txt"));
+    CHECK_EQ(record.path2, std::string("D:\\b.txt"));
+    CHECK(!record.preserveExt);
+    CHECK_EQ(record.code, kResultSuccess);
+
+    // Skipped pairs keep their reason; a skip without one is an invalid path
+    planned.strategy = PlanStrategy::Skip;
+    planned.code = kResultNameCollision;
+    out.clear();
+    AppendPlanRecord(out, 8, "a", "b", true, planned);
+    CHECK(ParsePlanRecord(out, record));
+    CHECK_EQ(record.code, kResultNameCollision);
+    CHECK(record.preserveExt);
+    CHECK(ParsePlanRecord("{\"path1\":\"a\",\"path2\":\"b\",\"strategy\":\"skip\"}", record));
+    CHECK_EQ(record.code, kResultInvalidPath);
+
+    // Not records: a plain line, the header, a missing path, a bad flag, an unclosed record
+    for (const std::string_view line : {std::string_view("a.txt"), std::string_view(), std::string_view("{}"),
+                                        kPlanHeader, std::string_view("{\"path1\":\"a\"}"),
+                                        std::string_view("{\"path1\":\"a\",\"path2\":\"b\",\"preserve\":yes}"),
+                                        std::string_view("{\"path1\":\"a\",\"path2\":\"b\"")}) {
+        CHECK(!ParsePlanRecord(line, record));
+    }
+    CHECK_EQ(record.code, kResultInvalidPath);
+}
+}  // namespace
+
+int main() {
+    TestStrategies();
+    TestSkips();
+    TestCosts();
+    TestVolumes();
+    TestEstimate();
+    TestPlanRecords();
+    return CheckResult();
+}
@@ -0,0 +1,151 @@
+#include "queue_view.h"
+
+#include "check.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// A queue as the view sees it: a store, its entries and the two revisions
+struct Queue {
+    PathStore paths;
+    std::vector<SwapEntry> entries;
+    uint64_t revision = 0;
+    uint64_t layoutRevision = 0;
+
+    void Add(const char* path1, const char* path2, SwapState state = SwapState::Pending) {
+        SwapEntry entry;
+        entry.path1 = *paths.Intern(path1);
+        entry.path2 = *paths.Intern(path2);
+        entry.state = state;
+        entries.push_back(entry);
+        ++revision;
+        ++layoutRevision;
+    }
+
+    const std::vector<uint32_t>& Rows(QueueView& view) const {
+        view.Update(paths, entries, revision, layoutRevision);
+        return view.Rows();
+    }
+};
+
+using Rows = std::vector<uint32_t>;
+
+Queue Sample() {
+    Queue queue;
+    queue.Add("C:\\b\\Report.docx", "D:\\z\\one.txt", SwapState::Done);
+    queue.Add("C:\\a\\notes.md", "D:\\y\\two.txt", SwapState::Failed);
+    queue.Add("C:\\c\\REPORT.xlsx", "D:\\x\\three.txt", SwapState::Pending);
+    queue.Add("C:\\a\\archive.zip", "D:\\w\\report.pdf", SwapState::Running);
+    queue.Add("C:\\b\\image.png", "D:\\v\\four.txt", SwapState::Pending);
+    return queue;
+}
+
+void TestOrder() {
+    const Queue queue = Sample();
+    QueueView view;
+    CHECK_EQ(queue.Rows(view), (Rows{0, 1, 2, 3, 4}));
+    view.descending = true;
+    CHECK_EQ(queue.Rows(view), (Rows{4, 3, 2, 1, 0}));
+}
+
+// Paths sort byte-wise, so upper case comes first; equal keys keep insertion order
+void TestSortByPath() {
+    Queue queue = Sample();
+    queue.Add("C:\\a\\notes.md", "D:\\u\\five.txt");
+    QueueView view;
+    view.sortKey = QueueSortKey::Path1;
+    CHECK_EQ(queue.Rows(view), (Rows{3, 1, 5, 0, 4, 2}));
+    view.descending = true;
+    CHECK_EQ(queue.Rows(view), (Rows{2, 4, 0, 5, 1, 3}));
+    view.descending = false;
+    view.sortKey = QueueSortKey::Path2;
+    CHECK_EQ(queue.Rows(view), (Rows{5, 4, 3, 2, 1, 0}));
+}
+
+// Running, pending, failed, done; insertion order inside each, in either direction
+void TestSortByStatus() {
+    const Queue queue = Sample();
+    QueueView view;
+    view.sortKey = QueueSortKey::Status;
+    CHECK_EQ(queue.Rows(view), (Rows{3, 2, 4, 1, 0}));
+    view.descending = true;
+    CHECK_EQ(queue.Rows(view), (Rows{0, 1, 2, 4, 3}));
+}
+
+void TestStateFilter() {
+    const Queue queue = Sample();
+    QueueView view;
+    view.filter = QueueFilter::Pending;
+    CHECK_EQ(queue.Rows(view), (Rows{2, 4}));
+    view.filter = QueueFilter::Running;
+    CHECK_EQ(queue.Rows(view), Rows{3});
+    view.filter = QueueFilter::Failed;
+    CHECK_EQ(queue.Rows(view), Rows{1});
+    view.filter = QueueFilter::Done;
+    view.descending = true;
+    CHECK_EQ(queue.Rows(view), Rows{0});
+}
+
+// Text matches either path, ignoring ASCII case, and combines with the state filter and the sort
+void TestTextFilter() {
+    const Queue queue = Sample();
+    QueueView view;
+    view.filterText = "rEpOrT";
+    CHECK_EQ(queue.Rows(view), (Rows{0, 2, 3}));
+    view.filter = QueueFilter::Pending;
+    CHECK_EQ(queue.Rows(view), Rows{2});
+    view.filter = QueueFilter::All;
+    view.sortKey = QueueSortKey::Path1;
+    CHECK_EQ(queue.Rows(view), (Rows{3, 0, 2}));
+    view.filterText = "nothing";
+    CHECK(queue.Rows(view).empty());
+    view.filterText.clear();
+    CHECK_EQ(queue.Rows(view).size(), size_t{5});
+}
+
+// Added entries are sorted and matched at once, as they change the layout revision
+void TestAddedEntries() {
+    Queue queue = Sample();
+    QueueView view;
+    view.sortKey = QueueSortKey::Path1;
+    view.filterText = "a\\";
+    CHECK_EQ(queue.Rows(view), (Rows{3, 1}));
+    queue.Add("C:\\a\\aaa.txt", "D:\\t\\six.txt");
+    CHECK_EQ(queue.Rows(view), (Rows{5, 3, 1}));
+}
+
+// A state change shows on the next update at most every 100 ms; an unchanged revision never rebuilds
+void TestStateChangesThrottled() {
+    Queue queue = Sample();
+    QueueView view;
+    view.filter = QueueFilter::Pending;
+    CHECK_EQ(queue.Rows(view), (Rows{2, 4}));
+
+    queue.entries[2].state = SwapState::Running;
+    CHECK_EQ(queue.Rows(view), (Rows{2, 4}));
+    ++queue.revision;
+    CHECK_EQ(queue.Rows(view), (Rows{2, 4}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    CHECK_EQ(queue.Rows(view), Rows{4});
+
+    // A settings change takes effect at once
+    queue.entries[4].state = SwapState::Done;
+    ++queue.revision;
+    view.filter = QueueFilter::Done;
+    CHECK_EQ(queue.Rows(view), (Rows{0, 4}));
+}
+}  // namespace
+
+int main() {
+    TestOrder();
+    TestSortByPath();
+    TestSortByStatus();
+    TestStateFilter();
+    TestTextFilter();
+    TestAddedEntries();
+    TestStateChangesThrottled();
+    return CheckResult();
+}
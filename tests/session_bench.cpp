@@ -0,0 +1,110 @@
+// Swaps the same pairs by spawning name_exchanger once per pair and through one in-process session,
+// and prints the time per pair of each:
+//   session_bench <path to name_exchanger.exe> [pairs]
+// Not run by ctest. Each method swaps every pair once, all in the same temp folder.
+
+#include "swap_session.h"
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double seconds = 0;
+    size_t failed = 0;
+};
+
+Result Spawn(const std::wstring& exe, const std::vector<std::string>& paths1, const std::vector<std::string>& paths2) {
+    Result result;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < paths1.size(); ++i) {
+        std::wstring commandLine = L"\"" + exe + L"\" \"" + fs::path(paths1[i]).wstring() + L"\" \"" +
+                                   fs::path(paths2[i]).wstring() + L"\"";
+        STARTUPINFOW si = {};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi = {};
+        if (!CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr,
+                            &si, &pi)) {
+            ++result.failed;
+            continue;
+        }
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        DWORD code = 1;
+        GetExitCodeProcess(pi.hProcess, &code);
+        result.failed += code != 0;
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+Result InProcess(uint32_t depth, const std::vector<std::string>& paths1, const std::vector<std::string>& paths2) {
+    Result result;
+    std::vector<const char*> ptrs1;
+    std::vector<const char*> ptrs2;
+    for (size_t i = 0; i < paths1.size(); ++i) {
+        ptrs1.push_back(paths1[i].c_str());
+        ptrs2.push_back(paths2[i].c_str());
+    }
+    nx_options options;
+    nx_options_init(&options);
+    options.pipeline_depth = depth;
+    std::vector<int32_t> codes(paths1.size());
+
+    const auto start = Clock::now();
+    nx_session* session = nx_session_open();
+    nx_session_add(session, ptrs1.data(), ptrs2.data(), nullptr, ptrs1.size());
+    nx_session_execute(session, &options);
+    nx_session_results(session, 0, codes.size(), codes.data(), nullptr);
+    nx_session_close(session);
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const int32_t code : codes) result.failed += code != 0;
+    return result;
+}
+
+void Print(const char* method, const Result& result, size_t pairs) {
+    std::printf("%-22s %10.1f ms %10.1f us/pair %8zu failed\n", method, result.seconds * 1e3,
+                result.seconds * 1e6 / static_cast<double>(pairs), result.failed);
+}
+}  // namespace
+
+int wmain(int argc, wchar_t** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: session_bench <name_exchanger.exe> [pairs]\n");
+        return 2;
+    }
+    const std::wstring exe = fs::absolute(argv[1]).wstring();
+    const size_t count = argc > 2 ? std::wcstoul(argv[2], nullptr, 10) : 500;
+
+    const fs::path dir = fs::temp_directory_path() / "nx_session_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::vector<std::string> paths1;
+    std::vector<std::string> paths2;
+    for (size_t i = 0; i < count; ++i) {
+        const fs::path a = dir / ("a" + std::to_string(i) + ".txt");
+        const fs::path b = dir / ("b" + std::to_string(i) + ".txt");
+        std::ofstream(a) << 'a';
+        std::ofstream(b) << 'b';
+        paths1.push_back(a.string());
+        paths2.push_back(b.string());
+    }
+
+    std::printf("%zu pairs\n", count);
+    Print("spawn per pair", Spawn(exe, paths1, paths2), count);
+    Print("session, depth 1", InProcess(1, paths1, paths2), count);
+    Print("session, depth 8", InProcess(8, paths1, paths2), count);
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Runs one manifest with --workers 1, 2, 4, 8 and 16 on a simulated share and prints the throughput
+// of each against a single worker:
+//   shard_bench <path to name_exchanger.exe> [pairs] [rtt ms]
+// Not run by ctest. The pairs are spread over 256 folders, so every worker count has shards to share.
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+namespace fs = std::filesystem;
+
+constexpr size_t kFolders = 256;
+constexpr size_t kWorkerCounts[] = {1, 2, 4, 8, 16};
+
+// Seconds the run took, or a negative value if it could not be started or failed
+double Run(std::wstring commandLine) {
+    SECURITY_ATTRIBUTES inherit = {sizeof(inherit), nullptr, TRUE};
+    HANDLE null = CreateFileW(L"NUL", GENERIC_WRITE, FILE_SHARE_WRITE, &inherit, OPEN_EXISTING, 0, nullptr);
+    STARTUPINFOW si = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    si.hStdOutput = null;
+    si.hStdError = null;
+    PROCESS_INFORMATION pi = {};
+    const auto start = std::chrono::steady_clock::now();
+    const BOOL started = CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr,
+                                        nullptr, &si, &pi);
+    CloseHandle(null);
+    if (!started) return -1;
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    DWORD code = 1;
+    GetExitCodeProcess(pi.hProcess, &code);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return code == 0 ? seconds : -1;
+}
+}  // namespace
+
+int wmain(int argc, wchar_t** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: shard_bench <name_exchanger.exe> [pairs] [rtt ms]\n");
+        return 2;
+    }
+    const std::wstring exe = fs::absolute(argv[1]).wstring();
+    const size_t count = argc > 2 ? std::wcstoul(argv[2], nullptr, 10) : 20000;
+    const std::wstring rtt = argc > 3 ? argv[3] : L"2";
+
+    const fs::path manifest = fs::temp_directory_path() / "nx_shard_bench.txt";
+    {
+        std::ofstream list(manifest, std::ios::binary);
+        for (size_t i = 0; i < count; ++i) {
+            const std::string dir = "S:\\bench\\f" + std::to_string(i % kFolders) + "\\";
+            list << dir << "a" << i << ".txt\n" << dir << "b" << i << ".txt\n";
+        }
+    }
+
+    std::printf("%zu pairs, %ls ms per round trip\n", count, rtt.c_str());
+    std::printf("%8s %10s %12s %8s\n", "workers", "seconds", "pairs/s", "speedup");
+    double single = 0;
+    for (const size_t workers : kWorkerCounts) {
+        const double seconds = Run(L"\"" + exe + L"\" --manifest \"" + manifest.wstring() + L"\" --workers " +
+                                   std::to_wstring(workers) + L" --simulate-latency " + rtt);
+        if (seconds < 0) {
+            std::printf("%8zu failed\n", workers);
+            continue;
+        }
+        if (single == 0) single = seconds;
+        std::printf("%8zu %10.2f %12.0f %7.2fx\n", workers, seconds, static_cast<double>(count) / seconds,
+                    single / seconds);
+    }
+    fs::remove(manifest);
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "shard_executor.h"
+
+#include "check.h"
+#include "exchange.h"
+#include "manifest.h"
+#include "name_rules.h"
+#include "vfs.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+
+// Lines one way between the coordinator and a fake worker
+class LineQueue {
+public:
+    bool Push(std::string line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) return false;
+        lines_.push_back(std::move(line));
+        cv_.notify_all();
+        return true;
+    }
+    bool Pop(std::string& line) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return closed_ || !lines_.empty(); });
+        if (lines_.empty()) return false;
+        line = std::move(lines_.front());
+        lines_.pop_front();
+        return true;
+    }
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> lines_;
+    bool closed_ = false;
+};
+
+// The worker side of a fake channel: gets the shard's pairs and the channel to answer on; returns
+// false to die on the spot, as a killed process would
+using WorkerFn = std::function<bool(const std::vector<uint64_t>& pairs, LineQueue& out)>;
+
+// A worker on a thread of this process, speaking the pipe protocol over two queues
+class FakeChannel final : public ShardChannel {
+public:
+    explicit FakeChannel(WorkerFn work) {
+        worker_ = std::thread([this, work = std::move(work)]() {
+            std::string line;
+            while (toWorker_.Pop(line)) {
+                std::vector<uint64_t> pairs;
+                for (size_t at = line.find(' '); at != std::string::npos; at = line.find(' ', at + 1)) {
+                    pairs.push_back(std::stoull(line.substr(at + 1)));
+                }
+                if (!work(pairs, fromWorker_) || !fromWorker_.Push("D")) break;
+            }
+            fromWorker_.Close();
+        });
+    }
+    ~FakeChannel() override {
+        toWorker_.Close();
+        worker_.join();
+    }
+
+    bool Send(std::string_view line) override { return toWorker_.Push(std::string(line)); }
+    bool Receive(std::string& line) override { return fromWorker_.Pop(line); }
+
+private:
+    LineQueue toWorker_;
+    LineQueue fromWorker_;
+    std::thread worker_;
+};
+
+// Runs every pair it is sent, except that the first worker started dies after `dieAfter` pairs of
+// its first shard, with the pair after them begun but not finished
+class FakeTransport final : public ShardTransport {
+public:
+    explicit FakeTransport(size_t dieAfter) : dieAfter_(dieAfter) {}
+
+    std::unique_ptr<ShardChannel> Connect(size_t /*slot*/) override {
+        const bool doomed = connects_.fetch_add(1) == 0;
+        return std::make_unique<FakeChannel>([this, doomed](const std::vector<uint64_t>& pairs, LineQueue& out) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                shards.push_back(pairs);
+                if (doomed) killedShard = pairs;
+            }
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                out.Push("B " + std::to_string(pairs[i]));
+                if (doomed && i == dieAfter_) return false;
+                out.Push("E " + std::to_string(pairs[i]) + " 0 1");
+            }
+            return true;
+        });
+    }
+
+    std::mutex mutex;
+    std::vector<std::vector<uint64_t>> shards;  // Every shard sent, in order
+    std::vector<uint64_t> killedShard;
+
+private:
+    size_t dieAfter_;
+    std::atomic<size_t> connects_{0};
+};
+
+// No worker can be started: everything runs in the coordinator's process
+class DeadTransport final : public ShardTransport {
+public:
+    std::unique_ptr<ShardChannel> Connect(size_t /*slot*/) override {
+        ++connects;
+        return nullptr;
+    }
+    std::atomic<size_t> connects{0};
+};
+
+class CountingVfs final : public Vfs {
+public:
+    int Probe(const std::string&) override { return kResultSuccess; }
+    int Exchange(const std::string&, const std::string&, bool) override {
+        ++swaps;
+        return kResultSuccess;
+    }
+    std::atomic<size_t> swaps{0};
+};
+
+struct Fixture {
+    fs::path dir = fs::temp_directory_path() / "nx_shard_executor_test";
+    Manifest manifest;
+
+    Fixture() {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+    ~Fixture() {
+        manifest.Close();
+        fs::remove_all(dir);
+    }
+
+    // `pairs` pairs in each of `folders` folders; nothing exists on disk, the fakes never look
+    bool MakeManifest(size_t folders, size_t pairs) {
+        std::ofstream list(dir / "pairs.txt", std::ios::binary);
+        for (size_t f = 0; f < folders; ++f) {
+            for (size_t p = 0; p < pairs; ++p) {
+                const std::string base = "C:\\shard\\f" + std::to_string(f) + "\\";
+                list << base << "a" << p << ".txt\n" << base << "b" << p << ".txt\n";
+            }
+        }
+        list.close();
+        return manifest.Open((dir / "pairs.txt").wstring());
+    }
+
+    // Run the coordinator with stdout sent to a file; returns the code of each pair's result
+    // record, in the order written
+    std::vector<std::pair<uint64_t, int>> Run(ShardTransport& transport, Vfs& vfs, size_t workers, int& exitCode) {
+        const fs::path outPath = dir / "out.jsonl";
+        HANDLE out = CreateFileW(outPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, 0, nullptr);
+        const HANDLE stdOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        SetStdHandle(STD_OUTPUT_HANDLE, out);
+        RunShardCoordinator(vfs, manifest, false, 4, NameRules::None, transport, workers, &exitCode);
+        SetStdHandle(STD_OUTPUT_HANDLE, stdOut);
+        CloseHandle(out);
+
+        std::vector<std::pair<uint64_t, int>> records;
+        std::ifstream in(outPath);
+        for (std::string line; std::getline(in, line);) {
+            const size_t seq = line.find("\"seq\":");
+            const size_t code = line.find("\"code\":");
+            if (seq == std::string::npos || code == std::string::npos) continue;
+            records.emplace_back(std::stoull(line.substr(seq + 6)), std::stoi(line.substr(code + 7)));
+        }
+        return records;
+    }
+};
+
+// A worker killed mid-shard: the pair it had begun is reported lost (code 10) and never handed
+// out again, the pairs it never started go to another worker, and every pair is reported once
+void TestWorkerKilledMidShard() {
+    Fixture f;
+    CHECK(f.MakeManifest(16, 8));
+    FakeTransport transport(3);
+    CountingVfs vfs;
+    int exitCode = -1;
+    const auto records = f.Run(transport, vfs, 4, exitCode);
+
+    CHECK_EQ(exitCode, 1);
+    CHECK_EQ(vfs.swaps.load(), size_t{0});
+    CHECK_EQ(records.size(), f.manifest.Size());
+    std::map<uint64_t, int> codes;
+    for (const auto& [pair, code] : records) {
+        CHECK(codes.emplace(pair, code).second);
+    }
+    CHECK_EQ(codes.size(), f.manifest.Size());
+
+    std::lock_guard<std::mutex> lock(transport.mutex);
+    const std::vector<uint64_t>& killed = transport.killedShard;
+    CHECK(killed.size() > 4);
+    if (killed.size() <= 4) return;
+    const uint64_t lost = killed[3];
+    for (const auto& [pair, code] : codes) {
+        CHECK_EQ(code, pair == lost ? kResultWorkerLost : kResultSuccess);
+    }
+
+    // Sent once, to the killed worker, and never again; the rest of its shard went out once more
+    size_t sentLost = 0;
+    std::map<uint64_t, size_t> sent;
+    for (const std::vector<uint64_t>& shard : transport.shards) {
+        for (const uint64_t pair : shard) ++sent[pair];
+    }
+    for (size_t i = 0; i < killed.size(); ++i) {
+        CHECK_EQ(sent[killed[i]], size_t{i > 3 ? 2 : 1});
+        sentLost += killed[i] == lost;
+    }
+    CHECK_EQ(sentLost, size_t{1});
+    for (const auto& [pair, count] : sent) {
+        if (std::find(killed.begin(), killed.end(), pair) == killed.end()) CHECK_EQ(count, size_t{1});
+    }
+}
+
+// Without any worker the coordinator runs the shards itself after giving each slot its restarts
+void TestNoWorkerRunsLocally() {
+    Fixture f;
+    CHECK(f.MakeManifest(4, 5));
+    DeadTransport transport;
+    CountingVfs vfs;
+    int exitCode = -1;
+    const auto records = f.Run(transport, vfs, 2, exitCode);
+
+    CHECK_EQ(exitCode, 0);
+    CHECK_EQ(records.size(), f.manifest.Size());
+    CHECK_EQ(vfs.swaps.load(), f.manifest.Size());
+    CHECK(transport.connects.load() >= 2);
+    for (const auto& [pair, code] : records) CHECK_EQ(code, kResultSuccess);
+}
+}  // namespace
+
+int main() {
+    TestWorkerKilledMidShard();
+    TestNoWorkerRunsLocally();
+    return CheckResult();
+}
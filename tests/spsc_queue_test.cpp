@@ -0,0 +1,84 @@
+#include "spsc_queue.h"
+
+#include "check.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace {
+void TestCapacityRoundsUpToPowerOfTwo() {
+    SpscQueue<int> queue(3);
+    int pushed = 0;
+    for (int value = 0; value < 8; ++value) {
+        if (!queue.TryPush(value)) break;
+        ++pushed;
+    }
+    CHECK_EQ(pushed, 4);
+
+    // Freeing one slot makes room for exactly one more
+    CHECK(queue.TryPop() == 0);
+    int value = 4;
+    CHECK(queue.TryPush(value));
+    value = 5;
+    CHECK(!queue.TryPush(value));
+}
+
+void TestEmptyAndDrain() {
+    SpscQueue<int> queue(4);
+    CHECK(queue.Empty());
+    CHECK(!queue.TryPop().has_value());
+
+    queue.Push(1);
+    queue.Push(2);
+    queue.Close();
+    int out = 0;
+    CHECK(queue.Pop(out) && out == 1);
+    CHECK(queue.Pop(out) && out == 2);
+    CHECK(!queue.Pop(out));
+    CHECK(queue.Empty());
+}
+
+// A small ring forces both sides to park on each other; every item must arrive once, in order
+void TestOrderUnderBackpressure() {
+    constexpr uint64_t kItems = 1'000'000;
+    SpscQueue<uint64_t> queue(8);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < kItems; ++i) queue.Push(i);
+        queue.Close();
+    });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    uint64_t item = 0;
+    while (queue.Pop(item)) {
+        ordered = ordered && item == expected;
+        ++expected;
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK_EQ(expected, kItems);
+}
+
+// Close() must wake a consumer already parked on an empty ring
+void TestCloseWakesParkedConsumer() {
+    SpscQueue<int> queue(2);
+    bool popped = true;
+    std::thread consumer([&] {
+        int out = 0;
+        popped = queue.Pop(out);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.Close();
+    consumer.join();
+    CHECK(!popped);
+}
+}  // namespace
+
+int main() {
+    TestCapacityRoundsUpToPowerOfTwo();
+    TestEmptyAndDrain();
+    TestOrderUnderBackpressure();
+    TestCloseWakesParkedConsumer();
+    return CheckResult();
+}
@@ -0,0 +1,151 @@
+#include "swap_pipeline.h"
+
+#include "check.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cwctype>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Stand-in for FoldName, whose Windows case tables are not available everywhere. Paths use '/',
+// which std::filesystem splits on every platform.
+std::wstring TestFold(std::wstring_view text) {
+    std::wstring folded(text);
+    for (wchar_t& ch : folded) ch = static_cast<wchar_t>(std::towupper(ch));
+    return folded;
+}
+
+struct Span {
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+// Runs the pairs through a pipeline whose executor holds every swap for holdMs and records when
+// each ticket ran
+struct Recorder {
+    std::mutex mutex;
+    std::map<uint64_t, Span> spans;
+    std::vector<uint64_t> starts;
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+
+    void Run(size_t depth, const std::vector<std::pair<std::string, std::string>>& pairs, bool preserveExt,
+             int holdMs) {
+        SwapPipeline pipeline(
+            depth,
+            [&](uint64_t ticket, const std::string&, const std::string&, bool) {
+                const auto start = Clock::now();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    starts.push_back(ticket);
+                }
+                const int now = ++running;
+                for (int seen = maxRunning; now > seen && !maxRunning.compare_exchange_weak(seen, now);) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(holdMs));
+                --running;
+                std::lock_guard<std::mutex> lock(mutex);
+                spans[ticket] = {start, Clock::now()};
+                return 0;
+            },
+            [](uint64_t, int, int64_t) {}, TestFold);
+        for (size_t i = 0; i < pairs.size(); ++i) pipeline.Submit(i, pairs[i].first, pairs[i].second, preserveExt);
+        pipeline.Finish();
+    }
+
+    bool RanAfter(uint64_t later, uint64_t earlier) { return spans.at(later).start >= spans.at(earlier).end; }
+};
+
+void TestIndependentPairsOverlap() {
+    Recorder recorder;
+    recorder.Run(4, {{"A/1.txt", "B/1.txt"}, {"C/2.txt", "D/2.txt"}, {"E/3.txt", "F/3.txt"}, {"G/4.txt", "H/4.txt"}},
+                 true, 100);
+    CHECK_EQ(recorder.spans.size(), size_t{4});
+    CHECK_EQ(recorder.maxRunning.load(), 4);
+}
+
+void TestSharedPathsRunInOrder() {
+    Recorder recorder;
+    recorder.Run(4,
+                 {{"D/a.txt", "D/b.txt"}, {"D/B.TXT", "E/c.txt"}, {"e/c.txt", "F/d.txt"}, {"F/x/../d.txt", "G/e.txt"}},
+                 true, 30);
+    CHECK_EQ(recorder.maxRunning.load(), 1);
+    CHECK(recorder.RanAfter(1, 0));
+    CHECK(recorder.RanAfter(2, 1));
+    CHECK(recorder.RanAfter(3, 2));
+}
+
+// The second pair moves c.bin to D/old.txt, a name the first pair frees: it must wait even though
+// the two pairs share no path
+void TestTargetFreedByEarlierPairWaits() {
+    Recorder recorder;
+    recorder.Run(4, {{"D/old.txt", "E/new.txt"}, {"D/c.bin", "F/old.txt"}}, false, 50);
+    CHECK(recorder.RanAfter(1, 0));
+}
+
+// With preserveExt the second pair gives c.bin the name D/old.bin, which the first pair takes
+void TestPreservedExtensionTargetWaits() {
+    Recorder recorder;
+    recorder.Run(4, {{"D/x.bin", "E/old.txt"}, {"D/c.bin", "F/Old.Txt"}}, true, 50);
+    CHECK(recorder.RanAfter(1, 0));
+}
+
+// Pairs that only share a folder, not a name, still overlap
+void TestSameFolderDifferentNamesOverlap() {
+    Recorder recorder;
+    recorder.Run(4, {{"D/a.txt", "E/b.txt"}, {"D/c.txt", "E/d.txt"}}, true, 100);
+    CHECK_EQ(recorder.maxRunning.load(), 2);
+}
+
+// A later independent pair may overtake one that is waiting, but never the pair it waits for
+void TestIndependentPairOvertakesBlockedOne() {
+    Recorder recorder;
+    recorder.Run(2, {{"D/a.txt", "D/b.txt"}, {"D/a.txt", "D/c.txt"}, {"X/1.txt", "Y/2.txt"}}, true, 50);
+    CHECK(recorder.RanAfter(1, 0));
+    CHECK(!recorder.RanAfter(2, 0));
+}
+
+void TestCancelDropsWaitingPairs() {
+    std::atomic<bool> release{false};
+    std::atomic<int> completed{0};
+    SwapPipeline pipeline(
+        1,
+        [&](uint64_t, const std::string&, const std::string&, bool) {
+            while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return 0;
+        },
+        [&](uint64_t, int, int64_t) { ++completed; }, TestFold);
+    pipeline.Submit(0, "A/1", "B/1", true);
+    pipeline.Submit(1, "A/2", "B/2", true);
+    pipeline.Submit(2, "A/3", "B/3", true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        release = true;
+    });
+    const std::vector<uint64_t> dropped = pipeline.Cancel();
+    releaser.join();
+    CHECK_EQ(dropped, (std::vector<uint64_t>{1, 2}));
+    CHECK_EQ(completed.load(), 1);
+}
+}  // namespace
+
+int main() {
+    TestIndependentPairsOverlap();
+    TestSharedPathsRunInOrder();
+    TestTargetFreedByEarlierPairWaits();
+    TestPreservedExtensionTargetWaits();
+    TestSameFolderDifferentNamesOverlap();
+    TestIndependentPairOvertakesBlockedOne();
+    TestCancelDropsWaitingPairs();
+    return CheckResult();
+}
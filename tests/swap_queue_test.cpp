@@ -0,0 +1,70 @@
+#include "swap_queue.h"
+
+#include "check.h"
+#include "exchange.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+const std::string kLongName(64 * 1024, 'x');
+
+std::vector<SwapEntry> EntriesOf(const SwapQueue& queue) {
+    std::vector<SwapEntry> entries;
+    queue.Read([&](const PathStore&, const std::vector<SwapEntry>& all) { entries = all; });
+    return entries;
+}
+
+// A pair whose path the store cannot hold fails at once instead of running on an empty path
+void TestBatchRejectsOverlongPath() {
+    SwapBatch batch;
+    batch.Add("C:\\dir\\a.txt", "C:\\dir\\b.txt", true);
+    batch.Add("C:\\dir\\" + kLongName, "C:\\dir\\c.txt", true);
+    batch.Add("C:\\dir\\d.txt", "C:\\" + kLongName + "\\e.txt", false);
+    CHECK_EQ(batch.entries[0].state, SwapState::Pending);
+    for (size_t i = 1; i < 3; ++i) {
+        CHECK_EQ(batch.entries[i].state, SwapState::Failed);
+        CHECK_EQ(batch.entries[i].code, kResultInvalidPath);
+    }
+
+    SwapBatch merged;
+    merged.Append(batch);
+    CHECK_EQ(merged.entries[0].state, SwapState::Pending);
+    CHECK_EQ(merged.entries[1].state, SwapState::Failed);
+    CHECK_EQ(merged.entries[2].code, kResultInvalidPath);
+}
+
+void TestQueueKeepsRejectionsFailed() {
+    SwapQueue queue;
+    queue.Add("C:\\dir\\" + kLongName, "C:\\dir\\b.txt", true);
+    CHECK_EQ(queue.Count(SwapState::Failed), size_t{1});
+    CHECK_EQ(queue.Count(SwapState::Pending), size_t{0});
+
+    SwapBatch batch;
+    batch.Add("C:\\dir\\a.txt", "C:\\dir\\b.txt", true);
+    batch.Add("C:\\dir\\" + kLongName, "C:\\dir\\c.txt", true);
+    queue.AddBatch(std::move(batch), true);
+    CHECK_EQ(queue.Count(SwapState::Failed), size_t{2});
+    CHECK_EQ(queue.Count(SwapState::Pending), size_t{1});
+    const std::vector<SwapEntry> entries = EntriesOf(queue);
+    CHECK_EQ(entries.size(), size_t{3});
+    CHECK_EQ(entries[1].state, SwapState::Pending);
+    CHECK_EQ(entries[2].state, SwapState::Failed);
+    CHECK_EQ(entries[2].code, kResultInvalidPath);
+
+    queue.ClearFinished();
+    CHECK_EQ(queue.Count(SwapState::Failed), size_t{0});
+    CHECK_EQ(queue.Count(SwapState::Pending), size_t{1});
+    queue.Read([](const PathStore& paths, const std::vector<SwapEntry>& kept) {
+        std::string buffer;
+        CHECK_EQ(kept.size(), size_t{1});
+        CHECK_EQ(std::string(paths.Path(kept[0].path1, buffer)), std::string("C:\\dir\\a.txt"));
+    });
+}
+}  // namespace
+
+int main() {
+    TestBatchRejectsOverlongPath();
+    TestQueueKeepsRejectionsFailed();
+    return CheckResult();
+}
@@ -0,0 +1,159 @@
+#include "swap_session.h"
+
+#include "check.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+
+// `count` pairs a<i>/b<i> in a fresh temp folder, each file holding its own name
+struct Pairs {
+    fs::path dir;
+    std::vector<std::string> paths1;
+    std::vector<std::string> paths2;
+    std::vector<const char*> ptrs1;
+    std::vector<const char*> ptrs2;
+
+    Pairs(const char* name, size_t count) : dir(fs::temp_directory_path() / name) {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (size_t i = 0; i < count; ++i) {
+            for (const char* side : {"a", "b"}) {
+                const std::string file = side + std::to_string(i);
+                std::ofstream(dir / file) << file;
+                (*side == 'a' ? paths1 : paths2).push_back((dir / file).string());
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            ptrs1.push_back(paths1[i].c_str());
+            ptrs2.push_back(paths2[i].c_str());
+        }
+    }
+    Pairs(const Pairs&) = delete;
+    Pairs& operator=(const Pairs&) = delete;
+    ~Pairs() { fs::remove_all(dir); }
+
+    int Add(nx_session* session, size_t first, size_t count) const {
+        return nx_session_add(session, ptrs1.data() + first, ptrs2.data() + first, nullptr, count);
+    }
+    std::string Content(const std::string& path) const {
+        std::ifstream in(path);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+};
+
+std::vector<int32_t> Results(nx_session* session) {
+    std::vector<int32_t> codes(nx_session_size(session));
+    CHECK_EQ(nx_session_results(session, 0, codes.size(), codes.data(), nullptr), NX_OK);
+    return codes;
+}
+
+void TestArguments() {
+    CHECK_EQ(nx_session_add(nullptr, nullptr, nullptr, nullptr, 0), NX_ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(nx_session_execute(nullptr, nullptr), NX_ERROR_INVALID_ARGUMENT);
+    nx_session* session = nx_session_open();
+    const char* missing[] = {nullptr};
+    CHECK_EQ(nx_session_add(session, missing, missing, nullptr, 1), NX_ERROR_INVALID_ARGUMENT);
+    nx_options options;
+    nx_options_init(&options);
+    options.name_rules = 99;
+    CHECK_EQ(nx_session_execute(session, &options), NX_ERROR_INVALID_ARGUMENT);
+    int32_t code = 0;
+    CHECK_EQ(nx_session_results(session, 0, 1, &code, nullptr), NX_ERROR_INVALID_ARGUMENT);
+    nx_session_close(session);
+}
+
+// A second execute is refused while one runs; adds and result reads go on beside it and see
+// every pair either not run or finished
+void TestConcurrentCalls() {
+    constexpr size_t kFirst = 4000;
+    constexpr size_t kLater = 200;
+    const Pairs pairs("nx_session_test", kFirst + kLater);
+    nx_session* session = nx_session_open();
+    CHECK_EQ(pairs.Add(session, 0, kFirst), NX_OK);
+
+    nx_options options;
+    nx_options_init(&options);
+    options.pipeline_depth = 1;
+    std::atomic<bool> finished{false};
+    int first = -100;
+    std::thread executor([&]() {
+        first = nx_session_execute(session, &options);
+        finished.store(true);
+    });
+
+    // Wait for the first pair so the execution is known to have taken its snapshot
+    while (!finished.load() && Results(session)[0] == NX_RESULT_NOT_RUN) std::this_thread::yield();
+    size_t busy = 0;
+    size_t added = 0;
+    while (!finished.load()) {
+        const int code = nx_session_execute(session, &options);
+        CHECK(code == NX_ERROR_BUSY || code == NX_OK);
+        busy += code == NX_ERROR_BUSY;
+        if (added < kLater) {
+            CHECK_EQ(pairs.Add(session, kFirst + added, 1), NX_OK);
+            ++added;
+        }
+        for (const int32_t result : Results(session)) {
+            CHECK(result == NX_RESULT_NOT_RUN || result == 0);
+        }
+    }
+    executor.join();
+    CHECK_EQ(first, NX_OK);
+    CHECK(busy > 0);
+    CHECK(added > 0);
+
+    CHECK_EQ(pairs.Add(session, kFirst + added, kLater - added), NX_OK);
+    CHECK_EQ(nx_session_size(session), kFirst + kLater);
+    CHECK_EQ(nx_session_execute(session, &options), NX_OK);
+    const std::vector<int32_t> codes = Results(session);
+    size_t succeeded = 0;
+    for (const int32_t code : codes) succeeded += code == 0;
+    CHECK_EQ(succeeded, kFirst + kLater);
+    CHECK_EQ(pairs.Content(pairs.paths1[0]), std::string("b0"));
+    CHECK_EQ(pairs.Content(pairs.paths2[kFirst + kLater - 1]), "a" + std::to_string(kFirst + kLater - 1));
+    nx_session_close(session);
+}
+
+// Sessions share nothing: several run on their own threads at once
+void TestIndependentSessions() {
+    constexpr size_t kSessions = 4;
+    constexpr size_t kPairs = 300;
+    std::vector<std::unique_ptr<Pairs>> pairs;
+    for (size_t s = 0; s < kSessions; ++s) {
+        pairs.push_back(std::make_unique<Pairs>(("nx_session_test_" + std::to_string(s)).c_str(), kPairs));
+    }
+    std::vector<std::thread> threads;
+    std::vector<int> codes(kSessions, -100);
+    std::vector<size_t> succeeded(kSessions, 0);
+    for (size_t s = 0; s < kSessions; ++s) {
+        threads.emplace_back([&, s]() {
+            nx_session* session = nx_session_open();
+            pairs[s]->Add(session, 0, kPairs);
+            codes[s] = nx_session_execute(session, nullptr);
+            for (const int32_t code : Results(session)) succeeded[s] += code == 0;
+            nx_session_close(session);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (size_t s = 0; s < kSessions; ++s) {
+        CHECK_EQ(codes[s], NX_OK);
+        CHECK_EQ(succeeded[s], kPairs);
+    }
+}
+}  // namespace
+
+int main() {
+    TestArguments();
+    TestConcurrentCalls();
+    TestIndependentSessions();
+    return CheckResult();
+}
@@ -0,0 +1,75 @@
+#include "theme_palette.h"
+
+#include "check.h"
+
+namespace {
+ThemeInputs LightInputs() {
+    ThemeInputs inputs;
+    inputs.window = 0xFFFFFF;
+    inputs.windowText = 0x000000;
+    inputs.shadow = 0xA0A0A0;
+    inputs.buttonFace = 0xF0F0F0;
+    inputs.scrollbar = 0xC8C8C8;
+    inputs.accent = 0xD77800;
+    return inputs;
+}
+
+void TestRefreshWindow() {
+    CHECK(kThemeRefreshQuiet == std::chrono::milliseconds(150));
+    CHECK(kThemeRefreshMaxDelay == std::chrono::seconds(1));
+}
+
+// The no-op paths rely on equal inputs deriving bit-identical palettes
+void TestDeriveIsDeterministic() {
+    const ThemeInputs inputs = LightInputs();
+    ThemeInputs copy = inputs;
+    CHECK(DeriveThemePalette(inputs) == DeriveThemePalette(copy));
+    copy.accent ^= 1;
+    CHECK(copy != inputs);
+    CHECK(DeriveThemePalette(inputs) != DeriveThemePalette(copy));
+}
+
+// A broadcast that leaves every input alone changes nothing, not even the stored inputs
+void TestUnchangedInputsAreNoOp() {
+    ThemeInputs current = LightInputs();
+    const ThemePalette applied = DeriveThemePalette(current);
+    CHECK(!RefreshThemePalette(current, applied, LightInputs()).has_value());
+    CHECK(current == LightInputs());
+}
+
+// Inputs that differ but still derive the applied palette are taken in without a rebuild
+void TestSamePaletteIsNoOp() {
+    ThemeInputs current = LightInputs();
+    ThemeInputs inputs = LightInputs();
+    inputs.accent = 0x0078D7;
+    const ThemePalette applied = DeriveThemePalette(inputs);
+    CHECK(!RefreshThemePalette(current, applied, inputs).has_value());
+    CHECK(current == inputs);
+}
+
+void TestChangedPaletteIsApplied() {
+    ThemeInputs current = LightInputs();
+    const ThemePalette applied = DeriveThemePalette(current);
+    ThemeInputs dark = LightInputs();
+    dark.darkMode = true;
+    const std::optional<ThemePalette> palette = RefreshThemePalette(current, applied, dark);
+    CHECK(palette.has_value());
+    CHECK(palette && *palette == DeriveThemePalette(dark));
+    CHECK(palette && *palette != applied);
+    CHECK(current == dark);
+    // Dark mode keeps the window background dark and the text light
+    CHECK(palette && palette->windowBg.x < 0.3f && palette->text.x > 0.7f);
+
+    // The same notification again is a no-op
+    CHECK(!RefreshThemePalette(current, *palette, dark).has_value());
+}
+}  // namespace
+
+int main() {
+    TestRefreshWindow();
+    TestDeriveIsDeterministic();
+    TestUnchangedInputsAreNoOp();
+    TestSamePaletteIsNoOp();
+    TestChangedPaletteIsApplied();
+    return CheckResult();
+}
@@ -0,0 +1,105 @@
+#include "ui_script.h"
+
+#include "check.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+UiStep Parse(const std::string& line, bool expected = true) {
+    UiStep step;
+    CHECK_EQ(ParseUiStep(line, step), expected);
+    return step;
+}
+
+void TestParseSteps() {
+    UiStep step = Parse("idle 120");
+    CHECK(step.kind == UiStepKind::Idle);
+    CHECK_EQ(step.frames, 120);
+    CHECK_EQ(step.label, std::string("idle 120"));
+    // Without a count, the settle frames of any other step
+    CHECK_EQ(Parse("idle").frames, 60);
+
+    // The text runs to the end of the line, spaces included
+    step = Parse("type 2 D:\\My Files\\a b.txt");
+    CHECK(step.kind == UiStepKind::Type);
+    CHECK_EQ(step.field, 2);
+    CHECK_EQ(step.text, std::string("D:\\My Files\\a b.txt"));
+
+    step = Parse("drop C:\\a.txt|C:\\b c.txt");
+    CHECK(step.kind == UiStepKind::Drop);
+    CHECK_EQ(step.text, std::string("C:\\a.txt|C:\\b c.txt"));
+
+    step = Parse("dpi 1.5");
+    CHECK(step.kind == UiStepKind::Dpi);
+    CHECK_EQ(step.value, 1.5f);
+    CHECK(Parse("theme").kind == UiStepKind::Theme);
+    step = Parse("queue 990");
+    CHECK(step.kind == UiStepKind::Queue);
+    CHECK_EQ(step.value, 990.0f);
+}
+
+void TestRejectBadSteps() {
+    for (const char* line : {"", "wait 10", "IDLE 10", "idle 0", "idle -5", "dpi", "dpi 0", "dpi abc", "queue",
+                             "queue 0.5"}) {
+        Parse(line, false);
+    }
+}
+
+void TestLoadScript() {
+    const fs::path path = fs::temp_directory_path() / "nx_ui_script_test.txt";
+    std::ofstream(path) << "# warm up\r\n\r\n  idle 5\r\n\ttype 1 abc\n   \n# done\ntheme\n";
+    std::vector<UiStep> steps;
+    CHECK(LoadUiScript(path.wstring(), steps));
+    CHECK_EQ(steps.size(), size_t{3});
+    if (steps.size() == 3) {
+        CHECK_EQ(steps[0].frames, 5);
+        CHECK_EQ(steps[1].label, std::string("type 1 abc"));
+        CHECK_EQ(steps[1].text, std::string("abc"));
+        CHECK(steps[2].kind == UiStepKind::Theme);
+    }
+
+    // One bad line fails the whole script
+    std::ofstream(path) << "idle 5\ndpi 0\n";
+    steps.clear();
+    CHECK(!LoadUiScript(path.wstring(), steps));
+    fs::remove(path);
+    CHECK(!LoadUiScript(path.wstring(), steps));
+}
+
+// Every line of the built-in scenario parses
+void TestDefaultScript() {
+    const std::vector<UiStep> steps = DefaultUiScript();
+    CHECK_EQ(steps.size(), size_t{11});
+    for (const UiStep& step : steps) {
+        UiStep parsed;
+        CHECK(ParseUiStep(step.label, parsed));
+    }
+    CHECK(steps.back().kind == UiStepKind::Queue);
+    CHECK_EQ(steps.back().value, 99000.0f);
+}
+
+void TestSplit() {
+    // a, e with acute, a Han character and an emoji
+    const std::vector<std::string> chars = SplitCodePoints("a\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80");
+    const std::vector<std::string> expected = {"a", "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80"};
+    CHECK_EQ(chars, expected);
+    CHECK(SplitCodePoints("").empty());
+
+    CHECK_EQ(SplitDropPaths("C:\\a.txt|C:\\b c.txt"), (std::vector<std::string>{"C:\\a.txt", "C:\\b c.txt"}));
+    CHECK_EQ(SplitDropPaths("C:\\a.txt"), std::vector<std::string>{"C:\\a.txt"});
+}
+}  // namespace
+
+int main() {
+    TestParseSteps();
+    TestRejectBadSteps();
+    TestLoadScript();
+    TestDefaultScript();
+    TestSplit();
+    return CheckResult();
+}
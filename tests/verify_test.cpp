@@ -0,0 +1,108 @@
+#include "verify.h"
+
+#include "check.h"
+#include "exchange.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// exchange() stands in for the library: the test decides what a "swap" does to the disk, so that
+// --verify can be shown a swap that did not land
+enum class FakeSwap { Rename, CopyContent, Nothing, Fail };
+FakeSwap g_fakeSwap = FakeSwap::Rename;
+
+extern "C" int exchange(const char* path1, const char* path2, bool /*preserve_ext*/) {
+    const fs::path a(path1);
+    const fs::path b(path2);
+    const fs::path parked = a.parent_path() / "parked.tmp";
+    switch (g_fakeSwap) {
+        case FakeSwap::Rename:
+            fs::rename(a, parked);
+            fs::rename(b, a);
+            fs::rename(parked, b);
+            return kResultSuccess;
+        case FakeSwap::CopyContent:
+            // The names now show each other's bytes, but through the same files as before
+            fs::copy_file(a, parked);
+            fs::copy_file(b, a, fs::copy_options::overwrite_existing);
+            fs::copy_file(parked, b, fs::copy_options::overwrite_existing);
+            fs::remove(parked);
+            return kResultSuccess;
+        case FakeSwap::Nothing:
+            return kResultSuccess;
+        case FakeSwap::Fail:
+            return kResultPermissionDenied;
+    }
+    return kResultSuccess;
+}
+
+namespace {
+struct Fixture {
+    fs::path dir = fs::temp_directory_path() / "nx_verify_test";
+
+    Fixture() {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        std::ofstream(dir / "a.txt") << "first";
+        std::ofstream(dir / "b.txt") << "second";
+    }
+    ~Fixture() { fs::remove_all(dir); }
+
+    std::string Path(const char* name) const { return (dir / name).string(); }
+    std::string Content(const char* name) const {
+        std::ifstream in(dir / name);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+};
+
+void TestSwappedLocation() {
+    CHECK(SwappedLocation(L"C:\\x\\a.txt", L"C:\\y\\b.md", false, false) == L"C:\\x\\b.md");
+    CHECK(SwappedLocation(L"C:\\x\\a.txt", L"C:\\y\\b.md", false, true) == L"C:\\x\\b.txt");
+    // Folders keep no extension
+    CHECK(SwappedLocation(L"C:\\x\\a.d", L"C:\\y\\b.e", true, true) == L"C:\\x\\b.e");
+}
+
+void TestVerifiedSwap() {
+    Fixture f;
+    g_fakeSwap = FakeSwap::Rename;
+    CHECK_EQ(ExchangeVerified(f.Path("a.txt"), f.Path("b.txt"), false), kResultSuccess);
+    CHECK_EQ(f.Content("a.txt"), std::string("second"));
+}
+
+// Each name shows the other's bytes, but the items never moved. %TEMP% is on NTFS, whose file IDs
+// survive renames, so identity catches it.
+void TestCopiedContentFails() {
+    Fixture f;
+    g_fakeSwap = FakeSwap::CopyContent;
+    CHECK_EQ(ExchangeVerified(f.Path("a.txt"), f.Path("b.txt"), false), kResultVerifyFailed);
+    CHECK_EQ(f.Content("a.txt"), std::string("second"));
+}
+
+void TestUnmovedItemsFail() {
+    Fixture f;
+    g_fakeSwap = FakeSwap::Nothing;
+    CHECK_EQ(ExchangeVerified(f.Path("a.txt"), f.Path("b.txt"), false), kResultVerifyFailed);
+}
+
+// Codes from the swap itself, and from items that do not exist, pass through unchanged
+void TestSwapErrorsPassThrough() {
+    Fixture f;
+    g_fakeSwap = FakeSwap::Fail;
+    CHECK_EQ(ExchangeVerified(f.Path("a.txt"), f.Path("b.txt"), false), kResultPermissionDenied);
+    CHECK_EQ(ExchangeVerified(f.Path("missing.txt"), f.Path("b.txt"), false), kResultPermissionDenied);
+    CHECK_EQ(f.Content("a.txt"), std::string("first"));
+}
+}  // namespace
+
+int main() {
+    TestSwappedLocation();
+    TestVerifiedSwap();
+    TestCopiedContentFails();
+    TestUnmovedItemsFail();
+    TestSwapErrorsPassThrough();
+    return CheckResult();
+}